@@ -0,0 +1,459 @@
+#include "aes128ctrencoderexecutor.h"
+#include "cpufeatures.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <random>
+#include <sys/random.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define AES_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using RoundKeys = Aes128CtrEncoderExecutor::RoundKeys;
+
+static constexpr size_t blockSize = 16;
+static constexpr int rounds = 10;
+
+/*
+ * Переносимая реализация.
+ *
+ * 64 байта состояния (4 блока) хранятся для SubBytes в виде 8 битовых срезов: бит j среза k -
+ * бит k байта j. S-блок вычисляется как x^254 в GF(2^8) с последующим аффинным преобразованием;
+ * все операции над срезами - логические, без ветвлений и обращений к таблицам по данным.
+ */
+
+using BitSlices = uint64_t[8];
+
+/*!
+ * \brief Транспонировать битовую матрицу 8x8: байт j, бит k <-> байт k, бит j
+ */
+static inline uint64_t transpose8x8(uint64_t x)
+{
+    uint64_t t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+static void toBitSlices(const uint8_t* bytes, BitSlices slices)
+{
+    for (int k = 0; k < 8; ++k)
+        slices[k] = 0;
+    for (int chunk = 0; chunk < 8; ++chunk)
+    {
+        uint64_t x;
+        std::memcpy(&x, bytes + 8 * chunk, sizeof(x));
+        x = transpose8x8(x);
+        for (int k = 0; k < 8; ++k)
+            slices[k] |= ((x >> (8 * k)) & 0xFF) << (8 * chunk);
+    }
+}
+
+static void fromBitSlices(const BitSlices slices, uint8_t* bytes)
+{
+    for (int chunk = 0; chunk < 8; ++chunk)
+    {
+        uint64_t x = 0;
+        for (int k = 0; k < 8; ++k)
+            x |= ((slices[k] >> (8 * chunk)) & 0xFF) << (8 * k);
+        x = transpose8x8(x);
+        std::memcpy(bytes + 8 * chunk, &x, sizeof(x));
+    }
+}
+
+/*!
+ * \brief Приведение произведения степени не выше 14 по модулю x^8 + x^4 + x^3 + x + 1
+ */
+static inline void reduce(uint64_t p[15], BitSlices r)
+{
+    for (int k = 14; k >= 8; --k)
+    {
+        p[k - 4] ^= p[k];
+        p[k - 5] ^= p[k];
+        p[k - 7] ^= p[k];
+        p[k - 8] ^= p[k];
+    }
+    for (int k = 0; k < 8; ++k)
+        r[k] = p[k];
+}
+
+static void gfMultiply(const BitSlices a, const BitSlices b, BitSlices r)
+{
+    uint64_t p[15] = {};
+    for (int i = 0; i < 8; ++i)
+    {
+        for (int j = 0; j < 8; ++j)
+            p[i + j] ^= a[i] & b[j];
+    }
+    reduce(p, r);
+}
+
+static void gfSquare(const BitSlices a, BitSlices r)
+{
+    uint64_t p[15] = {};
+    for (int i = 0; i < 8; ++i)
+        p[2 * i] = a[i];
+    reduce(p, r);
+}
+
+static void subBitSlices(BitSlices x)
+{
+    // x^254 = x^-1 (и 0 для 0): x^2, x^3, x^12, x^15, x^240, x^252, x^254
+    BitSlices x2, x3, x12, x15, x240, t, u;
+    gfSquare(x, x2);
+    gfMultiply(x2, x, x3);
+    gfSquare(x3, t);
+    gfSquare(t, x12);
+    gfMultiply(x12, x3, x15);
+    gfSquare(x15, t);
+    gfSquare(t, u);
+    gfSquare(u, t);
+    gfSquare(t, x240);
+    gfMultiply(x240, x12, u); // x^252
+    gfMultiply(u, x2, t);     // x^254
+
+    // b'_i = b_i ^ b_(i+4) ^ b_(i+5) ^ b_(i+6) ^ b_(i+7) ^ c_i, c = 0x63
+    for (int i = 0; i < 8; ++i)
+    {
+        const uint64_t constant = (0x63 >> i) & 1 ? ~0ULL : 0;
+        x[i] = t[i] ^ t[(i + 4) % 8] ^ t[(i + 5) % 8] ^ t[(i + 6) % 8] ^ t[(i + 7) % 8] ^ constant;
+    }
+}
+
+/*!
+ * \brief Заменить 64 байта S-блоком AES
+ */
+static void subBytes64(uint8_t* bytes)
+{
+    BitSlices slices;
+    toBitSlices(bytes, slices);
+    subBitSlices(slices);
+    fromBitSlices(slices, bytes);
+}
+
+static inline uint32_t loadColumn(const uint8_t* bytes)
+{
+    uint32_t column;
+    std::memcpy(&column, bytes, sizeof(column));
+    return column;
+}
+
+static inline uint32_t rotateColumn(uint32_t column, int bytes)
+{
+    return (column >> (8 * bytes)) | (column << (32 - 8 * bytes));
+}
+
+/*!
+ * \brief Умножение на x четырех байтов столбца без ветвлений
+ */
+static inline uint32_t xtime4(uint32_t column)
+{
+    return ((column & 0x7F7F7F7Fu) << 1) ^ (((column >> 7) & 0x01010101u) * 0x1B);
+}
+
+/*!
+ * \brief Раунд без SubBytes: ShiftRows, MixColumns (кроме последнего раунда) и AddRoundKey для одного блока
+ */
+static void shiftMixAdd(uint8_t* state, const uint8_t* roundKey, bool mix)
+{
+    uint8_t shifted[blockSize];
+    for (int c = 0; c < 4; ++c)
+    {
+        for (int r = 0; r < 4; ++r)
+            shifted[r + 4 * c] = state[r + 4 * ((c + r) % 4)];
+    }
+    for (int c = 0; c < 4; ++c)
+    {
+        uint32_t column = loadColumn(shifted + 4 * c);
+        if (mix)
+        {
+            const uint32_t c1 = rotateColumn(column, 1);
+            column = xtime4(column ^ c1) ^ c1 ^ rotateColumn(column, 2) ^ rotateColumn(column, 3);
+        }
+        column ^= loadColumn(roundKey + 4 * c);
+        std::memcpy(state + 4 * c, &column, sizeof(column));
+    }
+}
+
+/*!
+ * \brief Зашифровать 4 блока \a blocks на месте переносимой реализацией
+ */
+static void encrypt4Portable(const RoundKeys& roundKeys, uint8_t* blocks)
+{
+    for (size_t i = 0; i < 4 * blockSize; ++i)
+        blocks[i] ^= roundKeys[i % blockSize];
+    for (int round = 1; round <= rounds; ++round)
+    {
+        subBytes64(blocks);
+        for (int b = 0; b < 4; ++b)
+            shiftMixAdd(blocks + b * blockSize, roundKeys.data() + round * blockSize, round != rounds);
+    }
+}
+
+static RoundKeys expandKey(const Aes128CtrEncoderExecutor::Key& key)
+{
+    static constexpr uint8_t rcon[rounds] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36 };
+    RoundKeys roundKeys;
+    std::copy(key.begin(), key.end(), roundKeys.begin());
+    for (size_t i = blockSize; i < roundKeys.size(); i += 4)
+    {
+        uint8_t word[4] = { roundKeys[i - 4], roundKeys[i - 3], roundKeys[i - 2], roundKeys[i - 1] };
+        if (i % blockSize == 0)
+        {
+            // RotWord, SubWord (той же реализацией без таблиц) и Rcon
+            uint8_t bytes[4 * blockSize] = { word[1], word[2], word[3], word[0] };
+            subBytes64(bytes);
+            for (int k = 0; k < 4; ++k)
+                word[k] = bytes[k];
+            word[0] ^= rcon[i / blockSize - 1];
+        }
+        for (int k = 0; k < 4; ++k)
+            roundKeys[i + k] = roundKeys[i - blockSize + k] ^ word[k];
+    }
+    return roundKeys;
+}
+
+/*!
+ * \brief Записать блок счетчика: nonce и номер блока в big-endian
+ */
+static inline void counterBlock(uint64_t nonce, uint64_t index, uint8_t* block)
+{
+    for (int k = 0; k < 8; ++k)
+    {
+        block[k] = static_cast<uint8_t>(nonce >> (56 - 8 * k));
+        block[8 + k] = static_cast<uint8_t>(index >> (56 - 8 * k));
+    }
+}
+
+/*!
+ * \brief Наложить ключевой поток блоков с номерами начиная с \a index на \a blocks блоков из \a in
+ */
+static void xorBlocksPortable(const RoundKeys& roundKeys, uint64_t nonce, uint64_t index, char* out, const char* in, size_t blocks)
+{
+    uint8_t keystream[4 * blockSize];
+    while (blocks > 0)
+    {
+        const size_t count = std::min<size_t>(blocks, 4);
+        for (size_t b = 0; b < 4; ++b)
+            counterBlock(nonce, index + b, keystream + b * blockSize);
+        encrypt4Portable(roundKeys, keystream);
+        for (size_t i = 0; i < count * blockSize; ++i)
+            out[i] = static_cast<char>(in[i] ^ keystream[i]);
+        index += count;
+        blocks -= count;
+        out += count * blockSize;
+        in += count * blockSize;
+    }
+}
+
+#ifdef AES_X86_KERNELS
+
+__attribute__((target("aes,sse2"))) static inline __m128i encryptAesNi(const __m128i* keys, __m128i block)
+{
+    block = _mm_xor_si128(block, keys[0]);
+    for (int round = 1; round < rounds; ++round)
+        block = _mm_aesenc_si128(block, keys[round]);
+    return _mm_aesenclast_si128(block, keys[rounds]);
+}
+
+/*!
+ * \brief Наложение ключевого потока по 8 блоков: независимые цепочки aesenc скрывают задержку инструкции
+ */
+__attribute__((target("aes,sse2"))) static void xorBlocksAesNi(const RoundKeys& roundKeys, uint64_t nonce, uint64_t index, char* out, const char* in, size_t blocks)
+{
+    __m128i keys[rounds + 1];
+    for (int round = 0; round <= rounds; ++round)
+        keys[round] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(roundKeys.data() + round * blockSize));
+    const long long nonceBytes = static_cast<long long>(__builtin_bswap64(nonce));
+    auto counter = [nonceBytes](uint64_t i) {
+        return _mm_set_epi64x(static_cast<long long>(__builtin_bswap64(i)), nonceBytes);
+    };
+
+    // Состояния блоков - отдельные переменные: массив при -O2 остается в памяти
+    size_t b = 0;
+    for (; b + 8 <= blocks; b += 8)
+    {
+        const uint64_t i = index + b;
+        __m128i s0 = _mm_xor_si128(counter(i), keys[0]);
+        __m128i s1 = _mm_xor_si128(counter(i + 1), keys[0]);
+        __m128i s2 = _mm_xor_si128(counter(i + 2), keys[0]);
+        __m128i s3 = _mm_xor_si128(counter(i + 3), keys[0]);
+        __m128i s4 = _mm_xor_si128(counter(i + 4), keys[0]);
+        __m128i s5 = _mm_xor_si128(counter(i + 5), keys[0]);
+        __m128i s6 = _mm_xor_si128(counter(i + 6), keys[0]);
+        __m128i s7 = _mm_xor_si128(counter(i + 7), keys[0]);
+        for (int round = 1; round < rounds; ++round)
+        {
+            const __m128i key = keys[round];
+            s0 = _mm_aesenc_si128(s0, key);
+            s1 = _mm_aesenc_si128(s1, key);
+            s2 = _mm_aesenc_si128(s2, key);
+            s3 = _mm_aesenc_si128(s3, key);
+            s4 = _mm_aesenc_si128(s4, key);
+            s5 = _mm_aesenc_si128(s5, key);
+            s6 = _mm_aesenc_si128(s6, key);
+            s7 = _mm_aesenc_si128(s7, key);
+        }
+        const __m128i state[8] = { s0, s1, s2, s3, s4, s5, s6, s7 };
+        for (int k = 0; k < 8; ++k)
+        {
+            const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + (b + k) * blockSize));
+            const __m128i keystream = _mm_aesenclast_si128(state[k], keys[rounds]);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (b + k) * blockSize), _mm_xor_si128(data, keystream));
+        }
+    }
+    for (; b < blocks; ++b)
+    {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + b * blockSize));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + b * blockSize), _mm_xor_si128(data, encryptAesNi(keys, counter(index + b))));
+    }
+}
+
+#endif // AES_X86_KERNELS
+
+static void xorBlocks(const RoundKeys& roundKeys, uint64_t nonce, uint64_t index, char* out, const char* in, size_t blocks)
+{
+#ifdef AES_X86_KERNELS
+    if (aesNiEnabled())
+        return xorBlocksAesNi(roundKeys, nonce, index, out, in, blocks);
+#endif
+    xorBlocksPortable(roundKeys, nonce, index, out, in, blocks);
+}
+
+/*!
+ * \brief Наложить ключевой поток начиная с байта \a offset; допускается совпадение \a out и \a in
+ */
+static void xorKeystream(const RoundKeys& roundKeys, uint64_t nonce, uint64_t offset, char* out, const char* in, size_t size)
+{
+    uint64_t index = offset / blockSize;
+    size_t skip = offset % blockSize;
+    while (size > 0)
+    {
+        if (skip == 0 && size >= blockSize)
+        {
+            const size_t blocks = size / blockSize;
+            xorBlocks(roundKeys, nonce, index, out, in, blocks);
+            index += blocks;
+            out += blocks * blockSize;
+            in += blocks * blockSize;
+            size -= blocks * blockSize;
+            continue;
+        }
+        // Неполный блок в начале или в конце сообщения
+        char block[blockSize] = {};
+        const size_t count = std::min(blockSize - skip, size);
+        std::memcpy(block + skip, in, count);
+        xorBlocks(roundKeys, nonce, index, block, block, 1);
+        std::memcpy(out, block + skip, count);
+        ++index;
+        skip = 0;
+        out += count;
+        in += count;
+        size -= count;
+    }
+}
+
+Aes128CtrEncoderExecutor::Aes128CtrEncoderExecutor(const Key& key, uint64_t encodeNonce, uint64_t decodeNonce) :
+    m_roundKeys(expandKey(key))
+{
+    m_encodeStream.nonce = encodeNonce;
+    m_decodeStream.nonce = decodeNonce;
+}
+
+Aes128CtrEncoderExecutor::Block Aes128CtrEncoderExecutor::encryptBlock(const Key& key, const Block& block)
+{
+    const auto roundKeys = expandKey(key);
+    Block result {};
+#ifdef AES_X86_KERNELS
+    if (aesNiEnabled())
+    {
+        __m128i keys[rounds + 1];
+        for (int round = 0; round <= rounds; ++round)
+            keys[round] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(roundKeys.data() + round * blockSize));
+        const __m128i encrypted = encryptAesNi(keys, _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.data())));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(result.data()), encrypted);
+        return result;
+    }
+#endif
+    uint8_t blocks[4 * blockSize] = {};
+    std::copy(block.begin(), block.end(), blocks);
+    encrypt4Portable(roundKeys, blocks);
+    std::copy(blocks, blocks + blockSize, result.begin());
+    return result;
+}
+
+bool Aes128CtrEncoderExecutor::hardwareAccelerated()
+{
+    return aesNiEnabled();
+}
+
+uint64_t Aes128CtrEncoderExecutor::randomNonce()
+{
+    uint64_t nonce = 0;
+    while (!nonce)
+    {
+        const ssize_t size = getrandom(&nonce, sizeof(nonce), 0);
+        if (size == static_cast<ssize_t>(sizeof(nonce)))
+            continue;
+        if (size < 0 && errno == EINTR)
+            continue;
+        // getrandom(2) недоступен: std::random_device тоже берет числа из генератора ОС
+        std::random_device device;
+        nonce = (uint64_t(device()) << 32) | device();
+    }
+    return nonce;
+}
+
+void Aes128CtrEncoderExecutor::apply(const Stream& stream, char* out, const char* in, size_t size) const
+{
+    const uint64_t offset = stream.offset.fetch_add(size, std::memory_order_relaxed);
+    xorKeystream(m_roundKeys, stream.nonce, offset, out, in, size);
+}
+
+std::string Aes128CtrEncoderExecutor::encode(const std::string& message) const
+{
+    std::string encoded(message.size(), '\0');
+    apply(m_encodeStream, &encoded[0], message.data(), message.size());
+    return encoded;
+}
+
+std::string Aes128CtrEncoderExecutor::decode(const std::string& message) const
+{
+    std::string decoded(message.size(), '\0');
+    apply(m_decodeStream, &decoded[0], message.data(), message.size());
+    return decoded;
+}
+
+std::optional<size_t> Aes128CtrEncoderExecutor::encodeInto(std::string_view message, char* output, size_t outputSize) const
+{
+    if (outputSize < message.size())
+        return {};
+    apply(m_encodeStream, output, message.data(), message.size());
+    return message.size();
+}
+
+std::optional<size_t> Aes128CtrEncoderExecutor::decodeInto(std::string_view message, char* output, size_t outputSize) const
+{
+    if (outputSize < message.size())
+        return {};
+    apply(m_decodeStream, output, message.data(), message.size());
+    return message.size();
+}
+
+bool Aes128CtrEncoderExecutor::encodeInPlace(char* data, size_t size) const
+{
+    apply(m_encodeStream, data, data, size);
+    return true;
+}
+
+bool Aes128CtrEncoderExecutor::decodeInPlace(char* data, size_t size) const
+{
+    apply(m_decodeStream, data, data, size);
+    return true;
+}
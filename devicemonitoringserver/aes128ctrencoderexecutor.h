@@ -0,0 +1,90 @@
+#ifndef AES128CTRENCODEREXECUTOR_H
+#define AES128CTRENCODEREXECUTOR_H
+
+#include "baseencoderexecutor.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*!
+ * \brief Шифрование AES-128 в режиме счетчика (CTR)
+ *
+ * Блок счетчика - nonce (8 байтов, big-endian) и номер блока ключевого потока (8 байтов, big-endian).
+ * Каждое направление передачи - отдельный ключевой поток со своим nonce: сообщения занимают
+ * в нем последовательные участки, поэтому размер сообщения сохраняется, а ключевой поток
+ * не используется повторно. Отсюда следует, что объект создается для одного соединения,
+ * и сообщения этого соединения должны шифроваться и расшифровываться в порядке передачи.
+ * Целостность не проверяется.
+ *
+ * При поддержке процессором используются инструкции AES-NI (по 8 блоков за итерацию),
+ * иначе - переносимая реализация, время работы которой не зависит от ключа и данных
+ * (S-блок вычисляется обращением в GF(2^8) над битовыми срезами 4 блоков, без таблиц).
+ */
+class Aes128CtrEncoderExecutor final : public BaseEncoderExecutor
+{
+public:
+    using Key = std::array<uint8_t, 16>;
+    using Block = std::array<uint8_t, 16>;
+
+    /*!
+     * \brief Конструктор.
+     * \param key - ключ соединения
+     * \param encodeNonce - nonce ключевого потока исходящих сообщений
+     * \param decodeNonce - nonce ключевого потока входящих сообщений; должен отличаться от \a encodeNonce
+     */
+    Aes128CtrEncoderExecutor(const Key& key, uint64_t encodeNonce, uint64_t decodeNonce);
+
+    /*!
+     * \brief Название алгоритма
+     */
+    static constexpr const char* algorithmName() { return "AES-128-CTR"; }
+    /*!
+     * \brief Зашифровать один блок \a block ключом \a key (для проверки по эталонным векторам)
+     */
+    static Block encryptBlock(const Key& key, const Block& block);
+    /*!
+     * \brief Используется ли реализация на инструкциях AES-NI
+     */
+    static bool hardwareAccelerated();
+    /*!
+     * \brief Случайный ненулевой nonce из генератора случайных чисел ОС (getrandom(2))
+     */
+    static uint64_t randomNonce();
+
+    std::string encode(const std::string& message) const override final;
+    std::string decode(const std::string& message) const override final;
+    std::string name() const override final { return algorithmName(); }
+    size_t maxEncodedSize(size_t size) const override final { return size; }
+    size_t maxDecodedSize(size_t size) const override final { return size; }
+    std::optional<size_t> encodeInto(std::string_view message, char* output, size_t outputSize) const override final;
+    std::optional<size_t> decodeInto(std::string_view message, char* output, size_t outputSize) const override final;
+    bool lengthPreserving() const override final { return true; }
+    size_t encodedUnitSize() const override final { return 1; }
+    bool encodeInPlace(char* data, size_t size) const override final;
+    bool decodeInPlace(char* data, size_t size) const override final;
+
+    /*!
+     * \brief Расширенный ключ: 11 раундовых ключей по 16 байтов
+     */
+    using RoundKeys = std::array<uint8_t, 176>;
+
+private:
+    /*!
+     * \brief Ключевой поток одного направления
+     */
+    struct Stream
+    {
+        uint64_t nonce = 0;
+        mutable std::atomic<uint64_t> offset = 0; ///< Позиция следующего сообщения в ключевом потоке, байтов
+    };
+
+    void apply(const Stream& stream, char* out, const char* in, size_t size) const;
+
+private:
+    alignas(16) RoundKeys m_roundKeys;
+    Stream m_encodeStream;
+    Stream m_decodeStream;
+};
+
+#endif // AES128CTRENCODEREXECUTOR_H
@@ -1,14 +1,32 @@
 #ifndef BASEENCODEREXECUTOR_H
 #define BASEENCODEREXECUTOR_H
 
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
 #include <string>
+#include <string_view>
 
 /*!
  * \brief Абстрактный базовый класс для алгоритмов шифрования
+ *
+ * Помимо обязательного строкового интерфейса алгоритм может реализовать работу с буферами
+ * вызывающей стороны (encodeInto()/decodeInto()) и шифрование на месте. Реализации по умолчанию
+ * выражены через строковый интерфейс, поэтому сторонние алгоритмы продолжают работать без изменений.
  */
 class BaseEncoderExecutor
 {
 public:
+    /*!
+     * \brief Размер результата заранее неизвестен
+     */
+    static constexpr size_t unknownSize = SIZE_MAX;
+    /*!
+     * \brief Таблица замены байтов: элемент с индексом c - результат шифрования байта c
+     */
+    using ByteMap = std::array<uint8_t, 256>;
+
     virtual ~BaseEncoderExecutor() = default;
     /*!
      * \brief Зашифровать сообщение \a message
@@ -22,6 +40,127 @@ public:
      * \brief Название алгоритма
      */
     virtual std::string name() const = 0;
+
+    /*!
+     * \brief Наибольший размер зашифрованного сообщения для исходного сообщения размером \a size
+     * \return unknownSize, если алгоритм не умеет предсказывать размер
+     */
+    virtual size_t maxEncodedSize(size_t /*size*/) const { return unknownSize; }
+    /*!
+     * \brief Наибольший размер расшифрованного сообщения для зашифрованного сообщения размером \a size
+     * \return unknownSize, если алгоритм не умеет предсказывать размер
+     */
+    virtual size_t maxDecodedSize(size_t /*size*/) const { return unknownSize; }
+    /*!
+     * \brief Зашифровать сообщение \a message в буфер \a output размером \a outputSize
+     * \note Буферы не должны перекрываться
+     * \return количество записанных байтов; std::nullopt, если буфер слишком мал
+     */
+    virtual std::optional<size_t> encodeInto(std::string_view message, char* output, size_t outputSize) const
+    {
+        return copyInto(encode(std::string(message)), output, outputSize);
+    }
+    /*!
+     * \brief Расшифровать сообщение \a message в буфер \a output размером \a outputSize
+     * \note Буферы не должны перекрываться
+     * \return количество записанных байтов; std::nullopt, если буфер слишком мал
+     */
+    virtual std::optional<size_t> decodeInto(std::string_view message, char* output, size_t outputSize) const
+    {
+        return copyInto(decode(std::string(message)), output, outputSize);
+    }
+    /*!
+     * \brief Сохраняет ли алгоритм размер сообщения при шифровании и расшифровке
+     */
+    virtual bool lengthPreserving() const { return false; }
+    /*!
+     * \brief Зашифровать \a size байтов по адресу \a data на месте
+     * \return false, если алгоритм не поддерживает шифрование на месте
+     */
+    virtual bool encodeInPlace(char* /*data*/, size_t /*size*/) const { return false; }
+    /*!
+     * \brief Расшифровать \a size байтов по адресу \a data на месте
+     * \return false, если алгоритм не поддерживает расшифровку на месте
+     */
+    virtual bool decodeInPlace(char* /*data*/, size_t /*size*/) const { return false; }
+    /*!
+     * \brief Зашифровать сообщение размером \a size, записанное в конец буфера \a buffer
+     * размером maxEncodedSize(size); результат записывается с начала того же буфера
+     *
+     * Позволяет сериализовать сообщение сразу в буфер зашифрованных данных без промежуточной копии.
+     * Реализация должна читать каждый блок исходных данных до записи результата поверх него.
+     * \return количество записанных байтов; std::nullopt, если алгоритм не поддерживает этот режим
+     */
+    virtual std::optional<size_t> encodeFromTail(char* buffer, size_t size) const
+    {
+        if (lengthPreserving() && encodeInPlace(buffer, size))
+            return size;
+        return {};
+    }
+
+    /*!
+     * \brief Количество байтов, в которое независимо от остальных шифруется каждый байт сообщения
+     *
+     * Позволяет расшифровывать поток по частям (StreamDecoder): любые целые единицы расшифровываются
+     * отдельно от остальных.
+     * \return 0, если алгоритм не шифрует байты независимо
+     */
+    virtual size_t encodedUnitSize() const { return 0; }
+    /*!
+     * \brief Заполнить таблицу \a table, если алгоритм шифрует каждый байт независимо от остальных
+     *
+     * Подряд идущие такие алгоритмы в CompositeEncoderExecutor объединяются в одну таблицу.
+     * Таблица должна быть перестановкой, а decode() - обратным ей преобразованием.
+     * \return false, если алгоритм не является заменой байтов
+     */
+    virtual bool byteMap(ByteMap& /*table*/) const { return false; }
+
+    /*!
+     * \brief Зашифровать сообщение \a message в строку \a output, повторно используя ее память
+     * \return false в случае ошибки
+     */
+    virtual bool encodeTo(std::string_view message, std::string& output) const
+    {
+        const size_t maxSize = maxEncodedSize(message.size());
+        if (maxSize == unknownSize)
+        {
+            output = encode(std::string(message));
+            return true;
+        }
+        output.resize(maxSize);
+        return shrinkTo(output, encodeInto(message, &output[0], output.size()));
+    }
+    /*!
+     * \brief Расшифровать сообщение \a message в строку \a output, повторно используя ее память
+     * \return false в случае ошибки
+     */
+    virtual bool decodeTo(std::string_view message, std::string& output) const
+    {
+        const size_t maxSize = maxDecodedSize(message.size());
+        if (maxSize == unknownSize)
+        {
+            output = decode(std::string(message));
+            return true;
+        }
+        output.resize(maxSize);
+        return shrinkTo(output, decodeInto(message, &output[0], output.size()));
+    }
+
+private:
+    static std::optional<size_t> copyInto(const std::string& result, char* output, size_t outputSize)
+    {
+        if (result.size() > outputSize)
+            return {};
+        std::memcpy(output, result.data(), result.size());
+        return result.size();
+    }
+    static bool shrinkTo(std::string& output, std::optional<size_t> size)
+    {
+        if (!size)
+            return false;
+        output.resize(*size);
+        return true;
+    }
 };
 
 #endif // BASEENCODEREXECUTOR_H
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "benchmarkrunner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+void BenchmarkRunner::addResult(const std::string& name, size_t bytes, size_t batch, std::vector<Clock::duration> samples)
+{
+    if (samples.empty())
+        return;
+    std::sort(samples.begin(), samples.end());
+    auto perOperation = [batch](Clock::duration duration) {
+        return std::chrono::duration<double, std::nano>(duration).count() / batch;
+    };
+    // Процентиль по ближайшему рангу
+    const size_t p99 = static_cast<size_t>(std::ceil(samples.size() * 0.99)) - 1;
+    Result result;
+    result.name = name;
+    result.bytes = bytes;
+    result.batch = batch;
+    result.samples = samples.size();
+    result.minNs = perOperation(samples.front());
+    result.medianNs = perOperation(samples[samples.size() / 2]);
+    result.p99Ns = perOperation(samples[p99]);
+    m_results.push_back(std::move(result));
+}
+
+/*!
+ * \brief Пропускная способность по медианному времени, МБ/с; 0, если объем данных не задан
+ */
+static double throughput(const BenchmarkRunner::Result& result)
+{
+    return result.bytes && result.medianNs > 0 ? result.bytes * 1e3 / result.medianNs : 0;
+}
+
+void BenchmarkRunner::printTable(std::ostream& os) const
+{
+    size_t width = 4;
+    for (const auto& result : m_results)
+        width = std::max(width, result.name.size());
+    const auto flags = os.flags();
+    os << std::left << std::setw(width) << "name" << std::right
+       << std::setw(12) << "min, ns" << std::setw(12) << "median, ns" << std::setw(12) << "p99, ns" << std::setw(12) << "MB/s" << '\n';
+    os << std::fixed << std::setprecision(1);
+    for (const auto& result : m_results)
+    {
+        os << std::left << std::setw(width) << result.name << std::right
+           << std::setw(12) << result.minNs << std::setw(12) << result.medianNs << std::setw(12) << result.p99Ns;
+        if (result.bytes)
+            os << std::setw(12) << throughput(result);
+        os << '\n';
+    }
+    os.flags(flags);
+}
+
+static void printJsonString(std::ostream& os, const std::string& string)
+{
+    os << '"';
+    for (char c : string)
+    {
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+        else
+            os << c;
+    }
+    os << '"';
+}
+
+void BenchmarkRunner::printJson(std::ostream& os, const std::vector<std::pair<std::string, std::string>>& context) const
+{
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << std::fixed << std::setprecision(3);
+    os << "{\n  \"context\": {";
+    for (size_t i = 0; i < context.size(); ++i)
+    {
+        os << (i ? ",\n    " : "\n    ");
+        printJsonString(os, context[i].first);
+        os << ": ";
+        printJsonString(os, context[i].second);
+    }
+    os << "\n  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < m_results.size(); ++i)
+    {
+        const auto& result = m_results[i];
+        os << (i ? ",\n    {" : "\n    {") << "\"name\": ";
+        printJsonString(os, result.name);
+        os << ", \"bytes\": " << result.bytes
+           << ", \"batch\": " << result.batch
+           << ", \"samples\": " << result.samples
+           << ", \"min_ns\": " << result.minNs
+           << ", \"median_ns\": " << result.medianNs
+           << ", \"p99_ns\": " << result.p99Ns
+           << ", \"mb_per_s\": " << throughput(result) << "}";
+    }
+    os << "\n  ]\n}\n";
+    os.precision(precision);
+    os.flags(flags);
+}
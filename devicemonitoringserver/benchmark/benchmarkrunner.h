@@ -0,0 +1,126 @@
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include "../common.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+ * \brief Не дать компилятору удалить вычисление значения \a value
+ */
+template <class T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/*!
+ * \brief Запуск микробенчмарков и сбор статистики
+ *
+ * Операция выполняется сериями: размер серии подбирается при прогреве так, чтобы серия
+ * длилась не менее minSampleTime, после чего замеряется samples серий. Для каждой операции
+ * сохраняются минимальное, медианное и 99-процентильное время одной операции.
+ * Параметры запуска по умолчанию фиксированы, поэтому результаты разных коммитов сопоставимы.
+ */
+class BenchmarkRunner
+{
+    NON_COPYABLE(BenchmarkRunner)
+public:
+    /*!
+     * \brief Параметры запуска
+     */
+    struct Options
+    {
+        size_t samples = 50;                                ///< Количество замеряемых серий
+        size_t warmupSamples = 5;                           ///< Количество серий прогрева после подбора размера серии
+        std::chrono::nanoseconds minSampleTime = std::chrono::milliseconds(2); ///< Наименьшая длительность серии
+        std::string filter;                                 ///< Подстрока названия; пустая - все операции
+    };
+    /*!
+     * \brief Результат замера одной операции
+     */
+    struct Result
+    {
+        std::string name;
+        size_t bytes = 0;    ///< Объем данных, обрабатываемых одной операцией; 0 - не задан
+        size_t batch = 0;    ///< Количество операций в серии
+        size_t samples = 0;  ///< Количество серий
+        double minNs = 0;    ///< Время одной операции, нс
+        double medianNs = 0;
+        double p99Ns = 0;
+    };
+
+    explicit BenchmarkRunner(Options options) :
+        m_options(std::move(options)) {}
+
+    /*!
+     * \brief Замерить операцию \a operation с названием \a name
+     * \param bytes - объем данных одной операции для расчета пропускной способности
+     */
+    template <class Operation>
+    void run(const std::string& name, size_t bytes, Operation&& operation);
+    /*!
+     * \brief Операция с названием \a name проходит фильтр; позволяет не готовить окружение для пропускаемых операций
+     */
+    bool enabled(const std::string& name) const { return name.find(m_options.filter) != std::string::npos; }
+
+    const std::vector<Result>& results() const { return m_results; }
+    /*!
+     * \brief Вывести результаты таблицей для чтения человеком
+     */
+    void printTable(std::ostream& os) const;
+    /*!
+     * \brief Вывести результаты в формате JSON
+     * \param context - пары "ключ, значение" с описанием условий запуска
+     */
+    void printJson(std::ostream& os, const std::vector<std::pair<std::string, std::string>>& context) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    template <class Operation>
+    static Clock::duration measure(size_t batch, Operation& operation)
+    {
+        const auto start = Clock::now();
+        for (size_t i = 0; i < batch; ++i)
+            operation();
+        return Clock::now() - start;
+    }
+    void addResult(const std::string& name, size_t bytes, size_t batch, std::vector<Clock::duration> samples);
+
+private:
+    Options m_options;
+    std::vector<Result> m_results;
+};
+
+template <class Operation>
+void BenchmarkRunner::run(const std::string& name, size_t bytes, Operation&& operation)
+{
+    if (!enabled(name))
+        return;
+    // Подбор размера серии одновременно прогревает кэши и предсказатель переходов
+    size_t batch = 1;
+    while (measure(batch, operation) < m_options.minSampleTime && batch < (size_t(1) << 40))
+        batch *= 2;
+    for (size_t i = 0; i < m_options.warmupSamples; ++i)
+        measure(batch, operation);
+
+    std::vector<Clock::duration> samples;
+    samples.reserve(m_options.samples);
+    for (size_t i = 0; i < m_options.samples; ++i)
+        samples.push_back(measure(batch, operation));
+    addResult(name, bytes, batch, std::move(samples));
+}
+
+#endif // BENCHMARKRUNNER_H
@@ -0,0 +1,569 @@
+#include "benchmarkrunner.h"
+
+#include "../aes128ctrencoderexecutor.h"
+#include "../bigendian.h"
+#include "../compositeencoderexecutor.h"
+#include "../cpufeatures.h"
+#include "../dummyencoderexecutor.h"
+#include "../executorregistry.h"
+#include "../message.h"
+#include "../messagebatch.h"
+#include "../messagecommand.h"
+#include "../messageerror.h"
+#include "../messagehandshake.h"
+#include "../messagemeterage.h"
+#include "../messagemeteragedelta.h"
+#include "../messagemulticommand.h"
+#include "../messagemultimeterage.h"
+#include "../messagepipeline.h"
+#include "../messageserializer.h"
+#include "../shardeddevicemonitoringserver.h"
+#include "../shm/shmclientconnection.h"
+#include "../shm/shmconnectionserver.h"
+#include "../udp/udpclientconnection.h"
+#include "../udp/udpconnectionserver.h"
+#include "../tcp/eventloop.h"
+#include "../tcp/iouringconnectionserver.h"
+#include "../tcp/tcpclientconnection.h"
+#include "../tcp/tcpconnectionserver.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractmessagehandler.h>
+#include <handlers/abstractnewconnectionhandler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+/*!
+ * \brief Размеры сообщений для алгоритмов шифрования и пакетной сериализации чисел
+ */
+static const size_t payloadSizes[] = { 16, 256, 4096, 65536 };
+
+static std::string makePayload(size_t size)
+{
+    std::string payload(size, '\0');
+    for (size_t i = 0; i < size; ++i)
+        payload[i] = static_cast<char>(i * 31 + 7);
+    return payload;
+}
+
+static void benchmarkEncoders(BenchmarkRunner& runner)
+{
+    static const DummyEncoderExecutor dummy;
+    std::vector<const BaseEncoderExecutor*> executors = { &dummy };
+    for (const auto& name : ExecutorRegistry::instance().names())
+        executors.push_back(ExecutorRegistry::instance().find(name).get());
+    const CompositeEncoderExecutor composite("ROT3+Mirror", { ExecutorRegistry::instance().find("ROT3"), ExecutorRegistry::instance().find("Mirror") });
+    executors.push_back(&composite);
+    const Aes128CtrEncoderExecutor aes({}, 1, 2);
+    executors.push_back(&aes);
+
+    for (const auto* executor : executors)
+    {
+        for (size_t size : payloadSizes)
+        {
+            const auto message = makePayload(size);
+            std::string encoded(executor->maxEncodedSize(size), '\0');
+            const auto encodedSize = executor->encodeInto(message, &encoded[0], encoded.size());
+            if (!encodedSize)
+                continue;
+            encoded.resize(*encodedSize);
+            std::string output(std::max(encoded.size(), executor->maxDecodedSize(encoded.size())), '\0');
+            const auto suffix = "/" + std::to_string(size);
+            runner.run("encode/" + executor->name() + suffix, size, [&] {
+                doNotOptimize(executor->encodeInto(message, &output[0], output.size()));
+            });
+            runner.run("decode/" + executor->name() + suffix, size, [&] {
+                doNotOptimize(executor->decodeInto(encoded, &output[0], output.size()));
+            });
+        }
+    }
+}
+
+/*!
+ * \brief Набор сообщений всех типов, в том числе пакеты разного размера
+ */
+static std::vector<std::pair<std::string, MessageVariant>> sampleMessages()
+{
+    std::vector<std::pair<std::string, MessageVariant>> messages = {
+        { "MessageMeterage", MessageMeterage(1700000000u, 42u) },
+        { "MessageMeterageDelta", MessageMeterageDelta(1, 42u) },
+        { "MessageCommand", MessageCommand(-5) },
+        { "MessageError", MessageError(MessageError::ErrorType::NoSchedule) },
+        { "MessageHandshake", MessageHandshake("ROT3", WireVersion::V2, 64u) },
+        { "MessageMultiMeterage/16", MessageMultiMeterage(1700000000u, std::vector<uint8_t>(16, 42u)) },
+        { "MessageMultiCommand/16", MessageMultiCommand(std::vector<int8_t>(16, -5)) },
+    };
+    for (size_t records : { 1, 64, 1024 })
+    {
+        MessageBatch batch;
+        for (size_t i = 0; i < records; ++i)
+        {
+            if (i % 2)
+                batch.append(MessageMeterageDelta(1, static_cast<uint8_t>(i)));
+            else
+                batch.append(MessageMeterage(1700000000u + i, static_cast<uint8_t>(i)));
+        }
+        messages.push_back({ "MessageBatch/" + std::to_string(records), std::move(batch) });
+    }
+    return messages;
+}
+
+static void benchmarkSerializer(BenchmarkRunner& runner)
+{
+    for (const auto& [name, message] : sampleMessages())
+    {
+        const auto serialized = MessageSerializer::serialize(message);
+        std::string buffer;
+        runner.run("MessageSerializer::serialize/" + name, serialized.size(), [&] {
+            doNotOptimize(MessageSerializer::serialize(message, buffer));
+        });
+        runner.run("MessageSerializer::deserializeValue/" + name, serialized.size(), [&] {
+            doNotOptimize(MessageSerializer::deserializeValue(serialized));
+        });
+        runner.run("MessageSerializer::deserialize/" + name, serialized.size(), [&] {
+            doNotOptimize(MessageSerializer::deserialize(serialized));
+        });
+        std::istringstream is(serialized, std::ios_base::binary);
+        runner.run("Message::deserialize/" + name, serialized.size(), [&] {
+            is.clear();
+            is.seekg(0);
+            doNotOptimize(Message::deserialize(is));
+        });
+    }
+}
+
+template <class T>
+static void benchmarkBigEndian(BenchmarkRunner& runner, const std::string& typeName)
+{
+    for (size_t size : payloadSizes)
+    {
+        const size_t count = size / sizeof(T);
+        std::vector<T> values(count);
+        for (size_t i = 0; i < count; ++i)
+            values[i] = static_cast<T>(i * 0x9E3779B97F4A7C15ULL);
+        std::string buffer(count * sizeof(T), '\0');
+        const auto suffix = "<" + typeName + ">/" + std::to_string(size);
+        runner.run("toBigEndian" + suffix, size, [&] {
+            toBigEndian(&buffer[0], values.data(), count);
+            doNotOptimize(buffer);
+        });
+        runner.run("fromBigEndian" + suffix, size, [&] {
+            fromBigEndian(values.data(), buffer.data(), count);
+            doNotOptimize(values);
+        });
+        // Поэлементные функции для сравнения с пакетными
+        runner.run("toBigEndian" + suffix + "/elementwise", size, [&] {
+            char* it = &buffer[0];
+            for (size_t i = 0; i < count; ++i)
+                it = toBigEndian(it, values[i]);
+            doNotOptimize(buffer);
+        });
+        runner.run("fromBigEndian" + suffix + "/elementwise", size, [&] {
+            for (size_t i = 0; i < count; ++i)
+                values[i] = fromBigEndian<T>(buffer.data() + i * sizeof(T));
+            doNotOptimize(values);
+        });
+    }
+}
+
+/*!
+ * \brief Обрабатывать события цикла \a eventLoop, пока не выполнится условие \a done
+ * \return false, если условие не выполнилось за отведенное время
+ */
+template <class Condition>
+static bool processEventsUntil(EventLoop& eventLoop, Condition&& done)
+{
+    for (int i = 0; i < 1000 && !done(); ++i)
+        eventLoop.processEvents(10);
+    return done();
+}
+
+/*!
+ * \brief Обмен сообщениями клиента \a Client с сервером \a Server в одном цикле событий
+ * \param transport - префикс имен: "tcp/<сервер>" для loopback, "shm" для разделяемой памяти
+ * \param maxMessageSize - наибольший размер сообщения транспорта; большие полезные нагрузки пропускаются
+ */
+template <class Server, class Client>
+static void benchmarkTransport(BenchmarkRunner& runner, const std::string& transport, size_t maxMessageSize = SIZE_MAX)
+{
+    // Сервер считает полученные сообщения и, если включено, отправляет их обратно
+    struct ServerState
+    {
+        size_t received = 0;
+        bool echo = false;
+    };
+    struct ServerMessageHandler final : public AbstractMessageHandler
+    {
+        ServerMessageHandler(AbstractConnection* conn, ServerState& state) :
+            m_conn(conn), m_state(state) {}
+        void operator()(const std::string& message) final
+        {
+            ++m_state.received;
+            if (m_state.echo)
+                m_conn->sendMessage(message);
+        }
+
+    private:
+        AbstractConnection* m_conn = nullptr;
+        ServerState& m_state;
+    };
+    struct NewConnectionHandler final : public AbstractNewConnectionHandler
+    {
+        NewConnectionHandler(ServerState& state) :
+            m_state(state) {}
+        void operator()(AbstractConnection* conn) final
+        {
+            conn->setMessageHandler(new ServerMessageHandler(conn, m_state));
+        }
+
+    private:
+        ServerState& m_state;
+    };
+    struct CountingMessageHandler final : public AbstractMessageHandler
+    {
+        CountingMessageHandler(size_t& counter) :
+            m_counter(counter) {}
+        void operator()(const std::string&) final { ++m_counter; }
+
+    private:
+        size_t& m_counter;
+    };
+
+    EventLoop eventLoop;
+    Server server(eventLoop);
+    ServerState state;
+    server.setNewConnectionHandler(new NewConnectionHandler(state));
+    uint64_t port = 0;
+    for (uint64_t candidate = 30000; candidate < 30100 && !port; ++candidate)
+        port = server.listen(candidate) ? candidate : 0;
+    if (!port)
+    {
+        std::cerr << "Transport benchmarks (" << transport << ") skipped: no free server id\n";
+        return;
+    }
+
+    const uint64_t clientId = 1;
+    Client client(eventLoop);
+    size_t clientReceived = 0;
+    client.setMessageHandler(new CountingMessageHandler(clientReceived));
+    client.bind(clientId);
+
+    runner.run(transport + "/connect+identify+disconnect", 0, [&] {
+        client.connectToHost(port);
+        processEventsUntil(eventLoop, [&] { return server.connection(clientId) != nullptr; });
+        client.disconnect();
+        processEventsUntil(eventLoop, [&] { return !server.connection(clientId); });
+    });
+
+    client.connectToHost(port);
+    if (!processEventsUntil(eventLoop, [&] { return server.connection(clientId) != nullptr; }))
+    {
+        std::cerr << "Transport benchmarks (" << transport << ") skipped: cannot connect\n";
+        return;
+    }
+    for (size_t size : payloadSizes)
+    {
+        if (size > maxMessageSize)
+            continue;
+        const auto message = makePayload(size);
+        const auto suffix = "/" + std::to_string(size);
+        state.echo = true;
+        runner.run(transport + "/round-trip" + suffix, size, [&] {
+            const size_t expected = clientReceived + 1;
+            client.sendMessage(message);
+            processEventsUntil(eventLoop, [&] { return clientReceived == expected; });
+        });
+        // Сообщения отправляются подряд без ожидания ответа
+        const size_t streamMessages = 64;
+        state.echo = false;
+        runner.run(transport + "/stream" + suffix + "x" + std::to_string(streamMessages), size * streamMessages, [&] {
+            const size_t expected = state.received + streamMessages;
+            for (size_t i = 0; i < streamMessages; ++i)
+                client.sendMessage(message);
+            processEventsUntil(eventLoop, [&] { return state.received == expected; });
+        });
+    }
+    client.disconnect();
+    processEventsUntil(eventLoop, [&] { return !server.connection(clientId); });
+}
+
+/*!
+ * \brief Нагрузочный тест ShardedDeviceMonitoringServer через loopback с разным количеством шардов.
+ *
+ * Устройства обмениваются с сервером измерениями и командами поочередно (как DeviceMock) из стольких
+ * клиентских потоков, сколько шардов; операция - по roundTrips обменов каждого устройства.
+ * При линейном масштабировании время операции обратно пропорционально количеству шардов,
+ * пока шардам и клиентам хватает процессоров.
+ */
+static void benchmarkSharded(BenchmarkRunner& runner)
+{
+    const size_t devicesPerThread = 16;
+    const size_t roundTrips = 16;
+    const auto executor = ExecutorRegistry::instance().find("ROT3");
+
+    // Счетчик устройств, еще не завершивших операцию
+    struct Round
+    {
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t pendingDevices = 0;
+
+        void onDeviceFinished()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pendingDevices == 0)
+                finished.notify_one();
+        }
+    };
+    struct Device
+    {
+        Device(EventLoop& eventLoop, const BaseEncoderExecutor& executor, Round& round) :
+            connection(eventLoop), executor(executor), round(round) {}
+
+        void sendNextMeterage()
+        {
+            MessagePipeline::encode(MessageVariant(MessageMeterage(++timeStamp, 7)), executor, wireBuffer, plainBuffer);
+            connection.sendMessage(wireBuffer);
+        }
+        void onReply()
+        {
+            if (--remaining > 0)
+                sendNextMeterage();
+            else
+                round.onDeviceFinished();
+        }
+
+        TcpClientConnection connection;
+        const BaseEncoderExecutor& executor;
+        Round& round;
+        uint64_t timeStamp = 0;
+        size_t remaining = 0;
+        std::string wireBuffer;
+        std::string plainBuffer;
+    };
+    struct ReplyHandler final : public AbstractMessageHandler
+    {
+        ReplyHandler(Device* device) :
+            m_device(device) {}
+        void operator()(const std::string&) final { m_device->onReply(); }
+
+    private:
+        Device* m_device = nullptr;
+    };
+    struct ClientThread
+    {
+        EventLoop eventLoop;
+        std::vector<Device*> devices;
+        std::thread thread;
+    };
+    struct StartRoundAction final : public AbstractAction
+    {
+        StartRoundAction(ClientThread& client, size_t roundTrips) :
+            m_client(client), m_roundTrips(roundTrips) {}
+        void operator()() final
+        {
+            for (auto* device : m_client.devices)
+            {
+                device->remaining = m_roundTrips;
+                device->sendNextMeterage();
+            }
+        }
+
+    private:
+        ClientThread& m_client;
+        size_t m_roundTrips = 0;
+    };
+    struct QuitAction final : public AbstractAction
+    {
+        QuitAction(EventLoop& eventLoop) :
+            m_eventLoop(eventLoop) {}
+        void operator()() final
+        {
+            m_eventLoop.quit();
+        }
+
+    private:
+        EventLoop& m_eventLoop;
+    };
+
+    const size_t cpuCount = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t shardCount : { 1, 2, 4 })
+    {
+        const std::string name = "sharded/" + std::to_string(shardCount) + "/meterage round-trips x"
+            + std::to_string(shardCount * devicesPerThread * roundTrips);
+        if (!runner.enabled(name))
+            continue;
+        ShardedDeviceMonitoringServer server(shardCount);
+        server.selectExecutor(executor->name());
+        uint64_t port = 0;
+        for (uint64_t candidate = 30100; candidate < 30200 && !port; ++candidate)
+            port = server.listen(candidate) ? candidate : 0;
+        if (!port)
+        {
+            std::cerr << "Sharded benchmarks skipped: no free port\n";
+            return;
+        }
+
+        Round round;
+        std::vector<ClientThread*> clients;
+        uint64_t deviceId = 0;
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            auto* client = new ClientThread;
+            for (size_t j = 0; j < devicesPerThread; ++j)
+            {
+                auto* device = new Device(client->eventLoop, *executor, round);
+                device->connection.setMessageHandler(new ReplyHandler(device));
+                device->connection.bind(++deviceId);
+                server.setDeviceWorkSchedule({ deviceId, { { 0u, 10u } } });
+                device->connection.connectToHost(port);
+                client->devices.push_back(device);
+            }
+            client->thread = std::thread([client] { client->eventLoop.run(); });
+            clients.push_back(client);
+        }
+        bool connected = false;
+        for (int i = 0; i < 1000 && !connected; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            connected = true;
+            for (uint64_t id = 1; id <= deviceId && connected; ++id)
+                connected = server.deviceShard(id) != DeviceDirectory::noShard;
+        }
+
+        if (connected)
+        {
+            runner.run(name, 0, [&] {
+                std::unique_lock<std::mutex> lock(round.mutex);
+                round.pendingDevices = deviceId;
+                for (auto* client : clients)
+                    client->eventLoop.invoke(new StartRoundAction(*client, roundTrips));
+                round.finished.wait(lock, [&round] { return round.pendingDevices == 0; });
+            });
+        }
+        else
+            std::cerr << "Sharded benchmark with " << shardCount << " shards skipped: cannot connect\n";
+        if (shardCount > cpuCount)
+            std::cerr << name << ": " << shardCount << " shards and client threads on " << cpuCount << " CPUs\n";
+
+        for (auto* client : clients)
+        {
+            client->eventLoop.invoke(new QuitAction(client->eventLoop));
+            client->thread.join();
+            for (auto* device : client->devices)
+                delete device;
+            delete client;
+        }
+    }
+}
+
+static const char* simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::Sse2:
+        return "sse2";
+    case SimdLevel::Ssse3:
+        return "ssse3";
+    case SimdLevel::Avx2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+static void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --filter=TEXT       run benchmarks whose name contains TEXT\n"
+              << "  --samples=N         measured samples per benchmark (default 50)\n"
+              << "  --min-time-ms=N     minimal duration of one sample (default 2)\n"
+              << "  --simd=LEVEL        scalar, sse2, ssse3 or avx2 (default: detected)\n"
+              << "  --json=FILE         write JSON to FILE instead of standard output\n";
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkRunner::Options options;
+    std::string jsonPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        auto value = [&arg](const char* prefix) -> const char* {
+            return arg.compare(0, std::strlen(prefix), prefix) == 0 ? arg.c_str() + std::strlen(prefix) : nullptr;
+        };
+        if (const char* v = value("--filter="))
+            options.filter = v;
+        else if (const char* v = value("--samples="))
+            options.samples = std::max<size_t>(1, std::stoul(v));
+        else if (const char* v = value("--min-time-ms="))
+            options.minSampleTime = std::chrono::milliseconds(std::stoul(v));
+        else if (const char* v = value("--json="))
+            jsonPath = v;
+        else if (const char* v = value("--simd="))
+        {
+            bool found = false;
+            for (auto level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Ssse3, SimdLevel::Avx2 })
+            {
+                if (simdLevelName(level) == std::string(v))
+                {
+                    setSimdLevel(level);
+                    found = true;
+                }
+            }
+            if (!found)
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    BenchmarkRunner runner(options);
+    benchmarkEncoders(runner);
+    benchmarkSerializer(runner);
+    benchmarkBigEndian<uint16_t>(runner, "uint16_t");
+    benchmarkBigEndian<uint32_t>(runner, "uint32_t");
+    benchmarkBigEndian<uint64_t>(runner, "uint64_t");
+    benchmarkTransport<TcpConnectionServer, TcpClientConnection>(runner, "tcp/epoll");
+    if (IoUringConnectionServer::isSupported())
+        benchmarkTransport<IoUringConnectionServer, TcpClientConnection>(runner, "tcp/io_uring");
+    benchmarkTransport<ShmConnectionServer, ShmClientConnection>(runner, "shm");
+    benchmarkTransport<UdpConnectionServer, UdpClientConnection>(runner, "udp", UdpDatagram::maxMessageSize());
+    benchmarkSharded(runner);
+
+    const std::vector<std::pair<std::string, std::string>> context = {
+        { "compiler", __VERSION__ },
+        { "simd_level", simdLevelName(simdLevel()) },
+        { "aes_ni", aesNiEnabled() ? "true" : "false" },
+        { "samples", std::to_string(options.samples) },
+        { "min_sample_time_ms", std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(options.minSampleTime).count()) },
+    };
+    runner.printTable(std::cerr);
+    if (jsonPath.empty())
+        runner.printJson(std::cout, context);
+    else
+    {
+        std::ofstream file(jsonPath);
+        runner.printJson(file, context);
+        if (!file)
+        {
+            std::cerr << "Cannot write " << jsonPath << '\n';
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "bigendian.h"
+#include "cpufeatures.h"
+
+#if defined(__x86_64__) && defined(__GNUC__) && defined(BIGENDIAN_BYTESWAP_BUILTINS)
+#define BIGENDIAN_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/*!
+ * \brief Скалярная перестановка байтов \a count элементов типа \a T из \a in в \a out
+ */
+template <typename T>
+static void swapScalar(void* out, const void* in, size_t count)
+{
+    auto* dst = static_cast<char*>(out);
+    const auto* src = static_cast<const char*>(in);
+    for (size_t i = 0; i < count; ++i)
+    {
+        T value;
+        std::memcpy(&value, src + i * sizeof(T), sizeof(T));
+        value = hostToBigEndian(value);
+        std::memcpy(dst + i * sizeof(T), &value, sizeof(T));
+    }
+}
+
+#ifdef BIGENDIAN_X86_KERNELS
+
+/*!
+ * \brief Маска pshufb, переставляющая байты внутри каждого элемента размером \a Size
+ */
+template <size_t Size>
+static inline __m128i swapMask()
+{
+    alignas(16) char mask[16];
+    for (size_t i = 0; i < 16; ++i)
+        mask[i] = static_cast<char>((i / Size) * Size + (Size - 1 - i % Size));
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+}
+
+template <typename T>
+__attribute__((target("ssse3"))) static void swapSsse3(void* out, const void* in, size_t count)
+{
+    auto* dst = static_cast<char*>(out);
+    const auto* src = static_cast<const char*>(in);
+    const size_t bytes = count * sizeof(T);
+    const __m128i mask = swapMask<sizeof(T)>();
+    size_t i = 0;
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(v, mask));
+    }
+    swapScalar<T>(dst + i, src + i, (bytes - i) / sizeof(T));
+}
+
+template <typename T>
+__attribute__((target("avx2"))) static void swapAvx2(void* out, const void* in, size_t count)
+{
+    auto* dst = static_cast<char*>(out);
+    const auto* src = static_cast<const char*>(in);
+    const size_t bytes = count * sizeof(T);
+    const __m128i mask128 = swapMask<sizeof(T)>();
+    const __m256i mask = _mm256_broadcastsi128_si256(mask128);
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(v, mask));
+    }
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(v, mask128));
+    }
+    swapScalar<T>(dst + i, src + i, (bytes - i) / sizeof(T));
+}
+
+#endif // BIGENDIAN_X86_KERNELS
+
+template <typename T>
+static void swapBytes(void* out, const void* in, size_t count)
+{
+#ifdef BIGENDIAN_X86_KERNELS
+    switch (simdLevel())
+    {
+    case SimdLevel::Avx2:
+        return swapAvx2<T>(out, in, count);
+    case SimdLevel::Ssse3:
+        return swapSsse3<T>(out, in, count);
+    default:
+        break;
+    }
+#endif
+    swapScalar<T>(out, in, count);
+}
+
+void toBigEndian(char* buffer, const uint16_t* values, size_t count)
+{
+    swapBytes<uint16_t>(buffer, values, count);
+}
+
+void toBigEndian(char* buffer, const uint32_t* values, size_t count)
+{
+    swapBytes<uint32_t>(buffer, values, count);
+}
+
+void toBigEndian(char* buffer, const uint64_t* values, size_t count)
+{
+    swapBytes<uint64_t>(buffer, values, count);
+}
+
+void fromBigEndian(uint16_t* values, const char* buffer, size_t count)
+{
+    swapBytes<uint16_t>(values, buffer, count);
+}
+
+void fromBigEndian(uint32_t* values, const char* buffer, size_t count)
+{
+    swapBytes<uint32_t>(values, buffer, count);
+}
+
+void fromBigEndian(uint64_t* values, const char* buffer, size_t count)
+{
+    swapBytes<uint64_t>(values, buffer, count);
+}
@@ -1,6 +1,9 @@
 #ifndef BIGENDIAN_H
 #define BIGENDIAN_H
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <istream>
 #include <ostream>
 #include <type_traits>
@@ -41,4 +44,79 @@ T fromBigEndian(std::istream& istream)
     return value;
 }
 
-#endif // BIGENDIAN_H
\ No newline at end of file
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define BIGENDIAN_BYTESWAP_BUILTINS
+#endif
+
+/*!
+ * \brief Перевести беззнаковое целое \a value из порядка байтов платформы в Big Endian и обратно
+ */
+template <typename T>
+T hostToBigEndian(T value)
+{
+    static_assert(std::is_unsigned_v<T>, "hostToBigEndian requires an unsigned type");
+#ifdef BIGENDIAN_BYTESWAP_BUILTINS
+    if constexpr (sizeof(value) == 8)
+        return __builtin_bswap64(value);
+    else if constexpr (sizeof(value) == 4)
+        return __builtin_bswap32(value);
+    else if constexpr (sizeof(value) == 2)
+        return __builtin_bswap16(value);
+    else
+        return value;
+#else
+    unsigned char bytes[sizeof(value)];
+    for (size_t i = sizeof(value); i > 0; --i)
+    {
+        bytes[i - 1] = static_cast<unsigned char>(value & 0xFF);
+        value = static_cast<T>(value >> 8);
+    }
+    T result;
+    std::memcpy(&result, bytes, sizeof(result));
+    return result;
+#endif
+}
+
+/*!
+ * \brief Функция сериализации целого числа \a value типа \a T в буфер \a buffer в виде последовательности байтов в порядке Big Endian
+ * \return указатель на байт, следующий за записанными
+ */
+template <typename T>
+char* toBigEndian(char* buffer, T value)
+{
+    using unsigned_T = std::make_unsigned_t<T>;
+    const unsigned_T swapped = hostToBigEndian(static_cast<unsigned_T>(value));
+    std::memcpy(buffer, &swapped, sizeof(swapped));
+    return buffer + sizeof(swapped);
+}
+
+/*!
+ * \brief Функция десериализации целого числа типа \a T из буфера \a buffer в виде последовательности байтов в порядке Big Endian
+ * \note Буфер должен содержать не менее sizeof(T) байтов
+ */
+template <typename T>
+T fromBigEndian(const char* buffer)
+{
+    using unsigned_T = std::make_unsigned_t<T>;
+    unsigned_T value;
+    std::memcpy(&value, buffer, sizeof(value));
+    return static_cast<T>(hostToBigEndian(value));
+}
+
+/*!
+ * \brief Функции пакетной сериализации массива \a values из \a count чисел в буфер \a buffer в порядке Big Endian.
+ * \note Используют векторные инструкции SSSE3/AVX2, если они поддерживаются процессором
+ */
+void toBigEndian(char* buffer, const uint16_t* values, size_t count);
+void toBigEndian(char* buffer, const uint32_t* values, size_t count);
+void toBigEndian(char* buffer, const uint64_t* values, size_t count);
+
+/*!
+ * \brief Функции пакетной десериализации \a count чисел из буфера \a buffer в порядке Big Endian в массив \a values.
+ * \note Используют векторные инструкции SSSE3/AVX2, если они поддерживаются процессором
+ */
+void fromBigEndian(uint16_t* values, const char* buffer, size_t count);
+void fromBigEndian(uint32_t* values, const char* buffer, size_t count);
+void fromBigEndian(uint64_t* values, const char* buffer, size_t count);
+
+#endif // BIGENDIAN_H
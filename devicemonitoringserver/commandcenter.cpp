@@ -1,13 +1,58 @@
 #include "commandcenter.h"
 
+#include "cpufeatures.h"
 #include "messagecommand.h"
 #include "messageerror.h"
 #include "messagemeterage.h"
+#include "messagemulticommand.h"
+#include "messagemultimeterage.h"
 
 #include <algorithm>
 #include <cmath>
 #include <numeric>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*!
+ * \brief Вычислить команды по всем каналам: commands[i] = targets[i] - meterages[i].
+ *
+ * Разность вычисляется по модулю 256, как и при приведении int к int8_t в MessageCommand,
+ * поэтому векторная реализация (16 каналов за инструкцию) совпадает со скалярной.
+ */
+static void computeCommands(int8_t* commands, const uint8_t* targets, const uint8_t* meterages, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    if (simdLevel() >= SimdLevel::Sse2)
+    {
+        for (; i + sizeof(__m128i) <= count; i += sizeof(__m128i))
+        {
+            const __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(targets + i));
+            const __m128i meterage = _mm_loadu_si128(reinterpret_cast<const __m128i*>(meterages + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(commands + i), _mm_sub_epi8(target, meterage));
+        }
+    }
+#endif
+    for (; i < count; ++i)
+        commands[i] = static_cast<int8_t>(targets[i] - meterages[i]);
+}
+
+/*!
+ * \brief СКО по каналам по суммам квадратов отклонений и количеству измерений
+ */
+static std::vector<double> deviations(const std::vector<uint64_t>& squareDiffSums, uint64_t count)
+{
+    std::vector<double> result(squareDiffSums.size(), 0.0);
+    if (count)
+    {
+        for (size_t i = 0; i < result.size(); ++i)
+            result[i] = std::sqrt(static_cast<double>(squareDiffSums[i]) / count);
+    }
+    return result;
+}
+
 void CommandCenter::setSchedule(const DeviceWorkSchedule& schedule)
 {
     auto& scheduleInfo = m_scheduleInfo[schedule.deviceId];
@@ -18,19 +63,40 @@ void CommandCenter::setSchedule(const DeviceWorkSchedule& schedule)
               [](const Phase& phaseA, const Phase& phaseB) { return phaseA.timeStamp < phaseB.timeStamp; });
 }
 
+void CommandCenter::setMultiChannelSchedule(const MultiChannelDeviceWorkSchedule& schedule)
+{
+    auto& scheduleInfo = m_multiChannelScheduleInfo[schedule.deviceId];
+    scheduleInfo = {};
+    scheduleInfo.phases = schedule.schedule;
+    std::sort(scheduleInfo.phases.begin(),
+              scheduleInfo.phases.end(),
+              [](const MultiChannelPhase& phaseA, const MultiChannelPhase& phaseB) { return phaseA.timeStamp < phaseB.timeStamp; });
+}
+
 std::unique_ptr<Message> CommandCenter::processMeterage(uint64_t deviceId, MessageMeterage meterage)
+{
+    return toMessagePtr(processMeterageValue(deviceId, meterage));
+}
+
+MessageVariant CommandCenter::processMeterageValue(uint64_t deviceId, const MessageMeterage& meterage)
+{
+    return std::visit([](const auto& reply) -> MessageVariant { return reply; },
+                      processMeterageRecord(deviceId, meterage));
+}
+
+MessageBatch::Record CommandCenter::processMeterageRecord(uint64_t deviceId, const MessageMeterage& meterage)
 {
     auto currentTimeStamp = meterage.timeStamp();
 
     auto lastTimeStampIt = m_lastTimeStamp.find(deviceId);
     if (lastTimeStampIt != m_lastTimeStamp.end() && lastTimeStampIt->second >= currentTimeStamp)
-        return std::unique_ptr<Message>(new MessageError(MessageError::ErrorType::Obsolete));
+        return MessageError(MessageError::ErrorType::Obsolete);
     m_lastTimeStamp[deviceId] = currentTimeStamp;
 
     auto& scheduleInfo = m_scheduleInfo[deviceId];
     auto& statsInfo = m_statsInfo[deviceId];
     if (scheduleInfo.phases.empty())
-        return std::unique_ptr<Message>(new MessageError(MessageError::ErrorType::NoSchedule));
+        return MessageError(MessageError::ErrorType::NoSchedule);
 
     while (scheduleInfo.currentPhaseIndex + 1 < scheduleInfo.phases.size()
            && scheduleInfo.phases[scheduleInfo.currentPhaseIndex + 1].timeStamp <= currentTimeStamp)
@@ -41,7 +107,7 @@ std::unique_ptr<Message> CommandCenter::processMeterage(uint64_t deviceId, Messa
     auto currentPhase = scheduleInfo.phases[scheduleInfo.currentPhaseIndex];
 
     if (currentPhase.timeStamp > currentTimeStamp)
-        return std::unique_ptr<Message>(new MessageError(MessageError::ErrorType::NoTimestamp));
+        return MessageError(MessageError::ErrorType::NoTimestamp);
 
     int command = currentPhase.value - meterage.meterage();
 
@@ -59,7 +125,73 @@ std::unique_ptr<Message> CommandCenter::processMeterage(uint64_t deviceId, Messa
     double deviation = std::sqrt(squareDiffsSum / statsInfo.squareDiffs.size());
     lastDeviationStatIt->deviation = deviation;
 
-    return std::unique_ptr<Message>(new MessageCommand(command));
+    return MessageCommand(command);
+}
+
+MessageBatch CommandCenter::processMeterages(uint64_t deviceId, const MessageBatch& batch)
+{
+    MessageBatch replies;
+    for (const auto& record : batch.records())
+    {
+        if (const auto* meterage = std::get_if<MessageMeterage>(&record))
+            replies.append(processMeterageRecord(deviceId, *meterage));
+    }
+    return replies;
+}
+
+MessageVariant CommandCenter::processMultiMeterage(uint64_t deviceId, const MessageMultiMeterage& meterage)
+{
+    auto currentTimeStamp = meterage.timeStamp();
+
+    auto lastTimeStampIt = m_lastTimeStamp.find(deviceId);
+    if (lastTimeStampIt != m_lastTimeStamp.end() && lastTimeStampIt->second >= currentTimeStamp)
+        return MessageError(MessageError::ErrorType::Obsolete);
+    m_lastTimeStamp[deviceId] = currentTimeStamp;
+
+    auto& scheduleInfo = m_multiChannelScheduleInfo[deviceId];
+    auto& statsInfo = m_multiChannelStatsInfo[deviceId];
+    if (scheduleInfo.phases.empty())
+        return MessageError(MessageError::ErrorType::NoSchedule);
+
+    while (scheduleInfo.currentPhaseIndex + 1 < scheduleInfo.phases.size()
+           && scheduleInfo.phases[scheduleInfo.currentPhaseIndex + 1].timeStamp <= currentTimeStamp)
+    {
+        ++scheduleInfo.currentPhaseIndex;
+    }
+
+    const auto& currentPhase = scheduleInfo.phases[scheduleInfo.currentPhaseIndex];
+
+    if (currentPhase.timeStamp > currentTimeStamp)
+        return MessageError(MessageError::ErrorType::NoTimestamp);
+
+    const auto& meterages = meterage.meterages();
+    if (currentPhase.values.size() != meterages.size())
+        return MessageError(MessageError::ErrorType::NoSchedule);
+
+    std::vector<int8_t> commands(meterages.size());
+    computeCommands(commands.data(), currentPhase.values.data(), meterages.data(), commands.size());
+
+    auto lastDeviationStatIt = statsInfo.deviationStats.rbegin();
+    if (lastDeviationStatIt == statsInfo.deviationStats.rend()
+        || lastDeviationStatIt->phase.timeStamp != currentPhase.timeStamp
+        || lastDeviationStatIt->phase.values != currentPhase.values)
+    {
+        if (lastDeviationStatIt != statsInfo.deviationStats.rend())
+            lastDeviationStatIt->deviations = deviations(statsInfo.squareDiffSums, statsInfo.count);
+        statsInfo.squareDiffSums.assign(commands.size(), 0);
+        statsInfo.count = 0;
+        statsInfo.deviationStats.push_back({ currentPhase, currentTimeStamp, {} });
+    }
+    // Для текущего этапа хранятся только суммы, СКО вычисляется при запросе статистики.
+    // Отклонение считается по исходным значениям: команда усечена до int8_t и для больших разностей неверна
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+        const int diff = int(currentPhase.values[i]) - int(meterages[i]);
+        statsInfo.squareDiffSums[i] += diff * diff;
+    }
+    ++statsInfo.count;
+
+    return MessageMultiCommand(std::move(commands));
 }
 
 std::vector<DeviationStats> CommandCenter::deviationStats(uint64_t deviceId) const
@@ -71,9 +203,50 @@ std::vector<DeviationStats> CommandCenter::deviationStats(uint64_t deviceId) con
         return {};
 }
 
+std::vector<MultiChannelDeviationStats> CommandCenter::multiChannelDeviationStats(uint64_t deviceId) const
+{
+    auto statsInfoIt = m_multiChannelStatsInfo.find(deviceId);
+    if (statsInfoIt == m_multiChannelStatsInfo.cend())
+        return {};
+    const auto& statsInfo = statsInfoIt->second;
+    auto stats = statsInfo.deviationStats;
+    if (!stats.empty())
+        stats.back().deviations = deviations(statsInfo.squareDiffSums, statsInfo.count);
+    return stats;
+}
+
+/*!
+ * \brief Переместить запись \a key из \a from в \a to; при ее отсутствии удалить запись в \a to
+ */
+template <class Map>
+static void moveEntry(uint64_t key, Map& from, Map& to)
+{
+    const auto it = from.find(key);
+    if (it == from.end())
+    {
+        to.erase(key);
+        return;
+    }
+    to[key] = std::move(it->second);
+    from.erase(it);
+}
+
+void CommandCenter::moveDevice(uint64_t deviceId, CommandCenter& other)
+{
+    if (&other == this)
+        return;
+    moveEntry(deviceId, m_scheduleInfo, other.m_scheduleInfo);
+    moveEntry(deviceId, m_statsInfo, other.m_statsInfo);
+    moveEntry(deviceId, m_multiChannelScheduleInfo, other.m_multiChannelScheduleInfo);
+    moveEntry(deviceId, m_multiChannelStatsInfo, other.m_multiChannelStatsInfo);
+    moveEntry(deviceId, m_lastTimeStamp, other.m_lastTimeStamp);
+}
+
 void CommandCenter::forgetDevice(uint64_t deviceId)
 {
     m_scheduleInfo.erase(deviceId);
     m_statsInfo.erase(deviceId);
+    m_multiChannelScheduleInfo.erase(deviceId);
+    m_multiChannelStatsInfo.erase(deviceId);
     m_lastTimeStamp.erase(deviceId);
 }
@@ -2,6 +2,7 @@
 #define COMMANDCENTER_H
 
 #include "deviceworkschedule.h"
+#include "messagevariant.h"
 
 #include <cstdint>
 #include <map>
@@ -9,8 +10,6 @@
 #include <vector>
 
 class DeviceMonitoringServer;
-class MessageMeterage;
-class Message;
 
 /*!
  * \brief Статистика СКО физических параметров от плана
@@ -22,6 +21,16 @@ struct DeviationStats
     double deviation = 0;        ///< СКО физического параметра от плана
 };
 
+/*!
+ * \brief Статистика СКО физических параметров от плана для устройства с несколькими каналами
+ */
+struct MultiChannelDeviationStats
+{
+    MultiChannelPhase phase;        ///< Этап плана
+    uint64_t firstTimestamp = 0;    ///< Временная метка первого измерения для данного этапа плана
+    std::vector<double> deviations; ///< СКО физических параметров от плана по каналам
+};
+
 /*!
  * \brief Класс командного центра для управления и ведения статистики по физическим параметрам
  */
@@ -32,6 +41,10 @@ public:
      * \brief Установить план работы устройства
      */
     void setSchedule(const DeviceWorkSchedule& schedule);
+    /*!
+     * \brief Установить план работы устройства с несколькими каналами
+     */
+    void setMultiChannelSchedule(const MultiChannelDeviceWorkSchedule& schedule);
     /*!
      * \brief Обработать сообщение с измерением
      * \param deviceId - идентификатор устройства
@@ -39,14 +52,49 @@ public:
      * \return сообшение с ответом
      */
     std::unique_ptr<Message> processMeterage(uint64_t deviceId, MessageMeterage meterage);
+    /*!
+     * \brief Обработать сообщение с измерением без выделения динамической памяти
+     * \param deviceId - идентификатор устройства
+     * \param meterage - сообшение с измерением
+     * \return сообшение с ответом
+     */
+    MessageVariant processMeterageValue(uint64_t deviceId, const MessageMeterage& meterage);
+    /*!
+     * \brief Обработать пакет сообщений с измерениями за один проход
+     * \param deviceId - идентификатор устройства
+     * \param batch - пакет сообщений; записи, не являющиеся измерениями, пропускаются
+     * \return пакет ответов в порядке следования измерений
+     */
+    MessageBatch processMeterages(uint64_t deviceId, const MessageBatch& batch);
+    /*!
+     * \brief Обработать сообщение с измерениями по нескольким каналам
+     * \param deviceId - идентификатор устройства
+     * \param meterage - сообщение с измерениями
+     * \return сообщение с командами по всем каналам или сообщение об ошибке;
+     * если количество каналов не совпадает с планом, возвращается ошибка NoSchedule
+     */
+    MessageVariant processMultiMeterage(uint64_t deviceId, const MessageMultiMeterage& meterage);
     /*!
      * \brief Статистика СКО физических параметров от плана для устройства с идентификатором \a deviceId
      */
     std::vector<DeviationStats> deviationStats(uint64_t deviceId) const;
+    /*!
+     * \brief Статистика СКО физических параметров от плана по каналам для устройства с идентификатором \a deviceId
+     */
+    std::vector<MultiChannelDeviationStats> multiChannelDeviationStats(uint64_t deviceId) const;
     /*!
      * \brief Удалить всю известную информацию об устройстве с идентификатором \a deviceId
      */
     void forgetDevice(uint64_t deviceId);
+    /*!
+     * \brief Передать всю информацию об устройстве \a deviceId командному центру \a other
+     *
+     * Прежняя информация об устройстве в \a other заменяется, в этом командном центре удаляется.
+     */
+    void moveDevice(uint64_t deviceId, CommandCenter& other);
+
+private:
+    MessageBatch::Record processMeterageRecord(uint64_t deviceId, const MessageMeterage& meterage);
 
 private:
     struct ScheduleInfo
@@ -59,8 +107,21 @@ private:
         std::vector<double> squareDiffs;
         std::vector<DeviationStats> deviationStats;
     };
+    struct MultiChannelScheduleInfo
+    {
+        std::vector<MultiChannelPhase> phases;
+        size_t currentPhaseIndex = 0;
+    };
+    struct MultiChannelStatsInfo
+    {
+        std::vector<uint64_t> squareDiffSums; ///< Суммы квадратов отклонений по каналам для текущего этапа
+        uint64_t count = 0;                   ///< Количество измерений для текущего этапа
+        std::vector<MultiChannelDeviationStats> deviationStats;
+    };
     std::map<uint64_t, ScheduleInfo> m_scheduleInfo;
     std::map<uint64_t, StatsInfo> m_statsInfo;
+    std::map<uint64_t, MultiChannelScheduleInfo> m_multiChannelScheduleInfo;
+    std::map<uint64_t, MultiChannelStatsInfo> m_multiChannelStatsInfo;
     std::map<uint64_t, uint64_t> m_lastTimeStamp;
 };
 
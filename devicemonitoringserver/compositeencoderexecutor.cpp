@@ -0,0 +1,278 @@
+#include "compositeencoderexecutor.h"
+#include "rot3encoderexecutor.h"
+
+static void mapBytes(const BaseEncoderExecutor::ByteMap& table, char* out, const char* in, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        out[i] = static_cast<char>(table[static_cast<uint8_t>(in[i])]);
+}
+
+/*!
+ * \brief Является ли таблица \a table сдвигом байтов по модулю 256
+ * \param delta - величина сдвига
+ */
+static bool isRotation(const BaseEncoderExecutor::ByteMap& table, uint8_t& delta)
+{
+    delta = table[0];
+    for (size_t c = 0; c < table.size(); ++c)
+    {
+        if (table[c] != static_cast<uint8_t>(c + delta))
+            return false;
+    }
+    return true;
+}
+
+static bool isIdentity(const BaseEncoderExecutor::ByteMap& table)
+{
+    for (size_t c = 0; c < table.size(); ++c)
+    {
+        if (table[c] != c)
+            return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief Построить обратную таблицу \a inverse
+ * \return false, если таблица \a table не является перестановкой
+ */
+static bool invert(const BaseEncoderExecutor::ByteMap& table, BaseEncoderExecutor::ByteMap& inverse)
+{
+    std::array<bool, 256> seen = {};
+    for (size_t c = 0; c < table.size(); ++c)
+    {
+        if (seen[table[c]])
+            return false;
+        seen[table[c]] = true;
+        inverse[table[c]] = static_cast<uint8_t>(c);
+    }
+    return true;
+}
+
+CompositeEncoderExecutor::CompositeEncoderExecutor(std::string name, const std::vector<std::shared_ptr<const BaseEncoderExecutor>>& stages) :
+    m_name(std::move(name))
+{
+    for (const auto& executor : stages)
+    {
+        if (!executor)
+            continue;
+        // Вложенная цепочка разворачивается: звенья используют общий промежуточный буфер потока
+        if (const auto* composite = dynamic_cast<const CompositeEncoderExecutor*>(executor.get()))
+        {
+            for (const auto& stage : composite->m_stages)
+                append(stage);
+            continue;
+        }
+        Stage stage;
+        stage.executor = executor;
+        stage.byteMapped = executor->byteMap(stage.encodeTable) && invert(stage.encodeTable, stage.decodeTable);
+        // Вызов с пустыми данными сообщает о поддержке работы на месте
+        char probe = 0;
+        stage.inPlace = executor->lengthPreserving() && executor->encodeInPlace(&probe, 0) && executor->decodeInPlace(&probe, 0);
+        // Замена байтов без собственной реализации на месте выполняется по таблице
+        if (stage.byteMapped && !stage.inPlace)
+        {
+            stage.executor = nullptr;
+            stage.inPlace = true;
+        }
+        append(stage);
+    }
+    // Тождественные замены (например, ROT3 вслед за обратным ему сдвигом) не выполняются
+    std::vector<Stage> stagesLeft;
+    for (const auto& stage : m_stages)
+    {
+        if (!stage.byteMapped || !isIdentity(stage.encodeTable))
+            stagesLeft.push_back(stage);
+    }
+    m_stages = std::move(stagesLeft);
+    for (auto& stage : m_stages)
+    {
+        if (!stage.executor)
+            stage.rotation = isRotation(stage.encodeTable, stage.delta);
+        m_lengthPreserving = m_lengthPreserving && stage.lengthPreserving();
+        m_inPlace = m_inPlace && stage.inPlace;
+    }
+}
+
+void CompositeEncoderExecutor::append(const Stage& stage)
+{
+    if (!stage.byteMapped || m_stages.empty() || !m_stages.back().byteMapped)
+    {
+        m_stages.push_back(stage);
+        return;
+    }
+    // Объединенная замена выполняется по таблице вместо реализаций алгоритмов
+    auto& last = m_stages.back();
+    last.executor = nullptr;
+    last.inPlace = true;
+    for (auto& value : last.encodeTable)
+        value = stage.encodeTable[value];
+    invert(last.encodeTable, last.decodeTable);
+}
+
+bool CompositeEncoderExecutor::Stage::apply(bool encode, std::string_view input, std::string& output) const
+{
+    if (executor)
+        return encode ? executor->encodeTo(input, output) : executor->decodeTo(input, output);
+    output.resize(input.size());
+    applyTable(encode, &output[0], input.data(), input.size());
+    return true;
+}
+
+bool CompositeEncoderExecutor::Stage::applyInPlace(bool encode, char* data, size_t size) const
+{
+    if (executor)
+        return encode ? executor->encodeInPlace(data, size) : executor->decodeInPlace(data, size);
+    applyTable(encode, data, data, size);
+    return true;
+}
+
+void CompositeEncoderExecutor::Stage::applyTable(bool encode, char* out, const char* in, size_t size) const
+{
+    if (rotation)
+        Rot3EncoderExecutor::rotate(out, in, size, encode ? delta : static_cast<uint8_t>(-delta));
+    else
+        mapBytes(encode ? encodeTable : decodeTable, out, in, size);
+}
+
+bool CompositeEncoderExecutor::run(bool encode, std::string_view message, std::string& output) const
+{
+    // Звенья пишут поочередно в output и промежуточный буфер потока; звенья, сохраняющие
+    // размер, работают на месте в буфере с результатом предыдущего звена
+    thread_local std::string scratch;
+    std::string* buffers[] = { &output, &scratch };
+    int held = -1;
+    std::string_view current = message;
+    const size_t count = m_stages.size();
+    for (size_t k = 0; k < count; ++k)
+    {
+        const auto& stage = m_stages[encode ? k : count - 1 - k];
+        if (held >= 0 && stage.inPlace && stage.lengthPreserving())
+        {
+            auto& buffer = *buffers[held];
+            if (!stage.applyInPlace(encode, &buffer[0], buffer.size()))
+                return false;
+            continue;
+        }
+        const int target = held == 0 ? 1 : 0;
+        if (!stage.apply(encode, current, *buffers[target]))
+            return false;
+        held = target;
+        current = *buffers[held];
+    }
+    if (held < 0)
+        output.assign(message.data(), message.size());
+    else if (held == 1)
+        output.swap(scratch);
+    return true;
+}
+
+std::string CompositeEncoderExecutor::encode(const std::string& message) const
+{
+    std::string encoded;
+    run(true, message, encoded);
+    return encoded;
+}
+
+std::string CompositeEncoderExecutor::decode(const std::string& message) const
+{
+    std::string decoded;
+    run(false, message, decoded);
+    return decoded;
+}
+
+size_t CompositeEncoderExecutor::maxEncodedSize(size_t size) const
+{
+    for (const auto& stage : m_stages)
+    {
+        if (stage.byteMapped || size == unknownSize)
+            continue;
+        size = stage.executor->maxEncodedSize(size);
+    }
+    return size;
+}
+
+size_t CompositeEncoderExecutor::maxDecodedSize(size_t size) const
+{
+    for (auto it = m_stages.rbegin(); it != m_stages.rend(); ++it)
+    {
+        if (it->byteMapped || size == unknownSize)
+            continue;
+        size = it->executor->maxDecodedSize(size);
+    }
+    return size;
+}
+
+std::optional<size_t> CompositeEncoderExecutor::encodeInto(std::string_view message, char* output, size_t outputSize) const
+{
+    thread_local std::string result;
+    if (!run(true, message, result) || result.size() > outputSize)
+        return {};
+    std::memcpy(output, result.data(), result.size());
+    return result.size();
+}
+
+std::optional<size_t> CompositeEncoderExecutor::decodeInto(std::string_view message, char* output, size_t outputSize) const
+{
+    thread_local std::string result;
+    if (!run(false, message, result) || result.size() > outputSize)
+        return {};
+    std::memcpy(output, result.data(), result.size());
+    return result.size();
+}
+
+bool CompositeEncoderExecutor::encodeInPlace(char* data, size_t size) const
+{
+    if (!m_lengthPreserving || !m_inPlace)
+        return false;
+    for (const auto& stage : m_stages)
+        stage.applyInPlace(true, data, size);
+    return true;
+}
+
+bool CompositeEncoderExecutor::decodeInPlace(char* data, size_t size) const
+{
+    if (!m_lengthPreserving || !m_inPlace)
+        return false;
+    for (auto it = m_stages.rbegin(); it != m_stages.rend(); ++it)
+        it->applyInPlace(false, data, size);
+    return true;
+}
+
+size_t CompositeEncoderExecutor::encodedUnitSize() const
+{
+    // Байт шифруется в единицу первого звена, каждый ее байт - в единицу следующего и т. д.
+    size_t unit = 1;
+    for (const auto& stage : m_stages)
+    {
+        const size_t stageUnit = stage.byteMapped ? 1 : stage.executor->encodedUnitSize();
+        if (stageUnit == 0)
+            return 0;
+        unit *= stageUnit;
+    }
+    return unit;
+}
+
+bool CompositeEncoderExecutor::byteMap(ByteMap& table) const
+{
+    for (size_t c = 0; c < table.size(); ++c)
+        table[c] = static_cast<uint8_t>(c);
+    for (const auto& stage : m_stages)
+    {
+        if (!stage.byteMapped)
+            return false;
+        for (auto& value : table)
+            value = stage.encodeTable[value];
+    }
+    return true;
+}
+
+bool CompositeEncoderExecutor::encodeTo(std::string_view message, std::string& output) const
+{
+    return run(true, message, output);
+}
+
+bool CompositeEncoderExecutor::decodeTo(std::string_view message, std::string& output) const
+{
+    return run(false, message, output);
+}
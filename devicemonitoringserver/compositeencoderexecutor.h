@@ -0,0 +1,79 @@
+#ifndef COMPOSITEENCODEREXECUTOR_H
+#define COMPOSITEENCODEREXECUTOR_H
+
+#include "baseencoderexecutor.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+ * \brief Цепочка алгоритмов шифрования, применяемых последовательно
+ *
+ * При создании подряд идущие замены байтов (BaseEncoderExecutor::byteMap()) объединяются
+ * в одну таблицу из 256 элементов; одиночная замена остается собственной реализацией алгоритма,
+ * а таблица-сдвиг (например, несколько ROT3) выполняется векторной реализацией сдвига.
+ * Прочие звенья передают данные друг другу через два чередующихся буфера, а звенья,
+ * сохраняющие размер, выполняются на месте.
+ */
+class CompositeEncoderExecutor final : public BaseEncoderExecutor
+{
+public:
+    /*!
+     * \brief Конструктор.
+     * \param name - название цепочки
+     * \param stages - звенья в порядке шифрования; цепочка разделяет владение ими
+     */
+    CompositeEncoderExecutor(std::string name, const std::vector<std::shared_ptr<const BaseEncoderExecutor>>& stages);
+
+    std::string encode(const std::string& message) const override final;
+    std::string decode(const std::string& message) const override final;
+    std::string name() const override final { return m_name; }
+    size_t maxEncodedSize(size_t size) const override final;
+    size_t maxDecodedSize(size_t size) const override final;
+    std::optional<size_t> encodeInto(std::string_view message, char* output, size_t outputSize) const override final;
+    std::optional<size_t> decodeInto(std::string_view message, char* output, size_t outputSize) const override final;
+    bool lengthPreserving() const override final { return m_lengthPreserving; }
+    bool encodeInPlace(char* data, size_t size) const override final;
+    bool decodeInPlace(char* data, size_t size) const override final;
+    bool byteMap(ByteMap& table) const override final;
+    size_t encodedUnitSize() const override final;
+    bool encodeTo(std::string_view message, std::string& output) const override final;
+    bool decodeTo(std::string_view message, std::string& output) const override final;
+
+    /*!
+     * \brief Количество звеньев после объединения замен байтов
+     */
+    size_t stageCount() const { return m_stages.size(); }
+
+private:
+    /*!
+     * \brief Звено цепочки: алгоритм или объединенная таблица замены байтов
+     */
+    struct Stage
+    {
+        std::shared_ptr<const BaseEncoderExecutor> executor; ///< nullptr - звено задано таблицами
+        bool byteMapped = false;                       ///< Звено является заменой байтов, таблицы заполнены
+        bool inPlace = true;                           ///< Звено поддерживает шифрование и расшифровку на месте
+        bool rotation = false;                         ///< Объединенная таблица является сдвигом байтов на delta
+        uint8_t delta = 0;
+        ByteMap encodeTable = {};
+        ByteMap decodeTable = {};
+
+        bool lengthPreserving() const { return byteMapped || executor->lengthPreserving(); }
+        bool apply(bool encode, std::string_view input, std::string& output) const;
+        bool applyInPlace(bool encode, char* data, size_t size) const;
+        void applyTable(bool encode, char* out, const char* in, size_t size) const;
+    };
+
+    void append(const Stage& stage);
+    bool run(bool encode, std::string_view message, std::string& output) const;
+
+private:
+    std::string m_name;
+    std::vector<Stage> m_stages;
+    bool m_lengthPreserving = true;
+    bool m_inPlace = true;
+};
+
+#endif // COMPOSITEENCODEREXECUTOR_H
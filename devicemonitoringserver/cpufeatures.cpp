@@ -0,0 +1,52 @@
+#include "cpufeatures.h"
+
+#include <atomic>
+
+static SimdLevel detect()
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::Avx2;
+    if (__builtin_cpu_supports("ssse3"))
+        return SimdLevel::Ssse3;
+    if (__builtin_cpu_supports("sse2"))
+        return SimdLevel::Sse2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+static std::atomic<SimdLevel>& activeLevel()
+{
+    static std::atomic<SimdLevel> level { detectedSimdLevel() };
+    return level;
+}
+
+SimdLevel detectedSimdLevel()
+{
+    static const SimdLevel level = detect();
+    return level;
+}
+
+SimdLevel simdLevel()
+{
+    return activeLevel().load(std::memory_order_relaxed);
+}
+
+SimdLevel setSimdLevel(SimdLevel level)
+{
+    if (level > detectedSimdLevel())
+        level = detectedSimdLevel();
+    activeLevel().store(level, std::memory_order_relaxed);
+    return level;
+}
+
+bool aesNiEnabled()
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("aes") && __builtin_cpu_supports("sse2"));
+    return supported && simdLevel() != SimdLevel::Scalar;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,36 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+/*!
+ * \brief Уровни поддержки векторных инструкций (в порядке возрастания)
+ */
+enum class SimdLevel
+{
+    Scalar,
+    Sse2,
+    Ssse3,
+    Avx2
+};
+
+/*!
+ * \brief Максимальный уровень векторных инструкций, поддерживаемый процессором
+ */
+SimdLevel detectedSimdLevel();
+/*!
+ * \brief Уровень векторных инструкций, используемый для выбора реализаций алгоритмов
+ */
+SimdLevel simdLevel();
+/*!
+ * \brief Ограничить используемый уровень векторных инструкций (для тестов и замеров производительности)
+ * \param level - требуемый уровень; уровень выше поддерживаемого процессором игнорируется
+ * \return установленный уровень
+ */
+SimdLevel setSimdLevel(SimdLevel level);
+
+/*!
+ * \brief Можно ли использовать инструкции AES-NI
+ * \return false, если процессор их не поддерживает или уровень ограничен SimdLevel::Scalar
+ */
+bool aesNiEnabled();
+
+#endif // CPUFEATURES_H
@@ -0,0 +1,28 @@
+#include "devicedirectory.h"
+
+bool DeviceDirectory::attach(uint64_t deviceId, size_t shard, CommandCenter& commandCenter)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Как и сервер подключений, второе соединение устройства не принимаем
+    if (!m_shards.emplace(deviceId, shard).second)
+        return false;
+    m_commandCenter.moveDevice(deviceId, commandCenter);
+    return true;
+}
+
+void DeviceDirectory::detach(uint64_t deviceId, size_t shard, CommandCenter& commandCenter)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_shards.find(deviceId);
+    if (it == m_shards.end() || it->second != shard)
+        return;
+    commandCenter.moveDevice(deviceId, m_commandCenter);
+    m_shards.erase(it);
+}
+
+size_t DeviceDirectory::shardOf(uint64_t deviceId) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_shards.find(deviceId);
+    return it != m_shards.end() ? it->second : noShard;
+}
@@ -0,0 +1,75 @@
+#ifndef DEVICEDIRECTORY_H
+#define DEVICEDIRECTORY_H
+
+#include "commandcenter.h"
+#include "common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+/*!
+ * \brief Общий для шардов ShardedDeviceMonitoringServer справочник размещения устройств
+ *
+ * Информацию об устройстве (план, статистику, последнюю метку времени) хранит командный центр
+ * шарда, к которому устройство подключено; пока устройство не подключено - командный центр
+ * справочника. Справочник блокируется только при подключении и отключении устройств и при
+ * запросах из других потоков, а не на каждое сообщение.
+ */
+class DeviceDirectory
+{
+    NON_COPYABLE(DeviceDirectory)
+public:
+    /*!
+     * \brief Устройство не подключено ни к одному шарду
+     */
+    static constexpr size_t noShard = SIZE_MAX;
+
+    DeviceDirectory() = default;
+
+    /*!
+     * \brief Подключить устройство \a deviceId к шарду \a shard.
+     *
+     * Вызывается из потока шарда; информация об устройстве переносится в \a commandCenter шарда.
+     * \return false, если устройство уже подключено к другому шарду
+     */
+    bool attach(uint64_t deviceId, size_t shard, CommandCenter& commandCenter);
+    /*!
+     * \brief Отключить устройство \a deviceId от шарда \a shard и забрать информацию о нем из \a commandCenter.
+     *
+     * Вызывается из потока шарда.
+     */
+    void detach(uint64_t deviceId, size_t shard, CommandCenter& commandCenter);
+    /*!
+     * \brief Шард, к которому подключено устройство \a deviceId, или noShard.
+     *
+     * Для потока шарда, к которому подключено устройство, результат не изменится до detach().
+     */
+    size_t shardOf(uint64_t deviceId) const;
+    /*!
+     * \brief Если устройство \a deviceId не подключено, вызвать \a function(CommandCenter&)
+     * с командным центром справочника под блокировкой.
+     * \return noShard, если функция вызвана; иначе шард, к которому подключено устройство
+     */
+    template <class Function>
+    size_t accessDetached(uint64_t deviceId, Function&& function);
+
+private:
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint64_t, size_t> m_shards; ///< Шарды подключенных устройств
+    CommandCenter m_commandCenter;                 ///< Информация о неподключенных устройствах
+};
+
+template <class Function>
+size_t DeviceDirectory::accessDetached(uint64_t deviceId, Function&& function)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_shards.find(deviceId);
+    if (it != m_shards.end())
+        return it->second;
+    function(m_commandCenter);
+    return noShard;
+}
+
+#endif // DEVICEDIRECTORY_H
@@ -1,11 +1,16 @@
 #include "devicemock.h"
+#include "messagebatch.h"
 #include "messagecommand.h"
 #include "messageerror.h"
 #include "messagemeterage.h"
+#include "messagemeteragedelta.h"
+#include "messagemultimeterage.h"
 #include <handlers/abstractaction.h>
 #include <handlers/abstractmessagehandler.h>
 #include <server/abstractclientconnection.h>
 
+#include <algorithm>
+
 DeviceMock::DeviceMock(AbstractClientConnection* clientConnection) :
     m_clientConnection(clientConnection)
 {
@@ -78,16 +83,39 @@ void DeviceMock::sendMessage(const std::string& message) const
 
 void DeviceMock::onMessageReceived(const std::string& message)
 {
-    if (auto msg = MessageSerializer::deserialize(m_encoder.decode(message)))
-        m_messages.push_back(std::move(msg));
-    else
+    auto msg = MessageSerializer::deserializeValue(m_encoder.decode(message));
+    if (!msg)
         throw std::runtime_error("Message deserialization error!");
+    if (const auto* handshake = std::get_if<MessageHandshake>(&*msg))
+    {
+        m_messages.push_back(toMessagePtr(*msg));
+        if (handshake->encoderName() == Aes128CtrEncoderExecutor::algorithmName() && handshake->nonce()
+            && m_encryptionKey && m_handshakeNonce)
+        {
+            // Алгоритм с ключом соединения заменяет созданный при прошлом согласовании
+            m_encoder.addExecutor(new Aes128CtrEncoderExecutor(*m_encryptionKey, m_handshakeNonce, handshake->nonce()));
+            m_handshakeNonce = 0;
+        }
+        if (!handshake->encoderName().empty())
+            m_encoder.selectExecutor(handshake->encoderName());
+        setWireVersion(handshake->wireVersion());
+        setBatchSize(handshake->maxBatchSize());
+        return;
+    }
+    if (const auto* batch = std::get_if<MessageBatch>(&*msg))
+    {
+        for (const auto& record : batch->records())
+            m_messages.push_back(std::visit([](const auto& r) { return toMessagePtr(r); }, record));
+    }
+    else
+        m_messages.push_back(toMessagePtr(*msg));
 
     sendNextMeterage(); // Отправляем следующее измерение
 }
 
 void DeviceMock::onConnected()
 {
+    m_lastSentTimeStamp = 0;
 }
 
 void DeviceMock::onDisconnected()
@@ -97,9 +125,44 @@ void DeviceMock::onDisconnected()
 void DeviceMock::setMeterages(std::vector<uint8_t> meterages)
 {
     m_meterages = std::move(meterages);
+    m_channelMeterages.clear();
     m_timeStamp = 0;
 }
 
+void DeviceMock::setChannelMeterages(std::vector<std::vector<uint8_t>> meterages)
+{
+    m_channelMeterages = std::move(meterages);
+    m_meterages.clear();
+    m_timeStamp = 0;
+}
+
+void DeviceMock::setBatchSize(size_t batchSize)
+{
+    m_batchSize = std::max<size_t>(1, std::min(batchSize, MessageBatch::maxRecords()));
+}
+
+void DeviceMock::setWireVersion(WireVersion wireVersion)
+{
+    m_wireVersion = wireVersion;
+}
+
+void DeviceMock::setEncryptionKey(const Aes128CtrEncoderExecutor::Key& key)
+{
+    m_encryptionKey = key;
+}
+
+void DeviceMock::sendHandshake(const MessageHandshake& request)
+{
+    if (request.encoderName() != Aes128CtrEncoderExecutor::algorithmName() || !m_encryptionKey)
+    {
+        sendMessage(m_encoder.encode(MessageSerializer::serialize(request)));
+        return;
+    }
+    m_handshakeNonce = Aes128CtrEncoderExecutor::randomNonce();
+    sendMessage(m_encoder.encode(MessageSerializer::serialize(MessageHandshake(request.encoderName(), request.wireVersion(), request.maxBatchSize(),
+                                                                                request.compression(), m_handshakeNonce))));
+}
+
 void DeviceMock::startMeterageSending()
 {
     sendNextMeterage();
@@ -117,15 +180,44 @@ MessageEncoder& DeviceMock::messageEncoder()
 
 void DeviceMock::sendNextMeterage()
 {
-    if (m_timeStamp >= m_meterages.size())
+    std::string string;
+    uint64_t timeStamp = m_timeStamp;
+    if (!m_channelMeterages.empty())
+    {
+        if (timeStamp >= m_channelMeterages.size())
+            return;
+        string = MessageSerializer::serialize(MessageMultiMeterage(timeStamp, m_channelMeterages[timeStamp]));
+        ++timeStamp;
+    }
+    else if (timeStamp >= m_meterages.size())
         return;
-    const auto meterage = m_meterages.at(m_timeStamp);
-    auto string = MessageSerializer::serialize(MessageMeterage(m_timeStamp, meterage));
+    else if (m_batchSize > 1)
+    {
+        MessageBatch batch;
+        for (; timeStamp < m_meterages.size() && batch.records().size() < m_batchSize; ++timeStamp)
+            batch.append(makeMeterageRecord(timeStamp));
+        string = MessageSerializer::serialize(batch);
+    }
+    else
+    {
+        string = std::visit([](const auto& m) { return MessageSerializer::serialize(m); }, makeMeterageRecord(timeStamp));
+        ++timeStamp;
+    }
     if (!string.empty())
     {
         sendMessage(m_encoder.encode(string));
-        ++m_timeStamp;
+        m_timeStamp = timeStamp;
     }
     else
         throw std::runtime_error("Message serialization error!");
+}
+
+MessageBatch::Record DeviceMock::makeMeterageRecord(uint64_t timeStamp)
+{
+    MessageMeterage meterage(timeStamp, m_meterages.at(timeStamp));
+    const auto previousTimeStamp = m_lastSentTimeStamp;
+    m_lastSentTimeStamp = timeStamp;
+    if (m_wireVersion == WireVersion::V2)
+        return MessageMeterageDelta(meterage, previousTimeStamp);
+    return meterage;
 }
\ No newline at end of file
@@ -1,13 +1,18 @@
 #ifndef DEVICE_H
 #define DEVICE_H
 
+#include "aes128ctrencoderexecutor.h"
 #include "common.h"
 #include "message.h"
+#include "messagebatch.h"
+#include "messagehandshake.h"
 #include "messageencoder.h"
 #include "messageserializer.h"
+#include "wireversion.h"
 
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -44,6 +49,34 @@ public:
      * \param measurements - список измерений
      */
     void setMeterages(std::vector<uint8_t> meterages);
+    /*!
+     * \brief Установить количество измерений, отправляемых одним пакетом.
+     * \param batchSize - количество измерений; 1 - отправка измерений отдельными сообщениями
+     */
+    void setBatchSize(size_t batchSize);
+    /*!
+     * \brief Установить измерения по нескольким каналам для отправки сообщениями MessageMultiMeterage.
+     * \param meterages - измерения по каналам для каждой временной метки; заменяют измерения, заданные setMeterages()
+     */
+    void setChannelMeterages(std::vector<std::vector<uint8_t>> meterages);
+    /*!
+     * \brief Установить версию формата передачи измерений.
+     * \param wireVersion - версия формата; по умолчанию WireVersion::V1. Сервер принимает измерения
+     * WireVersion::V2 только после согласования этой версии (см. sendHandshake())
+     */
+    void setWireVersion(WireVersion wireVersion);
+    /*!
+     * \brief Отправить серверу запрос на согласование параметров соединения.
+     *
+     * Согласованные сервером алгоритм шифрования, версия формата и размер пакета
+     * применяются при получении ответа. При запросе Aes128CtrEncoderExecutor::algorithmName()
+     * и заданном setEncryptionKey() ключе к запросу добавляется случайный nonce устройства.
+     */
+    void sendHandshake(const MessageHandshake& request);
+    /*!
+     * \brief Установить ключ шифрования AES-128-CTR для согласования с сервером
+     */
+    void setEncryptionKey(const Aes128CtrEncoderExecutor::Key& key);
     /*!
      * \brief Начать отправку измерений.
      */
@@ -62,6 +95,10 @@ private:
      * \brief Отправить следующее измерение.
      */
     void sendNextMeterage();
+    /*!
+     * \brief Сформировать запись с измерением для отправки в соответствии с версией формата.
+     */
+    MessageBatch::Record makeMeterageRecord(uint64_t timeStamp);
     /*!
      * \brief Обработчик установления соединения.
      */
@@ -83,9 +120,15 @@ private:
 private:
     AbstractClientConnection* m_clientConnection = nullptr;
     std::vector<uint8_t> m_meterages;
+    std::vector<std::vector<uint8_t>> m_channelMeterages;
     uint64_t m_timeStamp = 0;
+    size_t m_batchSize = 1;
+    WireVersion m_wireVersion = WireVersion::V1;
+    uint64_t m_lastSentTimeStamp = 0;
     std::vector<std::unique_ptr<Message>> m_messages;
     MessageEncoder m_encoder;
+    std::optional<Aes128CtrEncoderExecutor::Key> m_encryptionKey;
+    uint64_t m_handshakeNonce = 0; ///< Nonce последнего запроса согласования AES-128-CTR
 };
 
 #endif // DEVICE_H
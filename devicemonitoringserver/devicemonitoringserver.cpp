@@ -1,13 +1,21 @@
 #include "devicemonitoringserver.h"
-#include "messagecommand.h"
-#include "messageerror.h"
+#include "baseencoderexecutor.h"
+#include "devicedirectory.h"
+#include "messagebatch.h"
+#include "messagehandshake.h"
 #include "messagemeterage.h"
+#include "messagemeteragedelta.h"
+#include "messagemultimeterage.h"
+#include "messagepipeline.h"
+#include "messagevariant.h"
 #include <handlers/abstractaction.h>
 #include <handlers/abstractmessagehandler.h>
 #include <handlers/abstractnewconnectionhandler.h>
 #include <server/abstractconnection.h>
 #include <servermock/connectionservermock.h>
 
+#include <algorithm>
+
 DeviceMonitoringServer::DeviceMonitoringServer(AbstractConnectionServer* connectionServer) :
     m_connectionServer(connectionServer)
 {
@@ -37,6 +45,11 @@ void DeviceMonitoringServer::setDeviceWorkSchedule(const DeviceWorkSchedule& sch
     m_commandcenter.setSchedule(schedule);
 }
 
+void DeviceMonitoringServer::setMultiChannelDeviceWorkSchedule(const MultiChannelDeviceWorkSchedule& schedule)
+{
+    m_commandcenter.setMultiChannelSchedule(schedule);
+}
+
 bool DeviceMonitoringServer::listen(uint64_t serverId)
 {
     return m_connectionServer->listen(serverId);
@@ -47,11 +60,32 @@ std::vector<DeviationStats> DeviceMonitoringServer::deviationStats(uint64_t devi
     return m_commandcenter.deviationStats(deviceId);
 }
 
+std::vector<MultiChannelDeviationStats> DeviceMonitoringServer::multiChannelDeviationStats(uint64_t deviceId)
+{
+    return m_commandcenter.multiChannelDeviationStats(deviceId);
+}
+
 MessageEncoder& DeviceMonitoringServer::messageEncoder()
 {
     return m_encoder;
 }
 
+void DeviceMonitoringServer::setMaxBatchSize(size_t maxBatchSize)
+{
+    m_maxBatchSize = std::max<size_t>(1, std::min(maxBatchSize, MessageBatch::maxRecords()));
+}
+
+void DeviceMonitoringServer::setEncryptionKey(uint64_t deviceId, const Aes128CtrEncoderExecutor::Key& key)
+{
+    m_encryptionKeys[deviceId] = key;
+}
+
+void DeviceMonitoringServer::setDeviceDirectory(DeviceDirectory* directory, size_t shard)
+{
+    m_deviceDirectory = directory;
+    m_shard = shard;
+}
+
 void DeviceMonitoringServer::sendMessage(uint64_t deviceId, const std::string& message)
 {
     auto* conn = m_connectionServer->connection(deviceId);
@@ -59,22 +93,134 @@ void DeviceMonitoringServer::sendMessage(uint64_t deviceId, const std::string& m
         conn->sendMessage(message);
 }
 
+/*!
+ * \brief Восстановить измерение из сообщения в формате WireVersion::V1 или WireVersion::V2.
+ * \param lastTimeStamp - метка времени предыдущего измерения в рамках соединения, обновляется
+ * \return std::nullopt, если сообщение не является измерением
+ */
+template <class Variant>
+static std::optional<MessageMeterage> resolveMeterage(uint64_t& lastTimeStamp, const Variant& message)
+{
+    std::optional<MessageMeterage> meterage;
+    if (const auto* m = std::get_if<MessageMeterage>(&message))
+        meterage = *m;
+    else if (const auto* delta = std::get_if<MessageMeterageDelta>(&message))
+        meterage = delta->toMeterage(lastTimeStamp);
+    if (meterage)
+        lastTimeStamp = meterage->timeStamp();
+    return meterage;
+}
+
+/*!
+ * \brief Допустимо ли сообщение при версии формата \a wireVersion, согласованной для соединения:
+ * измерения WireVersion::V2 принимаются только от устройств, согласовавших эту версию
+ */
+template <class Variant>
+static bool isWireVersionNegotiated(WireVersion wireVersion, const Variant& message)
+{
+    return wireVersion >= WireVersion::V2 || !std::holds_alternative<MessageMeterageDelta>(message);
+}
+
 void DeviceMonitoringServer::onMessageReceived(uint64_t deviceId, const std::string& message)
 {
-    if (auto msg = MessageSerializer::deserialize(m_encoder.decode(message)))
+    auto& session = m_sessions[deviceId];
+    const auto executor = sessionExecutor(session);
+    if (!executor)
+        return;
+    if (auto msg = MessagePipeline::decode(message, *executor, session.plainBuffer))
+        processMessage(deviceId, session, *msg);
+}
+
+void DeviceMonitoringServer::onDecodedMessageReceived(uint64_t deviceId, const std::string& decoded)
+{
+    auto& session = m_sessions[deviceId];
+    if (auto msg = MessageSerializer::deserializeValue(decoded))
+        processMessage(deviceId, session, *msg);
+}
+
+void DeviceMonitoringServer::processMessage(uint64_t deviceId, Session& session, const MessageVariant& message)
+{
+    if (const auto* batch = std::get_if<MessageBatch>(&message))
     {
-        const MessageMeterage* messageMeterage = dynamic_cast<const MessageMeterage*>(msg.get());
-        if (messageMeterage)
-            sendMessage(deviceId, *m_commandcenter.processMeterage(deviceId, *messageMeterage));
+        const auto& records = batch->records();
+        const auto negotiated = [&session](const MessageBatch::Record& record) {
+            return isWireVersionNegotiated(session.wireVersion, record);
+        };
+        const size_t maxBatchSize = session.maxBatchSize ? session.maxBatchSize : m_maxBatchSize;
+        if (records.size() > maxBatchSize || !std::all_of(records.begin(), records.end(), negotiated))
+            return sendMessage(deviceId, session, MessageError(MessageError::ErrorType::NotNegotiated));
+        // Записей не больше, чем в принятом пакете, поэтому append() не отбрасывает их
+        MessageBatch meterages;
+        for (const auto& record : records)
+        {
+            if (auto meterage = resolveMeterage(session.lastMeterageTimeStamp, record))
+                meterages.append(*meterage);
+        }
+        auto replies = m_commandcenter.processMeterages(deviceId, meterages);
+        if (!replies.records().empty())
+            sendMessage(deviceId, session, MessageVariant(std::move(replies)));
     }
+    else if (const auto* multiMeterage = std::get_if<MessageMultiMeterage>(&message))
+        sendMessage(deviceId, session, m_commandcenter.processMultiMeterage(deviceId, *multiMeterage));
+    else if (!isWireVersionNegotiated(session.wireVersion, message))
+        sendMessage(deviceId, session, MessageError(MessageError::ErrorType::NotNegotiated));
+    else if (auto meterage = resolveMeterage(session.lastMeterageTimeStamp, message))
+        sendMessage(deviceId, session, m_commandcenter.processMeterageValue(deviceId, *meterage));
+    else if (const auto* handshake = std::get_if<MessageHandshake>(&message))
+        onHandshake(deviceId, session, *handshake);
 }
 
-void DeviceMonitoringServer::onDisconnected(uint64_t /*clientId*/)
+void DeviceMonitoringServer::onHandshake(uint64_t deviceId, Session& session, const MessageHandshake& request)
 {
+    const auto wireVersion = std::max(WireVersion::V1, std::min(request.wireVersion(), WireVersion::V2));
+    const size_t maxBatchSize = std::max<size_t>(1, std::min<size_t>(request.maxBatchSize(), m_maxBatchSize));
+
+    const auto key = m_encryptionKeys.find(deviceId);
+    // Позиция в ключевом потоке AES-128-CTR не передается с сообщением: потерянная датаграмма сбила бы расшифровку
+    if (request.encoderName() == Aes128CtrEncoderExecutor::algorithmName() && request.nonce() && key != m_encryptionKeys.end()
+        && session.reliable)
+    {
+        // Ключевые потоки направлений должны различаться
+        uint64_t nonce = 0;
+        while (!nonce || nonce == request.nonce())
+            nonce = Aes128CtrEncoderExecutor::randomNonce();
+        sendMessage(deviceId, session, MessageHandshake(request.encoderName(), wireVersion, static_cast<uint16_t>(maxBatchSize),
+                                                        MessageHandshake::Compression::None, nonce));
+        session.executor = std::make_shared<Aes128CtrEncoderExecutor>(key->second, nonce, request.nonce());
+        session.wireVersion = wireVersion;
+        session.maxBatchSize = maxBatchSize;
+        return;
+    }
+
+    // Неизвестный алгоритм шифрования не меняет действующий
+    auto executor = m_encoder.executor(request.encoderName());
+    if (!executor)
+        executor = sessionExecutor(session);
+
+    // Ответ шифруется прежним алгоритмом: устройство переключается только после его получения
+    sendMessage(deviceId, session, MessageHandshake(executor ? executor->name() : std::string(), wireVersion, static_cast<uint16_t>(maxBatchSize)));
+    session.executor = std::move(executor);
+    session.wireVersion = wireVersion;
+    session.maxBatchSize = maxBatchSize;
+}
+
+void DeviceMonitoringServer::onDisconnected(uint64_t clientId)
+{
+    m_sessions.erase(clientId);
+    if (m_deviceDirectory)
+        m_deviceDirectory->detach(clientId, m_shard, m_commandcenter);
 }
 
 void DeviceMonitoringServer::onNewIncomingConnection(AbstractConnection* conn)
 {
+    if (m_deviceDirectory && !m_deviceDirectory->attach(conn->peerId(), m_shard, m_commandcenter))
+    {
+        conn->disconnect();
+        return;
+    }
+    auto& session = m_sessions[conn->peerId()];
+    session = {};
+    session.reliable = conn->reliable();
     addMessageHandler(conn);
     addDisconnectedHandler(conn);
 }
@@ -91,6 +237,16 @@ void DeviceMonitoringServer::addMessageHandler(AbstractConnection* conn)
         {
             m_server->onMessageReceived(m_clientId, message);
         }
+        std::shared_ptr<const BaseEncoderExecutor> streamExecutor() final
+        {
+            // Алгоритм запрашивается перед каждым сообщением, поэтому смена после согласования учитывается
+            const auto session = m_server->m_sessions.find(m_clientId);
+            return session != m_server->m_sessions.end() ? m_server->sessionExecutor(session->second) : nullptr;
+        }
+        void onDecoded(const std::string& message) final
+        {
+            m_server->onDecodedMessageReceived(m_clientId, message);
+        }
 
     private:
         DeviceMonitoringServer* m_server = nullptr;
@@ -121,7 +277,17 @@ void DeviceMonitoringServer::addDisconnectedHandler(AbstractConnection* conn)
     conn->setDisconnectedHandler(new DisconnectedHandler(this, clientId));
 }
 
-void DeviceMonitoringServer::sendMessage(uint64_t deviceId, const Message& message)
+void DeviceMonitoringServer::sendMessage(uint64_t deviceId, Session& session, const MessageVariant& message)
+{
+    const auto executor = sessionExecutor(session);
+    if (!executor)
+        return;
+    // Буферы соединения переиспользуются: после первых сообщений память не выделяется
+    if (MessagePipeline::encode(message, *executor, session.wireBuffer, session.plainBuffer))
+        sendMessage(deviceId, session.wireBuffer);
+}
+
+std::shared_ptr<const BaseEncoderExecutor> DeviceMonitoringServer::sessionExecutor(const Session& session) const
 {
-    sendMessage(deviceId, m_encoder.encode(MessageSerializer::serialize(message)));
+    return session.executor ? session.executor : m_encoder.currentExecutor();
 }
\ No newline at end of file
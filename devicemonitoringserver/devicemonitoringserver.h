@@ -1,17 +1,25 @@
 #ifndef DEVICEMONITORINGSERVER_H
 #define DEVICEMONITORINGSERVER_H
 
+#include "aes128ctrencoderexecutor.h"
 #include "commandcenter.h"
 #include "common.h"
 #include "messageencoder.h"
 #include "messageserializer.h"
+#include "wireversion.h"
 
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 
 struct DeviceWorkSchedule;
+struct MultiChannelDeviceWorkSchedule;
 class AbstractConnectionServer;
 class AbstractConnection;
+class BaseEncoderExecutor;
+class DeviceDirectory;
+class MessageHandshake;
 
 /*!
  * \brief Класс сервера для мониторинга состояния устройств.
@@ -31,6 +39,10 @@ public:
      * \brief Установить план работы устройств.
      */
     void setDeviceWorkSchedule(const DeviceWorkSchedule&);
+    /*!
+     * \brief Установить план работы устройств с несколькими каналами.
+     */
+    void setMultiChannelDeviceWorkSchedule(const MultiChannelDeviceWorkSchedule&);
     /*!
      * \brief Начать прием подключений по идентификатору \a serverId
      */
@@ -39,10 +51,54 @@ public:
      * \brief Статистика СКО физических параметров от плана для устройства с идентификатором \a deviceId
      */
     std::vector<DeviationStats> deviationStats(uint64_t deviceId);
+    /*!
+     * \brief Статистика СКО физических параметров от плана по каналам для устройства с идентификатором \a deviceId
+     */
+    std::vector<MultiChannelDeviationStats> multiChannelDeviationStats(uint64_t deviceId);
     /*!
      * \brief Ссылка на объект MessageEncoder для управления параметрами шифрования.
      */
     MessageEncoder& messageEncoder();
+    /*!
+     * \brief Установить максимальный размер пакета, предлагаемый устройствам при согласовании параметров соединения.
+     *
+     * Пакеты устройств, не согласовавших параметры, ограничены этим же размером.
+     * \param maxBatchSize - количество записей в пакете; по умолчанию MessageBatch::maxRecords()
+     */
+    void setMaxBatchSize(size_t maxBatchSize);
+    /*!
+     * \brief Установить ключ шифрования AES-128-CTR для соединений с устройством \a deviceId
+     *
+     * Устройство, запросившее при согласовании Aes128CtrEncoderExecutor::algorithmName() со своим nonce,
+     * получает в ответе nonce сервера; каждое соединение шифруется отдельным объектом алгоритма.
+     * Без ключа такой запрос не меняет действующий алгоритм, как и по соединению, теряющему или
+     * переставляющему сообщения (AbstractConnection::reliable()): позиция в ключевом потоке
+     * не передается с сообщением, и после первой потери расшифровка сбилась бы навсегда.
+     */
+    void setEncryptionKey(uint64_t deviceId, const Aes128CtrEncoderExecutor::Key& key);
+    /*!
+     * \brief Работать шардом \a shard сервера ShardedDeviceMonitoringServer.
+     *
+     * Информация об устройстве забирается из \a directory при подключении устройства и возвращается
+     * туда при отключении; подключение устройства, уже подключенного к другому шарду, разрывается.
+     * \param directory - невладеющий указатель на общий справочник; nullptr - работать отдельно
+     */
+    void setDeviceDirectory(DeviceDirectory* directory, size_t shard);
+
+private:
+    /*!
+     * \brief Состояние соединения с устройством.
+     */
+    struct Session
+    {
+        uint64_t lastMeterageTimeStamp = 0;             ///< Метка времени последнего принятого измерения (база для WireVersion::V2)
+        std::shared_ptr<const BaseEncoderExecutor> executor; ///< Согласованный алгоритм шифрования; nullptr - выбранный в messageEncoder()
+        WireVersion wireVersion = WireVersion::V1;     ///< Согласованная версия формата передачи измерений
+        size_t maxBatchSize = 0;                       ///< Согласованный максимальный размер пакета; 0 - не согласован
+        bool reliable = true;                          ///< Соединение доставляет сообщения без потерь и по порядку
+        std::string plainBuffer;                       ///< Буфер расшифрованного входящего сообщения (и промежуточный для исходящего)
+        std::string wireBuffer;                        ///< Буфер сериализуемого и шифруемого исходящего сообщения
+    };
 
 private:
     /*!
@@ -57,6 +113,12 @@ private:
      * \param message - сообщение
      */
     void onMessageReceived(uint64_t deviceId, const std::string& message);
+    /*!
+     * \brief Обработчик приема сообщения, расшифрованного транспортом по мере приема.
+     * \param deviceId - идентификатор устройства
+     * \param decoded - расшифрованное сообщение
+     */
+    void onDecodedMessageReceived(uint64_t deviceId, const std::string& decoded);
     /*!
      * \brief Обработчик поступления нового входящего подключения.
      * \param conn - невладеющий указатель на объект подключения
@@ -67,16 +129,33 @@ private:
      * \param deviceId - идентификатор устройства
      */
     void onDisconnected(uint64_t clientId);
+    /*!
+     * \brief Согласовать параметры соединения по запросу устройства и отправить ответ.
+     * \param deviceId - идентификатор устройства
+     * \param session - состояние соединения; обновляется после отправки ответа
+     * \param request - запрос устройства
+     */
+    void onHandshake(uint64_t deviceId, Session& session, const MessageHandshake& request);
 
 private:
     void addMessageHandler(AbstractConnection* conn);
     void addDisconnectedHandler(AbstractConnection* conn);
-    void sendMessage(uint64_t deviceId, const Message& message);
+    void sendMessage(uint64_t deviceId, Session& session, const MessageVariant& message);
+    void processMessage(uint64_t deviceId, Session& session, const MessageVariant& message);
+    /*!
+     * \brief Алгоритм шифрования соединения: согласованный или выбранный в messageEncoder()
+     */
+    std::shared_ptr<const BaseEncoderExecutor> sessionExecutor(const Session& session) const;
 
 private:
     AbstractConnectionServer* m_connectionServer = nullptr;
     CommandCenter m_commandcenter;
     MessageEncoder m_encoder;
+    std::unordered_map<uint64_t, Session> m_sessions;
+    size_t m_maxBatchSize = MessageBatch::maxRecords();
+    std::unordered_map<uint64_t, Aes128CtrEncoderExecutor::Key> m_encryptionKeys;
+    DeviceDirectory* m_deviceDirectory = nullptr;
+    size_t m_shard = 0;
 };
 
 #endif // DEVICEMONITORINGSERVER_H
@@ -22,4 +22,22 @@ struct DeviceWorkSchedule
     std::vector<Phase> schedule; ///< План работы устройства
 };
 
+/*!
+ * \brief Параметры этапа для устройства с несколькими физическими параметрами (каналами).
+ */
+struct MultiChannelPhase
+{
+    uint64_t timeStamp = 0;      ///< Метка времени начала этапа
+    std::vector<uint8_t> values; ///< Целевые значения этапа по каналам
+};
+
+/*!
+ * \brief План работы устройства с несколькими физическими параметрами (каналами).
+ */
+struct MultiChannelDeviceWorkSchedule
+{
+    uint64_t deviceId = 0;                   ///< Идентификатор устройства
+    std::vector<MultiChannelPhase> schedule; ///< План работы устройства
+};
+
 #endif // DEVICEWORKSCHEDULE_H
@@ -8,6 +8,29 @@ class DummyEncoderExecutor final : public BaseEncoderExecutor
     std::string encode(const std::string& message) const override final { return message; }
     std::string decode(const std::string& message) const override final { return message; }
     std::string name() const override final { return "Dummy"; }
+    size_t maxEncodedSize(size_t size) const override final { return size; }
+    size_t maxDecodedSize(size_t size) const override final { return size; }
+    std::optional<size_t> encodeInto(std::string_view message, char* output, size_t outputSize) const override final
+    {
+        if (outputSize < message.size())
+            return {};
+        std::memcpy(output, message.data(), message.size());
+        return message.size();
+    }
+    std::optional<size_t> decodeInto(std::string_view message, char* output, size_t outputSize) const override final
+    {
+        return encodeInto(message, output, outputSize);
+    }
+    bool lengthPreserving() const override final { return true; }
+    size_t encodedUnitSize() const override final { return 1; }
+    bool encodeInPlace(char*, size_t) const override final { return true; }
+    bool decodeInPlace(char*, size_t) const override final { return true; }
+    bool byteMap(ByteMap& table) const override final
+    {
+        for (size_t c = 0; c < table.size(); ++c)
+            table[c] = static_cast<uint8_t>(c);
+        return true;
+    }
 };
 
 #endif // DUMMYENCODEREXECUTOR_H
\ No newline at end of file
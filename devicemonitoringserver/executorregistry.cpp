@@ -0,0 +1,31 @@
+#include "executorregistry.h"
+#include "mirrorencoderexecutor.h"
+#include "multiply41encoderexecutor.h"
+#include "rot3encoderexecutor.h"
+
+const ExecutorRegistry& ExecutorRegistry::instance()
+{
+    static const ExecutorRegistry registry;
+    return registry;
+}
+
+ExecutorRegistry::ExecutorRegistry()
+{
+    const std::shared_ptr<const BaseEncoderExecutor> builtins[] = {
+        std::make_shared<Rot3EncoderExecutor>(),
+        std::make_shared<MirrorEncoderExecutor>(),
+        std::make_shared<Multiply41EncoderExecutor>(),
+    };
+
+    // Названия заполняются целиком до построения таблицы: ключи ссылаются на их данные
+    for (const auto& executor : builtins)
+        m_names.push_back(executor->name());
+    for (size_t i = 0; i < m_names.size(); ++i)
+        m_executors.emplace(m_names[i], builtins[i]);
+}
+
+std::shared_ptr<const BaseEncoderExecutor> ExecutorRegistry::find(std::string_view name) const
+{
+    const auto it = m_executors.find(name);
+    return it != m_executors.end() ? it->second : nullptr;
+}
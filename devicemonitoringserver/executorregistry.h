@@ -0,0 +1,48 @@
+#ifndef EXECUTORREGISTRY_H
+#define EXECUTORREGISTRY_H
+
+#include "common.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class BaseEncoderExecutor;
+
+/*!
+ * \brief Общий для процесса неизменяемый реестр встроенных алгоритмов шифрования
+ *
+ * Встроенные алгоритмы не имеют состояния, поэтому существуют в единственном экземпляре
+ * на весь процесс и разделяются всеми объектами MessageEncoder. Названия алгоритмов
+ * вычисляются один раз при создании реестра, поиск по названию выполняется по хеш-таблице.
+ */
+class ExecutorRegistry
+{
+public:
+    NON_COPYABLE(ExecutorRegistry)
+
+    /*!
+     * \brief Реестр процесса; создается при первом обращении
+     */
+    static const ExecutorRegistry& instance();
+    /*!
+     * \brief Найти встроенный алгоритм с названием \a name
+     * \return алгоритм, существующий до завершения процесса; nullptr, если алгоритма нет
+     */
+    std::shared_ptr<const BaseEncoderExecutor> find(std::string_view name) const;
+    /*!
+     * \brief Названия встроенных алгоритмов в порядке регистрации
+     */
+    const std::vector<std::string>& names() const { return m_names; }
+
+private:
+    ExecutorRegistry();
+
+private:
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string_view, std::shared_ptr<const BaseEncoderExecutor>> m_executors; ///< Ключи ссылаются на m_names
+};
+
+#endif // EXECUTORREGISTRY_H
@@ -1,10 +1,17 @@
 #ifndef ABSTRACTMESSAGEHANDLER_H
 #define ABSTRACTMESSAGEHANDLER_H
 
+#include <memory>
 #include <string>
 
+class BaseEncoderExecutor;
+
 /*!
  * \brief Базовый класс функтора-обработчика события поступления нового сообщения.
+ *
+ * Потоковый транспорт может расшифровывать сообщение по мере приема (см. StreamDecoder),
+ * если обработчик сообщает алгоритм шифрования через streamExecutor(); тогда расшифрованное
+ * сообщение передается в onDecoded() вместо оператора вызова.
  */
 class AbstractMessageHandler
 {
@@ -15,6 +22,16 @@ public:
      * \param message - сообщение
      */
     virtual void operator()(const std::string& message) = 0;
+    /*!
+     * \brief Алгоритм, которым транспорт расшифровывает следующее сообщение при приеме.
+     * \return nullptr - сообщение передается оператору вызова без расшифровки
+     */
+    virtual std::shared_ptr<const BaseEncoderExecutor> streamExecutor() { return nullptr; }
+    /*!
+     * \brief Обработать сообщение, расшифрованное транспортом алгоритмом streamExecutor().
+     * \param message - расшифрованное сообщение
+     */
+    virtual void onDecoded(const std::string& message) { (void)message; }
 };
 
 #endif // ABSTRACTMESSAGEHANDLER_H
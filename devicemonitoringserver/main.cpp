@@ -1,6 +1,9 @@
 #include "test_runner.h"
 #include "tests.h"
 #include <servermock/servertests.h>
+#include <shm/shmtests.h>
+#include <tcp/tcptests.h>
+#include <udp/udptests.h>
 
 int main()
 {
@@ -9,17 +12,54 @@ int main()
     RUN_TEST(tr, safeObjectPointerTest);
     RUN_TEST(tr, connectionChannelTest);
     RUN_TEST(tr, clientServerTest);
+    RUN_TEST(tr, eventLoopTest);
+    RUN_TEST(tr, eventLoopInvokeTest);
+    RUN_TEST(tr, tcpClientServerTest);
+    RUN_TEST(tr, tcpFramingTest);
+    RUN_TEST(tr, tcpStreamDecodingTest);
+    RUN_TEST(tr, tcpPendingConnectionsTest);
+    RUN_TEST(tr, ioUringClientServerTest);
+    RUN_TEST(tr, ioUringFramingTest);
+    RUN_TEST(tr, ioUringStreamDecodingTest);
+    RUN_TEST(tr, ioUringPendingConnectionsTest);
+    RUN_TEST(tr, shmRingTest);
+    RUN_TEST(tr, shmClientServerTest);
+    RUN_TEST(tr, shmFramingTest);
+    RUN_TEST(tr, udpDatagramTest);
+    RUN_TEST(tr, udpClientServerTest);
+    RUN_TEST(tr, udpBatchTest);
 
     RUN_TEST(tr, messageSerializationTest);
+    RUN_TEST(tr, messageValueSerializationTest);
+    RUN_TEST(tr, messageBufferSerializationTest);
+    RUN_TEST(tr, messageViewDeserializationTest);
+    RUN_TEST(tr, messageRegistryTest);
+    RUN_TEST(tr, bigEndianTest);
+    RUN_TEST(tr, messageBatchSerializationTest);
+    RUN_TEST(tr, varintTest);
+    RUN_TEST(tr, messageMeterageDeltaSerializationTest);
+    RUN_TEST(tr, messageMultiChannelSerializationTest);
+    RUN_TEST(tr, messageHandshakeSerializationTest);
 
     RUN_TEST(tr, messageEncoderEmptyTest);
     RUN_TEST(tr, messageEncoderDummyTest);
     RUN_TEST(tr, messageEncoderNegativeTest);
     RUN_TEST(tr, messageEncoderAddTest);
     RUN_TEST(tr, messageEncoderDoubleAddTest);
+    RUN_TEST(tr, messageEncoderLookupTest);
+    RUN_TEST(tr, messageEncoderSharedRegistryTest);
+    RUN_TEST(tr, messageEncoderHotSwapTest);
+    RUN_TEST(tr, messageEncoderBufferTest);
+    RUN_TEST(tr, messageEncoderCompositeTest);
+    RUN_TEST(tr, messagePipelineTest);
+    RUN_TEST(tr, streamDecoderTest);
     RUN_TEST(tr, messageEncoderRot3Test);
+    RUN_TEST(tr, messageEncoderRot3SimdTest);
     RUN_TEST(tr, messageEncoderMirrorTest);
+    RUN_TEST(tr, messageEncoderMirrorTableTest);
     RUN_TEST(tr, messageEncoderMultiply41Test);
+    RUN_TEST(tr, messageEncoderMultiply41SimdTest);
+    RUN_TEST(tr, messageEncoderAes128CtrTest);
 
     RUN_TEST(tr, commandCenterNoScheduleTest);
     RUN_TEST(tr, commandCenterNoTimestampTest);
@@ -34,6 +74,10 @@ int main()
     RUN_TEST(tr, commandCenterDeviationTest);
     RUN_TEST(tr, commandCenterDeviationNewScheduleTest);
     RUN_TEST(tr, commandCenterForgetTest);
+    RUN_TEST(tr, deviceDirectoryTest);
+    RUN_TEST(tr, commandCenterValueTest);
+    RUN_TEST(tr, commandCenterBatchTest);
+    RUN_TEST(tr, commandCenterMultiChannelTest);
 
     RUN_TEST(tr, monitoringServerTestNoSchedule);
     RUN_TEST(tr, monitoringServerTestObsolete);
@@ -42,6 +86,20 @@ int main()
     RUN_TEST(tr, monitoringServerTestTwoDevices);
     RUN_TEST(tr, monitoringServerCryptoPositiveTest);
     RUN_TEST(tr, monitoringServerCryptoNegativeTest);
+    RUN_TEST(tr, monitoringServerBatchTest);
+    RUN_TEST(tr, monitoringServerWireV2Test);
+    RUN_TEST(tr, monitoringServerWireV2BatchTest);
+    RUN_TEST(tr, monitoringServerWireV2NotNegotiatedTest);
+    RUN_TEST(tr, monitoringServerMultiChannelTest);
+    RUN_TEST(tr, monitoringServerHandshakeTest);
+    RUN_TEST(tr, monitoringServerHandshakeViolationTest);
+    RUN_TEST(tr, monitoringServerHandshakeUnsupportedTest);
+    RUN_TEST(tr, monitoringServerAesHandshakeTest);
+    RUN_TEST(tr, monitoringServerTcpTest);
+    RUN_TEST(tr, monitoringServerIoUringTest);
+    RUN_TEST(tr, monitoringServerShmTest);
+    RUN_TEST(tr, monitoringServerUdpTest);
+    RUN_TEST(tr, monitoringServerShardedTest);
 
     return 0;
 }
@@ -1,6 +1,7 @@
 #ifndef MESSAGE_H
 #define MESSAGE_H
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <ostream>
@@ -22,6 +23,15 @@ public:
      * \brief Сериализовать сообщение в поток \a os
      */
     virtual void serialize(std::ostream& os) const = 0;
+    /*!
+     * \brief Размер сериализованного сообщения в байтах
+     */
+    virtual size_t serializedSize() const = 0;
+    /*!
+     * \brief Сериализовать сообщение в буфер \a buffer размером не менее serializedSize()
+     * \return количество записанных байтов
+     */
+    virtual size_t serialize(char* buffer) const = 0;
 
     /*!
     * \brief Вывод сообщения в виде строки для отладки
@@ -0,0 +1,110 @@
+#include "messagebatch.h"
+
+#include "bigendian.h"
+
+#include <algorithm>
+#include <string>
+
+std::optional<MessageBatch> MessageBatch::create(std::vector<Record> records)
+{
+    if (records.size() > maxRecords())
+        return {};
+    MessageBatch batch;
+    batch.m_records = std::move(records);
+    return batch;
+}
+
+bool MessageBatch::append(Record record)
+{
+    if (m_records.size() >= maxRecords())
+        return false;
+    m_records.push_back(std::move(record));
+    return true;
+}
+
+void MessageBatch::serialize(std::ostream& os) const
+{
+    std::string buffer(serializedSize(), '\0');
+    os.write(buffer.data(), serialize(buffer.data()));
+}
+
+size_t MessageBatch::serializedSize() const
+{
+    size_t size = 1 + sizeof(uint16_t);
+    for (const auto& record : m_records)
+        size += 1 + std::visit([](const auto& r) { return r.serializedSize(); }, record);
+    return size;
+}
+
+size_t MessageBatch::serialize(char* buffer) const
+{
+    char* it = buffer;
+    *it++ = signature();
+    it = toBigEndian(it, static_cast<uint16_t>(m_records.size()));
+    for (const auto& record : m_records)
+    {
+        const auto length = std::visit([it](const auto& r) { return r.serialize(it + 1); }, record);
+        *it = static_cast<char>(length);
+        it += 1 + length;
+    }
+    return it - buffer;
+}
+
+std::unique_ptr<Message> MessageBatch::deserialize(std::istream& is)
+{
+    const auto count = fromBigEndian<uint16_t>(is);
+    if (is.fail())
+        return {};
+    MessageBatch batch;
+    char record[UINT8_MAX];
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto length = static_cast<unsigned char>(is.get());
+        is.read(record, length);
+        if (is.fail())
+            return {};
+        auto message = MessageBatchRecordTypes::deserializeValue(std::string_view(record, length));
+        if (!message)
+            return {};
+        batch.m_records.push_back(std::move(*message));
+    }
+    return std::unique_ptr<Message>(new MessageBatch(std::move(batch)));
+}
+
+std::optional<MessageBatch> MessageBatch::deserializeValue(std::string_view payload)
+{
+    if (payload.size() < sizeof(uint16_t))
+        return {};
+    const auto count = fromBigEndian<uint16_t>(payload.data());
+    payload.remove_prefix(sizeof(uint16_t));
+    MessageBatch batch;
+    batch.m_records.reserve(std::min<size_t>(count, payload.size()));
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (payload.empty())
+            return {};
+        const auto length = static_cast<unsigned char>(payload.front());
+        if (payload.size() < 1u + length)
+            return {};
+        auto message = MessageBatchRecordTypes::deserializeValue(payload.substr(1, length));
+        if (!message)
+            return {};
+        batch.m_records.push_back(std::move(*message));
+        payload.remove_prefix(1 + length);
+    }
+    return batch;
+}
+
+void MessageBatch::print(std::ostream& os) const
+{
+    os << "MessageBatch (records=[";
+    bool first = true;
+    for (const auto& record : m_records)
+    {
+        if (!first)
+            os << ", ";
+        first = false;
+        std::visit([&os](const auto& r) { r.print(os); }, record);
+    }
+    os << "])";
+}
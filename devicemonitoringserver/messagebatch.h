@@ -0,0 +1,104 @@
+#ifndef MESSAGEBATCH_H
+#define MESSAGEBATCH_H
+
+#include "message.h"
+#include "messagecommand.h"
+#include "messageerror.h"
+#include "messagemeterage.h"
+#include "messagemeteragedelta.h"
+#include "messageregistry.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/*!
+ * \brief Реестр типов сообщений, которые могут входить в пакет
+ */
+using MessageBatchRecordTypes = MessageRegistry<MessageMeterage, MessageCommand, MessageError, MessageMeterageDelta>;
+
+/*!
+ * \brief Класс пакета сообщений.
+ *
+ * Позволяет передать несколько измерений (или ответов на них) одним кадром.
+ * Формат: обозначение типа, количество записей (uint16_t), далее для каждой записи
+ * ее длина (uint8_t) и сериализованное сообщение.
+ */
+class MessageBatch final : public Message
+{
+public:
+    /*!
+     * \brief Запись пакета
+     */
+    using Record = MessageBatchRecordTypes::Variant;
+
+    MessageBatch() = default;
+    /*!
+     * \brief Создать пакет из записей \a records.
+     * \return std::nullopt, если записей больше maxRecords(): их количество не поместится в заголовок
+     */
+    static std::optional<MessageBatch> create(std::vector<Record> records);
+
+    /*!
+     * \brief Обозначение типа сообщения для целей сериализации
+     */
+    static constexpr char signature() { return 'b'; }
+    /*!
+     * \brief Максимальное количество записей в пакете
+     */
+    static constexpr size_t maxRecords() { return UINT16_MAX; }
+
+    /*!
+     * \brief Записи пакета
+     */
+    const std::vector<Record>& records() const { return m_records; }
+    /*!
+     * \brief Добавить запись в пакет
+     * \return false, если пакет заполнен
+     */
+    bool append(Record record);
+
+    /*!
+     * \brief Сериализовать сообщение в поток \a os
+     */
+    virtual void serialize(std::ostream& os) const override final;
+    size_t serializedSize() const override final;
+    /*!
+     * \brief Сериализовать сообщение в буфер \a buffer размером не менее serializedSize()
+     * \return количество записанных байтов
+     */
+    size_t serialize(char* buffer) const override final;
+    /*!
+     * \brief Десериализовать сообщение из потока \a is
+     */
+    static std::unique_ptr<Message> deserialize(std::istream& is);
+    /*!
+     * \brief Десериализовать сообщение без выделения динамической памяти под само сообщение
+     * \param payload - данные сообщения, следующие за обозначением типа
+     */
+    static std::optional<MessageBatch> deserializeValue(std::string_view payload);
+
+    bool operator==(const MessageBatch& other) const
+    {
+        return records() == other.records();
+    }
+    bool operator!=(const MessageBatch& other) const
+    {
+        return !(*this == other);
+    }
+    using Message::operator!=;
+    bool operator==(const Message& other) const override final
+    {
+        const MessageBatch* o = dynamic_cast<const MessageBatch*>(&other);
+        return o && *this == *o;
+    }
+
+    void print(std::ostream& os) const override final;
+
+private:
+    std::vector<Record> m_records;
+};
+
+#endif // MESSAGEBATCH_H
@@ -2,20 +2,32 @@
 
 #include "bigendian.h"
 
-#include <functional>
-#include <optional>
-
 void MessageCommand::serialize(std::ostream& os) const
 {
-    os << signature();
-    toBigEndian(os, command());
+    char buffer[maxSerializedSize()];
+    os.write(buffer, serialize(buffer));
+}
+
+size_t MessageCommand::serialize(char* buffer) const
+{
+    char* it = buffer;
+    *it++ = signature();
+    it = toBigEndian(it, command());
+    return it - buffer;
 }
 
 std::unique_ptr<Message> MessageCommand::deserialize(std::istream& is)
 {
-    int command;
-    command = fromBigEndian<int8_t>(is);
-    if (is.fail())
+    char payload[maxSerializedSize() - 1];
+    is.read(payload, sizeof(payload));
+    if (auto message = deserializeValue(std::string_view(payload, is.gcount())))
+        return std::unique_ptr<Message>(new MessageCommand(*message));
+    return {};
+}
+
+std::optional<MessageCommand> MessageCommand::deserializeValue(std::string_view payload)
+{
+    if (payload.size() < sizeof(int8_t))
         return {};
-    return std::unique_ptr<Message>(new MessageCommand(command));
+    return MessageCommand(fromBigEndian<int8_t>(payload.data()));
 }
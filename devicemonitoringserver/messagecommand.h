@@ -5,6 +5,8 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <string_view>
 
 /*!
  * \brief Класс сообщения с командой для корректировки физического параметра
@@ -33,18 +35,39 @@ public:
      * \brief Сериализовать сообщение в поток \a os
      */
     virtual void serialize(std::ostream& os) const override final;
+    /*!
+     * \brief Максимальный размер сериализованного сообщения в байтах
+     */
+    static constexpr size_t maxSerializedSize() { return 1 + sizeof(int8_t); }
+    size_t serializedSize() const override final { return maxSerializedSize(); }
+    /*!
+     * \brief Сериализовать сообщение в буфер \a buffer размером не менее serializedSize()
+     * \return количество записанных байтов
+     */
+    size_t serialize(char* buffer) const override final;
     /*!
      * \brief Десериализовать сообщение из потока \a is
      */
     static std::unique_ptr<Message> deserialize(std::istream& is);
-
     /*!
-    * \brief Вывод сообщения в виде строки для отладки
-    */
-    bool operator==(const Message& other) const
+     * \brief Десериализовать сообщение без выделения динамической памяти
+     * \param payload - данные сообщения, следующие за обозначением типа
+     */
+    static std::optional<MessageCommand> deserializeValue(std::string_view payload);
+
+    bool operator==(const MessageCommand& other) const
+    {
+        return command() == other.command();
+    }
+    bool operator!=(const MessageCommand& other) const
+    {
+        return !(*this == other);
+    }
+    using Message::operator!=;
+    bool operator==(const Message& other) const override final
     {
         const MessageCommand* o = dynamic_cast<const MessageCommand*>(&other);
-        return o && command() == o->command();
+        return o && *this == *o;
     }
 
     void print(std::ostream& os) const override final
@@ -53,7 +76,7 @@ public:
     }
 
 private:
-    const int8_t m_command;
+    int8_t m_command;
 };
 
 #endif // MESSAGECOMMAND_H
\ No newline at end of file
@@ -1,66 +1,111 @@
 #include "messageencoder.h"
 #include "baseencoderexecutor.h"
-#include "mirrorencoderexecutor.h"
-#include "multiply41encoderexecutor.h"
-#include "rot3encoderexecutor.h"
+#include "compositeencoderexecutor.h"
+#include "executorregistry.h"
 
-MessageEncoder::MessageEncoder()
-{
-    addExecutor(new Rot3EncoderExecutor());
-    addExecutor(new MirrorEncoderExecutor());
-    addExecutor(new Multiply41EncoderExecutor());
-}
+#include <atomic>
 
-MessageEncoder::~MessageEncoder()
-{
-    for (auto executor : m_executors)
-    {
-        delete executor;
-    }
-}
+MessageEncoder::MessageEncoder() = default;
+
+MessageEncoder::~MessageEncoder() = default;
 
 std::string MessageEncoder::encode(const std::string& message) const
 {
-    if (!m_currentExecutor)
+    const auto executor = currentExecutor();
+    if (!executor)
         return std::string();
-    return m_currentExecutor->encode(message);
+    return executor->encode(message);
 }
 
 std::string MessageEncoder::decode(const std::string& message) const
 {
-    if (!m_currentExecutor)
+    const auto executor = currentExecutor();
+    if (!executor)
         return std::string();
-    return m_currentExecutor->decode(message);
+    return executor->decode(message);
+}
+
+bool MessageEncoder::encode(std::string_view message, std::string& encoded) const
+{
+    encoded.clear();
+    const auto executor = currentExecutor();
+    return executor && executor->encodeTo(message, encoded);
+}
+
+bool MessageEncoder::decode(std::string_view message, std::string& decoded) const
+{
+    decoded.clear();
+    const auto executor = currentExecutor();
+    return executor && executor->decodeTo(message, decoded);
 }
 
 bool MessageEncoder::selectExecutor(const std::string& name)
 {
-    for (auto executor : m_executors)
-    {
-        if (executor->name() == name)
-        {
-            m_currentExecutor = executor;
-            return true;
-        }
-    }
-    return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto selected = findExecutor(name);
+    if (!selected)
+        return false;
+    std::atomic_store_explicit(&m_currentExecutor, std::move(selected), std::memory_order_release);
+    return true;
 }
 
 bool MessageEncoder::addExecutor(BaseEncoderExecutor* executor)
 {
     if (!executor)
         return false;
-    for (auto& e : m_executors)
+    std::shared_ptr<const BaseEncoderExecutor> added(executor);
+    auto name = added->name();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Алгоритм с названием встроенного перекрывает его только в этом объекте
+    const auto previous = findExecutor(name);
+    if (previous && std::atomic_load_explicit(&m_currentExecutor, std::memory_order_relaxed) == previous)
+        std::atomic_store_explicit(&m_currentExecutor, added, std::memory_order_release);
+    for (auto& custom : m_executors)
     {
-        if (e->name() == executor->name())
+        if (custom.name == name)
         {
-            if (m_currentExecutor == e)
-                m_currentExecutor = executor;
-            delete e;
-            e = executor;
+            // Замененный алгоритм удаляется, когда его отпустят выполняющиеся вызовы и сеансы
+            custom.executor = std::move(added);
             return true;
         }
     }
-    m_executors.push_back(executor);
+    m_executors.push_back({ std::move(name), std::move(added) });
     return true;
 }
+
+bool MessageEncoder::addComposite(const std::string& name, const std::vector<std::string>& stages)
+{
+    if (stages.empty())
+        return false;
+    std::vector<std::shared_ptr<const BaseEncoderExecutor>> executors;
+    for (const auto& stage : stages)
+    {
+        auto e = executor(stage);
+        if (!e)
+            return false;
+        executors.push_back(std::move(e));
+    }
+    // Цепочка разделяет владение звеньями, поэтому они переживают свою замену
+    return addExecutor(new CompositeEncoderExecutor(name, executors));
+}
+
+std::shared_ptr<const BaseEncoderExecutor> MessageEncoder::executor(std::string_view name) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return findExecutor(name);
+}
+
+std::shared_ptr<const BaseEncoderExecutor> MessageEncoder::currentExecutor() const
+{
+    return std::atomic_load_explicit(&m_currentExecutor, std::memory_order_acquire);
+}
+
+std::shared_ptr<const BaseEncoderExecutor> MessageEncoder::findExecutor(std::string_view name) const
+{
+    for (const auto& custom : m_executors)
+    {
+        if (custom.name == name)
+            return custom.executor;
+    }
+    return ExecutorRegistry::instance().find(name);
+}
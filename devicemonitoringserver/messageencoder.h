@@ -1,17 +1,32 @@
 #ifndef MESSAGEENCODER_H
 #define MESSAGEENCODER_H
 
+#include "common.h"
+
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class BaseEncoderExecutor;
 
 /*!
  * \brief Класс для шифрования сообщений
+ *
+ * Встроенные алгоритмы берутся из общего реестра процесса (ExecutorRegistry) и не создаются
+ * для каждого объекта; объект разделяет владение алгоритмами, добавленными через addExecutor().
+ *
+ * Методы потокобезопасны. Выбранный алгоритм публикуется атомарно (std::atomic_store для
+ * std::shared_ptr): шифрование и расшифровка держат ссылку на алгоритм на время вызова, а смена
+ * алгоритма не ждет их завершения. Замененный алгоритм удаляется, когда его отпускает последний
+ * пользователь: объект, выполняющийся вызов или сеанс, получивший его через executor().
  */
 class MessageEncoder
 {
 public:
+    NON_COPYABLE(MessageEncoder)
+
     MessageEncoder();
     ~MessageEncoder();
     /*!
@@ -22,6 +37,16 @@ public:
      * \brief Расшифровать сообщение \a message
      */
     std::string decode(const std::string& message) const;
+    /*!
+     * \brief Зашифровать сообщение \a message в строку \a encoded, повторно используя ее память
+     * \return false, если алгоритм не выбран или произошла ошибка
+     */
+    bool encode(std::string_view message, std::string& encoded) const;
+    /*!
+     * \brief Расшифровать сообщение \a message в строку \a decoded, повторно используя ее память
+     * \return false, если алгоритм не выбран или произошла ошибка
+     */
+    bool decode(std::string_view message, std::string& decoded) const;
     /*!
      * \brief Выбрать для шифрования алгоритм с названием \a name
      * \return false в случае ошибки
@@ -33,10 +58,46 @@ public:
      * \return false в случае ошибки
      */
     bool addExecutor(BaseEncoderExecutor* executor);
+    /*!
+     * \brief Зарегистрировать цепочку \a name из зарегистрированных алгоритмов \a stages
+     *
+     * Алгоритмы применяются при шифровании в порядке перечисления, подряд идущие замены байтов
+     * объединяются в одну таблицу (см. CompositeEncoderExecutor).
+     * \return false, если список пуст или какой-либо алгоритм не зарегистрирован
+     */
+    bool addComposite(const std::string& name, const std::vector<std::string>& stages);
+    /*!
+     * \brief Найти алгоритм шифрования с названием \a name
+     *
+     * Добавленные алгоритмы имеют приоритет над встроенными с тем же названием.
+     * \return алгоритм, остающийся действительным и после замены через addExecutor();
+     * nullptr, если алгоритм не зарегистрирован
+     */
+    std::shared_ptr<const BaseEncoderExecutor> executor(std::string_view name) const;
+    /*!
+     * \brief Выбранный алгоритм шифрования или nullptr
+     */
+    std::shared_ptr<const BaseEncoderExecutor> currentExecutor() const;
+
+private:
+    /*!
+     * \brief Добавленный алгоритм с вычисленным при добавлении названием
+     */
+    struct CustomExecutor
+    {
+        std::string name;
+        std::shared_ptr<const BaseEncoderExecutor> executor;
+    };
+
+    /*!
+     * \brief Найти алгоритм с названием \a name; вызывается под m_mutex
+     */
+    std::shared_ptr<const BaseEncoderExecutor> findExecutor(std::string_view name) const;
 
 private:
-    BaseEncoderExecutor* m_currentExecutor = nullptr;
-    std::vector<BaseEncoderExecutor*> m_executors;
+    std::shared_ptr<const BaseEncoderExecutor> m_currentExecutor; ///< Читается и заменяется только атомарными операциями
+    mutable std::mutex m_mutex; ///< Защищает список алгоритмов от одновременного изменения
+    std::vector<CustomExecutor> m_executors;
 };
 
 #endif // MESSAGEENCODER_H
\ No newline at end of file
@@ -1,37 +1,56 @@
 #include "messageerror.h"
 
-#include <optional>
-
 void MessageError::serialize(std::ostream& os) const
 {
-    os << signature();
+    char buffer[maxSerializedSize()];
+    os.write(buffer, serialize(buffer));
+}
+
+size_t MessageError::serialize(char* buffer) const
+{
+    char* it = buffer;
+    *it++ = signature();
     switch (errorType())
     {
     case MessageError::ErrorType::NoSchedule:
-        os.put('s');
+        *it++ = 's';
         break;
     case MessageError::ErrorType::NoTimestamp:
-        os.put('t');
+        *it++ = 't';
         break;
     case MessageError::ErrorType::Obsolete:
-        os.put('o');
+        *it++ = 'o';
+        break;
+    case MessageError::ErrorType::NotNegotiated:
+        *it++ = 'n';
         break;
     }
+    return it - buffer;
 }
 
 std::unique_ptr<Message> MessageError::deserialize(std::istream& is)
 {
-    char ch = is.get();
-    if (is.fail())
+    char payload[maxSerializedSize() - 1];
+    is.read(payload, sizeof(payload));
+    if (auto message = deserializeValue(std::string_view(payload, is.gcount())))
+        return std::unique_ptr<Message>(new MessageError(*message));
+    return {};
+}
+
+std::optional<MessageError> MessageError::deserializeValue(std::string_view payload)
+{
+    if (payload.empty())
         return {};
-    switch (ch)
+    switch (payload.front())
     {
     case 's':
-        return std::unique_ptr<Message>(new MessageError(MessageError::ErrorType::NoSchedule));
+        return MessageError(MessageError::ErrorType::NoSchedule);
     case 't':
-        return std::unique_ptr<Message>(new MessageError(MessageError::ErrorType::NoTimestamp));
+        return MessageError(MessageError::ErrorType::NoTimestamp);
     case 'o':
-        return std::unique_ptr<Message>(new MessageError(MessageError::ErrorType::Obsolete));
+        return MessageError(MessageError::ErrorType::Obsolete);
+    case 'n':
+        return MessageError(MessageError::ErrorType::NotNegotiated);
     }
     return {};
 }
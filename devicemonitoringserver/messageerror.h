@@ -5,6 +5,8 @@
 
 #include <istream>
 #include <memory>
+#include <optional>
+#include <string_view>
 
 /*!
  * \brief Класс сообщения об ошибке
@@ -19,7 +21,8 @@ public:
     {
         NoSchedule,
         NoTimestamp,
-        Obsolete
+        Obsolete,
+        NotNegotiated ///< Сообщение не соответствует параметрам, согласованным для соединения
     };
     /*!
      * \brief Конструктор.
@@ -41,21 +44,45 @@ public:
      * \brief Сериализовать сообщение в поток \a os
      */
     virtual void serialize(std::ostream& os) const override final;
+    /*!
+     * \brief Максимальный размер сериализованного сообщения в байтах
+     */
+    static constexpr size_t maxSerializedSize() { return 2; }
+    size_t serializedSize() const override final { return maxSerializedSize(); }
+    /*!
+     * \brief Сериализовать сообщение в буфер \a buffer размером не менее serializedSize()
+     * \return количество записанных байтов
+     */
+    size_t serialize(char* buffer) const override final;
     /*!
      * \brief Десериализовать сообщение из потока \a is
      */
     static std::unique_ptr<Message> deserialize(std::istream& is);
+    /*!
+     * \brief Десериализовать сообщение без выделения динамической памяти
+     * \param payload - данные сообщения, следующие за обозначением типа
+     */
+    static std::optional<MessageError> deserializeValue(std::string_view payload);
 
+    bool operator==(const MessageError& other) const
+    {
+        return errorType() == other.errorType();
+    }
+    bool operator!=(const MessageError& other) const
+    {
+        return !(*this == other);
+    }
+    using Message::operator!=;
     bool operator==(const Message& other) const override final
     {
         const MessageError* o = dynamic_cast<const MessageError*>(&other);
-        return o && errorType() == o->errorType();
+        return o && *this == *o;
     }
 
     void print(std::ostream& os) const override final;
 
 private:
-    const ErrorType m_errorType;
+    ErrorType m_errorType;
 };
 
 inline std::ostream& operator<<(std::ostream& os, MessageError::ErrorType t)
@@ -72,6 +99,9 @@ inline std::ostream& operator<<(std::ostream& os, MessageError::ErrorType t)
     case MessageError::ErrorType::Obsolete:
         os << "Obsolete";
         break;
+    case MessageError::ErrorType::NotNegotiated:
+        os << "NotNegotiated";
+        break;
     default:
         os << "<unknown>";
     }
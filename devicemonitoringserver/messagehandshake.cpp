@@ -0,0 +1,77 @@
+#include "messagehandshake.h"
+
+#include "bigendian.h"
+
+#include <cstring>
+
+void MessageHandshake::serialize(std::ostream& os) const
+{
+    char buffer[maxSerializedSize()];
+    os.write(buffer, serialize(buffer));
+}
+
+size_t MessageHandshake::serialize(char* buffer) const
+{
+    char* it = buffer;
+    *it++ = signature();
+    it = toBigEndian(it, static_cast<uint8_t>(wireVersion()));
+    it = toBigEndian(it, maxBatchSize());
+    it = toBigEndian(it, static_cast<uint8_t>(compression()));
+    it = toBigEndian(it, static_cast<uint8_t>(m_encoderName.size()));
+    std::memcpy(it, m_encoderName.data(), m_encoderName.size());
+    it += m_encoderName.size();
+    // Nonce необязателен: без него сообщение совпадает с прежним форматом
+    if (m_nonce)
+        it = toBigEndian(it, m_nonce);
+    return it - buffer;
+}
+
+std::unique_ptr<Message> MessageHandshake::deserialize(std::istream& is)
+{
+    char payload[maxSerializedSize() - 1];
+    constexpr size_t header = headerSize() - 1;
+    is.read(payload, header);
+    size_t size = is.gcount();
+    if (size == header)
+    {
+        is.read(payload + header, fromBigEndian<uint8_t>(payload + header - sizeof(uint8_t)));
+        size += is.gcount();
+        if (size == header + fromBigEndian<uint8_t>(payload + header - sizeof(uint8_t)))
+        {
+            is.read(payload + size, sizeof(uint64_t));
+            size += is.gcount();
+        }
+    }
+    if (auto message = deserializeValue(std::string_view(payload, size)))
+        return std::unique_ptr<Message>(new MessageHandshake(std::move(*message)));
+    return {};
+}
+
+std::optional<MessageHandshake> MessageHandshake::deserializeValue(std::string_view payload)
+{
+    constexpr size_t header = headerSize() - 1;
+    if (payload.size() < header)
+        return {};
+    const char* it = payload.data();
+    const auto wireVersion = static_cast<WireVersion>(fromBigEndian<uint8_t>(it));
+    it += sizeof(uint8_t);
+    const auto maxBatchSize = fromBigEndian<uint16_t>(it);
+    it += sizeof(uint16_t);
+    const auto compression = static_cast<Compression>(fromBigEndian<uint8_t>(it));
+    it += sizeof(uint8_t);
+    const size_t nameSize = fromBigEndian<uint8_t>(it);
+    it += sizeof(uint8_t);
+    if (payload.size() < header + nameSize)
+        return {};
+    uint64_t nonce = 0;
+    const size_t nonceSize = payload.size() - header - nameSize;
+    if (nonceSize == sizeof(uint64_t))
+    {
+        nonce = fromBigEndian<uint64_t>(it + nameSize);
+        if (!nonce)
+            return {};
+    }
+    else if (nonceSize != 0)
+        return {};
+    return MessageHandshake(std::string(it, nameSize), wireVersion, maxBatchSize, compression, nonce);
+}
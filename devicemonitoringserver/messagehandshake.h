@@ -0,0 +1,143 @@
+#ifndef MESSAGEHANDSHAKE_H
+#define MESSAGEHANDSHAKE_H
+
+#include "message.h"
+#include "wireversion.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/*!
+ * \brief Класс сообщения для согласования параметров соединения.
+ *
+ * Устройство отправляет запрос с желаемыми параметрами, сервер отвечает сообщением
+ * с согласованными параметрами. Запрос и ответ шифруются алгоритмом, действовавшим
+ * до согласования; последующие сообщения - согласованным алгоритмом.
+ * Формат: обозначение типа, версия формата (uint8_t), максимальный размер пакета (uint16_t),
+ * сжатие (uint8_t), длина названия алгоритма шифрования (uint8_t), само название
+ * и необязательный ненулевой nonce (uint64_t).
+ */
+class MessageHandshake final : public Message
+{
+public:
+    /*!
+     * \brief Перечисление алгоритмов сжатия
+     */
+    enum class Compression : uint8_t
+    {
+        None = 0
+    };
+    /*!
+     * \brief Конструктор.
+     * \param encoderName - название алгоритма шифрования; названия длиннее maxEncoderNameSize() обрезаются
+     * \param wireVersion - версия формата передачи измерений
+     * \param maxBatchSize - максимальное количество записей в пакете MessageBatch
+     * \param compression - алгоритм сжатия
+     * \param nonce - nonce ключевого потока отправителя для алгоритмов, которым он нужен; 0 - не передается
+     */
+    MessageHandshake(std::string encoderName, WireVersion wireVersion, uint16_t maxBatchSize, Compression compression = Compression::None,
+                     uint64_t nonce = 0) :
+        m_encoderName(std::move(encoderName)), m_wireVersion(wireVersion), m_maxBatchSize(maxBatchSize), m_compression(compression), m_nonce(nonce)
+    {
+        if (m_encoderName.size() > maxEncoderNameSize())
+            m_encoderName.resize(maxEncoderNameSize());
+    }
+
+    /*!
+     * \brief Обозначение типа сообщения для целей сериализации
+     */
+    static constexpr char signature() { return 'h'; }
+    /*!
+     * \brief Максимальная длина названия алгоритма шифрования
+     */
+    static constexpr size_t maxEncoderNameSize() { return UINT8_MAX; }
+
+    /*!
+     * \brief Название алгоритма шифрования
+     */
+    const std::string& encoderName() const { return m_encoderName; }
+    /*!
+     * \brief Версия формата передачи измерений
+     */
+    WireVersion wireVersion() const { return m_wireVersion; }
+    /*!
+     * \brief Максимальное количество записей в пакете MessageBatch
+     */
+    uint16_t maxBatchSize() const { return m_maxBatchSize; }
+    /*!
+     * \brief Алгоритм сжатия
+     */
+    Compression compression() const { return m_compression; }
+    /*!
+     * \brief Nonce ключевого потока отправителя (Aes128CtrEncoderExecutor); 0 - не передан
+     */
+    uint64_t nonce() const { return m_nonce; }
+
+    /*!
+     * \brief Сериализовать сообщение в поток \a os
+     */
+    virtual void serialize(std::ostream& os) const override final;
+    /*!
+     * \brief Максимальный размер сериализованного сообщения в байтах
+     */
+    static constexpr size_t maxSerializedSize() { return headerSize() + maxEncoderNameSize() + sizeof(uint64_t); }
+    size_t serializedSize() const override final { return headerSize() + m_encoderName.size() + (m_nonce ? sizeof(uint64_t) : 0); }
+    /*!
+     * \brief Сериализовать сообщение в буфер \a buffer размером не менее serializedSize()
+     * \return количество записанных байтов
+     */
+    size_t serialize(char* buffer) const override final;
+    /*!
+     * \brief Десериализовать сообщение из потока \a is
+     */
+    static std::unique_ptr<Message> deserialize(std::istream& is);
+    /*!
+     * \brief Десериализовать сообщение из буфера
+     * \param payload - данные сообщения, следующие за обозначением типа
+     */
+    static std::optional<MessageHandshake> deserializeValue(std::string_view payload);
+
+    bool operator==(const MessageHandshake& other) const
+    {
+        return encoderName() == other.encoderName() && wireVersion() == other.wireVersion()
+               && maxBatchSize() == other.maxBatchSize() && compression() == other.compression()
+               && nonce() == other.nonce();
+    }
+    bool operator!=(const MessageHandshake& other) const
+    {
+        return !(*this == other);
+    }
+    using Message::operator!=;
+    bool operator==(const Message& other) const override final
+    {
+        const MessageHandshake* o = dynamic_cast<const MessageHandshake*>(&other);
+        return o && *this == *o;
+    }
+
+    void print(std::ostream& os) const override final
+    {
+        os << "MessageHandshake (encoderName=" << encoderName()
+           << ", wireVersion=" << static_cast<int>(wireVersion())
+           << ", maxBatchSize=" << maxBatchSize()
+           << ", compression=" << static_cast<int>(compression())
+           << ", nonce=" << nonce() << ")";
+    }
+
+private:
+    /*!
+     * \brief Размер заголовка: обозначение типа, версия формата, размер пакета, сжатие и длина названия
+     */
+    static constexpr size_t headerSize() { return 1 + sizeof(uint8_t) + sizeof(uint16_t) + sizeof(uint8_t) + sizeof(uint8_t); }
+
+private:
+    std::string m_encoderName;
+    WireVersion m_wireVersion;
+    uint16_t m_maxBatchSize;
+    Compression m_compression;
+    uint64_t m_nonce;
+};
+
+#endif // MESSAGEHANDSHAKE_H
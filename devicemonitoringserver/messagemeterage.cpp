@@ -4,18 +4,32 @@
 
 void MessageMeterage::serialize(std::ostream& os) const
 {
-    os << signature();
-    toBigEndian(os, timeStamp());
-    toBigEndian(os, meterage());
+    char buffer[maxSerializedSize()];
+    os.write(buffer, serialize(buffer));
+}
+
+size_t MessageMeterage::serialize(char* buffer) const
+{
+    char* it = buffer;
+    *it++ = signature();
+    it = toBigEndian(it, timeStamp());
+    it = toBigEndian(it, meterage());
+    return it - buffer;
 }
 
 std::unique_ptr<Message> MessageMeterage::deserialize(std::istream& is)
 {
-    uint64_t timeStamp;
-    uint8_t meterage;
-    timeStamp = fromBigEndian<uint64_t>(is);
-    meterage = fromBigEndian<uint8_t>(is);
-    if (is.fail())
+    char payload[maxSerializedSize() - 1];
+    is.read(payload, sizeof(payload));
+    if (auto message = deserializeValue(std::string_view(payload, is.gcount())))
+        return std::unique_ptr<Message>(new MessageMeterage(*message));
+    return {};
+}
+
+std::optional<MessageMeterage> MessageMeterage::deserializeValue(std::string_view payload)
+{
+    if (payload.size() < sizeof(uint64_t) + sizeof(uint8_t))
         return {};
-    return std::unique_ptr<Message>(new MessageMeterage(timeStamp, meterage));
+    return MessageMeterage(fromBigEndian<uint64_t>(payload.data()),
+                           fromBigEndian<uint8_t>(payload.data() + sizeof(uint64_t)));
 }
@@ -5,6 +5,8 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <string_view>
 
 /*!
  * \brief Класс сообщения с измерением физического параметра
@@ -38,15 +40,39 @@ public:
      * \brief Сериализовать сообщение в поток \a os
      */
     virtual void serialize(std::ostream& os) const override final;
+    /*!
+     * \brief Максимальный размер сериализованного сообщения в байтах
+     */
+    static constexpr size_t maxSerializedSize() { return 1 + sizeof(uint64_t) + sizeof(uint8_t); }
+    size_t serializedSize() const override final { return maxSerializedSize(); }
+    /*!
+     * \brief Сериализовать сообщение в буфер \a buffer размером не менее serializedSize()
+     * \return количество записанных байтов
+     */
+    size_t serialize(char* buffer) const override final;
     /*!
      * \brief Десериализовать сообщение из потока \a is
      */
     static std::unique_ptr<Message> deserialize(std::istream& is);
+    /*!
+     * \brief Десериализовать сообщение без выделения динамической памяти
+     * \param payload - данные сообщения, следующие за обозначением типа
+     */
+    static std::optional<MessageMeterage> deserializeValue(std::string_view payload);
 
-    bool operator==(const Message& other) const
+    bool operator==(const MessageMeterage& other) const
+    {
+        return timeStamp() == other.timeStamp() && meterage() == other.meterage();
+    }
+    bool operator!=(const MessageMeterage& other) const
+    {
+        return !(*this == other);
+    }
+    using Message::operator!=;
+    bool operator==(const Message& other) const override final
     {
         const MessageMeterage* o = dynamic_cast<const MessageMeterage*>(&other);
-        return o && timeStamp() == o->timeStamp() && meterage() == o->meterage();
+        return o && *this == *o;
     }
 
     void print(std::ostream& os) const override final
@@ -55,8 +81,8 @@ public:
     }
 
 private:
-    const uint64_t m_timeStamp;
-    const uint8_t m_meterage;
+    uint64_t m_timeStamp;
+    uint8_t m_meterage;
 };
 
 #endif // MESSAGEMETERAGE_H
\ No newline at end of file
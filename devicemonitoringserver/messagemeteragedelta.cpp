@@ -0,0 +1,47 @@
+#include "messagemeteragedelta.h"
+
+#include "bigendian.h"
+
+void MessageMeterageDelta::serialize(std::ostream& os) const
+{
+    char buffer[maxSerializedSize()];
+    os.write(buffer, serialize(buffer));
+}
+
+size_t MessageMeterageDelta::serialize(char* buffer) const
+{
+    char* it = buffer;
+    *it++ = signature();
+    it = toVarint(it, zigZagEncode(timeStampDelta()));
+    it = toBigEndian(it, meterage());
+    return it - buffer;
+}
+
+std::unique_ptr<Message> MessageMeterageDelta::deserialize(std::istream& is)
+{
+    char payload[maxSerializedSize() - 1];
+    size_t size = 0;
+    // Байты LEB128 читаются до последнего (со сброшенным старшим битом), затем величина измерения
+    while (size < maxVarintSize)
+    {
+        const auto ch = is.get();
+        if (is.fail())
+            return {};
+        payload[size++] = static_cast<char>(ch);
+        if (!(ch & 0x80))
+            break;
+    }
+    is.read(payload + size, sizeof(uint8_t));
+    if (auto message = deserializeValue(std::string_view(payload, size + is.gcount())))
+        return std::unique_ptr<Message>(new MessageMeterageDelta(*message));
+    return {};
+}
+
+std::optional<MessageMeterageDelta> MessageMeterageDelta::deserializeValue(std::string_view payload)
+{
+    uint64_t delta;
+    const auto size = fromVarint(payload, delta);
+    if (!size || payload.size() < size + sizeof(uint8_t))
+        return {};
+    return MessageMeterageDelta(zigZagDecode(delta), fromBigEndian<uint8_t>(payload.data() + size));
+}
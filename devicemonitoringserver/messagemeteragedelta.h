@@ -0,0 +1,110 @@
+#ifndef MESSAGEMETERAGEDELTA_H
+#define MESSAGEMETERAGEDELTA_H
+
+#include "message.h"
+#include "messagemeterage.h"
+#include "varint.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+/*!
+ * \brief Класс сообщения с измерением в компактном формате (WireVersion::V2).
+ *
+ * Вместо полной метки времени передается ее разность с меткой времени предыдущего
+ * измерения в рамках соединения, закодированная ZigZag + LEB128.
+ * Обе стороны соединения отслеживают метку времени предыдущего измерения, начиная с 0.
+ */
+class MessageMeterageDelta final : public Message
+{
+public:
+    /*!
+     * \brief Конструктор.
+     * \param timeStampDelta - разность меток времени текущего и предыдущего измерений
+     * \param meterage - величина измерения
+     */
+    MessageMeterageDelta(int64_t timeStampDelta, uint8_t meterage) :
+        m_timeStampDelta(timeStampDelta), m_meterage(meterage) {}
+    /*!
+     * \brief Конструктор.
+     * \param meterage - измерение
+     * \param previousTimeStamp - метка времени предыдущего измерения в рамках соединения
+     */
+    MessageMeterageDelta(const MessageMeterage& meterage, uint64_t previousTimeStamp) :
+        m_timeStampDelta(static_cast<int64_t>(meterage.timeStamp() - previousTimeStamp)),
+        m_meterage(meterage.meterage()) {}
+
+    /*!
+     * \brief Обозначение типа сообщения для целей сериализации
+     */
+    static constexpr char signature() { return 'd'; }
+
+    /*!
+     * \brief Разность меток времени текущего и предыдущего измерений
+     */
+    int64_t timeStampDelta() const { return m_timeStampDelta; }
+    /*!
+     * \brief Величина измерения
+     */
+    uint8_t meterage() const { return m_meterage; }
+    /*!
+     * \brief Восстановить измерение
+     * \param previousTimeStamp - метка времени предыдущего измерения в рамках соединения
+     */
+    MessageMeterage toMeterage(uint64_t previousTimeStamp) const
+    {
+        return MessageMeterage(previousTimeStamp + static_cast<uint64_t>(m_timeStampDelta), m_meterage);
+    }
+
+    /*!
+     * \brief Сериализовать сообщение в поток \a os
+     */
+    virtual void serialize(std::ostream& os) const override final;
+    /*!
+     * \brief Максимальный размер сериализованного сообщения в байтах
+     */
+    static constexpr size_t maxSerializedSize() { return 1 + maxVarintSize + sizeof(uint8_t); }
+    size_t serializedSize() const override final { return 1 + varintSize(zigZagEncode(m_timeStampDelta)) + sizeof(uint8_t); }
+    /*!
+     * \brief Сериализовать сообщение в буфер \a buffer размером не менее serializedSize()
+     * \return количество записанных байтов
+     */
+    size_t serialize(char* buffer) const override final;
+    /*!
+     * \brief Десериализовать сообщение из потока \a is
+     */
+    static std::unique_ptr<Message> deserialize(std::istream& is);
+    /*!
+     * \brief Десериализовать сообщение без выделения динамической памяти
+     * \param payload - данные сообщения, следующие за обозначением типа
+     */
+    static std::optional<MessageMeterageDelta> deserializeValue(std::string_view payload);
+
+    bool operator==(const MessageMeterageDelta& other) const
+    {
+        return timeStampDelta() == other.timeStampDelta() && meterage() == other.meterage();
+    }
+    bool operator!=(const MessageMeterageDelta& other) const
+    {
+        return !(*this == other);
+    }
+    using Message::operator!=;
+    bool operator==(const Message& other) const override final
+    {
+        const MessageMeterageDelta* o = dynamic_cast<const MessageMeterageDelta*>(&other);
+        return o && *this == *o;
+    }
+
+    void print(std::ostream& os) const override final
+    {
+        os << "MessageMeterageDelta (timeStampDelta=" << timeStampDelta() << ", meterage=" << static_cast<int>(meterage()) << ")";
+    }
+
+private:
+    int64_t m_timeStampDelta;
+    uint8_t m_meterage;
+};
+
+#endif // MESSAGEMETERAGEDELTA_H
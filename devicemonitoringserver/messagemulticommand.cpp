@@ -0,0 +1,58 @@
+#include "messagemulticommand.h"
+
+#include "bigendian.h"
+
+#include <cstring>
+
+void MessageMultiCommand::serialize(std::ostream& os) const
+{
+    char buffer[maxSerializedSize()];
+    os.write(buffer, serialize(buffer));
+}
+
+size_t MessageMultiCommand::serialize(char* buffer) const
+{
+    char* it = buffer;
+    *it++ = signature();
+    it = toBigEndian(it, static_cast<uint8_t>(m_commands.size()));
+    if (!m_commands.empty())
+        std::memcpy(it, m_commands.data(), m_commands.size());
+    it += m_commands.size();
+    return it - buffer;
+}
+
+std::unique_ptr<Message> MessageMultiCommand::deserialize(std::istream& is)
+{
+    char payload[maxSerializedSize() - 1];
+    constexpr size_t header = headerSize() - 1;
+    is.read(payload, header);
+    size_t size = is.gcount();
+    if (size == header)
+    {
+        is.read(payload + header, fromBigEndian<uint8_t>(payload));
+        size += is.gcount();
+    }
+    if (auto message = deserializeValue(std::string_view(payload, size)))
+        return std::unique_ptr<Message>(new MessageMultiCommand(std::move(*message)));
+    return {};
+}
+
+std::optional<MessageMultiCommand> MessageMultiCommand::deserializeValue(std::string_view payload)
+{
+    constexpr size_t header = headerSize() - 1;
+    if (payload.size() < header)
+        return {};
+    const size_t channels = fromBigEndian<uint8_t>(payload.data());
+    if (payload.size() < header + channels)
+        return {};
+    const auto* values = reinterpret_cast<const int8_t*>(payload.data() + header);
+    return MessageMultiCommand(std::vector<int8_t>(values, values + channels));
+}
+
+void MessageMultiCommand::print(std::ostream& os) const
+{
+    os << "MessageMultiCommand (commands=[";
+    for (size_t i = 0; i < m_commands.size(); ++i)
+        os << (i ? ", " : "") << static_cast<int>(m_commands[i]);
+    os << "])";
+}
@@ -0,0 +1,96 @@
+#ifndef MESSAGEMULTICOMMAND_H
+#define MESSAGEMULTICOMMAND_H
+
+#include "message.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/*!
+ * \brief Класс сообщения с командами для корректировки нескольких физических параметров (каналов) устройства.
+ *
+ * Формат: обозначение типа, количество каналов (uint8_t), далее величины коррекции по каналам.
+ */
+class MessageMultiCommand final : public Message
+{
+public:
+    /*!
+     * \brief Конструктор.
+     * \param commands - величины для коррекции по каналам; каналы сверх maxChannels() отбрасываются
+     */
+    MessageMultiCommand(std::vector<int8_t> commands) :
+        m_commands(std::move(commands))
+    {
+        if (m_commands.size() > maxChannels())
+            m_commands.resize(maxChannels());
+    }
+
+    /*!
+     * \brief Обозначение типа сообщения для целей сериализации
+     */
+    static constexpr char signature() { return 'C'; }
+    /*!
+     * \brief Максимальное количество каналов в сообщении
+     */
+    static constexpr size_t maxChannels() { return UINT8_MAX; }
+
+    /*!
+     * \brief Величины для коррекции по каналам
+     */
+    const std::vector<int8_t>& commands() const { return m_commands; }
+
+    /*!
+     * \brief Сериализовать сообщение в поток \a os
+     */
+    virtual void serialize(std::ostream& os) const override final;
+    /*!
+     * \brief Максимальный размер сериализованного сообщения в байтах
+     */
+    static constexpr size_t maxSerializedSize() { return headerSize() + maxChannels(); }
+    size_t serializedSize() const override final { return headerSize() + m_commands.size(); }
+    /*!
+     * \brief Сериализовать сообщение в буфер \a buffer размером не менее serializedSize()
+     * \return количество записанных байтов
+     */
+    size_t serialize(char* buffer) const override final;
+    /*!
+     * \brief Десериализовать сообщение из потока \a is
+     */
+    static std::unique_ptr<Message> deserialize(std::istream& is);
+    /*!
+     * \brief Десериализовать сообщение из буфера
+     * \param payload - данные сообщения, следующие за обозначением типа
+     */
+    static std::optional<MessageMultiCommand> deserializeValue(std::string_view payload);
+
+    bool operator==(const MessageMultiCommand& other) const
+    {
+        return commands() == other.commands();
+    }
+    bool operator!=(const MessageMultiCommand& other) const
+    {
+        return !(*this == other);
+    }
+    using Message::operator!=;
+    bool operator==(const Message& other) const override final
+    {
+        const MessageMultiCommand* o = dynamic_cast<const MessageMultiCommand*>(&other);
+        return o && *this == *o;
+    }
+
+    void print(std::ostream& os) const override final;
+
+private:
+    /*!
+     * \brief Размер заголовка: обозначение типа и количество каналов
+     */
+    static constexpr size_t headerSize() { return 1 + sizeof(uint8_t); }
+
+private:
+    std::vector<int8_t> m_commands;
+};
+
+#endif // MESSAGEMULTICOMMAND_H
@@ -0,0 +1,60 @@
+#include "messagemultimeterage.h"
+
+#include "bigendian.h"
+
+#include <cstring>
+
+void MessageMultiMeterage::serialize(std::ostream& os) const
+{
+    char buffer[maxSerializedSize()];
+    os.write(buffer, serialize(buffer));
+}
+
+size_t MessageMultiMeterage::serialize(char* buffer) const
+{
+    char* it = buffer;
+    *it++ = signature();
+    it = toBigEndian(it, timeStamp());
+    it = toBigEndian(it, static_cast<uint8_t>(m_meterages.size()));
+    if (!m_meterages.empty())
+        std::memcpy(it, m_meterages.data(), m_meterages.size());
+    it += m_meterages.size();
+    return it - buffer;
+}
+
+std::unique_ptr<Message> MessageMultiMeterage::deserialize(std::istream& is)
+{
+    char payload[maxSerializedSize() - 1];
+    constexpr size_t header = headerSize() - 1;
+    is.read(payload, header);
+    size_t size = is.gcount();
+    if (size == header)
+    {
+        is.read(payload + header, fromBigEndian<uint8_t>(payload + sizeof(uint64_t)));
+        size += is.gcount();
+    }
+    if (auto message = deserializeValue(std::string_view(payload, size)))
+        return std::unique_ptr<Message>(new MessageMultiMeterage(std::move(*message)));
+    return {};
+}
+
+std::optional<MessageMultiMeterage> MessageMultiMeterage::deserializeValue(std::string_view payload)
+{
+    constexpr size_t header = headerSize() - 1;
+    if (payload.size() < header)
+        return {};
+    const size_t channels = fromBigEndian<uint8_t>(payload.data() + sizeof(uint64_t));
+    if (payload.size() < header + channels)
+        return {};
+    const auto* values = reinterpret_cast<const uint8_t*>(payload.data() + header);
+    return MessageMultiMeterage(fromBigEndian<uint64_t>(payload.data()),
+                                std::vector<uint8_t>(values, values + channels));
+}
+
+void MessageMultiMeterage::print(std::ostream& os) const
+{
+    os << "MessageMultiMeterage (timeStamp=" << timeStamp() << ", meterages=[";
+    for (size_t i = 0; i < m_meterages.size(); ++i)
+        os << (i ? ", " : "") << static_cast<int>(m_meterages[i]);
+    os << "])";
+}
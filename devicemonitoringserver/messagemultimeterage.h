@@ -0,0 +1,103 @@
+#ifndef MESSAGEMULTIMETERAGE_H
+#define MESSAGEMULTIMETERAGE_H
+
+#include "message.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/*!
+ * \brief Класс сообщения с измерениями нескольких физических параметров (каналов) устройства.
+ *
+ * Формат: обозначение типа, временная метка (uint64_t), количество каналов (uint8_t),
+ * далее величины измерений по каналам.
+ */
+class MessageMultiMeterage final : public Message
+{
+public:
+    /*!
+     * \brief Конструктор.
+     * \param timeStamp - временная метка измерений
+     * \param meterages - величины измерений по каналам; каналы сверх maxChannels() отбрасываются
+     */
+    MessageMultiMeterage(uint64_t timeStamp, std::vector<uint8_t> meterages) :
+        m_timeStamp(timeStamp), m_meterages(std::move(meterages))
+    {
+        if (m_meterages.size() > maxChannels())
+            m_meterages.resize(maxChannels());
+    }
+
+    /*!
+     * \brief Обозначение типа сообщения для целей сериализации
+     */
+    static constexpr char signature() { return 'M'; }
+    /*!
+     * \brief Максимальное количество каналов в сообщении
+     */
+    static constexpr size_t maxChannels() { return UINT8_MAX; }
+
+    /*!
+     * \brief Временная метка измерений
+     */
+    uint64_t timeStamp() const { return m_timeStamp; }
+    /*!
+     * \brief Величины измерений по каналам
+     */
+    const std::vector<uint8_t>& meterages() const { return m_meterages; }
+
+    /*!
+     * \brief Сериализовать сообщение в поток \a os
+     */
+    virtual void serialize(std::ostream& os) const override final;
+    /*!
+     * \brief Максимальный размер сериализованного сообщения в байтах
+     */
+    static constexpr size_t maxSerializedSize() { return headerSize() + maxChannels(); }
+    size_t serializedSize() const override final { return headerSize() + m_meterages.size(); }
+    /*!
+     * \brief Сериализовать сообщение в буфер \a buffer размером не менее serializedSize()
+     * \return количество записанных байтов
+     */
+    size_t serialize(char* buffer) const override final;
+    /*!
+     * \brief Десериализовать сообщение из потока \a is
+     */
+    static std::unique_ptr<Message> deserialize(std::istream& is);
+    /*!
+     * \brief Десериализовать сообщение из буфера
+     * \param payload - данные сообщения, следующие за обозначением типа
+     */
+    static std::optional<MessageMultiMeterage> deserializeValue(std::string_view payload);
+
+    bool operator==(const MessageMultiMeterage& other) const
+    {
+        return timeStamp() == other.timeStamp() && meterages() == other.meterages();
+    }
+    bool operator!=(const MessageMultiMeterage& other) const
+    {
+        return !(*this == other);
+    }
+    using Message::operator!=;
+    bool operator==(const Message& other) const override final
+    {
+        const MessageMultiMeterage* o = dynamic_cast<const MessageMultiMeterage*>(&other);
+        return o && *this == *o;
+    }
+
+    void print(std::ostream& os) const override final;
+
+private:
+    /*!
+     * \brief Размер заголовка: обозначение типа, временная метка и количество каналов
+     */
+    static constexpr size_t headerSize() { return 1 + sizeof(uint64_t) + sizeof(uint8_t); }
+
+private:
+    uint64_t m_timeStamp;
+    std::vector<uint8_t> m_meterages;
+};
+
+#endif // MESSAGEMULTIMETERAGE_H
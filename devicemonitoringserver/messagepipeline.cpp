@@ -0,0 +1,41 @@
+#include "messagepipeline.h"
+#include "baseencoderexecutor.h"
+#include "messageserializer.h"
+
+bool MessagePipeline::encode(const MessageVariant& message, const BaseEncoderExecutor& executor,
+                             std::string& encoded, std::string& scratch)
+{
+    return std::visit([&executor, &encoded, &scratch](const auto& m) {
+        // Размер пакета вычисляется обходом записей, поэтому делается это один раз
+        const size_t size = m.serializedSize();
+        const size_t encodedSize = executor.maxEncodedSize(size);
+        if (encodedSize == BaseEncoderExecutor::unknownSize || encodedSize < size)
+        {
+            scratch.resize(size);
+            scratch.resize(m.serialize(&scratch[0]));
+            return executor.encodeTo(scratch, encoded);
+        }
+        encoded.resize(encodedSize);
+        char* tail = &encoded[0] + encodedSize - size;
+        const size_t written = m.serialize(tail);
+        if (written == size)
+        {
+            if (auto encodedWritten = executor.encodeFromTail(&encoded[0], size))
+            {
+                encoded.resize(*encodedWritten);
+                return true;
+            }
+        }
+        scratch.assign(tail, written);
+        return executor.encodeTo(scratch, encoded);
+    },
+                      message);
+}
+
+std::optional<MessageVariant> MessagePipeline::decode(std::string_view message, const BaseEncoderExecutor& executor,
+                                                      std::string& decoded)
+{
+    if (!executor.decodeTo(message, decoded))
+        return {};
+    return MessageSerializer::deserializeValue(decoded);
+}
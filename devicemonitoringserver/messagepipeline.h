@@ -0,0 +1,40 @@
+#ifndef MESSAGEPIPELINE_H
+#define MESSAGEPIPELINE_H
+
+#include "messagevariant.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+class BaseEncoderExecutor;
+
+/*!
+ * \brief Совмещенные сериализация и шифрование сообщений
+ *
+ * Исходящее сообщение сериализуется сразу в конец буфера зашифрованных данных и шифруется
+ * в том же буфере (BaseEncoderExecutor::encodeFromTail()); входящее расшифровывается в буфер,
+ * из которого разбирается без копирования. Если алгоритм не поддерживает совмещенный режим,
+ * используется промежуточный буфер.
+ */
+class MessagePipeline
+{
+public:
+    MessagePipeline() = delete;
+    /*!
+     * \brief Сериализовать и зашифровать сообщение \a message алгоритмом \a executor в строку \a encoded
+     * \param scratch - промежуточный буфер, используемый, если совмещенный режим не поддерживается
+     * \return false в случае ошибки
+     */
+    static bool encode(const MessageVariant& message, const BaseEncoderExecutor& executor,
+                       std::string& encoded, std::string& scratch);
+    /*!
+     * \brief Расшифровать алгоритмом \a executor и разобрать сообщение \a message
+     * \param decoded - буфер расшифрованных данных; результат ссылается на него и действителен,
+     * пока буфер не изменен
+     */
+    static std::optional<MessageVariant> decode(std::string_view message, const BaseEncoderExecutor& executor,
+                                                std::string& decoded);
+};
+
+#endif // MESSAGEPIPELINE_H
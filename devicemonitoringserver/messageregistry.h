@@ -0,0 +1,126 @@
+#ifndef MESSAGEREGISTRY_H
+#define MESSAGEREGISTRY_H
+
+#include <array>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <variant>
+
+class Message;
+
+/*!
+ * \brief Проверка уникальности обозначений типов сообщений \a Ts на этапе компиляции
+ */
+template <class... Ts>
+constexpr bool uniqueMessageSignatures()
+{
+    constexpr char signatures[] = { Ts::signature()... };
+    for (size_t i = 0; i < sizeof...(Ts); ++i)
+    {
+        for (size_t j = i + 1; j < sizeof...(Ts); ++j)
+        {
+            if (signatures[i] == signatures[j])
+                return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Реестр типов сообщений \a Ts, построенный на этапе компиляции.
+ *
+ * Для каждого возможного значения первого байта (обозначения типа) строится таблица
+ * из 256 функций десериализации, поэтому выбор типа сообщения выполняется одним
+ * индексированным переходом независимо от количества зарегистрированных типов.
+ * Каждый тип должен предоставлять static constexpr char signature(),
+ * static std::optional<T> deserializeValue(std::string_view payload) и
+ * static std::unique_ptr<Message> deserialize(std::istream& is).
+ */
+template <class... Ts>
+class MessageRegistry
+{
+    static_assert(sizeof...(Ts) > 0, "Message registry must not be empty");
+    static_assert(uniqueMessageSignatures<Ts...>(), "Message signatures must be unique");
+
+public:
+    MessageRegistry() = delete;
+
+    /*!
+     * \brief Сообщение-значение, содержащее один из зарегистрированных типов
+     */
+    using Variant = std::variant<Ts...>;
+
+    /*!
+     * \brief Десериализовать сообщение-значение из буфера \a data
+     */
+    static std::optional<Variant> deserializeValue(std::string_view data)
+    {
+        if (data.empty())
+            return {};
+        return s_valueParsers[static_cast<unsigned char>(data.front())](data.substr(1));
+    }
+
+    /*!
+     * \brief Десериализовать сообщение из входного потока \a is
+     * \note Если обозначение типа неизвестно, поток не изменяется
+     */
+    static std::unique_ptr<Message> deserialize(std::istream& is)
+    {
+        const auto signature = is.peek();
+        if (signature == std::istream::traits_type::eof())
+            return {};
+        const auto parser = s_streamParsers[static_cast<unsigned char>(signature)];
+        if (!parser)
+            return {};
+        is.get();
+        return parser(is);
+    }
+
+    /*!
+     * \brief Тип с обозначением \a signature зарегистрирован
+     */
+    static constexpr bool contains(char signature)
+    {
+        return s_streamParsers[static_cast<unsigned char>(signature)] != nullptr;
+    }
+
+private:
+    using ValueParser = std::optional<Variant> (*)(std::string_view);
+    using StreamParser = std::unique_ptr<Message> (*)(std::istream&);
+
+    template <class T>
+    static std::optional<Variant> parseValue(std::string_view payload)
+    {
+        if (auto message = T::deserializeValue(payload))
+            return Variant(std::in_place_type<T>, std::move(*message));
+        return {};
+    }
+
+    static std::optional<Variant> rejectValue(std::string_view)
+    {
+        return {};
+    }
+
+    static constexpr std::array<ValueParser, 256> makeValueParsers()
+    {
+        std::array<ValueParser, 256> parsers {};
+        for (auto& parser : parsers)
+            parser = &rejectValue;
+        ((parsers[static_cast<unsigned char>(Ts::signature())] = &parseValue<Ts>), ...);
+        return parsers;
+    }
+
+    static constexpr std::array<StreamParser, 256> makeStreamParsers()
+    {
+        std::array<StreamParser, 256> parsers {};
+        ((parsers[static_cast<unsigned char>(Ts::signature())] = &Ts::deserialize), ...);
+        return parsers;
+    }
+
+    static constexpr std::array<ValueParser, 256> s_valueParsers = makeValueParsers();
+    static constexpr std::array<StreamParser, 256> s_streamParsers = makeStreamParsers();
+};
+
+#endif // MESSAGEREGISTRY_H
@@ -4,17 +4,76 @@
 #include "messageerror.h"
 #include "messagemeterage.h"
 
-#include <sstream>
+size_t MessageSerializer::serializedSize(const Message& message)
+{
+    return message.serializedSize();
+}
+
+size_t MessageSerializer::serializedSize(const MessageVariant& message)
+{
+    return std::visit([](const auto& m) { return m.serializedSize(); }, message);
+}
+
+size_t MessageSerializer::serialize(const Message& message, char* buffer, size_t size)
+{
+    if (message.serializedSize() > size)
+        return 0;
+    return message.serialize(buffer);
+}
+
+size_t MessageSerializer::serialize(const MessageVariant& message, char* buffer, size_t size)
+{
+    return std::visit([buffer, size](const auto& m) -> size_t {
+        if (m.serializedSize() > size)
+            return 0;
+        return m.serialize(buffer);
+    },
+                      message);
+}
+
+size_t MessageSerializer::serialize(const Message& message, std::string& buffer)
+{
+    const auto offset = buffer.size();
+    buffer.resize(offset + message.serializedSize());
+    const auto written = message.serialize(buffer.data() + offset);
+    buffer.resize(offset + written);
+    return written;
+}
+
+size_t MessageSerializer::serialize(const MessageVariant& message, std::string& buffer)
+{
+    return std::visit([&buffer](const auto& m) {
+        const auto offset = buffer.size();
+        buffer.resize(offset + m.serializedSize());
+        const auto written = m.serialize(buffer.data() + offset);
+        buffer.resize(offset + written);
+        return written;
+    },
+                      message);
+}
 
 std::string MessageSerializer::serialize(const Message& message)
 {
-    std::ostringstream os(std::ios_base::binary);
-    message.serialize(os);
-    return os.str();
+    std::string buffer;
+    serialize(message, buffer);
+    return buffer;
+}
+
+std::string MessageSerializer::serialize(const MessageVariant& message)
+{
+    std::string buffer;
+    serialize(message, buffer);
+    return buffer;
+}
+
+std::unique_ptr<Message> MessageSerializer::deserialize(std::string_view string)
+{
+    if (auto message = deserializeMessageValue(string))
+        return toMessagePtr(*message);
+    return {};
 }
 
-std::unique_ptr<Message> MessageSerializer::deserialize(const std::string& string)
+std::optional<MessageVariant> MessageSerializer::deserializeValue(std::string_view string)
 {
-    std::istringstream is(string, std::ios_base::binary);
-    return Message::deserialize(is);
-}
\ No newline at end of file
+    return deserializeMessageValue(string);
+}
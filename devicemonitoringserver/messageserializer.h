@@ -1,8 +1,13 @@
 #ifndef MESSAGESERIALIZER_H
 #define MESSAGESERIALIZER_H
 
+#include "messagevariant.h"
+
+#include <cstddef>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 
 class Message;
 
@@ -13,14 +18,50 @@ class MessageSerializer
 {
 public:
     MessageSerializer() = delete;
+    /*!
+     * \brief Размер сериализованного сообщения \a message в байтах
+     */
+    static size_t serializedSize(const Message& message);
+    /*!
+     * \brief Размер сериализованного сообщения-значения \a message в байтах
+     */
+    static size_t serializedSize(const MessageVariant& message);
+    /*!
+     * \brief Сериализовать сообщение \a message в буфер \a buffer размером \a size
+     * \return количество записанных байтов или 0, если буфер слишком мал
+     */
+    static size_t serialize(const Message& message, char* buffer, size_t size);
+    /*!
+     * \brief Сериализовать сообщение-значение \a message в буфер \a buffer размером \a size
+     * \return количество записанных байтов или 0, если буфер слишком мал
+     */
+    static size_t serialize(const MessageVariant& message, char* buffer, size_t size);
+    /*!
+     * \brief Дописать сериализованное сообщение \a message в конец переиспользуемого буфера \a buffer
+     * \return количество записанных байтов
+     */
+    static size_t serialize(const Message& message, std::string& buffer);
+    /*!
+     * \brief Дописать сериализованное сообщение-значение \a message в конец переиспользуемого буфера \a buffer
+     * \return количество записанных байтов
+     */
+    static size_t serialize(const MessageVariant& message, std::string& buffer);
     /*!
      * \brief Сериализовать сообщение \a message
      */
     static std::string serialize(const Message& message);
+    /*!
+     * \brief Сериализовать сообщение-значение \a message
+     */
+    static std::string serialize(const MessageVariant& message);
     /*!
      * \brief Десериализовать сообщение из строки \a string
      */
-    static std::unique_ptr<Message> deserialize(const std::string& string);
+    static std::unique_ptr<Message> deserialize(std::string_view string);
+    /*!
+     * \brief Десериализовать сообщение-значение из строки \a string без копирования данных
+     */
+    static std::optional<MessageVariant> deserializeValue(std::string_view string);
 };
 
-#endif // MESSAGESERIALIZER_H
\ No newline at end of file
+#endif // MESSAGESERIALIZER_H
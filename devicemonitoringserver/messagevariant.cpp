@@ -0,0 +1,21 @@
+#include "messagevariant.h"
+#include "bigendian.h"
+
+std::optional<MessageVariant> deserializeMessageValue(std::string_view data)
+{
+    // Быстрый путь для самого частого сообщения фиксированного размера: одна проверка границ
+    if (data.size() >= MessageMeterage::maxSerializedSize() && data.front() == MessageMeterage::signature())
+    {
+        return MessageMeterage(fromBigEndian<uint64_t>(data.data() + 1),
+                               fromBigEndian<uint8_t>(data.data() + 1 + sizeof(uint64_t)));
+    }
+    return MessageTypes::deserializeValue(data);
+}
+
+std::unique_ptr<Message> toMessagePtr(const MessageVariant& message)
+{
+    return std::visit([](const auto& m) -> std::unique_ptr<Message> {
+        return std::unique_ptr<Message>(new std::decay_t<decltype(m)>(m));
+    },
+                      message);
+}
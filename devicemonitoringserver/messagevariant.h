@@ -0,0 +1,51 @@
+#ifndef MESSAGEVARIANT_H
+#define MESSAGEVARIANT_H
+
+#include "messagebatch.h"
+#include "messagecommand.h"
+#include "messageerror.h"
+#include "messagehandshake.h"
+#include "messagemeterage.h"
+#include "messagemeteragedelta.h"
+#include "messagemulticommand.h"
+#include "messagemultimeterage.h"
+#include "messageregistry.h"
+
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <variant>
+
+/*!
+ * \brief Реестр всех типов сообщений протокола.
+ * \note Новые типы сообщений регистрируются добавлением в этот список
+ */
+using MessageTypes = MessageRegistry<MessageMeterage, MessageCommand, MessageError, MessageBatch, MessageMeterageDelta,
+                                    MessageMultiMeterage, MessageMultiCommand, MessageHandshake>;
+
+/*!
+ * \brief Сообщение в виде значения.
+ *
+ * Замкнутый набор типов сообщений: хранится без выделения динамической памяти,
+ * обработка выполняется через std::visit без dynamic_cast.
+ */
+using MessageVariant = MessageTypes::Variant;
+
+/*!
+ * \brief Десериализовать сообщение-значение из буфера \a data без копирования данных
+ */
+std::optional<MessageVariant> deserializeMessageValue(std::string_view data);
+
+/*!
+ * \brief Преобразовать сообщение-значение в полиморфное сообщение
+ */
+std::unique_ptr<Message> toMessagePtr(const MessageVariant& message);
+
+inline std::ostream& operator<<(std::ostream& os, const MessageVariant& message)
+{
+    std::visit([&os](const auto& m) { m.print(os); }, message);
+    return os;
+}
+
+#endif // MESSAGEVARIANT_H
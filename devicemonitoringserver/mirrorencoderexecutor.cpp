@@ -1,11 +1,16 @@
 #include "mirrorencoderexecutor.h"
 #include "bigendian.h"
+#include "cpufeatures.h"
 
-#include <cassert>
 #include <cstdint>
-#include <sstream>
+#include <cstring>
 
-static int digits(uint16_t value)
+#if defined(__x86_64__) && defined(__GNUC__)
+#define MIRROR_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+static constexpr int digits(uint16_t value)
 {
     int digits = 0;
     while (value > 0)
@@ -16,7 +21,7 @@ static int digits(uint16_t value)
     return digits;
 }
 
-static uint16_t mirror(uint16_t value, int digits)
+static constexpr uint16_t mirror(uint16_t value, int digits)
 {
     uint16_t result = 0;
     for (int i = 0; i < digits; ++i)
@@ -28,32 +33,209 @@ static uint16_t mirror(uint16_t value, int digits)
     return result;
 }
 
-std::string MirrorEncoderExecutor::encode(const std::string& message) const
+/*!
+ * \brief Таблицы кодирования и декодирования.
+ *
+ * Кодирование: байт -> тройка (количество цифр, зеркальное значение в big-endian),
+ * дополненная до 4 байтов для записи одной операцией.
+ * Декодирование: (количество цифр, значение) -> байт для значений, возможных при кодировании
+ * (не более 3 цифр и 999); прочие тройки декодируются вычислением mirror().
+ */
+struct MirrorTables
 {
-    std::ostringstream ostream(std::ios_base::binary);
-    for (auto ch : message)
+    static constexpr int maxDigits = 3;
+    static constexpr uint16_t maxValue = 999;
+
+    uint32_t encode[256] = {};
+    uint8_t decode[maxDigits + 1][maxValue + 1] = {};
+    uint8_t decodePadding[3] = {}; ///< Позволяет читать 4 байта начиная с последнего элемента decode
+};
+
+static constexpr MirrorTables makeMirrorTables()
+{
+    MirrorTables tables;
+    for (int c = 0; c < 256; ++c)
+    {
+        const int digs = digits(static_cast<uint16_t>(c));
+        const uint16_t value = mirror(static_cast<uint16_t>(c), digs);
+        // Байты в памяти: количество цифр, старший и младший байты значения, 0 (little-endian)
+        tables.encode[c] = static_cast<uint32_t>(digs) | static_cast<uint32_t>(value >> 8) << 8 | static_cast<uint32_t>(value & 0xFF) << 16;
+    }
+    for (int digs = 0; digs <= MirrorTables::maxDigits; ++digs)
     {
-        auto c = static_cast<unsigned char>(ch);
-        int digs = digits(c);
-        ostream.put(digs);
-        toBigEndian(ostream, mirror(c, digs));
+        for (int value = 0; value <= MirrorTables::maxValue; ++value)
+            tables.decode[digs][value] = static_cast<uint8_t>(mirror(static_cast<uint16_t>(value), digs));
     }
-    return ostream.str();
+    return tables;
 }
 
-std::string MirrorEncoderExecutor::decode(const std::string& message) const
+static constexpr MirrorTables tables = makeMirrorTables();
+
+/*!
+ * \brief Записать тройку \a triple по адресу \a out.
+ * \param padded - можно ли записать 4 байта (байт-заполнитель перезаписывается следующей тройкой)
+ */
+static inline void storeTriple(char* out, uint32_t triple, bool padded)
 {
-    std::istringstream istream(message, std::ios_base::binary);
-    std::string decoded;
-    while (true)
+#if defined(BIGENDIAN_BYTESWAP_BUILTINS)
+    if (padded)
     {
-        unsigned char digs = istream.get();
-        if (istream.fail())
-            break;
-        auto value = mirror(fromBigEndian<uint16_t>(istream), digs);
-        if (istream.fail())
+        std::memcpy(out, &triple, sizeof(triple));
+        return;
+    }
+#else
+    (void)padded;
+#endif
+    out[0] = static_cast<char>(triple);
+    out[1] = static_cast<char>(triple >> 8);
+    out[2] = static_cast<char>(triple >> 16);
+}
+
+/*!
+ * \brief Закодировать \a size байтов из \a in в \a out размером 3 * size
+ */
+static void encodeScalar(char* out, const char* in, size_t size)
+{
+    for (size_t i = 0; i < size; ++i, out += 3)
+        storeTriple(out, tables.encode[static_cast<uint8_t>(in[i])], i + 1 < size);
+}
+
+#ifdef MIRROR_X86_KERNELS
+
+/*!
+ * \brief Кодирование по 8 байтов: выборка 32-битных элементов таблицы (vpgatherdd)
+ * и удаление байта-заполнителя перестановкой (vpshufb).
+ */
+__attribute__((target("avx2"))) static void encodeAvx2(char* out, const char* in, size_t size)
+{
+    const __m256i compact = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                             0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const auto* table = reinterpret_cast<const int*>(tables.encode);
+    size_t i = 0;
+    // Каждая итерация записывает 28 байтов, из которых используются 24: 3 * (i + 10) >= 3 * i + 28
+    for (; i + 10 <= size; i += 8, out += 24)
+    {
+        const __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)));
+        const __m256i triples = _mm256_shuffle_epi8(_mm256_i32gather_epi32(table, index, 4), compact);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(triples));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm256_extracti128_si256(triples, 1));
+    }
+    encodeScalar(out, in + i, size - i);
+}
+
+/*!
+ * \brief Декодирование по 8 троек: перестановкой (vpshufb) количество цифр и значение
+ * раскладываются по 32-битным элементам, байт выбирается из таблицы (vpgatherdd).
+ * Блоки с тройками, не получаемыми при кодировании, декодируются скалярно.
+ * \param inSize - размер данных \a in
+ * \return количество декодированных байтов
+ */
+__attribute__((target("avx2"))) static size_t decodeAvx2(char* out, const char* in, size_t inSize)
+{
+    const __m256i digitsMask = _mm256_setr_epi8(0, -1, -1, -1, 3, -1, -1, -1, 6, -1, -1, -1, 9, -1, -1, -1,
+                                                0, -1, -1, -1, 3, -1, -1, -1, 6, -1, -1, -1, 9, -1, -1, -1);
+    const __m256i valueMask = _mm256_setr_epi8(2, 1, -1, -1, 5, 4, -1, -1, 8, 7, -1, -1, 11, 10, -1, -1,
+                                               2, 1, -1, -1, 5, 4, -1, -1, 8, 7, -1, -1, 11, 10, -1, -1);
+    const __m256i packMask = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                              0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i maxDigits = _mm256_set1_epi32(MirrorTables::maxDigits);
+    const __m256i maxValue = _mm256_set1_epi32(MirrorTables::maxValue);
+    const __m256i rowSize = _mm256_set1_epi32(MirrorTables::maxValue + 1);
+    const auto* table = reinterpret_cast<const int*>(&tables.decode[0][0]);
+    size_t i = 0;
+    // Каждая итерация читает 28 байтов, из которых используются 24
+    for (; 3 * i + 28 <= inSize; i += 8, in += 24)
+    {
+        const __m256i triples = _mm256_loadu2_m128i(reinterpret_cast<const __m128i*>(in + 12),
+                                                    reinterpret_cast<const __m128i*>(in));
+        const __m256i digs = _mm256_shuffle_epi8(triples, digitsMask);
+        const __m256i value = _mm256_shuffle_epi8(triples, valueMask);
+        const __m256i invalid = _mm256_or_si256(_mm256_cmpgt_epi32(digs, maxDigits), _mm256_cmpgt_epi32(value, maxValue));
+        if (!_mm256_testz_si256(invalid, invalid))
             break;
-        decoded += static_cast<unsigned char>(value);
+        const __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(digs, rowSize), value);
+        const __m256i bytes = _mm256_shuffle_epi8(_mm256_i32gather_epi32(table, index, 1), packMask);
+        const uint64_t packed = static_cast<uint32_t>(_mm256_extract_epi32(bytes, 0))
+                                | static_cast<uint64_t>(static_cast<uint32_t>(_mm256_extract_epi32(bytes, 4))) << 32;
+        std::memcpy(out + i, &packed, sizeof(packed));
+    }
+    return i;
+}
+
+#endif // MIRROR_X86_KERNELS
+
+/*!
+ * \brief Закодировать \a size байтов с выбором реализации по уровню векторных инструкций
+ */
+static void encodeBytes(char* out, const char* in, size_t size)
+{
+#ifdef MIRROR_X86_KERNELS
+    if (simdLevel() >= SimdLevel::Avx2)
+        return encodeAvx2(out, in, size);
+#endif
+    encodeScalar(out, in, size);
+}
+
+/*!
+ * \brief Декодировать \a size троек из \a in размером \a inSize
+ */
+static void decodeTriples(char* out, const char* in, size_t inSize, size_t size)
+{
+    size_t i = 0;
+#ifdef MIRROR_X86_KERNELS
+    if (simdLevel() >= SimdLevel::Avx2)
+    {
+        i = decodeAvx2(out, in, inSize);
+        in += 3 * i;
     }
+#endif
+    for (; i < size; ++i, in += 3)
+    {
+        const auto digs = static_cast<unsigned char>(in[0]);
+        const auto value = fromBigEndian<uint16_t>(in + 1);
+        out[i] = static_cast<char>(digs <= MirrorTables::maxDigits && value <= MirrorTables::maxValue
+                                       ? tables.decode[digs][value]
+                                       : static_cast<uint8_t>(mirror(value, digs)));
+    }
+}
+
+std::string MirrorEncoderExecutor::encode(const std::string& message) const
+{
+    std::string encoded(maxEncodedSize(message.size()), '\0');
+    encodeBytes(&encoded[0], message.data(), message.size());
+    return encoded;
+}
+
+std::string MirrorEncoderExecutor::decode(const std::string& message) const
+{
+    std::string decoded(maxDecodedSize(message.size()), '\0');
+    decodeTriples(&decoded[0], message.data(), message.size(), decoded.size());
     return decoded;
 }
+
+std::optional<size_t> MirrorEncoderExecutor::encodeInto(std::string_view message, char* output, size_t outputSize) const
+{
+    const size_t size = maxEncodedSize(message.size());
+    if (outputSize < size)
+        return {};
+    encodeBytes(output, message.data(), message.size());
+    return size;
+}
+
+std::optional<size_t> MirrorEncoderExecutor::decodeInto(std::string_view message, char* output, size_t outputSize) const
+{
+    const size_t size = maxDecodedSize(message.size());
+    if (outputSize < size)
+        return {};
+    decodeTriples(output, message.data(), message.size(), size);
+    return size;
+}
+
+std::optional<size_t> MirrorEncoderExecutor::encodeFromTail(char* buffer, size_t size) const
+{
+    // Тройка i записывается в [3i, 3i + 4), непрочитанные байты начинаются с 2 * size + i + 1:
+    // запись не обгоняет чтение, в том числе в блоках по 8 байтов (условие цикла i + 10 <= size)
+    const size_t encodedSize = maxEncodedSize(size);
+    encodeBytes(buffer, buffer + encodedSize - size, size);
+    return encodedSize;
+}
@@ -8,6 +8,12 @@ class MirrorEncoderExecutor final : public BaseEncoderExecutor
     std::string encode(const std::string& message) const override final;
     std::string decode(const std::string& message) const override final;
     std::string name() const override final { return "Mirror"; }
+    size_t maxEncodedSize(size_t size) const override final { return size * 3; }
+    size_t maxDecodedSize(size_t size) const override final { return size / 3; }
+    size_t encodedUnitSize() const override final { return 3; }
+    std::optional<size_t> encodeInto(std::string_view message, char* output, size_t outputSize) const override final;
+    std::optional<size_t> decodeInto(std::string_view message, char* output, size_t outputSize) const override final;
+    std::optional<size_t> encodeFromTail(char* buffer, size_t size) const override final;
 };
 
 #endif // MIRRORENCODEREXECUTOR_H
\ No newline at end of file
@@ -1,30 +1,217 @@
 #include "multiply41encoderexecutor.h"
 #include "bigendian.h"
+#include "cpufeatures.h"
 
 #include <cstdint>
-#include <sstream>
 
-std::string Multiply41EncoderExecutor::encode(const std::string& message) const
+#if defined(__x86_64__) && defined(__GNUC__)
+#define MULTIPLY41_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+static constexpr uint16_t factor = 41;
+
+/*!
+ * \brief Константы деления 16-битного числа на 41 умножением на обратную величину:
+ * t = (v * reciprocal) >> 16, v / 41 = (t + ((v - t) >> 1)) >> shift.
+ * Результат точен для всех 65536 значений (проверяется тестами).
+ */
+static constexpr uint16_t reciprocal = 36765;
+static constexpr int shift = 5;
+
+/*!
+ * \brief Минимальное количество байтов сообщения для 256-битной реализации.
+ *
+ * 256-битное умножение требует прогрева векторного блока процессора, и на коротких
+ * сообщениях 128-битная реализация быстрее (по замерам граница около 2-4 КиБ).
+ */
+static constexpr size_t avx2MinSize = 4096;
+
+static void encodeScalar(char* out, const char* in, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        out = toBigEndian(out, static_cast<uint16_t>(static_cast<uint8_t>(in[i]) * factor));
+}
+
+static void decodeScalar(char* out, const char* in, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        out[i] = static_cast<char>(fromBigEndian<uint16_t>(in + i * sizeof(uint16_t)) / factor);
+}
+
+#ifdef MULTIPLY41_X86_KERNELS
+
+/*!
+ * \brief Умножить 8 байтов (в 16-битных элементах) на 41 и переставить байты каждого элемента
+ */
+__attribute__((target("sse2"))) static inline __m128i encodeSse2Block(__m128i values)
+{
+    const __m128i product = _mm_mullo_epi16(values, _mm_set1_epi16(factor));
+    return _mm_or_si128(_mm_slli_epi16(product, 8), _mm_srli_epi16(product, 8));
+}
+
+/*!
+ * \brief Переставить байты 8 элементов, разделить на 41 и оставить младший байт частного
+ */
+__attribute__((target("sse2"))) static inline __m128i decodeSse2Block(__m128i encoded)
+{
+    const __m128i values = _mm_or_si128(_mm_slli_epi16(encoded, 8), _mm_srli_epi16(encoded, 8));
+    const __m128i t = _mm_mulhi_epu16(values, _mm_set1_epi16(static_cast<short>(reciprocal)));
+    const __m128i quotient = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(_mm_sub_epi16(values, t), 1)), shift);
+    return _mm_and_si128(quotient, _mm_set1_epi16(0x00FF));
+}
+
+__attribute__((target("sse2"))) static void encodeSse2(char* out, const char* in, size_t size)
 {
-    std::ostringstream ostream(std::ios_base::binary);
-    for (auto ch : message)
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
     {
-        auto c = static_cast<unsigned char>(ch);
-        toBigEndian(ostream, static_cast<uint16_t>(c * 41));
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), encodeSse2Block(_mm_unpacklo_epi8(bytes, zero)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), encodeSse2Block(_mm_unpackhi_epi8(bytes, zero)));
     }
-    return ostream.str();
+    encodeScalar(out + 2 * i, in + i, size - i);
 }
 
-std::string Multiply41EncoderExecutor::decode(const std::string& message) const
+__attribute__((target("sse2"))) static void decodeSse2(char* out, const char* in, size_t size)
+{
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i low = decodeSse2Block(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i)));
+        const __m128i high = decodeSse2Block(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 16)));
+        // Частные уже ограничены младшим байтом, упаковка с насыщением их не меняет
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+    }
+    decodeScalar(out + i, in + 2 * i, size - i);
+}
+
+__attribute__((target("avx2"))) static inline __m256i encodeAvx2Block(__m256i values)
 {
-    std::istringstream istream(message, std::ios_base::binary);
-    std::string decoded;
-    while (true)
+    const __m256i product = _mm256_mullo_epi16(values, _mm256_set1_epi16(factor));
+    return _mm256_or_si256(_mm256_slli_epi16(product, 8), _mm256_srli_epi16(product, 8));
+}
+
+__attribute__((target("avx2"))) static inline __m256i decodeAvx2Block(__m256i encoded)
+{
+    const __m256i values = _mm256_or_si256(_mm256_slli_epi16(encoded, 8), _mm256_srli_epi16(encoded, 8));
+    const __m256i t = _mm256_mulhi_epu16(values, _mm256_set1_epi16(static_cast<short>(reciprocal)));
+    const __m256i quotient = _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(_mm256_sub_epi16(values, t), 1)), shift);
+    return _mm256_and_si256(quotient, _mm256_set1_epi16(0x00FF));
+}
+
+__attribute__((target("avx2"))) static void encodeAvx2(char* out, const char* in, size_t size)
+{
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
     {
-        auto value = fromBigEndian<uint16_t>(istream);
-        if (istream.fail())
-            break;
-        decoded += static_cast<unsigned char>(value / 41);
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 16));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i), encodeAvx2Block(_mm256_cvtepu8_epi16(low)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 32), encodeAvx2Block(_mm256_cvtepu8_epi16(high)));
     }
+    encodeSse2(out + 2 * i, in + i, size - i);
+}
+
+__attribute__((target("avx2"))) static void decodeAvx2(char* out, const char* in, size_t size)
+{
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        const __m256i low = decodeAvx2Block(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * i)));
+        const __m256i high = decodeAvx2Block(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * i + 32)));
+        // vpackuswb упаковывает по 128-битным половинам, порядок восстанавливается перестановкой четвертей
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    decodeSse2(out + i, in + 2 * i, size - i);
+}
+
+#endif // MULTIPLY41_X86_KERNELS
+
+/*!
+ * \brief Закодировать \a size байтов с выбором реализации по уровню векторных инструкций и размеру
+ */
+static void encodeBytes(char* out, const char* in, size_t size)
+{
+#ifdef MULTIPLY41_X86_KERNELS
+    switch (simdLevel())
+    {
+    case SimdLevel::Avx2:
+        if (size >= avx2MinSize)
+            return encodeAvx2(out, in, size);
+        [[fallthrough]];
+    case SimdLevel::Ssse3:
+    case SimdLevel::Sse2:
+        return encodeSse2(out, in, size);
+    default:
+        break;
+    }
+#endif
+    encodeScalar(out, in, size);
+}
+
+/*!
+ * \brief Декодировать \a size значений с выбором реализации по уровню векторных инструкций и размеру
+ */
+static void decodeValues(char* out, const char* in, size_t size)
+{
+#ifdef MULTIPLY41_X86_KERNELS
+    switch (simdLevel())
+    {
+    case SimdLevel::Avx2:
+        if (size >= avx2MinSize)
+            return decodeAvx2(out, in, size);
+        [[fallthrough]];
+    case SimdLevel::Ssse3:
+    case SimdLevel::Sse2:
+        return decodeSse2(out, in, size);
+    default:
+        break;
+    }
+#endif
+    decodeScalar(out, in, size);
+}
+
+std::string Multiply41EncoderExecutor::encode(const std::string& message) const
+{
+    std::string encoded(maxEncodedSize(message.size()), '\0');
+    encodeBytes(&encoded[0], message.data(), message.size());
+    return encoded;
+}
+
+std::string Multiply41EncoderExecutor::decode(const std::string& message) const
+{
+    // Непарный последний байт отбрасывается
+    std::string decoded(maxDecodedSize(message.size()), '\0');
+    decodeValues(&decoded[0], message.data(), decoded.size());
     return decoded;
 }
+
+std::optional<size_t> Multiply41EncoderExecutor::encodeInto(std::string_view message, char* output, size_t outputSize) const
+{
+    const size_t size = maxEncodedSize(message.size());
+    if (outputSize < size)
+        return {};
+    encodeBytes(output, message.data(), message.size());
+    return size;
+}
+
+std::optional<size_t> Multiply41EncoderExecutor::decodeInto(std::string_view message, char* output, size_t outputSize) const
+{
+    const size_t size = maxDecodedSize(message.size());
+    if (outputSize < size)
+        return {};
+    decodeValues(output, message.data(), size);
+    return size;
+}
+
+std::optional<size_t> Multiply41EncoderExecutor::encodeFromTail(char* buffer, size_t size) const
+{
+    // Блок из n байтов, начинающийся с i, читается целиком и записывается в [2i, 2i + 2n),
+    // что не превосходит начала непрочитанных данных size + i + n, пока i + n <= size
+    const size_t encodedSize = maxEncodedSize(size);
+    encodeBytes(buffer, buffer + size, size);
+    return encodedSize;
+}
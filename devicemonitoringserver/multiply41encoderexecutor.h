@@ -8,6 +8,12 @@ class Multiply41EncoderExecutor final : public BaseEncoderExecutor
     std::string encode(const std::string& message) const override final;
     std::string decode(const std::string& message) const override final;
     std::string name() const override final { return "Multiply41"; }
+    size_t maxEncodedSize(size_t size) const override final { return size * sizeof(uint16_t); }
+    size_t maxDecodedSize(size_t size) const override final { return size / sizeof(uint16_t); }
+    size_t encodedUnitSize() const override final { return sizeof(uint16_t); }
+    std::optional<size_t> encodeInto(std::string_view message, char* output, size_t outputSize) const override final;
+    std::optional<size_t> decodeInto(std::string_view message, char* output, size_t outputSize) const override final;
+    std::optional<size_t> encodeFromTail(char* buffer, size_t size) const override final;
 };
 
 #endif // MULTIPLY41ENCODEREXECUTOR_H
\ No newline at end of file
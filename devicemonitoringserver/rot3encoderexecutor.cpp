@@ -1,40 +1,124 @@
 #include "rot3encoderexecutor.h"
+#include "cpufeatures.h"
 
-#include <limits>
+#include <cstdint>
 
-static constexpr int start = std::numeric_limits<char>::min();
-static constexpr int end = std::numeric_limits<char>::max() + 1;
+#if defined(__x86_64__) && defined(__GNUC__)
+#define ROT3_X86_KERNELS
+#include <immintrin.h>
+#endif
 
-std::string Rot3EncoderExecutor::encode(const std::string& message) const
+/*!
+ * \brief Величина сдвига: каждый байт сообщения увеличивается на 3 по модулю 256
+ */
+static constexpr uint8_t shift = 3;
+
+/*!
+ * \brief Скалярный сдвиг \a size байтов из \a in в \a out на \a delta по модулю 256
+ */
+static void rotateScalar(char* out, const char* in, size_t size, uint8_t delta)
+{
+    for (size_t i = 0; i < size; ++i)
+        out[i] = static_cast<char>(static_cast<uint8_t>(in[i]) + delta);
+}
+
+#ifdef ROT3_X86_KERNELS
+
+__attribute__((target("sse2"))) static void rotateSse2(char* out, const char* in, size_t size, uint8_t delta)
 {
-    std::string encoded;
-    encoded.reserve(message.size());
-    for (int c : message)
+    const __m128i add = _mm_set1_epi8(static_cast<char>(delta));
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
     {
-        if (c >= start && c < end)
-        {
-            c += 3;
-            if (c >= end)
-                c -= end - start;
-            encoded += c;
-        }
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi8(v, add));
     }
-    return encoded;
+    rotateScalar(out + i, in + i, size - i, delta);
 }
 
-std::string Rot3EncoderExecutor::decode(const std::string& message) const
+__attribute__((target("avx2"))) static void rotateAvx2(char* out, const char* in, size_t size, uint8_t delta)
+{
+    const __m256i add = _mm256_set1_epi8(static_cast<char>(delta));
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi8(v, add));
+    }
+    if (i + 16 <= size)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi8(v, _mm256_castsi256_si128(add)));
+        i += 16;
+    }
+    rotateScalar(out + i, in + i, size - i, delta);
+}
+
+#endif // ROT3_X86_KERNELS
+
+void Rot3EncoderExecutor::rotate(char* out, const char* in, size_t size, uint8_t delta)
 {
-    std::string decoded;
-    decoded.reserve(message.size());
-    for (int c : message)
+#ifdef ROT3_X86_KERNELS
+    switch (simdLevel())
     {
-        if (c >= start && c < end)
-        {
-            c -= 3;
-            if (c < start)
-                c += end - start;
-        }
-        decoded += c;
+    case SimdLevel::Avx2:
+        return rotateAvx2(out, in, size, delta);
+    case SimdLevel::Ssse3:
+    case SimdLevel::Sse2:
+        return rotateSse2(out, in, size, delta);
+    default:
+        break;
     }
+#endif
+    rotateScalar(out, in, size, delta);
+}
+
+std::string Rot3EncoderExecutor::encode(const std::string& message) const
+{
+    std::string encoded(message.size(), '\0');
+    rotate(&encoded[0], message.data(), message.size(), shift);
+    return encoded;
+}
+
+std::string Rot3EncoderExecutor::decode(const std::string& message) const
+{
+    std::string decoded(message.size(), '\0');
+    rotate(&decoded[0], message.data(), message.size(), static_cast<uint8_t>(-shift));
     return decoded;
 }
+
+std::optional<size_t> Rot3EncoderExecutor::encodeInto(std::string_view message, char* output, size_t outputSize) const
+{
+    if (outputSize < message.size())
+        return {};
+    rotate(output, message.data(), message.size(), shift);
+    return message.size();
+}
+
+std::optional<size_t> Rot3EncoderExecutor::decodeInto(std::string_view message, char* output, size_t outputSize) const
+{
+    if (outputSize < message.size())
+        return {};
+    rotate(output, message.data(), message.size(), static_cast<uint8_t>(-shift));
+    return message.size();
+}
+
+bool Rot3EncoderExecutor::encodeInPlace(char* data, size_t size) const
+{
+    // Каждый блок читается до записи на то же место, поэтому совпадение буферов допустимо
+    rotate(data, data, size, shift);
+    return true;
+}
+
+bool Rot3EncoderExecutor::decodeInPlace(char* data, size_t size) const
+{
+    rotate(data, data, size, static_cast<uint8_t>(-shift));
+    return true;
+}
+
+bool Rot3EncoderExecutor::byteMap(ByteMap& table) const
+{
+    for (size_t c = 0; c < table.size(); ++c)
+        table[c] = static_cast<uint8_t>(c + shift);
+    return true;
+}
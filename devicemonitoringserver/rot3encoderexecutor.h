@@ -5,9 +5,26 @@
 
 class Rot3EncoderExecutor final : public BaseEncoderExecutor
 {
+public:
+    /*!
+     * \brief Сдвинуть \a size байтов из \a in в \a out на \a delta по модулю 256
+     * с выбором реализации по уровню векторных инструкций; допускается совпадение \a out и \a in
+     */
+    static void rotate(char* out, const char* in, size_t size, uint8_t delta);
+
+private:
     std::string encode(const std::string& message) const override final;
     std::string decode(const std::string& message) const override final;
     std::string name() const override final { return "ROT3"; }
+    size_t maxEncodedSize(size_t size) const override final { return size; }
+    size_t maxDecodedSize(size_t size) const override final { return size; }
+    std::optional<size_t> encodeInto(std::string_view message, char* output, size_t outputSize) const override final;
+    std::optional<size_t> decodeInto(std::string_view message, char* output, size_t outputSize) const override final;
+    bool lengthPreserving() const override final { return true; }
+    size_t encodedUnitSize() const override final { return 1; }
+    bool encodeInPlace(char* data, size_t size) const override final;
+    bool decodeInPlace(char* data, size_t size) const override final;
+    bool byteMap(ByteMap& table) const override final;
 };
 
 #endif // ROT3ENCODEREXECUTOR_H
\ No newline at end of file
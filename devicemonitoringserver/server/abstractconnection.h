@@ -26,6 +26,10 @@ public:
      * \brief Соединение активно.
      */
     virtual bool connected() const = 0;
+    /*!
+     * \brief Сообщения доставляются без потерь и в порядке отправки.
+     */
+    virtual bool reliable() const { return true; }
     /*!
      * \brief Отправить сообщение.
      * \param message - сообщение
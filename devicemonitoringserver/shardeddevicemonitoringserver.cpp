@@ -0,0 +1,217 @@
+#include "shardeddevicemonitoringserver.h"
+#include "devicemonitoringserver.h"
+#include <handlers/abstractaction.h>
+#include <tcp/eventloop.h>
+#include <tcp/iouringconnectionserver.h>
+
+#include <algorithm>
+#include <future>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+
+namespace
+{
+
+/*!
+ * \brief Действие, выполняющее задачу, которой владеет ожидающий ее поток
+ */
+template <class Task>
+struct TaskAction final : public AbstractAction
+{
+    TaskAction(Task& task) :
+        m_task(task) {}
+
+    void operator()() final
+    {
+        m_task();
+    }
+
+private:
+    Task& m_task;
+};
+
+/*!
+ * \brief Выполнить \a function в потоке цикла \a eventLoop и дождаться результата
+ *
+ * Нельзя вызывать из потока самого цикла.
+ */
+template <class Function>
+auto runInLoop(EventLoop& eventLoop, Function function) -> decltype(function())
+{
+    std::packaged_task<decltype(function())()> task(std::move(function));
+    auto result = task.get_future();
+    eventLoop.invoke(new TaskAction<decltype(task)>(task));
+    return result.get();
+}
+
+/*!
+ * \brief Процессоры, на которых процессу разрешено выполняться
+ */
+std::vector<int> availableCpus()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+} // namespace
+
+struct ShardedDeviceMonitoringServer::Shard
+{
+    EventLoop eventLoop;
+    DeviceMonitoringServer* server = nullptr; ///< Создается и удаляется в потоке шарда
+    std::thread thread;
+};
+
+ShardedDeviceMonitoringServer::ShardedDeviceMonitoringServer(size_t shardCount, std::string host)
+{
+    const auto cpus = availableCpus();
+    if (!shardCount)
+        shardCount = std::max<size_t>(1, cpus.size());
+    for (size_t index = 0; index < shardCount; ++index)
+    {
+        auto* shard = new Shard;
+        m_shards.push_back(shard);
+        const int cpu = cpus.empty() ? -1 : cpus[index % cpus.size()];
+        shard->thread = std::thread([shard, cpu] {
+            if (cpu >= 0)
+            {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            }
+            shard->eventLoop.run();
+        });
+        // Кольцо io_uring с SINGLE_ISSUER обслуживает только создавший его поток
+        runInLoop(shard->eventLoop, [this, shard, index, &host] {
+            shard->server = new DeviceMonitoringServer(createTcpConnectionServer(shard->eventLoop, host, true));
+            shard->server->setDeviceDirectory(&m_directory, index);
+        });
+    }
+}
+
+ShardedDeviceMonitoringServer::~ShardedDeviceMonitoringServer()
+{
+    for (auto* shard : m_shards)
+    {
+        runInLoop(shard->eventLoop, [shard] {
+            delete shard->server;
+            shard->server = nullptr;
+        });
+        shard->eventLoop.quit();
+        shard->thread.join();
+        delete shard;
+    }
+}
+
+template <class Function>
+void ShardedDeviceMonitoringServer::forEachShard(Function function)
+{
+    for (auto* shard : m_shards)
+        runInLoop(shard->eventLoop, [&function, shard] { function(*shard->server); });
+}
+
+template <class Result, class DetachedFunction, class AttachedFunction>
+Result ShardedDeviceMonitoringServer::atDevice(uint64_t deviceId, DetachedFunction detached, AttachedFunction attached)
+{
+    for (;;)
+    {
+        Result result {};
+        const size_t index = m_directory.accessDetached(deviceId, [&](CommandCenter& commandCenter) { result = detached(commandCenter); });
+        if (index == DeviceDirectory::noShard)
+            return result;
+        // Пока запрос ждал в очереди шарда, устройство могло отключиться: тогда повторяем
+        Shard* shard = m_shards[index];
+        const bool done = runInLoop(shard->eventLoop, [&] {
+            if (m_directory.shardOf(deviceId) != index)
+                return false;
+            result = attached(*shard->server);
+            return true;
+        });
+        if (done)
+            return result;
+    }
+}
+
+void ShardedDeviceMonitoringServer::setDeviceWorkSchedule(const DeviceWorkSchedule& schedule)
+{
+    atDevice<bool>(
+        schedule.deviceId,
+        [&](CommandCenter& commandCenter) {
+            commandCenter.setSchedule(schedule);
+            return true;
+        },
+        [&](DeviceMonitoringServer& server) {
+            server.setDeviceWorkSchedule(schedule);
+            return true;
+        });
+}
+
+void ShardedDeviceMonitoringServer::setMultiChannelDeviceWorkSchedule(const MultiChannelDeviceWorkSchedule& schedule)
+{
+    atDevice<bool>(
+        schedule.deviceId,
+        [&](CommandCenter& commandCenter) {
+            commandCenter.setMultiChannelSchedule(schedule);
+            return true;
+        },
+        [&](DeviceMonitoringServer& server) {
+            server.setMultiChannelDeviceWorkSchedule(schedule);
+            return true;
+        });
+}
+
+bool ShardedDeviceMonitoringServer::listen(uint64_t serverId)
+{
+    // Порт занят - первый шард не начнет прием, и остальные не пытаются
+    for (auto* shard : m_shards)
+    {
+        if (!runInLoop(shard->eventLoop, [shard, serverId] { return shard->server->listen(serverId); }))
+            return false;
+    }
+    return true;
+}
+
+std::vector<DeviationStats> ShardedDeviceMonitoringServer::deviationStats(uint64_t deviceId)
+{
+    return atDevice<std::vector<DeviationStats>>(
+        deviceId,
+        [deviceId](CommandCenter& commandCenter) { return commandCenter.deviationStats(deviceId); },
+        [deviceId](DeviceMonitoringServer& server) { return server.deviationStats(deviceId); });
+}
+
+std::vector<MultiChannelDeviationStats> ShardedDeviceMonitoringServer::multiChannelDeviationStats(uint64_t deviceId)
+{
+    return atDevice<std::vector<MultiChannelDeviationStats>>(
+        deviceId,
+        [deviceId](CommandCenter& commandCenter) { return commandCenter.multiChannelDeviationStats(deviceId); },
+        [deviceId](DeviceMonitoringServer& server) { return server.multiChannelDeviationStats(deviceId); });
+}
+
+bool ShardedDeviceMonitoringServer::selectExecutor(const std::string& name)
+{
+    bool selected = true;
+    forEachShard([&](DeviceMonitoringServer& server) { selected = server.messageEncoder().selectExecutor(name) && selected; });
+    return selected;
+}
+
+void ShardedDeviceMonitoringServer::setMaxBatchSize(size_t maxBatchSize)
+{
+    forEachShard([maxBatchSize](DeviceMonitoringServer& server) { server.setMaxBatchSize(maxBatchSize); });
+}
+
+void ShardedDeviceMonitoringServer::setEncryptionKey(uint64_t deviceId, const Aes128CtrEncoderExecutor::Key& key)
+{
+    forEachShard([&](DeviceMonitoringServer& server) { server.setEncryptionKey(deviceId, key); });
+}
@@ -0,0 +1,104 @@
+#ifndef SHARDEDDEVICEMONITORINGSERVER_H
+#define SHARDEDDEVICEMONITORINGSERVER_H
+
+#include "aes128ctrencoderexecutor.h"
+#include "commandcenter.h"
+#include "common.h"
+#include "devicedirectory.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct DeviceWorkSchedule;
+struct MultiChannelDeviceWorkSchedule;
+
+/*!
+ * \brief Сервер мониторинга устройств в режиме "поток на ядро".
+ *
+ * Каждый шард - отдельный поток, закрепленный за процессором, со своим EventLoop, TCP-сервером
+ * (createTcpConnectionServer()) и DeviceMonitoringServer: своими соединениями, буферами
+ * шифрования и командным центром. Серверы шардов слушают один порт (SO_REUSEPORT), и ядро само
+ * распределяет между ними подключения. Сообщения устройства обрабатываются только шардом,
+ * принявшим его соединение, без общих изменяемых данных; информация об устройстве переходит
+ * между шардами через DeviceDirectory при подключении.
+ *
+ * Методы вызываются из потока-владельца (не из потоков шардов); запросы по устройству
+ * выполняются в потоке шарда, к которому оно подключено, с ожиданием результата.
+ */
+class ShardedDeviceMonitoringServer
+{
+    NON_COPYABLE(ShardedDeviceMonitoringServer)
+public:
+    /*!
+     * \brief Конструктор.
+     * \param shardCount - количество шардов; 0 - по количеству доступных процессу процессоров
+     * \param host - IPv4-адрес для приема подключений
+     */
+    explicit ShardedDeviceMonitoringServer(size_t shardCount = 0, std::string host = "127.0.0.1");
+    ~ShardedDeviceMonitoringServer();
+
+    /*!
+     * \brief Количество шардов.
+     */
+    size_t shardCount() const { return m_shards.size(); }
+    /*!
+     * \brief Шард, к которому подключено устройство \a deviceId, или DeviceDirectory::noShard
+     */
+    size_t deviceShard(uint64_t deviceId) const { return m_directory.shardOf(deviceId); }
+    /*!
+     * \brief Установить план работы устройств.
+     */
+    void setDeviceWorkSchedule(const DeviceWorkSchedule& schedule);
+    /*!
+     * \brief Установить план работы устройств с несколькими каналами.
+     */
+    void setMultiChannelDeviceWorkSchedule(const MultiChannelDeviceWorkSchedule& schedule);
+    /*!
+     * \brief Начать прием подключений всеми шардами на TCP-порту \a serverId
+     */
+    bool listen(uint64_t serverId);
+    /*!
+     * \brief Статистика СКО физических параметров от плана для устройства с идентификатором \a deviceId
+     */
+    std::vector<DeviationStats> deviationStats(uint64_t deviceId);
+    /*!
+     * \brief Статистика СКО физических параметров от плана по каналам для устройства с идентификатором \a deviceId
+     */
+    std::vector<MultiChannelDeviationStats> multiChannelDeviationStats(uint64_t deviceId);
+    /*!
+     * \brief Выбрать алгоритм шифрования по умолчанию во всех шардах (см. MessageEncoder::selectExecutor()).
+     */
+    bool selectExecutor(const std::string& name);
+    /*!
+     * \brief Установить максимальный размер пакета во всех шардах (см. DeviceMonitoringServer::setMaxBatchSize()).
+     */
+    void setMaxBatchSize(size_t maxBatchSize);
+    /*!
+     * \brief Установить ключ шифрования AES-128-CTR для соединений с устройством \a deviceId во всех шардах.
+     */
+    void setEncryptionKey(uint64_t deviceId, const Aes128CtrEncoderExecutor::Key& key);
+
+private:
+    struct Shard;
+
+    /*!
+     * \brief Выполнить \a function(DeviceMonitoringServer&) в потоке каждого шарда и дождаться завершения
+     */
+    template <class Function>
+    void forEachShard(Function function);
+    /*!
+     * \brief Выполнить запрос там, где находится информация об устройстве \a deviceId
+     * \param detached - функтор Result(CommandCenter&) для неподключенного устройства
+     * \param attached - функтор Result(DeviceMonitoringServer&), выполняется в потоке шарда устройства
+     */
+    template <class Result, class DetachedFunction, class AttachedFunction>
+    Result atDevice(uint64_t deviceId, DetachedFunction detached, AttachedFunction attached);
+
+private:
+    DeviceDirectory m_directory;
+    std::vector<Shard*> m_shards;
+};
+
+#endif // SHARDEDDEVICEMONITORINGSERVER_H
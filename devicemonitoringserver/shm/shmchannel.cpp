@@ -0,0 +1,204 @@
+#include "shmchannel.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractmessagehandler.h>
+
+#include <cstdint>
+#include <cstring>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace
+{
+
+struct DisconnectedAction final : public AbstractAction
+{
+    DisconnectedAction(ShmChannel* channel) :
+        m_channel(channel) {}
+
+    void operator()() final
+    {
+        auto* channel = dynamic_cast<ShmChannel*>(m_channel.data());
+        if (channel)
+            channel->onDisconnected();
+    }
+
+private:
+    SafeObjectPointer m_channel;
+};
+
+ShmSegment::Direction inputDirection(bool serverSide)
+{
+    return serverSide ? ShmSegment::Direction::ClientToServer : ShmSegment::Direction::ServerToClient;
+}
+
+ShmSegment::Direction outputDirection(bool serverSide)
+{
+    return inputDirection(!serverSide);
+}
+
+} // namespace
+
+ShmChannel::ShmChannel(EventLoop& eventLoop, int socketFd, ShmSegment* segment, bool serverSide, int eventFd, int peerEventFd) :
+    m_eventLoop(eventLoop),
+    m_socketFd(socketFd),
+    m_eventFd(eventFd),
+    m_peerEventFd(peerEventFd),
+    m_segment(segment),
+    m_input(segment->ringHeader(inputDirection(serverSide)), segment->ringData(inputDirection(serverSide)), segment->capacity()),
+    m_output(segment->ringHeader(outputDirection(serverSide)), segment->ringData(outputDirection(serverSide)), segment->capacity()),
+    m_socketHandler(this)
+{
+    if (!m_eventLoop.add(m_eventFd, EPOLLIN, this) || !m_eventLoop.add(m_socketFd, EPOLLRDHUP | EPOLLET, &m_socketHandler))
+        close();
+    else
+        wakeUp(m_eventFd); // Другая сторона могла записать сообщения до создания канала: разбираем их на ближайшей итерации
+}
+
+ShmChannel::~ShmChannel()
+{
+    if (m_connected)
+        closeDescriptors();
+    delete m_segment;
+}
+
+void ShmChannel::sendMessage(std::string_view message)
+{
+    if (!connected() || message.size() > maxMessageSize())
+        return;
+    if (m_writeBegin == m_writeBuffer.size() && m_output.write(message))
+    {
+        if (m_output.takeReaderWaiting())
+            wakeUp(m_peerEventFd);
+        return;
+    }
+    // Кольцо заполнено: сообщение ждет, пока другая сторона освободит место
+    const uint32_t size = static_cast<uint32_t>(message.size());
+    m_writeBuffer.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    m_writeBuffer.append(message.data(), message.size());
+    flush();
+}
+
+void ShmChannel::disconnect()
+{
+    // Данные, для которых нет места в кольце, теряются
+    if (connected())
+        flush();
+    close();
+}
+
+void ShmChannel::onDisconnected()
+{
+    // Обработчик может удалить канал
+    if (m_disconnectedHandler)
+        (*m_disconnectedHandler)();
+}
+
+void ShmChannel::operator()(uint32_t /*events*/)
+{
+    uint64_t value = 0;
+    const ssize_t size = ::read(m_eventFd, &value, sizeof(value));
+    UNUSED(size);
+    flush();
+    readAvailable(maxReadBatch());
+}
+
+void ShmChannel::onSocketEvent(uint32_t events)
+{
+    if (!(events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) || !connected())
+        return;
+    // Сообщения, записанные другой стороной до закрытия, доставляются
+    readAvailable(SIZE_MAX);
+    close();
+}
+
+void ShmChannel::readAvailable(size_t maxMessages)
+{
+    for (size_t count = 0; connected();)
+    {
+        if (count == maxMessages)
+        {
+            // Остальное - на следующей итерации цикла, после событий других дескрипторов
+            m_input.releaseRead();
+            if (m_input.takeWriterWaiting())
+                wakeUp(m_peerEventFd);
+            wakeUp(m_eventFd);
+            return;
+        }
+        switch (m_input.read(m_message))
+        {
+        case ShmRing::ReadStatus::Message:
+            ++count;
+            if (m_messageHandler)
+                (*m_messageHandler)(m_message);
+            break;
+        case ShmRing::ReadStatus::Corrupted:
+            return close();
+        case ShmRing::ReadStatus::Empty:
+            m_input.releaseRead();
+            if (m_input.takeWriterWaiting())
+                wakeUp(m_peerEventFd);
+            // Пока выставляли флаг ожидания, могли прийти новые сообщения
+            if (m_input.waitForData())
+                return;
+            break;
+        }
+    }
+}
+
+void ShmChannel::flush()
+{
+    bool written = false;
+    while (connected() && m_writeBegin < m_writeBuffer.size())
+    {
+        uint32_t size = 0;
+        std::memcpy(&size, &m_writeBuffer[m_writeBegin], sizeof(size));
+        const std::string_view message(&m_writeBuffer[m_writeBegin + sizeof(size)], size);
+        if (m_output.write(message))
+        {
+            m_writeBegin += sizeof(size) + size;
+            written = true;
+        }
+        else if (m_output.waitForSpace(size))
+            break;
+    }
+    if (m_writeBegin == m_writeBuffer.size())
+    {
+        m_writeBuffer.clear();
+        m_writeBegin = 0;
+    }
+    if (written && m_output.takeReaderWaiting())
+        wakeUp(m_peerEventFd);
+}
+
+void ShmChannel::wakeUp(int fd)
+{
+    const uint64_t value = 1;
+    const ssize_t size = ::write(fd, &value, sizeof(value));
+    UNUSED(size);
+}
+
+void ShmChannel::close()
+{
+    if (!m_connected)
+        return;
+    m_connected = false;
+    closeDescriptors();
+    m_eventLoop.post(new DisconnectedAction(this));
+}
+
+void ShmChannel::closeDescriptors()
+{
+    m_eventLoop.remove(m_eventFd);
+    m_eventLoop.remove(m_socketFd);
+    // Другая сторона получит разрыв по сокету
+    for (int* fd : { &m_socketFd, &m_eventFd, &m_peerEventFd })
+    {
+        ::close(*fd);
+        *fd = -1;
+    }
+}
+
+void ShmChannel::SocketHandler::operator()(uint32_t events)
+{
+    m_channel->onSocketEvent(events);
+}
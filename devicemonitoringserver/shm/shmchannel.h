@@ -0,0 +1,132 @@
+#ifndef SHMCHANNEL_H
+#define SHMCHANNEL_H
+
+#include "shmring.h"
+#include "shmsegment.h"
+#include <servermock/object.h>
+#include <tcp/eventloop.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class AbstractMessageHandler;
+class AbstractAction;
+
+/*!
+ * \brief Канал передачи сообщений между процессами одного узла через разделяемую память.
+ *
+ * Сообщения пишутся в кольцо ShmRing своего направления без системных вызовов. Другую сторону
+ * будит eventfd, только если она, разобрав свое кольцо, выставила флаг ожидания; пока стороны
+ * заняты, сообщения идут без пробуждений. За один вызов обработчика разбирается не больше
+ * maxReadBatch() сообщений, чтобы поток сообщений не задерживал другие соединения цикла.
+ * Сообщение, не поместившееся в кольцо, ждет места в буфере отправки.
+ *
+ * Разрыв соединения определяется по UNIX-сокету, через который стороны обменялись сегментом:
+ * перед закрытием канал разбирает оставшиеся в кольце сообщения. Обработчик разрыва вызывается
+ * отложенно через EventLoop, как в TcpChannel.
+ */
+class ShmChannel final : public Object, private AbstractEventHandler
+{
+    NON_COPYABLE(ShmChannel)
+
+    struct SocketHandler final : public AbstractEventHandler
+    {
+        SocketHandler(ShmChannel* channel) :
+            m_channel(channel) {}
+        void operator()(uint32_t events) final;
+
+    private:
+        ShmChannel* m_channel = nullptr;
+    };
+
+public:
+    /*!
+     * \brief Наибольшее количество сообщений, разбираемых за одно событие
+     */
+    static constexpr size_t maxReadBatch() { return 1024; }
+
+    /*!
+     * \brief Конструктор.
+     * \param socketFd - UNIX-сокет соединения; закрывается каналом
+     * \param segment - владеющий указатель на сегмент
+     * \param serverSide - канал сервера (читает кольцо от клиента)
+     * \param eventFd - eventfd, которым другая сторона будит канал; закрывается каналом
+     * \param peerEventFd - eventfd, которым канал будит другую сторону; закрывается каналом
+     */
+    ShmChannel(EventLoop& eventLoop, int socketFd, ShmSegment* segment, bool serverSide, int eventFd, int peerEventFd);
+    ~ShmChannel() final;
+
+    /*!
+     * \brief Наибольший размер сообщения.
+     */
+    size_t maxMessageSize() const { return m_output.maxMessageSize(); }
+    /*!
+     * \brief Канал активен.
+     */
+    bool connected() const { return m_connected; }
+    /*!
+     * \brief Отправить сообщение.
+     */
+    void sendMessage(std::string_view message);
+    /*!
+     * \brief Отправить оставшиеся данные, если для них есть место, и закрыть соединение.
+     */
+    void disconnect();
+    /*!
+     * \brief Установить обработчик события получения сообщения.
+     * \param handler - невладеющий указатель на обработчик
+     */
+    void setMessageHandler(AbstractMessageHandler* handler) { m_messageHandler = handler; }
+    /*!
+     * \brief Установить обработчик события разрыва соединения.
+     * \param handler - невладеющий указатель на обработчик
+     */
+    void setDisconnectedHandler(AbstractAction* handler) { m_disconnectedHandler = handler; }
+    /*!
+     * \brief Сообщить о разрыве соединения.
+     */
+    void onDisconnected();
+
+private:
+    void operator()(uint32_t events) final;
+    void onSocketEvent(uint32_t events);
+    /*!
+     * \brief Передать обработчику не больше \a maxMessages сообщений из кольца.
+     */
+    void readAvailable(size_t maxMessages);
+    /*!
+     * \brief Переписать в кольцо сообщения из буфера отправки, для которых появилось место.
+     */
+    void flush();
+    /*!
+     * \brief Разбудить другую сторону через eventfd.
+     */
+    void wakeUp(int fd);
+    /*!
+     * \brief Закрыть сокет и eventfd и запланировать вызов обработчика разрыва соединения.
+     */
+    void close();
+    /*!
+     * \brief Прекратить слежение за дескрипторами и закрыть их.
+     */
+    void closeDescriptors();
+
+private:
+    EventLoop& m_eventLoop;
+    int m_socketFd = -1;
+    int m_eventFd = -1;
+    int m_peerEventFd = -1;
+    ShmSegment* m_segment = nullptr; ///< Отображение остается до удаления канала
+    ShmRing m_input;
+    ShmRing m_output;
+    bool m_connected = true;
+    SocketHandler m_socketHandler;
+    std::string m_writeBuffer; ///< Кадры, не поместившиеся в кольцо: начиная с m_writeBegin
+    size_t m_writeBegin = 0;
+    std::string m_message;     ///< Буфер сообщения, передаваемого обработчику
+    AbstractMessageHandler* m_messageHandler = nullptr;
+    AbstractAction* m_disconnectedHandler = nullptr;
+};
+
+#endif // SHMCHANNEL_H
@@ -0,0 +1,158 @@
+#include "shmclientconnection.h"
+#include "shmchannel.h"
+#include <handlers/abstractmessagehandler.h>
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+
+struct ConnectedAction final : public AbstractAction
+{
+    ConnectedAction(ShmClientConnection* client, ShmChannel* channel) :
+        m_client(client), m_channel(channel) {}
+
+    void operator()() final
+    {
+        // Канал удаляется вместе с клиентом и при разрыве соединения
+        if (m_channel)
+            m_client->onConnected();
+    }
+
+private:
+    ShmClientConnection* m_client = nullptr;
+    SafeObjectPointer m_channel;
+};
+
+} // namespace
+
+ShmClientConnection::ShmClientConnection(EventLoop& eventLoop, size_t capacity) :
+    m_eventLoop(eventLoop), m_capacity(capacity), m_channelDisconnectedHandler(this)
+{
+}
+
+ShmClientConnection::~ShmClientConnection()
+{
+    delete m_channel;
+    delete m_messageHandler;
+    delete m_connectedHandler;
+    delete m_disconnectedHandler;
+}
+
+bool ShmClientConnection::bind(uint64_t clientId)
+{
+    if (!clientId || clientId == m_clientId || m_channel)
+        return false;
+    m_clientId = clientId;
+    return true;
+}
+
+bool ShmClientConnection::connectToHost(uint64_t serverId)
+{
+    if (!m_clientId || !serverId || m_channel)
+        return false;
+    sockaddr_un address {};
+    const size_t addressSize = shmServerAddress(serverId, address);
+    const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), static_cast<socklen_t>(addressSize)) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    ShmSegment* segment = ShmSegment::create(m_capacity);
+    const int serverEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    const int clientEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (!segment || serverEventFd < 0 || clientEventFd < 0
+        || !sendShmHandshake(fd, m_clientId, { segment->fd(), serverEventFd, clientEventFd }))
+    {
+        delete segment;
+        for (int eventFd : { serverEventFd, clientEventFd })
+        {
+            if (eventFd >= 0)
+                ::close(eventFd);
+        }
+        ::close(fd);
+        return false;
+    }
+    // У сервера свои копии дескрипторов
+    segment->closeFd();
+    m_serverId = serverId;
+    m_wasConnected = false;
+    m_channel = new ShmChannel(m_eventLoop, fd, segment, false, clientEventFd, serverEventFd);
+    m_channel->setMessageHandler(m_messageHandler);
+    m_channel->setDisconnectedHandler(&m_channelDisconnectedHandler);
+    m_eventLoop.post(new ConnectedAction(this, m_channel));
+    return true;
+}
+
+void ShmClientConnection::setConnectedHandler(AbstractAction* handler)
+{
+    delete m_connectedHandler;
+    m_connectedHandler = handler;
+}
+
+uint64_t ShmClientConnection::peerId() const
+{
+    return connected() ? m_serverId : 0;
+}
+
+bool ShmClientConnection::connected() const
+{
+    return m_wasConnected && m_channel && m_channel->connected();
+}
+
+void ShmClientConnection::disconnect()
+{
+    if (m_channel)
+        m_channel->disconnect();
+}
+
+void ShmClientConnection::sendMessage(const std::string& message)
+{
+    if (m_channel)
+        m_channel->sendMessage(message);
+}
+
+void ShmClientConnection::setMessageHandler(AbstractMessageHandler* handler)
+{
+    delete m_messageHandler;
+    m_messageHandler = handler;
+    if (m_channel)
+        m_channel->setMessageHandler(m_messageHandler);
+}
+
+void ShmClientConnection::setDisconnectedHandler(AbstractAction* handler)
+{
+    delete m_disconnectedHandler;
+    m_disconnectedHandler = handler;
+}
+
+void ShmClientConnection::onConnected()
+{
+    if (!m_channel || !m_channel->connected())
+        return;
+    m_wasConnected = true;
+    if (m_connectedHandler)
+        (*m_connectedHandler)();
+}
+
+void ShmClientConnection::onDisconnected()
+{
+    // Канал удаляется до вызова обработчика, чтобы из него можно было подключиться снова
+    const bool wasConnected = m_wasConnected;
+    delete m_channel;
+    m_channel = nullptr;
+    m_wasConnected = false;
+    if (wasConnected && m_disconnectedHandler)
+        (*m_disconnectedHandler)();
+}
+
+void ShmClientConnection::DisconnectedHandler::operator()()
+{
+    m_client->onDisconnected();
+}
@@ -0,0 +1,77 @@
+#ifndef SHMCLIENTCONNECTION_H
+#define SHMCLIENTCONNECTION_H
+
+#include "../common.h"
+#include "shmsegment.h"
+#include <handlers/abstractaction.h>
+#include <server/abstractclientconnection.h>
+
+class EventLoop;
+class ShmChannel;
+
+/*!
+ * \brief Клиент для подключения к ShmConnectionServer процесса того же узла.
+ *
+ * connectToHost() создает сегмент с кольцами и передает его серверу вместе со своим
+ * идентификатором; обработчик установки соединения вызывается отложенно через EventLoop.
+ * Если сервер не слушает, connectToHost() сразу возвращает false. Если сервер отклонил
+ * подключение, вызывается обработчик разрыва соединения.
+ */
+class ShmClientConnection final : public AbstractClientConnection
+{
+    NON_COPYABLE(ShmClientConnection)
+
+    struct DisconnectedHandler final : public AbstractAction
+    {
+        DisconnectedHandler(ShmClientConnection* client) :
+            m_client(client) {}
+        void operator()() final;
+
+    private:
+        ShmClientConnection* m_client = nullptr;
+    };
+
+public:
+    /*!
+     * \brief Конструктор.
+     * \param capacity - емкость кольца каждого направления, степень двойки
+     */
+    explicit ShmClientConnection(EventLoop& eventLoop, size_t capacity = ShmSegment::defaultCapacity());
+    ~ShmClientConnection() final;
+
+    /*!
+     * \brief Вызвать обработчик установки соединения.
+     */
+    void onConnected();
+
+    // AbstractClientConnection interface
+    uint64_t bindedId() const final { return m_clientId; }
+    bool bind(uint64_t clientId) final;
+    bool connectToHost(uint64_t serverId) final;
+    void setConnectedHandler(AbstractAction* handler) final;
+
+    // AbstractConnection interface
+    uint64_t peerId() const final;
+    bool connected() const final;
+    void disconnect() final;
+    void sendMessage(const std::string& message) final;
+    void setMessageHandler(AbstractMessageHandler* handler) final;
+    void setDisconnectedHandler(AbstractAction* handler) final;
+
+private:
+    void onDisconnected();
+
+private:
+    EventLoop& m_eventLoop;
+    size_t m_capacity = 0;
+    uint64_t m_clientId = 0;
+    uint64_t m_serverId = 0;
+    ShmChannel* m_channel = nullptr;
+    bool m_wasConnected = false; ///< Обработчик установки соединения вызван
+    DisconnectedHandler m_channelDisconnectedHandler;
+    AbstractMessageHandler* m_messageHandler = nullptr;
+    AbstractAction* m_connectedHandler = nullptr;
+    AbstractAction* m_disconnectedHandler = nullptr;
+};
+
+#endif // SHMCLIENTCONNECTION_H
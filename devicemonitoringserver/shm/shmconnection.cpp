@@ -0,0 +1,59 @@
+#include "shmconnection.h"
+#include "shmconnectionserver.h"
+#include <handlers/abstractmessagehandler.h>
+
+ShmConnection::ShmConnection(ShmConnectionServer* server, EventLoop& eventLoop, uint64_t clientId, int socketFd,
+                             ShmSegment* segment, int eventFd, int peerEventFd) :
+    m_server(server),
+    m_peerId(clientId),
+    m_channelDisconnectedHandler(this),
+    m_channel(eventLoop, socketFd, segment, true, eventFd, peerEventFd)
+{
+    m_channel.setDisconnectedHandler(&m_channelDisconnectedHandler);
+}
+
+ShmConnection::~ShmConnection()
+{
+    delete m_messageHandler;
+    delete m_disconnectedHandler;
+}
+
+bool ShmConnection::connected() const
+{
+    return m_channel.connected();
+}
+
+void ShmConnection::disconnect()
+{
+    m_channel.disconnect();
+}
+
+void ShmConnection::sendMessage(const std::string& message)
+{
+    m_channel.sendMessage(message);
+}
+
+void ShmConnection::setMessageHandler(AbstractMessageHandler* handler)
+{
+    delete m_messageHandler;
+    m_messageHandler = handler;
+    m_channel.setMessageHandler(m_messageHandler);
+}
+
+void ShmConnection::setDisconnectedHandler(AbstractAction* handler)
+{
+    delete m_disconnectedHandler;
+    m_disconnectedHandler = handler;
+}
+
+void ShmConnection::onDisconnected()
+{
+    if (m_disconnectedHandler)
+        (*m_disconnectedHandler)();
+    m_server->onDisconnected(this); // Удаляет соединение
+}
+
+void ShmConnection::DisconnectedHandler::operator()()
+{
+    m_conn->onDisconnected();
+}
@@ -0,0 +1,59 @@
+#ifndef SHMCONNECTION_H
+#define SHMCONNECTION_H
+
+#include "../common.h"
+#include "shmchannel.h"
+#include <handlers/abstractaction.h>
+#include <server/abstractconnection.h>
+
+class EventLoop;
+class ShmConnectionServer;
+
+/*!
+ * \brief Принятое ShmConnectionServer соединение с клиентом.
+ */
+class ShmConnection final : public AbstractConnection
+{
+    NON_COPYABLE(ShmConnection)
+
+    struct DisconnectedHandler final : public AbstractAction
+    {
+        DisconnectedHandler(ShmConnection* conn) :
+            m_conn(conn) {}
+        void operator()() final;
+
+    private:
+        ShmConnection* m_conn = nullptr;
+    };
+
+public:
+    /*!
+     * \brief Конструктор.
+     * \param clientId - идентификатор клиента из первого сообщения
+     * \param segment, eventFd, peerEventFd, socketFd - см. ShmChannel
+     */
+    ShmConnection(ShmConnectionServer* server, EventLoop& eventLoop, uint64_t clientId, int socketFd, ShmSegment* segment,
+                  int eventFd, int peerEventFd);
+    ~ShmConnection() final;
+
+    // AbstractConnection interface
+    uint64_t peerId() const final { return m_peerId; }
+    bool connected() const final;
+    void disconnect() final;
+    void sendMessage(const std::string& message) final;
+    void setMessageHandler(AbstractMessageHandler* handler) final;
+    void setDisconnectedHandler(AbstractAction* handler) final;
+
+private:
+    void onDisconnected();
+
+private:
+    ShmConnectionServer* m_server = nullptr;
+    uint64_t m_peerId = 0;
+    DisconnectedHandler m_channelDisconnectedHandler;
+    ShmChannel m_channel;
+    AbstractMessageHandler* m_messageHandler = nullptr;
+    AbstractAction* m_disconnectedHandler = nullptr;
+};
+
+#endif // SHMCONNECTION_H
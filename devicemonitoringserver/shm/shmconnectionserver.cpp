@@ -0,0 +1,163 @@
+#include "shmconnectionserver.h"
+#include "shmconnection.h"
+#include "shmsegment.h"
+#include <handlers/abstractnewconnectionhandler.h>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+ShmConnectionServer::ShmConnectionServer(EventLoop& eventLoop) :
+    m_eventLoop(eventLoop), m_acceptHandler(this)
+{
+}
+
+ShmConnectionServer::~ShmConnectionServer()
+{
+    delete m_newConnectionHandler;
+    for (auto it = m_connections.cbegin(); it != m_connections.cend(); ++it)
+        delete it->second;
+    while (!m_handshakes.empty())
+    {
+        const int fd = m_handshakes.begin()->first;
+        removeHandshake(fd);
+        ::close(fd);
+    }
+    if (m_listenFd >= 0)
+    {
+        m_eventLoop.remove(m_listenFd);
+        ::close(m_listenFd);
+    }
+}
+
+bool ShmConnectionServer::listen(uint64_t serverId)
+{
+    if (m_listenFd >= 0 || !serverId)
+        return false;
+    sockaddr_un address {};
+    const size_t addressSize = shmServerAddress(serverId, address);
+    const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), static_cast<socklen_t>(addressSize)) != 0
+        || ::listen(fd, SOMAXCONN) != 0 || !m_eventLoop.add(fd, EPOLLIN | EPOLLET, &m_acceptHandler))
+    {
+        ::close(fd);
+        return false;
+    }
+    m_listenFd = fd;
+    m_serverId = serverId;
+    return true;
+}
+
+void ShmConnectionServer::disconnect()
+{
+    for (const auto& conn : m_connections)
+        conn.second->disconnect();
+    while (!m_handshakes.empty())
+    {
+        const int fd = m_handshakes.begin()->first;
+        removeHandshake(fd);
+        ::close(fd);
+    }
+    if (m_listenFd >= 0)
+    {
+        m_eventLoop.remove(m_listenFd);
+        ::close(m_listenFd);
+        m_listenFd = -1;
+    }
+    m_serverId = 0;
+}
+
+void ShmConnectionServer::setNewConnectionHandler(AbstractNewConnectionHandler* handler)
+{
+    delete m_newConnectionHandler;
+    m_newConnectionHandler = handler;
+}
+
+AbstractConnection* ShmConnectionServer::connection(uint64_t clientId) const
+{
+    const auto it = m_connections.find(clientId);
+    return it != m_connections.cend() ? it->second : nullptr;
+}
+
+void ShmConnectionServer::onDisconnected(ShmConnection* connection)
+{
+    const auto it = m_connections.find(connection->peerId());
+    if (it != m_connections.end() && it->second == connection)
+        m_connections.erase(it);
+    delete connection;
+}
+
+void ShmConnectionServer::acceptConnections()
+{
+    while (m_listenFd >= 0)
+    {
+        const int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return; // EAGAIN или нехватка ресурсов: остальные подключения ждут следующего события
+        }
+        auto* handler = new HandshakeHandler(this, fd);
+        if (!m_eventLoop.add(fd, EPOLLIN | EPOLLRDHUP, handler))
+        {
+            delete handler;
+            ::close(fd);
+            continue;
+        }
+        m_handshakes.insert({ fd, handler });
+    }
+}
+
+void ShmConnectionServer::onHandshake(int fd)
+{
+    removeHandshake(fd);
+    uint64_t clientId = 0;
+    int fds[3] = { -1, -1, -1 };
+    if (!receiveShmHandshake(fd, clientId, fds))
+    {
+        ::close(fd);
+        return;
+    }
+    ShmSegment* segment = ShmSegment::attach(fds[0]);
+    // Чтение своего eventfd не должно блокировать цикл, даже если клиент передал другой дескриптор
+    const bool nonBlocking = fcntl(fds[1], F_SETFL, O_NONBLOCK) == 0 && fcntl(fds[2], F_SETFL, O_NONBLOCK) == 0;
+    if (!segment || !nonBlocking || !clientId || m_connections.count(clientId) > 0)
+    {
+        delete segment;
+        ::close(fds[1]);
+        ::close(fds[2]);
+        ::close(fd);
+        return;
+    }
+    segment->closeFd();
+    auto* connection = new ShmConnection(this, m_eventLoop, clientId, fd, segment, fds[1], fds[2]);
+    m_connections.insert({ clientId, connection });
+    if (m_newConnectionHandler)
+        (*m_newConnectionHandler)(connection);
+}
+
+void ShmConnectionServer::removeHandshake(int fd)
+{
+    const auto it = m_handshakes.find(fd);
+    if (it == m_handshakes.end())
+        return;
+    m_eventLoop.remove(fd);
+    delete it->second;
+    m_handshakes.erase(it);
+}
+
+void ShmConnectionServer::AcceptHandler::operator()(uint32_t /*events*/)
+{
+    m_server->acceptConnections();
+}
+
+void ShmConnectionServer::HandshakeHandler::operator()(uint32_t /*events*/)
+{
+    m_server->onHandshake(m_fd); // Удаляет обработчик
+}
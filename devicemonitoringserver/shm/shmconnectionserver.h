@@ -0,0 +1,85 @@
+#ifndef SHMCONNECTIONSERVER_H
+#define SHMCONNECTIONSERVER_H
+
+#include "../common.h"
+#include <server/abstractconnectionserver.h>
+#include <tcp/eventloop.h>
+
+#include <unordered_map>
+
+class ShmConnection;
+
+/*!
+ * \brief Сервер для приема подключений от процессов того же узла через разделяемую память.
+ *
+ * Подключения принимаются на UNIX-сокете в абстрактном пространстве имен (см. shmServerAddress()):
+ * клиент (ShmClientConnection) передает через него свой идентификатор, сегмент ShmSegment и два
+ * eventfd, после чего сообщения идут через кольца сегмента, а сокет служит только для определения
+ * разрыва. Подключение с недопустимым сегментом, нулевым или уже подключенным идентификатором
+ * разрывается.
+ */
+class ShmConnectionServer final : public AbstractConnectionServer
+{
+    NON_COPYABLE(ShmConnectionServer)
+
+    struct AcceptHandler final : public AbstractEventHandler
+    {
+        AcceptHandler(ShmConnectionServer* server) :
+            m_server(server) {}
+        void operator()(uint32_t events) final;
+
+    private:
+        ShmConnectionServer* m_server = nullptr;
+    };
+    /*!
+     * \brief Обработчик принятого сокета, через который клиент еще не передал сегмент
+     */
+    struct HandshakeHandler final : public AbstractEventHandler
+    {
+        HandshakeHandler(ShmConnectionServer* server, int fd) :
+            m_server(server), m_fd(fd) {}
+        void operator()(uint32_t events) final;
+
+    private:
+        ShmConnectionServer* m_server = nullptr;
+        int m_fd = -1;
+    };
+
+public:
+    explicit ShmConnectionServer(EventLoop& eventLoop);
+    ~ShmConnectionServer() final;
+
+    /*!
+     * \brief Обработчик закрытия соединения; удаляет соединение.
+     */
+    void onDisconnected(ShmConnection* connection);
+
+    // AbstractConnectionServer interface
+    uint64_t listenedId() const final { return m_serverId; }
+    bool listen(uint64_t serverId) final;
+    void disconnect() final;
+    void setNewConnectionHandler(AbstractNewConnectionHandler* handler) final;
+    AbstractConnection* connection(uint64_t clientId) const final;
+
+private:
+    void acceptConnections();
+    /*!
+     * \brief Принять сегмент клиента через сокет \a fd и создать соединение.
+     */
+    void onHandshake(int fd);
+    /*!
+     * \brief Прекратить ожидание сегмента через сокет \a fd; сокет не закрывается.
+     */
+    void removeHandshake(int fd);
+
+private:
+    EventLoop& m_eventLoop;
+    uint64_t m_serverId = 0;
+    int m_listenFd = -1;
+    AcceptHandler m_acceptHandler;
+    std::unordered_map<uint64_t, ShmConnection*> m_connections;
+    std::unordered_map<int, HandshakeHandler*> m_handshakes; ///< Сокеты, клиент которых еще не передал сегмент
+    AbstractNewConnectionHandler* m_newConnectionHandler = nullptr;
+};
+
+#endif // SHMCONNECTIONSERVER_H
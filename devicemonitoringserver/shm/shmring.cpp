@@ -0,0 +1,132 @@
+#include "shmring.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+ShmRing::ShmRing(ShmRingHeader* header, char* data, size_t capacity) :
+    m_header(header), m_data(data), m_capacity(capacity), m_mask(capacity - 1)
+{
+    // Позиции продолжаются с опубликованных: объект можно создать над уже используемым кольцом
+    m_writePosition = m_cachedTail = m_header->tail.load(std::memory_order_acquire);
+    m_readPosition = m_cachedHead = m_header->head.load(std::memory_order_acquire);
+}
+
+void ShmRing::initialize(ShmRingHeader* header)
+{
+    new (header) ShmRingHeader;
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->readerWaiting.store(0, std::memory_order_relaxed);
+    header->writerWaiting.store(0, std::memory_order_relaxed);
+}
+
+bool ShmRing::write(std::string_view message)
+{
+    const size_t frameSize = headerSize() + message.size();
+    if (freeSpace(frameSize) < frameSize)
+        return false;
+    const uint32_t size = static_cast<uint32_t>(message.size());
+    copyIn(m_writePosition, reinterpret_cast<const char*>(&size), headerSize());
+    copyIn(m_writePosition + headerSize(), message.data(), message.size());
+    m_writePosition += frameSize;
+    // seq_cst: пара к флагу ожидания читателя (см. takeReaderWaiting())
+    m_header->tail.store(m_writePosition, std::memory_order_seq_cst);
+    return true;
+}
+
+bool ShmRing::takeReaderWaiting()
+{
+    // Запись позиции и флага у обеих сторон упорядочена (seq_cst): либо читатель в waitForData()
+    // увидит новую позицию записи, либо писатель - его флаг, и пробуждение не теряется
+    if (!m_header->readerWaiting.load(std::memory_order_seq_cst))
+        return false;
+    return m_header->readerWaiting.exchange(0, std::memory_order_acq_rel) != 0;
+}
+
+bool ShmRing::waitForSpace(size_t size)
+{
+    m_header->writerWaiting.store(1, std::memory_order_seq_cst);
+    m_cachedHead = m_header->head.load(std::memory_order_seq_cst);
+    if (freeSpace(headerSize() + size) < headerSize() + size)
+        return true;
+    m_header->writerWaiting.store(0, std::memory_order_relaxed);
+    return false;
+}
+
+ShmRing::ReadStatus ShmRing::read(std::string& message)
+{
+    if (m_readPosition == m_cachedTail)
+    {
+        m_cachedTail = m_header->tail.load(std::memory_order_acquire);
+        if (m_readPosition == m_cachedTail)
+            return ReadStatus::Empty;
+    }
+    // Позиция записи приходит из чужого процесса: кадр должен целиком лежать в опубликованных данных
+    const uint64_t available = m_cachedTail - m_readPosition;
+    if (available < headerSize() || available > m_capacity)
+        return ReadStatus::Corrupted;
+    uint32_t size = 0;
+    copyOut(m_readPosition, reinterpret_cast<char*>(&size), headerSize());
+    if (size > available - headerSize())
+        return ReadStatus::Corrupted;
+    message.resize(size);
+    copyOut(m_readPosition + headerSize(), &message[0], size);
+    m_readPosition += headerSize() + size;
+    return ReadStatus::Message;
+}
+
+void ShmRing::releaseRead()
+{
+    if (m_header->head.load(std::memory_order_relaxed) != m_readPosition)
+        m_header->head.store(m_readPosition, std::memory_order_seq_cst);
+}
+
+bool ShmRing::takeWriterWaiting()
+{
+    if (!m_header->writerWaiting.load(std::memory_order_seq_cst))
+        return false;
+    return m_header->writerWaiting.exchange(0, std::memory_order_acq_rel) != 0;
+}
+
+bool ShmRing::waitForData()
+{
+    m_header->readerWaiting.store(1, std::memory_order_seq_cst);
+    m_cachedTail = m_header->tail.load(std::memory_order_seq_cst);
+    if (m_cachedTail == m_readPosition)
+        return true;
+    m_header->readerWaiting.store(0, std::memory_order_relaxed);
+    return false;
+}
+
+size_t ShmRing::freeSpace(size_t needed)
+{
+    uint64_t used = m_writePosition - m_cachedHead;
+    if (m_capacity - used < needed || used > m_capacity)
+    {
+        m_cachedHead = m_header->head.load(std::memory_order_acquire);
+        used = m_writePosition - m_cachedHead;
+    }
+    // Позиция чтения за пределами кольца - данные другой стороны испорчены: места нет
+    return used <= m_capacity ? m_capacity - used : 0;
+}
+
+void ShmRing::copyIn(uint64_t position, const char* data, size_t size)
+{
+    if (!size)
+        return;
+    const size_t offset = position & m_mask;
+    const size_t first = std::min(size, m_capacity - offset);
+    std::memcpy(m_data + offset, data, first);
+    std::memcpy(m_data, data + first, size - first);
+}
+
+void ShmRing::copyOut(uint64_t position, char* data, size_t size) const
+{
+    if (!size)
+        return;
+    const size_t offset = position & m_mask;
+    const size_t first = std::min(size, m_capacity - offset);
+    std::memcpy(data, m_data + offset, first);
+    std::memcpy(data + first, m_data, size - first);
+}
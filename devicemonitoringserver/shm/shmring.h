@@ -0,0 +1,134 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include "../common.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*!
+ * \brief Общая часть кольца в разделяемой памяти.
+ *
+ * Позиции только растут; смещение в данных - позиция по модулю емкости. Счетчики чтения и записи
+ * лежат в разных строках кэша, чтобы читатель и писатель не мешали друг другу.
+ */
+struct ShmRingHeader
+{
+    alignas(64) std::atomic<uint64_t> head;        ///< Позиция чтения; меняет читатель
+    alignas(64) std::atomic<uint64_t> tail;        ///< Позиция записи; меняет писатель
+    alignas(64) std::atomic<uint32_t> readerWaiting; ///< Читатель ждет данных и должен быть разбужен
+    std::atomic<uint32_t> writerWaiting;           ///< Писатель ждет места и должен быть разбужен
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "Атомарные переменные в разделяемой памяти должны быть без блокировок");
+
+/*!
+ * \brief Кольцо сообщений с одним писателем и одним читателем (SPSC) в разделяемой памяти.
+ *
+ * Сообщение хранится кадром: длина (uint32_t в порядке байт процессора - стороны на одном узле)
+ * и данные. Стороны не блокируют друг друга: писатель публикует позицию записи после каждого кадра,
+ * читатель - позицию чтения после пачки кадров. Будить другую сторону (eventfd) нужно, только если она
+ * перед сном выставила флаг ожидания: флаг и позиция пишутся и проверяются крест-накрест
+ * с упорядочением seq_cst, поэтому пробуждение не теряется.
+ *
+ * Объект хранит локальные для стороны копии позиций; каждая сторона создает свой объект над
+ * одной и той же общей частью и использует только свои методы.
+ */
+class ShmRing
+{
+    NON_COPYABLE(ShmRing)
+public:
+    /*!
+     * \brief Результат чтения кадра
+     */
+    enum class ReadStatus
+    {
+        Message,  ///< Сообщение прочитано
+        Empty,    ///< Кольцо пусто
+        Corrupted ///< Кадр поврежден: длина не помещается в кольцо
+    };
+
+    /*!
+     * \brief Размер заголовка кадра (длины сообщения)
+     */
+    static constexpr size_t headerSize() { return sizeof(uint32_t); }
+
+    /*!
+     * \brief Конструктор.
+     * \param header - общая часть кольца
+     * \param data - данные кольца в разделяемой памяти
+     * \param capacity - емкость данных, степень двойки
+     */
+    ShmRing(ShmRingHeader* header, char* data, size_t capacity);
+
+    /*!
+     * \brief Инициализировать общую часть нового кольца.
+     */
+    static void initialize(ShmRingHeader* header);
+
+    /*!
+     * \brief Наибольший размер сообщения, помещающегося в пустое кольцо.
+     */
+    size_t maxMessageSize() const { return m_capacity - headerSize(); }
+
+    // Методы писателя
+    /*!
+     * \brief Записать кадр с сообщением \a message и опубликовать его.
+     * \return false, если в кольце нет места для всего кадра
+     */
+    bool write(std::string_view message);
+    /*!
+     * \brief Нужно ли разбудить читателя после записи; сбрасывает его флаг ожидания.
+     */
+    bool takeReaderWaiting();
+    /*!
+     * \brief Подготовиться ждать места для кадра с сообщением размером \a size.
+     * \return false, если место уже появилось и ждать не нужно
+     */
+    bool waitForSpace(size_t size);
+
+    // Методы читателя
+    /*!
+     * \brief Прочитать следующий кадр в \a message.
+     *
+     * Освобожденное место становится доступно писателю после releaseRead().
+     */
+    ReadStatus read(std::string& message);
+    /*!
+     * \brief Опубликовать позицию чтения: вернуть писателю место прочитанных кадров.
+     */
+    void releaseRead();
+    /*!
+     * \brief Нужно ли разбудить писателя после освобождения места; сбрасывает его флаг ожидания.
+     */
+    bool takeWriterWaiting();
+    /*!
+     * \brief Подготовиться ждать данных.
+     * \return false, если данные уже появились и ждать не нужно
+     */
+    bool waitForData();
+
+private:
+    /*!
+     * \brief Свободное место с точки зрения писателя; при нехватке перечитывает позицию чтения
+     */
+    size_t freeSpace(size_t needed);
+    void copyIn(uint64_t position, const char* data, size_t size);
+    void copyOut(uint64_t position, char* data, size_t size) const;
+
+private:
+    ShmRingHeader* m_header = nullptr;
+    char* m_data = nullptr;
+    size_t m_capacity = 0;
+    size_t m_mask = 0;
+    uint64_t m_writePosition = 0; ///< Позиция записи писателя (опубликована или нет)
+    uint64_t m_cachedHead = 0;    ///< Последняя прочитанная писателем позиция чтения
+    uint64_t m_readPosition = 0;  ///< Позиция чтения читателя (опубликована или нет)
+    uint64_t m_cachedTail = 0;    ///< Последняя прочитанная читателем позиция записи
+};
+
+#endif // SHMRING_H
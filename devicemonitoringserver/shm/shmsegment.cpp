@@ -0,0 +1,223 @@
+#include "shmsegment.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr uint32_t segmentMagic = 0x48534d44; // "DMSH"
+constexpr uint32_t protocolVersion = 1;
+
+/*!
+ * \brief Начало сегмента: параметры и общие части колец
+ */
+struct SegmentHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    ShmRingHeader rings[2];
+};
+
+/*!
+ * \brief Смещение данных колец: с начала страницы после заголовка
+ */
+constexpr size_t dataOffset = (sizeof(SegmentHeader) + 4095) / 4096 * 4096;
+
+constexpr size_t segmentSize(size_t capacity)
+{
+    return dataOffset + 2 * capacity;
+}
+
+bool validCapacity(size_t capacity)
+{
+    return capacity >= ShmSegment::minCapacity() && capacity <= ShmSegment::maxCapacity() && !(capacity & (capacity - 1));
+}
+
+/*!
+ * \brief Первое сообщение клиента; дескрипторы передаются вместе с ним (SCM_RIGHTS)
+ */
+struct Handshake
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t clientId;
+};
+
+constexpr size_t handshakeFdCount = 3;
+
+} // namespace
+
+ShmSegment::ShmSegment(int fd, char* memory, size_t size, size_t capacity) :
+    m_fd(fd), m_memory(memory), m_size(size), m_capacity(capacity)
+{
+}
+
+ShmSegment::~ShmSegment()
+{
+    munmap(m_memory, m_size);
+    closeFd();
+}
+
+ShmSegment* ShmSegment::create(size_t capacity)
+{
+    if (!validCapacity(capacity))
+        return nullptr;
+    const int fd = memfd_create("devicemonitoringserver-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+        return nullptr;
+    const size_t size = segmentSize(capacity);
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0 || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    auto* header = new (memory) SegmentHeader;
+    header->magic = segmentMagic;
+    header->version = protocolVersion;
+    header->capacity = capacity;
+    for (auto& ring : header->rings)
+        ShmRing::initialize(&ring);
+    return new ShmSegment(fd, static_cast<char*>(memory), size, capacity);
+}
+
+ShmSegment* ShmSegment::attach(int fd)
+{
+    // Без запечатанного размера клиент мог бы уменьшить сегмент, и обращение к нему завершило бы сервер по SIGBUS
+    struct stat status {};
+    const int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || !(seals & F_SEAL_SHRINK) || fstat(fd, &status) != 0 || status.st_size <= static_cast<off_t>(dataOffset)
+        || status.st_size > static_cast<off_t>(segmentSize(maxCapacity())))
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(status.st_size);
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    const auto* header = static_cast<const SegmentHeader*>(memory);
+    const size_t capacity = header->capacity;
+    if (header->magic != segmentMagic || header->version != protocolVersion || !validCapacity(capacity)
+        || segmentSize(capacity) != size)
+    {
+        munmap(memory, size);
+        ::close(fd);
+        return nullptr;
+    }
+    return new ShmSegment(fd, static_cast<char*>(memory), size, capacity);
+}
+
+void ShmSegment::closeFd()
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+ShmRingHeader* ShmSegment::ringHeader(Direction direction) const
+{
+    return &reinterpret_cast<SegmentHeader*>(m_memory)->rings[static_cast<size_t>(direction)];
+}
+
+char* ShmSegment::ringData(Direction direction) const
+{
+    return m_memory + dataOffset + static_cast<size_t>(direction) * m_capacity;
+}
+
+size_t shmServerAddress(uint64_t serverId, sockaddr_un& address)
+{
+    address = {};
+    address.sun_family = AF_UNIX;
+    // Первый нулевой байт: имя в абстрактном пространстве, сокет не оставляет файлов
+    const int length = std::snprintf(address.sun_path + 1, sizeof(address.sun_path) - 1, "devicemonitoringserver-shm-%llu",
+                                     static_cast<unsigned long long>(serverId));
+    return offsetof(sockaddr_un, sun_path) + 1 + static_cast<size_t>(length);
+}
+
+bool sendShmHandshake(int socketFd, uint64_t clientId, const int (&fds)[3])
+{
+    Handshake handshake { segmentMagic, protocolVersion, clientId };
+    iovec part = { &handshake, sizeof(handshake) };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+    msghdr msg {};
+    msg.msg_iov = &part;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    ssize_t sent = 0;
+    do
+        sent = ::sendmsg(socketFd, &msg, MSG_NOSIGNAL);
+    while (sent < 0 && errno == EINTR);
+    return sent == static_cast<ssize_t>(sizeof(handshake));
+}
+
+bool receiveShmHandshake(int socketFd, uint64_t& clientId, int (&fds)[3])
+{
+    Handshake handshake {};
+    iovec part = { &handshake, sizeof(handshake) };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+    msghdr msg {};
+    msg.msg_iov = &part;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t size = 0;
+    do
+        size = ::recvmsg(socketFd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    while (size < 0 && errno == EINTR);
+
+    size_t fdCount = 0;
+    for (cmsghdr* cmsg = size >= 0 ? CMSG_FIRSTHDR(&msg) : nullptr; cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+        const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; ++i)
+        {
+            int fd = -1;
+            std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (fdCount < handshakeFdCount)
+                fds[fdCount] = fd;
+            else
+                ::close(fd);
+            ++fdCount;
+        }
+    }
+    if (size != static_cast<ssize_t>(sizeof(handshake)) || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) || fdCount != handshakeFdCount
+        || handshake.magic != segmentMagic || handshake.version != protocolVersion)
+    {
+        for (size_t i = 0; i < std::min(fdCount, handshakeFdCount); ++i)
+            ::close(fds[i]);
+        return false;
+    }
+    clientId = handshake.clientId;
+    return true;
+}
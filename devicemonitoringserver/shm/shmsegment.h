@@ -0,0 +1,107 @@
+#ifndef SHMSEGMENT_H
+#define SHMSEGMENT_H
+
+#include "../common.h"
+#include "shmring.h"
+
+#include <cstddef>
+#include <cstdint>
+
+struct sockaddr_un;
+
+/*!
+ * \brief Сегмент разделяемой памяти (memfd) с двумя кольцами ShmRing: от клиента к серверу и обратно.
+ *
+ * Сегмент создает клиент и передает его дескриптор серверу через UNIX-сокет. Размер сегмента
+ * запечатан (F_SEAL_SHRINK/F_SEAL_GROW), поэтому клиент не может уменьшить его под отображением
+ * сервера. Емкость колец сервер проверяет при подключении и дальше берет только из своей копии.
+ */
+class ShmSegment
+{
+    NON_COPYABLE(ShmSegment)
+public:
+    /*!
+     * \brief Направление передачи
+     */
+    enum class Direction
+    {
+        ClientToServer,
+        ServerToClient
+    };
+
+    /*!
+     * \brief Наименьшая емкость кольца
+     */
+    static constexpr size_t minCapacity() { return 4096; }
+    /*!
+     * \brief Наибольшая емкость кольца
+     */
+    static constexpr size_t maxCapacity() { return 64u << 20; }
+    /*!
+     * \brief Емкость кольца по умолчанию
+     */
+    static constexpr size_t defaultCapacity() { return 1u << 20; }
+
+    /*!
+     * \brief Создать сегмент с кольцами емкостью \a capacity (степень двойки).
+     * \return nullptr в случае ошибки
+     */
+    static ShmSegment* create(size_t capacity);
+    /*!
+     * \brief Отобразить сегмент, созданный другой стороной, и проверить его.
+     * \param fd - дескриптор memfd; закрывается в любом случае
+     * \return nullptr, если сегмент недопустим
+     */
+    static ShmSegment* attach(int fd);
+    ~ShmSegment();
+
+    /*!
+     * \brief Дескриптор memfd для передачи другой стороне; -1 после closeFd().
+     */
+    int fd() const { return m_fd; }
+    /*!
+     * \brief Закрыть дескриптор memfd; отображение остается.
+     */
+    void closeFd();
+    /*!
+     * \brief Емкость каждого из колец.
+     */
+    size_t capacity() const { return m_capacity; }
+    /*!
+     * \brief Общая часть кольца направления \a direction.
+     */
+    ShmRingHeader* ringHeader(Direction direction) const;
+    /*!
+     * \brief Данные кольца направления \a direction.
+     */
+    char* ringData(Direction direction) const;
+
+private:
+    ShmSegment(int fd, char* memory, size_t size, size_t capacity);
+
+private:
+    int m_fd = -1;
+    char* m_memory = nullptr;
+    size_t m_size = 0;
+    size_t m_capacity = 0;
+};
+
+/*!
+ * \brief Адрес UNIX-сокета, на котором ShmConnectionServer с идентификатором \a serverId
+ * принимает подключения (абстрактное пространство имен).
+ * \return длина адреса \a address для bind()/connect()
+ */
+size_t shmServerAddress(uint64_t serverId, sockaddr_un& address);
+/*!
+ * \brief Передать серверу через сокет \a socketFd идентификатор клиента \a clientId и дескрипторы:
+ * сегмента, eventfd для пробуждения сервера и eventfd для пробуждения клиента.
+ * \return false в случае ошибки
+ */
+bool sendShmHandshake(int socketFd, uint64_t clientId, const int (&fds)[3]);
+/*!
+ * \brief Принять через сокет \a socketFd данные sendShmHandshake().
+ * \return false, если сообщение неполное или не соответствует протоколу; полученные дескрипторы закрываются
+ */
+bool receiveShmHandshake(int socketFd, uint64_t& clientId, int (&fds)[3]);
+
+#endif // SHMSEGMENT_H
@@ -0,0 +1,384 @@
+#include "shmtests.h"
+#include "test_runner.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractmessagehandler.h>
+#include <handlers/abstractnewconnectionhandler.h>
+#include <shm/shmclientconnection.h>
+#include <shm/shmconnectionserver.h>
+#include <shm/shmring.h>
+#include <shm/shmsegment.h>
+#include <tcp/eventloop.h>
+#include <tcp/tcptests.h>
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+int allocationCounter = 0;
+
+void processEvents(EventLoop& eventLoop)
+{
+    while (eventLoop.processEvents(20))
+        ;
+}
+
+class MessageListHandler : public AbstractMessageHandler
+{
+public:
+    MessageListHandler(std::vector<std::string>& messageList) :
+        m_messageList(messageList) { ++allocationCounter; }
+    ~MessageListHandler() { --allocationCounter; }
+
+    void operator()(const std::string& message) final
+    {
+        m_messageList.push_back(message);
+    }
+
+private:
+    std::vector<std::string>& m_messageList;
+};
+
+class FlagHandler : public AbstractAction
+{
+public:
+    FlagHandler(bool& flag) :
+        m_flag(flag) { ++allocationCounter; }
+    ~FlagHandler() { --allocationCounter; }
+
+    void operator()() final
+    {
+        m_flag = true;
+    }
+
+private:
+    bool& m_flag;
+};
+
+struct EchoMessageHandler : public AbstractMessageHandler
+{
+    EchoMessageHandler(AbstractConnection* conn) :
+        m_conn(conn) { ++allocationCounter; }
+    ~EchoMessageHandler() { --allocationCounter; }
+
+private:
+    void operator()(const std::string& message) final
+    {
+        m_conn->sendMessage(message);
+    }
+
+private:
+    AbstractConnection* m_conn = nullptr;
+};
+
+class EchoNewConnectionHandler : public AbstractNewConnectionHandler
+{
+public:
+    EchoNewConnectionHandler(std::map<uint64_t, bool>* disconnected = nullptr) :
+        m_disconnected(disconnected) { ++allocationCounter; }
+    ~EchoNewConnectionHandler() { --allocationCounter; }
+
+private:
+    void operator()(AbstractConnection* conn) final
+    {
+        conn->setMessageHandler(new EchoMessageHandler(conn));
+        if (m_disconnected)
+            conn->setDisconnectedHandler(new FlagHandler((*m_disconnected)[conn->peerId()]));
+    }
+
+private:
+    std::map<uint64_t, bool>* m_disconnected = nullptr;
+};
+
+/*!
+ * \brief Подключиться к серверу \a serverId блокирующим сокетом в обход ShmClientConnection
+ */
+int connectRawSocket(uint64_t serverId)
+{
+    sockaddr_un address {};
+    const size_t addressSize = shmServerAddress(serverId, address);
+    const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&address), static_cast<socklen_t>(addressSize)) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*!
+ * \brief Сервер закрыл соединение сокета \a fd
+ */
+bool rawSocketClosed(int fd)
+{
+    char buffer[64];
+    return recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT) == 0;
+}
+
+} // namespace
+
+void shmRingTest()
+{
+    ASSERT(!ShmSegment::create(ShmSegment::minCapacity() + 1));
+    ASSERT(!ShmSegment::create(ShmSegment::minCapacity() / 2));
+    ASSERT(!ShmSegment::create(ShmSegment::maxCapacity() * 2));
+    ShmSegment* segment = ShmSegment::create(ShmSegment::minCapacity());
+    ASSERT(segment);
+    const size_t capacity = segment->capacity();
+    ASSERT_EQUAL(capacity, ShmSegment::minCapacity());
+
+    // Другая сторона получает сегмент по дескриптору; дескриптор без запечатанного размера не принимается
+    ShmSegment* attached = ShmSegment::attach(dup(segment->fd()));
+    ASSERT(attached);
+    ASSERT_EQUAL(attached->capacity(), capacity);
+    const int unsealedFd = memfd_create("unsealed", MFD_CLOEXEC);
+    ASSERT(unsealedFd >= 0);
+    ASSERT_EQUAL(ftruncate(unsealedFd, 1 << 16), 0);
+    ASSERT(!ShmSegment::attach(unsealedFd));
+    ASSERT(!ShmSegment::attach(eventfd(0, EFD_CLOEXEC)));
+
+    const auto direction = ShmSegment::Direction::ClientToServer;
+    ShmRing writer(segment->ringHeader(direction), segment->ringData(direction), capacity);
+    ShmRing reader(attached->ringHeader(direction), attached->ringData(direction), capacity);
+    std::string message;
+    ASSERT(reader.read(message) == ShmRing::ReadStatus::Empty);
+
+    // Писатель будит читателя только после того, как тот выставил флаг ожидания, и только один раз
+    ASSERT(!writer.takeReaderWaiting());
+    ASSERT(reader.waitForData());
+    ASSERT(writer.write("a"));
+    ASSERT(writer.takeReaderWaiting());
+    ASSERT(writer.write("b"));
+    ASSERT(!writer.takeReaderWaiting());
+    ASSERT(reader.read(message) == ShmRing::ReadStatus::Message);
+    ASSERT_EQUAL(message, "a");
+    ASSERT(reader.read(message) == ShmRing::ReadStatus::Message);
+    ASSERT_EQUAL(message, "b");
+    ASSERT(reader.read(message) == ShmRing::ReadStatus::Empty);
+    // Данные, пришедшие до выставления флага, не требуют ожидания
+    ASSERT(writer.write(""));
+    ASSERT(!reader.waitForData());
+    ASSERT(!writer.takeReaderWaiting());
+    ASSERT(reader.read(message) == ShmRing::ReadStatus::Message);
+    ASSERT_EQUAL(message, "");
+    reader.releaseRead();
+
+    // Кадр пишется целиком или не пишется; место возвращается писателю только после releaseRead()
+    const size_t frameSize = 1000;
+    size_t written = 0;
+    while (writer.write(std::string(frameSize, static_cast<char>('0' + written))))
+        ++written;
+    ASSERT_EQUAL(written, capacity / (ShmRing::headerSize() + frameSize));
+    ASSERT(writer.waitForSpace(frameSize));
+    ASSERT(reader.read(message) == ShmRing::ReadStatus::Message);
+    ASSERT_EQUAL(message, std::string(frameSize, '0'));
+    ASSERT(!writer.write(std::string(frameSize, 'w')));
+    reader.releaseRead();
+    ASSERT(reader.takeWriterWaiting());
+    ASSERT(!reader.takeWriterWaiting());
+    // Кадр переходит через конец кольца
+    std::string wrapped(frameSize, 'w');
+    for (size_t i = 0; i < wrapped.size(); ++i)
+        wrapped[i] = static_cast<char>(i * 7);
+    ASSERT(writer.write(wrapped));
+    ASSERT(!writer.waitForSpace(0));
+    for (size_t i = 1; i < written; ++i)
+    {
+        ASSERT(reader.read(message) == ShmRing::ReadStatus::Message);
+        ASSERT_EQUAL(message, std::string(frameSize, static_cast<char>('0' + i)));
+    }
+    ASSERT(reader.read(message) == ShmRing::ReadStatus::Message);
+    ASSERT_EQUAL(message, wrapped);
+    ASSERT(reader.read(message) == ShmRing::ReadStatus::Empty);
+    reader.releaseRead();
+
+    // Сообщения разного размера многократно проходят через конец кольца
+    for (size_t i = 0; i < 3000; ++i)
+    {
+        const std::string sent(i % 1500, static_cast<char>(i));
+        ASSERT(writer.write(sent));
+        ASSERT(reader.read(message) == ShmRing::ReadStatus::Message);
+        ASSERT_EQUAL(message, sent);
+        reader.releaseRead();
+    }
+    ASSERT(!writer.write(std::string(writer.maxMessageSize() + 1, 'm')));
+    ASSERT(writer.write(std::string(writer.maxMessageSize(), 'm')));
+    ASSERT(reader.read(message) == ShmRing::ReadStatus::Message);
+    ASSERT_EQUAL(message.size(), reader.maxMessageSize());
+    reader.releaseRead();
+
+    // Длина кадра, выходящая за опубликованные данные, - повреждение, а не чтение чужой памяти
+    const auto backDirection = ShmSegment::Direction::ServerToClient;
+    ShmRing backWriter(segment->ringHeader(backDirection), segment->ringData(backDirection), capacity);
+    ShmRing backReader(attached->ringHeader(backDirection), attached->ringData(backDirection), capacity);
+    ASSERT(backWriter.write("abc"));
+    const uint32_t corruptedSize = 4;
+    std::memcpy(segment->ringData(backDirection), &corruptedSize, sizeof(corruptedSize));
+    ASSERT(backReader.read(message) == ShmRing::ReadStatus::Corrupted);
+
+    delete attached;
+    delete segment;
+}
+
+void shmClientServerTest()
+{
+    EventLoop eventLoop;
+    {
+        ShmConnectionServer server(eventLoop);
+        std::map<uint64_t, bool> serverDisconnected;
+        server.setNewConnectionHandler(new EchoNewConnectionHandler(&serverDisconnected));
+
+        ShmClientConnection client(eventLoop);
+        std::vector<std::string> received;
+        client.setMessageHandler(new MessageListHandler(received));
+        bool clientConnected = false;
+        client.setConnectedHandler(new FlagHandler(clientConnected));
+        bool clientDisconnected = false;
+        client.setDisconnectedHandler(new FlagHandler(clientDisconnected));
+
+        const uint64_t clientId = 11;
+        ASSERT(!client.bind(0));
+        ASSERT(client.bind(clientId));
+        ASSERT(!client.connectToHost(0));
+        // Сервер не слушает: ошибка сразу
+        const uint64_t serverId = tcpTestPort(0);
+        ASSERT(!client.connectToHost(serverId));
+        ASSERT(!server.listen(0));
+        ASSERT(server.listen(serverId));
+        ASSERT(!server.listen(serverId));
+        ASSERT_EQUAL(server.listenedId(), serverId);
+        ShmConnectionServer busy(eventLoop);
+        ASSERT(!busy.listen(serverId));
+
+        ASSERT(client.connectToHost(serverId));
+        ASSERT(!client.connectToHost(serverId));
+        ASSERT(!client.connected());
+        // Сообщения, отправленные до подключения сервера, ждут его в кольце
+        client.sendMessage("connection request");
+        processEvents(eventLoop);
+        ASSERT(clientConnected);
+        ASSERT(client.connected());
+        ASSERT_EQUAL(client.peerId(), serverId);
+        auto* serverConn = server.connection(clientId);
+        ASSERT(serverConn);
+        ASSERT(serverConn->connected());
+        ASSERT_EQUAL(serverConn->peerId(), clientId);
+        ASSERT_EQUAL(received, std::vector<std::string>({ "connection request" }));
+
+        // Второй клиент с тем же идентификатором отклоняется, первый остается подключенным
+        {
+            ShmClientConnection duplicate(eventLoop);
+            bool duplicateDisconnected = false;
+            duplicate.setDisconnectedHandler(new FlagHandler(duplicateDisconnected));
+            ASSERT(duplicate.bind(clientId));
+            ASSERT(duplicate.connectToHost(serverId));
+            processEvents(eventLoop);
+            ASSERT(duplicateDisconnected);
+            ASSERT(!duplicate.connected());
+            ASSERT_EQUAL(server.connection(clientId), serverConn);
+            ASSERT(!serverDisconnected[clientId]);
+        }
+
+        // Сообщения, записанные перед разрывом, доставляются
+        client.sendMessage("last");
+        client.disconnect();
+        ASSERT(!clientDisconnected);
+        processEvents(eventLoop);
+        ASSERT(clientDisconnected);
+        ASSERT(serverDisconnected[clientId]);
+        ASSERT(!client.connected());
+        ASSERT(!server.connection(clientId));
+
+        // Повторное подключение после разрыва; разрыв со стороны сервера
+        clientConnected = clientDisconnected = serverDisconnected[clientId] = false;
+        received.clear();
+        ASSERT(client.connectToHost(serverId));
+        processEvents(eventLoop);
+        ASSERT(clientConnected);
+        client.sendMessage("again");
+        processEvents(eventLoop);
+        ASSERT_EQUAL(received, std::vector<std::string>({ "again" }));
+        server.disconnect();
+        processEvents(eventLoop);
+        ASSERT(clientDisconnected);
+        ASSERT(serverDisconnected[clientId]);
+        ASSERT(!client.connected());
+        ASSERT_EQUAL(client.peerId(), 0u);
+        ASSERT(!client.connectToHost(serverId));
+    }
+    processEvents(eventLoop);
+    ASSERT_EQUAL(allocationCounter, 0);
+}
+
+void shmFramingTest()
+{
+    EventLoop eventLoop;
+    {
+        ShmConnectionServer server(eventLoop);
+        server.setNewConnectionHandler(new EchoNewConnectionHandler);
+        const uint64_t serverId = listenOnTcpTestPort(server);
+        ASSERT(serverId);
+
+        // Маленькие кольца: сообщения ждут места в буфере отправки с обеих сторон
+        ShmClientConnection client(eventLoop, ShmSegment::minCapacity());
+        std::vector<std::string> received;
+        client.setMessageHandler(new MessageListHandler(received));
+        ASSERT(client.bind(1));
+        ASSERT(client.connectToHost(serverId));
+        processEvents(eventLoop);
+        ASSERT(client.connected());
+
+        const size_t maxMessageSize = ShmSegment::minCapacity() - ShmRing::headerSize();
+        std::vector<std::string> sent = { "", "a", std::string(maxMessageSize, 'b') };
+        for (int i = 0; i < 5000; ++i)
+            sent.push_back(std::to_string(i) + std::string(i % 100, 'c'));
+        sent.push_back(std::string(maxMessageSize, 'd'));
+        for (const auto& message : sent)
+            client.sendMessage(message);
+        // Сообщение больше кольца не отправляется
+        client.sendMessage(std::string(maxMessageSize + 1, 'e'));
+        processEvents(eventLoop);
+        ASSERT(client.connected());
+        ASSERT_EQUAL(received.size(), sent.size());
+        ASSERT(received == sent);
+
+        // Сервер разрывает подключения с неверным первым сообщением, без дескрипторов
+        // и с сегментом, размер которого не запечатан
+        const int eventFds[2] = { eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) };
+        const int unsealedFd = memfd_create("unsealed", MFD_CLOEXEC);
+        ASSERT(eventFds[0] >= 0 && eventFds[1] >= 0 && unsealedFd >= 0);
+        ASSERT_EQUAL(ftruncate(unsealedFd, 4096 + 2 * ShmSegment::minCapacity()), 0);
+        for (int attempt = 0; attempt < 3; ++attempt)
+        {
+            const int fd = connectRawSocket(serverId);
+            ASSERT(fd >= 0);
+            if (attempt == 0)
+            {
+                ASSERT_EQUAL(send(fd, "garbage", 7, MSG_NOSIGNAL), 7);
+            }
+            else if (attempt == 1)
+            {
+                ASSERT_EQUAL(send(fd, "0123456789abcdef", 16, MSG_NOSIGNAL), 16);
+            }
+            else
+            {
+                ASSERT(sendShmHandshake(fd, 2, { unsealedFd, eventFds[0], eventFds[1] }));
+            }
+            processEvents(eventLoop);
+            ASSERT(rawSocketClosed(fd));
+            ::close(fd);
+        }
+        for (int fd : { eventFds[0], eventFds[1], unsealedFd })
+            ::close(fd);
+        ASSERT(!server.connection(2));
+        ASSERT(client.connected());
+        ASSERT(server.connection(1));
+    }
+    processEvents(eventLoop);
+    ASSERT_EQUAL(allocationCounter, 0);
+}
@@ -0,0 +1,17 @@
+#ifndef SHMTESTS_H
+#define SHMTESTS_H
+
+/*!
+ * \brief Тест кольца в разделяемой памяти: переполнение, переход через конец, флаги ожидания, поврежденные кадры.
+ */
+void shmRingTest();
+/*!
+ * \brief Тест клиента и сервера на разделяемой памяти.
+ */
+void shmClientServerTest();
+/*!
+ * \brief Тест передачи сообщений больше свободного места в кольце и нарушений протокола подключения.
+ */
+void shmFramingTest();
+
+#endif // SHMTESTS_H
@@ -0,0 +1,59 @@
+#include "streamdecoder.h"
+#include "baseencoderexecutor.h"
+
+#include <algorithm>
+
+StreamDecoder::StreamDecoder(const BaseEncoderExecutor& executor) :
+    m_executor(executor), m_unitSize(executor.encodedUnitSize())
+{
+}
+
+size_t StreamDecoder::feed(std::string_view chunk, std::string& output)
+{
+    if (m_unitSize == 0)
+    {
+        m_pending.append(chunk.data(), chunk.size());
+        return 0;
+    }
+    const size_t offset = output.size();
+    // Сначала дополняется единица, начатая в предыдущей части
+    if (!m_pending.empty())
+    {
+        const size_t missing = std::min(m_unitSize - m_pending.size(), chunk.size());
+        m_pending.append(chunk.data(), missing);
+        chunk.remove_prefix(missing);
+        if (m_pending.size() < m_unitSize)
+            return 0;
+        if (!decodeUnits(m_pending, output))
+            return std::string::npos;
+        m_pending.clear();
+    }
+    const size_t whole = chunk.size() - chunk.size() % m_unitSize;
+    if (whole > 0 && !decodeUnits(chunk.substr(0, whole), output))
+        return std::string::npos;
+    m_pending.assign(chunk.data() + whole, chunk.size() - whole);
+    return output.size() - offset;
+}
+
+size_t StreamDecoder::finish(std::string& output)
+{
+    const size_t offset = output.size();
+    const bool ok = m_unitSize != 0 || decodeUnits(m_pending, output);
+    m_pending.clear();
+    return ok ? output.size() - offset : std::string::npos;
+}
+
+bool StreamDecoder::decodeUnits(std::string_view units, std::string& output) const
+{
+    const size_t offset = output.size();
+    const size_t size = m_unitSize ? units.size() / m_unitSize : m_executor.maxDecodedSize(units.size());
+    if (size == BaseEncoderExecutor::unknownSize)
+    {
+        output += m_executor.decode(std::string(units));
+        return true;
+    }
+    output.resize(offset + size);
+    const auto written = m_executor.decodeInto(units, &output[offset], size);
+    output.resize(offset + written.value_or(0));
+    return written.has_value();
+}
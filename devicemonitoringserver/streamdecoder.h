@@ -0,0 +1,61 @@
+#ifndef STREAMDECODER_H
+#define STREAMDECODER_H
+
+#include "common.h"
+
+#include <string>
+#include <string_view>
+
+class BaseEncoderExecutor;
+
+/*!
+ * \brief Расшифровка потока, разбитого на части произвольного размера
+ *
+ * Транспорт может разрезать зашифрованное сообщение в любом месте, в том числе внутри единицы
+ * шифрования (BaseEncoderExecutor::encodedUnitSize()). Декодер расшифровывает каждую часть сразу,
+ * без сборки целого сообщения: целые единицы расшифровываются напрямую из переданного буфера,
+ * незавершенная единица сохраняется до следующего вызова.
+ * Для алгоритмов без единицы шифрования данные накапливаются и расшифровываются в finish().
+ */
+class StreamDecoder
+{
+public:
+    NON_COPYABLE(StreamDecoder)
+
+    /*!
+     * \brief Конструктор.
+     * \param executor - алгоритм шифрования; должен существовать дольше декодера
+     */
+    explicit StreamDecoder(const BaseEncoderExecutor& executor);
+
+    /*!
+     * \brief Расшифровать очередную часть потока \a chunk, дописав результат в конец \a output
+     * \return количество дописанных байтов; std::string::npos в случае ошибки алгоритма
+     */
+    size_t feed(std::string_view chunk, std::string& output);
+    /*!
+     * \brief Завершить сообщение: расшифровать накопленные данные и сбросить состояние
+     *
+     * Незавершенная единица шифрования в конце сообщения отбрасывается, как и при расшифровке целого сообщения.
+     * \return количество дописанных в \a output байтов; std::string::npos в случае ошибки алгоритма
+     */
+    size_t finish(std::string& output);
+    /*!
+     * \brief Количество сохраненных байтов, еще не расшифрованных
+     */
+    size_t pendingSize() const { return m_pending.size(); }
+    /*!
+     * \brief Сбросить сохраненные байты
+     */
+    void reset() { m_pending.clear(); }
+
+private:
+    bool decodeUnits(std::string_view units, std::string& output) const;
+
+private:
+    const BaseEncoderExecutor& m_executor;
+    const size_t m_unitSize = 0;
+    std::string m_pending; ///< Незавершенная единица шифрования или, без единицы, все сообщение
+};
+
+#endif // STREAMDECODER_H
@@ -0,0 +1,156 @@
+#include "eventloop.h"
+#include <handlers/abstractaction.h>
+
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/*!
+ * \brief Наибольшее количество событий за один вызов epoll_wait()
+ */
+static constexpr size_t maxEvents = 256;
+
+EventLoop::EventLoop() :
+    m_epollFd(epoll_create1(EPOLL_CLOEXEC)), m_events(maxEvents), m_wakeupFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), m_wakeupHandler(this)
+{
+    if (m_wakeupFd >= 0 && !add(m_wakeupFd, EPOLLIN, &m_wakeupHandler))
+    {
+        ::close(m_wakeupFd);
+        m_wakeupFd = -1;
+    }
+}
+
+EventLoop::~EventLoop()
+{
+    for (auto* action : m_actions)
+        delete action;
+    for (auto* action : m_invokedActions)
+        delete action;
+    if (m_wakeupFd >= 0)
+        ::close(m_wakeupFd);
+    if (m_epollFd >= 0)
+        ::close(m_epollFd);
+}
+
+bool EventLoop::add(int fd, uint32_t events, AbstractEventHandler* handler)
+{
+    if (m_epollFd < 0 || fd < 0 || !handler || m_tokens.count(fd))
+        return false;
+    // Метки не повторяются, поэтому событие закрытого дескриптора не попадет
+    // к обработчику нового дескриптора с тем же номером
+    epoll_event event {};
+    event.events = events;
+    event.data.u64 = ++m_lastToken;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+        return false;
+    m_handlers.emplace(m_lastToken, handler);
+    m_tokens.emplace(fd, m_lastToken);
+    return true;
+}
+
+void EventLoop::remove(int fd)
+{
+    const auto it = m_tokens.find(fd);
+    if (it == m_tokens.end())
+        return;
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    m_handlers.erase(it->second);
+    m_tokens.erase(it);
+}
+
+void EventLoop::post(AbstractAction* action)
+{
+    if (action)
+        m_actions.push_back(action);
+}
+
+void EventLoop::invoke(AbstractAction* action)
+{
+    if (!action)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_invokeMutex);
+        m_invokedActions.push_back(action);
+    }
+    wakeUp();
+}
+
+void EventLoop::run()
+{
+    while (!m_quit.exchange(false, std::memory_order_acq_rel))
+        processEvents(-1);
+}
+
+void EventLoop::quit()
+{
+    m_quit.store(true, std::memory_order_release);
+    wakeUp();
+}
+
+bool EventLoop::processEvents(int timeoutMs)
+{
+    if (m_epollFd < 0)
+        return runActions();
+    // Завершение заявок io_uring тоже прерывает ожидание (EINTR): ждем дальше
+    int count = 0;
+    do
+        count = epoll_wait(m_epollFd, m_events.data(), static_cast<int>(m_events.size()), m_actions.empty() ? timeoutMs : 0);
+    while (count < 0 && errno == EINTR);
+    if (count < 0)
+        count = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        // Обработчик мог быть удален при обработке предыдущих событий
+        const auto it = m_handlers.find(m_events[i].data.u64);
+        if (it != m_handlers.end())
+            (*it->second)(m_events[i].events);
+    }
+    return runActions() || count > 0;
+}
+
+void EventLoop::wakeUp()
+{
+    const uint64_t value = 1;
+    const ssize_t written = ::write(m_wakeupFd, &value, sizeof(value));
+    UNUSED(written);
+}
+
+void EventLoop::takeInvokedActions()
+{
+    std::lock_guard<std::mutex> lock(m_invokeMutex);
+    m_actions.insert(m_actions.end(), m_invokedActions.begin(), m_invokedActions.end());
+    m_invokedActions.clear();
+}
+
+void EventLoop::WakeupHandler::operator()(uint32_t /*events*/)
+{
+    uint64_t value = 0;
+    const ssize_t result = ::read(m_eventLoop->m_wakeupFd, &value, sizeof(value));
+    UNUSED(result);
+    m_eventLoop->takeInvokedActions();
+}
+
+bool EventLoop::runActions()
+{
+    if (m_actions.empty())
+        return false;
+    // Действия, добавленные во время выполнения, выполняются на следующей итерации
+    std::vector<AbstractAction*> actions;
+    actions.swap(m_actions);
+    for (size_t i = 0; i < actions.size(); ++i)
+    {
+        try
+        {
+            (*actions[i])();
+        }
+        catch (...)
+        {
+            for (size_t j = i; j < actions.size(); ++j)
+                delete actions[j];
+            throw;
+        }
+        delete actions[i];
+    }
+    return true;
+}
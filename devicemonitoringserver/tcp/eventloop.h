@@ -0,0 +1,116 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include "../common.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct epoll_event;
+class AbstractAction;
+
+/*!
+ * \brief Базовый класс функтора-обработчика событий файлового дескриптора.
+ */
+class AbstractEventHandler
+{
+public:
+    virtual ~AbstractEventHandler() = default;
+    /*!
+     * \brief Перегрузка оператора вызова.
+     * \param events - маска событий epoll (EPOLLIN, EPOLLOUT, ...)
+     */
+    virtual void operator()(uint32_t events) = 0;
+};
+
+/*!
+ * \brief Цикл обработки событий на epoll.
+ *
+ * Заменяет TaskQueue для сетевых соединений: processEvents() обрабатывает готовые дескрипторы,
+ * затем отложенные действия. Обработчик, удаленный из цикла, не получает событий,
+ * уже выбранных из epoll в той же итерации.
+ * Все методы, кроме invoke() и quit(), вызываются из потока, обрабатывающего события.
+ */
+class EventLoop
+{
+    NON_COPYABLE(EventLoop)
+
+    struct WakeupHandler final : public AbstractEventHandler
+    {
+        WakeupHandler(EventLoop* eventLoop) :
+            m_eventLoop(eventLoop) {}
+        void operator()(uint32_t events) final;
+
+    private:
+        EventLoop* m_eventLoop = nullptr;
+    };
+
+public:
+    EventLoop();
+    ~EventLoop();
+
+    /*!
+     * \brief Следить за событиями \a events дескриптора \a fd.
+     * \param handler - невладеющий указатель на обработчик; действителен до remove()
+     * \return false в случае ошибки
+     */
+    bool add(int fd, uint32_t events, AbstractEventHandler* handler);
+    /*!
+     * \brief Прекратить слежение за дескриптором \a fd (до его закрытия).
+     */
+    void remove(int fd);
+    /*!
+     * \brief Выполнить действие после обработки текущих событий.
+     * \param action - владеющий указатель на действие
+     */
+    void post(AbstractAction* action);
+    /*!
+     * \brief Выполнить действие в потоке цикла; можно вызывать из любого потока.
+     * \param action - владеющий указатель на действие
+     */
+    void invoke(AbstractAction* action);
+    /*!
+     * \brief Обработать готовые события и отложенные действия.
+     * \param timeoutMs - наибольшее время ожидания событий, мс; -1 - без ограничения
+     * \return false, если за время ожидания ничего не произошло
+     */
+    bool processEvents(int timeoutMs);
+    /*!
+     * \brief Обрабатывать события, пока не будет вызван quit().
+     */
+    void run();
+    /*!
+     * \brief Завершить run(); можно вызывать из любого потока.
+     */
+    void quit();
+
+private:
+    /*!
+     * \brief Выполнить отложенные действия
+     * \return false, если их не было
+     */
+    bool runActions();
+    /*!
+     * \brief Перенести действия, переданные через invoke(), в очередь отложенных
+     */
+    void takeInvokedActions();
+    void wakeUp();
+
+private:
+    int m_epollFd = -1;
+    uint64_t m_lastToken = 0;
+    std::unordered_map<uint64_t, AbstractEventHandler*> m_handlers; ///< Обработчики по меткам регистрации
+    std::unordered_map<int, uint64_t> m_tokens;                     ///< Метки регистрации дескрипторов
+    std::vector<epoll_event> m_events;
+    std::vector<AbstractAction*> m_actions;
+    int m_wakeupFd = -1; ///< eventfd: будит цикл из других потоков
+    WakeupHandler m_wakeupHandler;
+    std::mutex m_invokeMutex;
+    std::vector<AbstractAction*> m_invokedActions; ///< Действия из других потоков; защищены m_invokeMutex
+    std::atomic<bool> m_quit { false };
+};
+
+#endif // EVENTLOOP_H
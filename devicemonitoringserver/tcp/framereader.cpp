@@ -0,0 +1,63 @@
+#include "framereader.h"
+#include "../baseencoderexecutor.h"
+#include "../bigendian.h"
+#include <handlers/abstractmessagehandler.h>
+
+#include <algorithm>
+
+size_t FrameReader::consume(std::string_view data, AbstractMessageHandler* handler)
+{
+    m_ready = false;
+    const size_t size = data.size();
+    if (m_headerFilled < headerSize())
+    {
+        const size_t part = std::min(headerSize() - m_headerFilled, data.size());
+        std::copy(data.begin(), data.begin() + part, m_header + m_headerFilled);
+        m_headerFilled += part;
+        data.remove_prefix(part);
+        if (m_headerFilled < headerSize())
+            return size;
+        m_remaining = fromBigEndian<uint32_t>(m_header);
+        if (m_remaining > maxMessageSize())
+            return std::string::npos;
+        // Алгоритм выбирается на весь кадр: обработчик может сменить его только между сообщениями
+        m_message.clear();
+        m_failed = false;
+        m_executor = handler ? handler->streamExecutor() : nullptr;
+        if (m_executor)
+            m_decoder.emplace(*m_executor);
+    }
+
+    const std::string_view part = data.substr(0, m_remaining);
+    if (!m_decoder)
+        m_message.append(part.data(), part.size());
+    else if (!m_failed && m_decoder->feed(part, m_message) == std::string::npos)
+        m_failed = true;
+    m_remaining -= part.size();
+    data.remove_prefix(part.size());
+    if (m_remaining == 0)
+        finishFrame();
+    return size - data.size();
+}
+
+void FrameReader::dispatch(AbstractMessageHandler* handler) const
+{
+    if (!m_ready || !handler)
+        return;
+    if (m_decoded)
+        handler->onDecoded(m_message);
+    else
+        (*handler)(m_message);
+}
+
+void FrameReader::finishFrame()
+{
+    m_decoded = m_decoder.has_value();
+    if (m_decoder && !m_failed && m_decoder->finish(m_message) == std::string::npos)
+        m_failed = true;
+    m_decoder.reset();
+    m_executor.reset();
+    m_headerFilled = 0;
+    // Кадр, который не удалось расшифровать, пропускается, как и при расшифровке целого сообщения
+    m_ready = !m_failed;
+}
@@ -0,0 +1,74 @@
+#ifndef FRAMEREADER_H
+#define FRAMEREADER_H
+
+#include "../common.h"
+#include "../streamdecoder.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+class AbstractMessageHandler;
+class BaseEncoderExecutor;
+
+/*!
+ * \brief Разбор кадров TCP (длина uint32_t big-endian и данные) из частей потока произвольного размера.
+ *
+ * Части разбираются прямо в буфере приема транспорта и не собираются в целые кадры: если обработчик
+ * сообщений при получении заголовка кадра сообщает алгоритм шифрования (AbstractMessageHandler::streamExecutor()),
+ * каждая часть данных кадра сразу расшифровывается StreamDecoder в буфер сообщения; иначе данные
+ * копируются в буфер сообщения как есть.
+ */
+class FrameReader
+{
+    NON_COPYABLE(FrameReader)
+public:
+    /*!
+     * \brief Размер заголовка кадра (длины сообщения)
+     */
+    static constexpr size_t headerSize() { return sizeof(uint32_t); }
+    /*!
+     * \brief Наибольший размер сообщения
+     */
+    static constexpr size_t maxMessageSize() { return 16u << 20; }
+
+    FrameReader() = default;
+
+    /*!
+     * \brief Разобрать начало принятых данных \a data: до конца данных или до конца кадра.
+     * \param handler - обработчик, у которого при получении заголовка запрашивается алгоритм
+     * расшифровки кадра; nullptr - кадр не расшифровывается
+     * \return количество разобранных байтов; std::string::npos, если длина кадра больше maxMessageSize()
+     */
+    size_t consume(std::string_view data, AbstractMessageHandler* handler);
+    /*!
+     * \brief Кадр принят целиком; сообщение доступно до следующего вызова consume()
+     */
+    bool ready() const { return m_ready; }
+    /*!
+     * \brief Сообщение принятого кадра (расшифрованное, если кадр расшифровывался)
+     */
+    const std::string& message() const { return m_message; }
+    /*!
+     * \brief Передать принятый кадр обработчику \a handler: расшифрованный - в AbstractMessageHandler::onDecoded()
+     */
+    void dispatch(AbstractMessageHandler* handler) const;
+
+private:
+    void finishFrame();
+
+private:
+    char m_header[sizeof(uint32_t)] = {};
+    size_t m_headerFilled = 0;  ///< Принятая часть заголовка текущего кадра
+    size_t m_remaining = 0;     ///< Непринятая часть данных текущего кадра
+    bool m_ready = false;
+    bool m_decoded = false;     ///< Сообщение кадра расшифровано
+    bool m_failed = false;      ///< Ошибка расшифровки: кадр отбрасывается
+    std::shared_ptr<const BaseEncoderExecutor> m_executor; ///< Алгоритм расшифровки текущего кадра
+    std::optional<StreamDecoder> m_decoder;
+    std::string m_message;      ///< Буфер сообщения, передаваемого обработчику
+};
+
+#endif // FRAMEREADER_H
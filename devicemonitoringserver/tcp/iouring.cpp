@@ -0,0 +1,213 @@
+#include "iouring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int ioUringSetup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static int ioUringRegister(int fd, unsigned opcode, void* arg, unsigned argCount)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, argCount));
+}
+
+bool IoUring::isSupported()
+{
+    static const bool supported = [] {
+        IoUring ring(8);
+        if (!ring.valid() || !ring.setupBufferRing(0, 8, 64))
+            return false;
+        // Многоразовый recv появился вместе с IORING_OP_SEND_ZC (Linux 6.0)
+        std::vector<char> probeData(sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op), '\0');
+        auto* probe = reinterpret_cast<io_uring_probe*>(probeData.data());
+        if (ioUringRegister(ring.fd(), IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0)
+            return false;
+        for (const auto op : { IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_ASYNC_CANCEL, IORING_OP_SEND_ZC })
+        {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+                return false;
+        }
+        return true;
+    }();
+    return supported;
+}
+
+IoUring::IoUring(unsigned entries)
+{
+    // С DEFER_TASKRUN ядро откладывает завершение заявок до io_uring_enter(GETEVENTS): данные,
+    // пришедшие за итерацию цикла, принимаются одной порцией, а не в каждом системном вызове потока
+    io_uring_params params {};
+    for (const unsigned flags : { IORING_SETUP_SUBMIT_ALL | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN,
+                                  IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN, 0u })
+    {
+        params = {};
+        params.flags = IORING_SETUP_CQSIZE | flags;
+        params.cq_entries = 4 * entries;
+        m_fd = ioUringSetup(entries, &params);
+        if (m_fd >= 0)
+            break;
+    }
+    if (m_fd < 0)
+        return;
+    m_deferTaskRun = params.flags & IORING_SETUP_DEFER_TASKRUN;
+    if (m_deferTaskRun)
+    {
+        // Отложенные заявки не делают дескриптор кольца готовым к чтению, а eventfd ядро уведомляет
+        m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_eventFd < 0 || ioUringRegister(m_fd, IORING_REGISTER_EVENTFD, &m_eventFd, 1) != 0)
+        {
+            if (m_eventFd >= 0)
+                ::close(m_eventFd);
+            m_eventFd = -1;
+            ::close(m_fd);
+            m_fd = -1;
+            return;
+        }
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+        m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED)
+        m_sqRing = nullptr;
+    m_cqRing = singleMmap ? m_sqRing
+                          : mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+    if (m_cqRing == MAP_FAILED)
+        m_cqRing = nullptr;
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+    m_sqes = sqes != MAP_FAILED ? static_cast<io_uring_sqe*>(sqes) : nullptr;
+    if (!m_sqRing || !m_cqRing || !m_sqes)
+    {
+        unmap();
+        ::close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    auto* sq = static_cast<char*>(m_sqRing);
+    m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    m_sqFlags = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+    m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    m_sqLocalTail = *m_sqTail;
+    auto* cq = static_cast<char*>(m_cqRing);
+    m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+IoUring::~IoUring()
+{
+    if (m_fd >= 0)
+        ::close(m_fd);
+    if (m_eventFd >= 0)
+        ::close(m_eventFd);
+    unmap();
+    if (m_bufferRing)
+        munmap(m_bufferRing, m_bufferRingSize);
+}
+
+io_uring_sqe* IoUring::getSqe()
+{
+    if (m_fd < 0)
+        return nullptr;
+    if (m_sqLocalTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries)
+    {
+        submit();
+        if (m_sqLocalTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries)
+            return nullptr;
+    }
+    const unsigned index = m_sqLocalTail & m_sqMask;
+    io_uring_sqe* sqe = &m_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    m_sqArray[index] = index;
+    ++m_sqLocalTail;
+    return sqe;
+}
+
+int IoUring::submit(unsigned minComplete)
+{
+    if (m_fd < 0)
+        return -EBADF;
+    const unsigned toSubmit = m_sqLocalTail - *m_sqTail;
+    if (!toSubmit && !minComplete)
+        return 0;
+    __atomic_store_n(m_sqTail, m_sqLocalTail, __ATOMIC_RELEASE);
+    int result = 0;
+    do
+        result = ioUringEnter(m_fd, toSubmit, minComplete, minComplete ? IORING_ENTER_GETEVENTS : 0);
+    while (result < 0 && errno == EINTR);
+    return result < 0 ? -errno : result;
+}
+
+bool IoUring::setupBufferRing(uint16_t groupId, uint16_t count, uint32_t bufferSize)
+{
+    if (m_fd < 0 || m_bufferRing || !count || (count & (count - 1)) || count > 32768 || !bufferSize)
+        return false;
+    m_bufferRingSize = count * sizeof(io_uring_buf);
+    void* ring = mmap(nullptr, m_bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED)
+        return false;
+    io_uring_buf_reg reg {};
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+    reg.ring_entries = count;
+    reg.bgid = groupId;
+    if (ioUringRegister(m_fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+    {
+        munmap(ring, m_bufferRingSize);
+        return false;
+    }
+    m_bufferRing = static_cast<io_uring_buf*>(ring);
+    m_bufferMask = static_cast<uint16_t>(count - 1);
+    m_bufferSize = bufferSize;
+    m_buffers.resize(static_cast<size_t>(count) * bufferSize);
+    for (uint16_t id = 0; id < count; ++id)
+        recycleBuffer(id);
+    return true;
+}
+
+void IoUring::recycleBuffer(uint16_t id)
+{
+    io_uring_buf& buf = m_bufferRing[m_bufferTail & m_bufferMask];
+    buf.addr = reinterpret_cast<uint64_t>(buffer(id));
+    buf.len = m_bufferSize;
+    buf.bid = id;
+    __atomic_store_n(&m_bufferRing[0].resv, ++m_bufferTail, __ATOMIC_RELEASE);
+}
+
+void IoUring::unmap()
+{
+    if (m_sqes)
+        munmap(m_sqes, m_sqesSize);
+    if (m_cqRing && m_cqRing != m_sqRing)
+        munmap(m_cqRing, m_cqRingSize);
+    if (m_sqRing)
+        munmap(m_sqRing, m_sqRingSize);
+    m_sqes = nullptr;
+    m_cqRing = m_sqRing = nullptr;
+}
+
+void IoUring::getEvents()
+{
+    while (ioUringEnter(m_fd, 0, 0, IORING_ENTER_GETEVENTS) < 0 && errno == EINTR)
+        ;
+}
@@ -0,0 +1,155 @@
+#ifndef IOURING_H
+#define IOURING_H
+
+#include "../common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <vector>
+
+/*!
+ * \brief Кольцо io_uring на системных вызовах, без liburing.
+ *
+ * Заявки (SQE) накапливаются в общей с ядром памяти и передаются ядру одним вызовом submit().
+ * Результаты (CQE) читаются из общей памяти; о них сообщает notificationFd(), поэтому кольцо
+ * можно обслуживать через EventLoop.
+ * Кольцо предоставленных буферов (provided buffer ring) позволяет ядру самому выбирать буфер
+ * для приема данных, и многоразовой заявке на прием не нужен собственный буфер.
+ */
+class IoUring
+{
+    NON_COPYABLE(IoUring)
+public:
+    /*!
+     * \brief Ядро поддерживает все возможности, которые нужны IoUringConnectionServer:
+     * многоразовые accept и recv и кольцо предоставленных буферов (Linux 6.0+).
+     */
+    static bool isSupported();
+
+    /*!
+     * \brief Конструктор.
+     * \param entries - размер очереди заявок; очередь результатов вчетверо больше
+     */
+    explicit IoUring(unsigned entries);
+    ~IoUring();
+
+    /*!
+     * \brief Кольцо создано.
+     */
+    bool valid() const { return m_fd >= 0; }
+    /*!
+     * \brief Дескриптор кольца.
+     */
+    int fd() const { return m_fd; }
+    /*!
+     * \brief Дескриптор для EventLoop (EPOLLET): сигнализирует о появлении результатов.
+     */
+    int notificationFd() const { return m_eventFd >= 0 ? m_eventFd : m_fd; }
+    /*!
+     * \brief Новая обнуленная заявка.
+     *
+     * Если очередь заполнена, накопленные заявки сначала передаются ядру.
+     * \return nullptr, если место в очереди не освободилось
+     */
+    io_uring_sqe* getSqe();
+    /*!
+     * \brief Передать ядру накопленные заявки.
+     * \param minComplete - дождаться стольких результатов
+     * \return количество принятых заявок или -errno
+     */
+    int submit(unsigned minComplete = 0);
+    /*!
+     * \brief Обработать все готовые результаты.
+     *
+     * Результат освобождается в очереди до вызова обработчика, поэтому обработчик может создавать
+     * новые заявки.
+     * \param handler - функтор void(const io_uring_cqe&)
+     * \return количество обработанных результатов
+     */
+    template <class Handler>
+    size_t processCompletions(Handler&& handler);
+
+    /*!
+     * \brief Зарегистрировать кольцо предоставленных буферов.
+     * \param groupId - идентификатор группы буферов для заявок с IOSQE_BUFFER_SELECT
+     * \param count - количество буферов, степень двойки
+     * \param bufferSize - размер буфера
+     */
+    bool setupBufferRing(uint16_t groupId, uint16_t count, uint32_t bufferSize);
+    /*!
+     * \brief Буфер с номером \a id.
+     */
+    const char* buffer(uint16_t id) const { return m_buffers.data() + static_cast<size_t>(id) * m_bufferSize; }
+    /*!
+     * \brief Вернуть буфер \a id ядру для приема следующих данных.
+     */
+    void recycleBuffer(uint16_t id);
+
+private:
+    void unmap();
+    /*!
+     * \brief Завершить отложенные заявки и перенести в очередь результаты, не поместившиеся в нее ранее.
+     */
+    void getEvents();
+
+private:
+    int m_fd = -1;
+    bool m_deferTaskRun = false; ///< Результаты появляются только после io_uring_enter(GETEVENTS)
+    int m_eventFd = -1;          ///< eventfd, зарегистрированный в кольце при m_deferTaskRun
+    void* m_sqRing = nullptr;
+    size_t m_sqRingSize = 0;
+    void* m_cqRing = nullptr;
+    size_t m_cqRingSize = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqesSize = 0;
+
+    unsigned* m_sqHead = nullptr;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqFlags = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_sqEntries = 0;
+    unsigned m_sqLocalTail = 0; ///< Хвост очереди заявок с учетом еще не переданных ядру
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    unsigned m_cqMask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+
+    // Кольцо адресуется как массив io_uring_buf: в C++ __DECLARE_FLEX_ARRAY смещает io_uring_buf_ring::bufs
+    io_uring_buf* m_bufferRing = nullptr; ///< Хвост кольца совмещен с полем resv первого элемента
+    size_t m_bufferRingSize = 0;
+    uint16_t m_bufferMask = 0;
+    uint16_t m_bufferTail = 0;
+    uint32_t m_bufferSize = 0;
+    std::vector<char> m_buffers;
+};
+
+template <class Handler>
+size_t IoUring::processCompletions(Handler&& handler)
+{
+    size_t count = 0;
+    if (m_deferTaskRun)
+        getEvents();
+    for (;;)
+    {
+        unsigned head = *m_cqHead;
+        const unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        if (head == tail)
+        {
+            if (!(__atomic_load_n(m_sqFlags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW))
+                return count;
+            getEvents();
+            continue;
+        }
+        while (head != tail)
+        {
+            const io_uring_cqe cqe = m_cqes[head & m_cqMask];
+            __atomic_store_n(m_cqHead, ++head, __ATOMIC_RELEASE);
+            handler(cqe);
+            ++count;
+        }
+    }
+}
+
+#endif // IOURING_H
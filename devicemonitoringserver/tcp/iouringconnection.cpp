@@ -0,0 +1,147 @@
+#include "iouringconnection.h"
+#include "../bigendian.h"
+#include "iouringconnectionserver.h"
+#include "tcpchannel.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractmessagehandler.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*!
+ * \brief Размер заголовка кадра (длины сообщения)
+ */
+static constexpr size_t headerSize = FrameReader::headerSize();
+
+IoUringConnection::IoUringConnection(IoUringConnectionServer* server, uint64_t token, int fd) :
+    m_server(server), m_token(token), m_fd(fd)
+{
+}
+
+IoUringConnection::~IoUringConnection()
+{
+    ::close(m_fd);
+    delete m_messageHandler;
+    delete m_disconnectedHandler;
+}
+
+void IoUringConnection::onReceived(const char* data, size_t size)
+{
+    std::string_view received(data, size);
+    while (!received.empty() && !m_closing)
+    {
+        // До идентификации кадр не расшифровывается
+        auto* handler = m_peerId ? m_messageHandler : nullptr;
+        const size_t processed = m_frameReader.consume(received, handler);
+        if (processed == std::string::npos)
+        {
+            close();
+            return;
+        }
+        received.remove_prefix(processed);
+        if (!m_frameReader.ready())
+            continue;
+        if (m_peerId)
+            m_frameReader.dispatch(m_messageHandler);
+        else
+            onIdentification(m_frameReader.message());
+    }
+}
+
+const std::string* IoUringConnection::takePendingData()
+{
+    m_sendScheduled = false;
+    if (m_sending || m_closing || m_pendingData.empty())
+        return nullptr;
+    // Буферы меняются местами, поэтому память обоих переиспользуется
+    m_sendingData.swap(m_pendingData);
+    m_pendingData.clear();
+    m_sentSize = 0;
+    m_sending = true;
+    return &m_sendingData;
+}
+
+size_t IoUringConnection::onSent(int32_t result)
+{
+    m_sending = false;
+    if (result < 0)
+    {
+        close();
+        return 0;
+    }
+    m_sentSize += static_cast<size_t>(result);
+    if (m_sentSize < m_sendingData.size() && !m_closing)
+    {
+        m_sending = true;
+        return m_sentSize;
+    }
+    m_sendingData.clear();
+    m_sentSize = 0;
+    return 0;
+}
+
+void IoUringConnection::close()
+{
+    if (m_closing)
+        return;
+    m_closing = true;
+    // Выполняемые заявки recv и send завершатся с ошибкой или концом потока
+    ::shutdown(m_fd, SHUT_RDWR);
+    m_server->onClosed(this);
+}
+
+void IoUringConnection::onDisconnected()
+{
+    if (m_peerId && m_disconnectedHandler)
+        (*m_disconnectedHandler)();
+    m_notified = true;
+    m_server->onDisconnected(this); // Может удалить соединение
+}
+
+void IoUringConnection::disconnect()
+{
+    // Данные, которые сокет не примет сразу, теряются
+    if (m_closing)
+        return;
+    m_server->sendNow(this);
+    close();
+}
+
+void IoUringConnection::sendMessage(const std::string& message)
+{
+    if (m_closing || message.size() > TcpChannel::maxMessageSize())
+        return;
+    char header[headerSize];
+    toBigEndian(header, static_cast<uint32_t>(message.size()));
+    m_pendingData.append(header, headerSize);
+    m_pendingData.append(message);
+    if (!m_sending && !m_sendScheduled)
+    {
+        m_sendScheduled = true;
+        m_server->scheduleSend(this);
+    }
+}
+
+void IoUringConnection::setMessageHandler(AbstractMessageHandler* handler)
+{
+    delete m_messageHandler;
+    m_messageHandler = handler;
+}
+
+void IoUringConnection::setDisconnectedHandler(AbstractAction* handler)
+{
+    delete m_disconnectedHandler;
+    m_disconnectedHandler = handler;
+}
+
+void IoUringConnection::onIdentification(const std::string& message)
+{
+    // Первый кадр - идентификатор клиента
+    if (message.size() == sizeof(uint64_t))
+        m_peerId = fromBigEndian<uint64_t>(message.data());
+    if (!m_server->onIdentified(this))
+    {
+        m_peerId = 0;
+        disconnect();
+    }
+}
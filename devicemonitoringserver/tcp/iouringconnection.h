@@ -0,0 +1,111 @@
+#ifndef IOURINGCONNECTION_H
+#define IOURINGCONNECTION_H
+
+#include "../common.h"
+#include "framereader.h"
+#include <server/abstractconnection.h>
+#include <servermock/object.h>
+
+#include <cstdint>
+#include <string>
+
+class AbstractAction;
+class AbstractMessageHandler;
+class IoUringConnectionServer;
+
+/*!
+ * \brief Принятое IoUringConnectionServer TCP-соединение с клиентом.
+ *
+ * Кадры те же, что у TcpChannel, и так же разбираются FrameReader прямо в буфере приема. Сообщения, отправленные за одну итерацию цикла событий,
+ * собираются в буфер и передаются ядру одной заявкой send. Пока заявка выполняется, буфер
+ * принадлежит ядру, поэтому после разрыва соединения объект живет, пока не завершатся
+ * все его заявки, и удаляется сервером.
+ */
+class IoUringConnection final : public AbstractConnection, public Object
+{
+    NON_COPYABLE(IoUringConnection)
+public:
+    /*!
+     * \brief Конструктор.
+     * \param token - метка заявок соединения
+     * \param fd - принятый сокет; закрывается соединением
+     */
+    IoUringConnection(IoUringConnectionServer* server, uint64_t token, int fd);
+    ~IoUringConnection() final;
+
+    uint64_t token() const { return m_token; }
+    int fd() const { return m_fd; }
+    /*!
+     * \brief Соединение закрывается или закрыто.
+     */
+    bool closing() const { return m_closing; }
+    /*!
+     * \brief Все заявки соединения завершены и сервер сообщил о разрыве: объект можно удалить.
+     */
+    bool finished() const { return m_closing && m_notified && !m_receiving && !m_sending; }
+
+    /*!
+     * \brief Обработать принятые данные.
+     */
+    void onReceived(const char* data, size_t size);
+    /*!
+     * \brief Многоразовая заявка на прием запущена (\a active == true) или завершилась.
+     */
+    void setReceiving(bool active) { m_receiving = active; }
+    bool receiving() const { return m_receiving; }
+    /*!
+     * \brief Данные для следующей заявки send.
+     * \return nullptr, если отправлять нечего или заявка уже выполняется
+     */
+    const std::string* takePendingData();
+    /*!
+     * \brief Буфер выполняемой заявки send.
+     */
+    const std::string* sendingData() const { return &m_sendingData; }
+    /*!
+     * \brief Обработать результат заявки send.
+     * \return смещение неотправленного остатка буфера заявки; 0 - буфер отправлен
+     */
+    size_t onSent(int32_t result);
+    /*!
+     * \brief Закрыть соединение (shutdown), не дожидаясь отправки данных.
+     */
+    void close();
+    /*!
+     * \brief Сообщить о разрыве соединения; вызывается сервером один раз.
+     */
+    void onDisconnected();
+
+    // AbstractConnection interface
+    uint64_t peerId() const final { return m_peerId; }
+    bool connected() const final { return m_peerId && !m_closing; }
+    void disconnect() final;
+    void sendMessage(const std::string& message) final;
+    void setMessageHandler(AbstractMessageHandler* handler) final;
+    void setDisconnectedHandler(AbstractAction* handler) final;
+
+private:
+    /*!
+     * \brief Обработать первый кадр - идентификатор клиента.
+     */
+    void onIdentification(const std::string& message);
+
+private:
+    IoUringConnectionServer* m_server = nullptr;
+    uint64_t m_token = 0;
+    int m_fd = -1;
+    uint64_t m_peerId = 0; ///< Идентификатор клиента; 0 - еще не получен
+    bool m_closing = false;
+    bool m_notified = false;  ///< Сервер сообщил о разрыве
+    bool m_receiving = false; ///< Выполняется заявка recv
+    bool m_sending = false;   ///< Выполняется заявка send
+    bool m_sendScheduled = false; ///< Соединение в очереди на отправку сервера
+    FrameReader m_frameReader;
+    std::string m_pendingData; ///< Кадры для следующей заявки send
+    std::string m_sendingData; ///< Буфер выполняемой заявки send
+    size_t m_sentSize = 0;     ///< Отправленная часть m_sendingData
+    AbstractMessageHandler* m_messageHandler = nullptr;
+    AbstractAction* m_disconnectedHandler = nullptr;
+};
+
+#endif // IOURINGCONNECTION_H
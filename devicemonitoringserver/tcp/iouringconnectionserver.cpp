@@ -0,0 +1,408 @@
+#include "iouringconnectionserver.h"
+#include "iouringconnection.h"
+#include "tcpconnectionserver.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractnewconnectionhandler.h>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+
+/*!
+ * \brief Размер очереди заявок
+ */
+constexpr unsigned ringEntries = 256;
+/*!
+ * \brief Группа предоставленных буферов для приема
+ */
+constexpr uint16_t bufferGroup = 0;
+constexpr uint16_t bufferCount = 128;
+constexpr uint32_t bufferSize = 32 * 1024;
+/*!
+ * \brief Разрядов метки заявки под операцию
+ */
+constexpr unsigned operationBits = 2;
+
+struct FlushAction final : public AbstractAction
+{
+    FlushAction(IoUringConnectionServer* server) :
+        m_server(server) {}
+
+    void operator()() final
+    {
+        auto* server = dynamic_cast<IoUringConnectionServer*>(m_server.data());
+        if (server)
+            server->flush();
+    }
+
+private:
+    SafeObjectPointer m_server;
+};
+
+struct DisconnectedAction final : public AbstractAction
+{
+    DisconnectedAction(IoUringConnection* connection) :
+        m_connection(connection) {}
+
+    void operator()() final
+    {
+        auto* connection = dynamic_cast<IoUringConnection*>(m_connection.data());
+        if (connection)
+            connection->onDisconnected();
+    }
+
+private:
+    SafeObjectPointer m_connection;
+};
+
+} // namespace
+
+IoUringConnectionServer::IoUringConnectionServer(EventLoop& eventLoop, std::string host) :
+    m_eventLoop(eventLoop), m_host(std::move(host)), m_ring(ringEntries),
+    m_identificationTimeout(TcpConnectionServer::defaultIdentificationTimeout()),
+    m_maxPendingConnections(TcpConnectionServer::defaultMaxPendingConnections()),
+    m_identificationTimer(eventLoop, new IdentificationTimeoutAction(this))
+{
+    if (m_ring.setupBufferRing(bufferGroup, bufferCount, bufferSize))
+        m_registered = m_eventLoop.add(m_ring.notificationFd(), EPOLLIN | EPOLLET, this);
+}
+
+IoUringConnectionServer::~IoUringConnectionServer()
+{
+    m_destroying = true;
+    delete m_newConnectionHandler;
+    m_newConnectionHandler = nullptr;
+    stopListening();
+    for (const auto& conn : m_tokens)
+        ::shutdown(conn.second->fd(), SHUT_RDWR);
+    // Буферы отправки принадлежат ядру, пока заявки не завершены: отменяем их и дожидаемся результатов
+    if (io_uring_sqe* sqe = prepare(0, Operation::Cancel))
+    {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+    }
+    m_ring.processCompletions([this](const io_uring_cqe& cqe) { onCompletion(cqe); });
+    while (m_activeOperations > 0 && m_ring.submit(1) >= 0)
+        m_ring.processCompletions([this](const io_uring_cqe& cqe) { onCompletion(cqe); });
+    for (const auto& conn : m_tokens)
+        delete conn.second;
+    if (m_registered)
+        m_eventLoop.remove(m_ring.notificationFd());
+}
+
+bool IoUringConnectionServer::listen(uint64_t serverId)
+{
+    if (!m_registered || m_listenFd >= 0 || !serverId || serverId > UINT16_MAX)
+        return false;
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(serverId));
+    if (inet_pton(AF_INET, m_host.c_str(), &address.sin_addr) != 1)
+        return false;
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    const int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if (m_reusePort)
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, SOMAXCONN) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    m_listenFd = fd;
+    ++m_listenGeneration;
+    m_serverId = serverId;
+    startAccept();
+    m_identificationTimer.start(m_identificationTimeout);
+    return true;
+}
+
+void IoUringConnectionServer::setIdentificationTimeout(int timeoutMs)
+{
+    m_identificationTimeout = timeoutMs > 0 ? timeoutMs : 0;
+    if (m_listenFd >= 0)
+        m_identificationTimer.start(m_identificationTimeout);
+}
+
+void IoUringConnectionServer::disconnect()
+{
+    for (const auto& conn : m_connections)
+        conn.second->disconnect();
+    for (const auto& conn : m_pendingConnections)
+        conn.first->disconnect();
+    stopListening();
+    m_serverId = 0;
+}
+
+void IoUringConnectionServer::setNewConnectionHandler(AbstractNewConnectionHandler* handler)
+{
+    delete m_newConnectionHandler;
+    m_newConnectionHandler = handler;
+}
+
+AbstractConnection* IoUringConnectionServer::connection(uint64_t clientId) const
+{
+    const auto it = m_connections.find(clientId);
+    return it != m_connections.cend() ? it->second : nullptr;
+}
+
+bool IoUringConnectionServer::onIdentified(IoUringConnection* connection)
+{
+    const uint64_t clientId = connection->peerId();
+    if (!clientId || m_connections.count(clientId) > 0 || !m_pendingConnections.erase(connection))
+        return false;
+    m_connections.insert({ clientId, connection });
+    if (m_newConnectionHandler)
+        (*m_newConnectionHandler)(connection);
+    return true;
+}
+
+void IoUringConnectionServer::onClosed(IoUringConnection* connection)
+{
+    if (!m_destroying)
+        m_eventLoop.post(new DisconnectedAction(connection));
+}
+
+void IoUringConnectionServer::onDisconnected(IoUringConnection* connection)
+{
+    const auto it = m_connections.find(connection->peerId());
+    if (it != m_connections.end() && it->second == connection)
+        m_connections.erase(it);
+    else
+        m_pendingConnections.erase(connection);
+    releaseIfFinished(connection);
+}
+
+void IoUringConnectionServer::scheduleSend(IoUringConnection* connection)
+{
+    m_sendQueue.push_back(connection->token());
+    if (!m_flushScheduled)
+    {
+        m_flushScheduled = true;
+        m_eventLoop.post(new FlushAction(this));
+    }
+}
+
+void IoUringConnectionServer::sendNow(IoUringConnection* connection)
+{
+    startSend(connection);
+    m_ring.submit();
+}
+
+void IoUringConnectionServer::flush()
+{
+    m_flushScheduled = false;
+    for (const uint64_t token : m_sendQueue)
+    {
+        const auto it = m_tokens.find(token);
+        if (it != m_tokens.end())
+            startSend(it->second);
+    }
+    m_sendQueue.clear();
+    m_ring.submit();
+}
+
+void IoUringConnectionServer::operator()(uint32_t /*events*/)
+{
+    m_ring.processCompletions([this](const io_uring_cqe& cqe) { onCompletion(cqe); });
+}
+
+void IoUringConnectionServer::onCompletion(const io_uring_cqe& cqe)
+{
+    const auto operation = static_cast<Operation>(cqe.user_data & ((1u << operationBits) - 1));
+    const uint64_t token = cqe.user_data >> operationBits;
+    if (operation == Operation::Cancel)
+        return;
+    // Многоразовая заявка продолжает работу, пока в результате есть IORING_CQE_F_MORE
+    if (operation == Operation::Send || !(cqe.flags & IORING_CQE_F_MORE))
+        --m_activeOperations;
+    if (operation == Operation::Accept)
+        return onAccepted(token, cqe.res, cqe.flags);
+
+    const auto it = m_tokens.find(token);
+    if (it == m_tokens.end())
+        return;
+    if (operation == Operation::Receive)
+        onReceived(it->second, cqe.res, cqe.flags);
+    else
+        onSent(it->second, cqe.res);
+}
+
+void IoUringConnectionServer::onAccepted(uint64_t generation, int32_t result, uint32_t flags)
+{
+    const bool current = generation == m_listenGeneration && m_listenFd >= 0 && !m_destroying;
+    if (!(flags & IORING_CQE_F_MORE))
+        m_accepting = false;
+    if (result >= 0)
+    {
+        if (!current)
+        {
+            ::close(result);
+            return;
+        }
+        if (m_maxPendingConnections && m_pendingConnections.size() >= m_maxPendingConnections)
+        {
+            // Прием продолжается: соединение освободит место, передав идентификатор или отключившись
+            ::close(result);
+        }
+        else
+        {
+            const int enable = 1;
+            setsockopt(result, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            auto* conn = new IoUringConnection(this, ++m_lastToken, result);
+            m_tokens.insert({ conn->token(), conn });
+            m_pendingConnections.insert({ conn, false });
+            startReceive(conn);
+        }
+    }
+    if (current && !m_accepting)
+        startAccept();
+}
+
+void IoUringConnectionServer::onReceived(IoUringConnection* connection, int32_t result, uint32_t flags)
+{
+    const bool more = flags & IORING_CQE_F_MORE;
+    if (!more)
+        connection->setReceiving(false);
+    if (result > 0 && (flags & IORING_CQE_F_BUFFER))
+    {
+        const auto id = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+        if (!connection->closing() && !m_destroying)
+            connection->onReceived(m_ring.buffer(id), static_cast<size_t>(result));
+        m_ring.recycleBuffer(id);
+    }
+    if (!more && !m_destroying)
+    {
+        // Закончились предоставленные буферы: после их возврата прием продолжается
+        if ((result > 0 || result == -ENOBUFS) && !connection->closing())
+            startReceive(connection);
+        else
+            connection->close();
+    }
+    releaseIfFinished(connection);
+}
+
+void IoUringConnectionServer::onSent(IoUringConnection* connection, int32_t result)
+{
+    const size_t offset = connection->onSent(result);
+    if (!m_destroying)
+        startSend(connection, offset);
+    releaseIfFinished(connection);
+}
+
+io_uring_sqe* IoUringConnectionServer::prepare(uint64_t token, Operation operation)
+{
+    io_uring_sqe* sqe = m_ring.getSqe();
+    if (!sqe)
+        return nullptr;
+    sqe->user_data = (token << operationBits) | static_cast<uint64_t>(operation);
+    if (operation != Operation::Cancel)
+        ++m_activeOperations;
+    if (!m_flushScheduled && !m_destroying)
+    {
+        m_flushScheduled = true;
+        m_eventLoop.post(new FlushAction(this));
+    }
+    return sqe;
+}
+
+void IoUringConnectionServer::startAccept()
+{
+    io_uring_sqe* sqe = prepare(m_listenGeneration, Operation::Accept);
+    if (!sqe)
+        return;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = m_listenFd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    m_accepting = true;
+}
+
+void IoUringConnectionServer::startReceive(IoUringConnection* connection)
+{
+    io_uring_sqe* sqe = prepare(connection->token(), Operation::Receive);
+    if (!sqe)
+        return connection->close();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = connection->fd();
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = bufferGroup;
+    connection->setReceiving(true);
+}
+
+void IoUringConnectionServer::startSend(IoUringConnection* connection, size_t offset)
+{
+    const std::string* data = offset ? connection->sendingData() : connection->takePendingData();
+    if (!data)
+        return;
+    io_uring_sqe* sqe = prepare(connection->token(), Operation::Send);
+    if (!sqe)
+    {
+        connection->onSent(-ENOMEM);
+        return;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = connection->fd();
+    sqe->addr = reinterpret_cast<uint64_t>(data->data() + offset);
+    sqe->len = static_cast<uint32_t>(data->size() - offset);
+    sqe->msg_flags = MSG_NOSIGNAL;
+}
+
+void IoUringConnectionServer::stopListening()
+{
+    if (m_listenFd < 0)
+        return;
+    // shutdown() завершает многоразовый accept; сокет закрывается сразу, кольцо держит свою ссылку
+    ::shutdown(m_listenFd, SHUT_RDWR);
+    ::close(m_listenFd);
+    m_listenFd = -1;
+    m_identificationTimer.stop();
+}
+
+void IoUringConnectionServer::closeUnidentifiedConnections()
+{
+    // Разрыв сообщается отложенно, поэтому соединения остаются в списке до конца обхода
+    for (auto& conn : m_pendingConnections)
+    {
+        if (conn.second)
+            conn.first->disconnect();
+        conn.second = true;
+    }
+}
+
+void IoUringConnectionServer::releaseIfFinished(IoUringConnection* connection)
+{
+    if (!connection->finished())
+        return;
+    m_tokens.erase(connection->token());
+    delete connection;
+}
+
+void IoUringConnectionServer::IdentificationTimeoutAction::operator()()
+{
+    m_server->closeUnidentifiedConnections();
+}
+
+AbstractConnectionServer* createTcpConnectionServer(EventLoop& eventLoop, std::string host, bool reusePort)
+{
+    if (IoUringConnectionServer::isSupported())
+    {
+        auto* server = new IoUringConnectionServer(eventLoop, std::move(host));
+        server->setReusePort(reusePort);
+        return server;
+    }
+    auto* server = new TcpConnectionServer(eventLoop, std::move(host));
+    server->setReusePort(reusePort);
+    return server;
+}
@@ -0,0 +1,167 @@
+#ifndef IOURINGCONNECTIONSERVER_H
+#define IOURINGCONNECTIONSERVER_H
+
+#include "../common.h"
+#include "eventloop.h"
+#include "iouring.h"
+#include "periodictimer.h"
+#include <handlers/abstractaction.h>
+#include <server/abstractconnectionserver.h>
+#include <servermock/object.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class IoUringConnection;
+
+/*!
+ * \brief Сервер для приема TCP-подключений на io_uring.
+ *
+ * Совместим с TcpConnectionServer по протоколу и поведению, но не делает системных вызовов
+ * на каждое сообщение: подключения принимаются многоразовой заявкой accept, данные - многоразовой
+ * заявкой recv в буферы из кольца предоставленных буферов, а заявки на отправку, созданные
+ * за итерацию цикла событий, передаются ядру одним вызовом io_uring_enter() в конце итерации.
+ * Кольцо обслуживается тем же EventLoop, что и остальные соединения.
+ * Неидентифицированные соединения ограничены так же, как в TcpConnectionServer.
+ */
+class IoUringConnectionServer final : public AbstractConnectionServer, public Object, private AbstractEventHandler
+{
+    NON_COPYABLE(IoUringConnectionServer)
+
+    struct IdentificationTimeoutAction final : public AbstractAction
+    {
+        IdentificationTimeoutAction(IoUringConnectionServer* server) :
+            m_server(server) {}
+        void operator()() final;
+
+    private:
+        IoUringConnectionServer* m_server = nullptr;
+    };
+
+public:
+    /*!
+     * \brief Ядро поддерживает io_uring в нужном объеме.
+     */
+    static bool isSupported() { return IoUring::isSupported(); }
+
+    /*!
+     * \brief Конструктор.
+     * \param host - IPv4-адрес для приема подключений
+     */
+    IoUringConnectionServer(EventLoop& eventLoop, std::string host = "127.0.0.1");
+    ~IoUringConnectionServer() final;
+
+    /*!
+     * \brief Разрешить нескольким серверам принимать подключения на одном порту (SO_REUSEPORT);
+     * ядро распределяет подключения между ними. Действует со следующего listen().
+     */
+    void setReusePort(bool enable) { m_reusePort = enable; }
+    /*!
+     * \brief См. TcpConnectionServer::setIdentificationTimeout()
+     */
+    void setIdentificationTimeout(int timeoutMs);
+    /*!
+     * \brief См. TcpConnectionServer::setMaxPendingConnections()
+     */
+    void setMaxPendingConnections(size_t count) { m_maxPendingConnections = count; }
+    /*!
+     * \brief Обработчик получения идентификатора клиента.
+     * \return false, если идентификатор недопустим
+     */
+    bool onIdentified(IoUringConnection* connection);
+    /*!
+     * \brief Обработчик закрытия соединения: запланировать сообщение о разрыве.
+     */
+    void onClosed(IoUringConnection* connection);
+    /*!
+     * \brief Обработчик сообщения о разрыве; соединение удаляется, когда завершатся его заявки.
+     */
+    void onDisconnected(IoUringConnection* connection);
+    /*!
+     * \brief Отправить данные соединения в конце итерации цикла событий.
+     */
+    void scheduleSend(IoUringConnection* connection);
+    /*!
+     * \brief Отправить данные соединения сразу (перед его закрытием).
+     */
+    void sendNow(IoUringConnection* connection);
+    /*!
+     * \brief Передать ядру накопленные заявки.
+     */
+    void flush();
+
+    // AbstractConnectionServer interface
+    uint64_t listenedId() const final { return m_serverId; }
+    bool listen(uint64_t serverId) final;
+    void disconnect() final;
+    void setNewConnectionHandler(AbstractNewConnectionHandler* handler) final;
+    AbstractConnection* connection(uint64_t clientId) const final;
+
+private:
+    enum class Operation : uint64_t
+    {
+        Accept,
+        Receive,
+        Send,
+        Cancel
+    };
+
+    void operator()(uint32_t events) final;
+    void onCompletion(const io_uring_cqe& cqe);
+    void onAccepted(uint64_t generation, int32_t result, uint32_t flags);
+    void onReceived(IoUringConnection* connection, int32_t result, uint32_t flags);
+    void onSent(IoUringConnection* connection, int32_t result);
+    /*!
+     * \brief Новая заявка с меткой \a token и операцией \a operation; nullptr, если очередь заполнена
+     */
+    io_uring_sqe* prepare(uint64_t token, Operation operation);
+    void startAccept();
+    void startReceive(IoUringConnection* connection);
+    /*!
+     * \brief Начать отправку буфера соединения с позиции \a offset или новых данных
+     */
+    void startSend(IoUringConnection* connection, size_t offset = 0);
+    void stopListening();
+    void closeUnidentifiedConnections();
+    /*!
+     * \brief Удалить соединение, если его заявки завершены
+     */
+    void releaseIfFinished(IoUringConnection* connection);
+
+private:
+    EventLoop& m_eventLoop;
+    std::string m_host;
+    bool m_reusePort = false;
+    IoUring m_ring;
+    bool m_registered = false;      ///< Кольцо обслуживается m_eventLoop
+    bool m_flushScheduled = false;  ///< Передача заявок запланирована на конец итерации
+    bool m_destroying = false;
+    uint64_t m_serverId = 0;
+    int m_listenFd = -1;
+    uint64_t m_listenGeneration = 0; ///< Номер вызова listen(): результаты прошлых accept отбрасываются
+    bool m_accepting = false;
+    size_t m_activeOperations = 0;   ///< Заявки, результат которых еще не получен
+    uint64_t m_lastToken = 0;
+    std::unordered_map<uint64_t, IoUringConnection*> m_tokens; ///< Все соединения, включая закрытые с незавершенными заявками
+    std::unordered_map<uint64_t, IoUringConnection*> m_connections;
+    /*!
+     * \brief Соединения, клиент которых еще не передал идентификатор;
+     * значение - соединение уже пережило срабатывание таймера
+     */
+    std::unordered_map<IoUringConnection*, bool> m_pendingConnections;
+    int m_identificationTimeout = 0;
+    size_t m_maxPendingConnections = 0;
+    PeriodicTimer m_identificationTimer;
+    std::vector<uint64_t> m_sendQueue; ///< Метки соединений с данными для отправки
+    AbstractNewConnectionHandler* m_newConnectionHandler = nullptr;
+};
+
+/*!
+ * \brief Создать TCP-сервер: IoUringConnectionServer, если ядро поддерживает io_uring, иначе TcpConnectionServer.
+ * \param reusePort - см. TcpConnectionServer::setReusePort()
+ * \return владеющий указатель
+ */
+AbstractConnectionServer* createTcpConnectionServer(EventLoop& eventLoop, std::string host = "127.0.0.1", bool reusePort = false);
+
+#endif // IOURINGCONNECTIONSERVER_H
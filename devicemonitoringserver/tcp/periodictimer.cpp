@@ -0,0 +1,61 @@
+#include "periodictimer.h"
+#include <handlers/abstractaction.h>
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+PeriodicTimer::PeriodicTimer(EventLoop& eventLoop, AbstractAction* action) :
+    m_eventLoop(eventLoop), m_action(action)
+{
+}
+
+PeriodicTimer::~PeriodicTimer()
+{
+    stop();
+    delete m_action;
+}
+
+bool PeriodicTimer::start(int periodMs)
+{
+    if (periodMs <= 0)
+    {
+        stop();
+        return true;
+    }
+    if (m_fd < 0)
+    {
+        const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd < 0)
+            return false;
+        if (!m_eventLoop.add(fd, EPOLLIN, this))
+        {
+            ::close(fd);
+            return false;
+        }
+        m_fd = fd;
+    }
+    itimerspec period {};
+    period.it_interval.tv_sec = periodMs / 1000;
+    period.it_interval.tv_nsec = (periodMs % 1000) * 1000000L;
+    period.it_value = period.it_interval;
+    return timerfd_settime(m_fd, 0, &period, nullptr) == 0;
+}
+
+void PeriodicTimer::stop()
+{
+    if (m_fd < 0)
+        return;
+    m_eventLoop.remove(m_fd);
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+void PeriodicTimer::operator()(uint32_t /*events*/)
+{
+    uint64_t expirations = 0;
+    if (::read(m_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return;
+    if (m_action)
+        (*m_action)();
+}
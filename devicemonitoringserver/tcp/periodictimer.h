@@ -0,0 +1,40 @@
+#ifndef PERIODICTIMER_H
+#define PERIODICTIMER_H
+
+#include "../common.h"
+#include "eventloop.h"
+
+class AbstractAction;
+
+/*!
+ * \brief Периодический таймер на timerfd, обслуживаемый EventLoop.
+ */
+class PeriodicTimer final : private AbstractEventHandler
+{
+    NON_COPYABLE(PeriodicTimer)
+public:
+    /*!
+     * \brief Конструктор.
+     * \param action - владеющий указатель на действие, выполняемое при каждом срабатывании
+     */
+    PeriodicTimer(EventLoop& eventLoop, AbstractAction* action);
+    ~PeriodicTimer() final;
+
+    /*!
+     * \brief Срабатывать каждые \a periodMs мс, первый раз - через \a periodMs мс; 0 - остановить.
+     * \return false, если таймер не удалось создать
+     */
+    bool start(int periodMs);
+    void stop();
+    bool active() const { return m_fd >= 0; }
+
+private:
+    void operator()(uint32_t events) final;
+
+private:
+    EventLoop& m_eventLoop;
+    AbstractAction* m_action = nullptr;
+    int m_fd = -1;
+};
+
+#endif // PERIODICTIMER_H
@@ -0,0 +1,205 @@
+#include "tcpchannel.h"
+#include "../bigendian.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractmessagehandler.h>
+
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace
+{
+
+/*!
+ * \brief Размер заголовка кадра (длины сообщения)
+ */
+constexpr size_t headerSize = FrameReader::headerSize();
+/*!
+ * \brief Размер буфера приема
+ */
+constexpr size_t readBufferSize = 64 * 1024;
+
+struct DisconnectedAction final : public AbstractAction
+{
+    DisconnectedAction(TcpChannel* channel) :
+        m_channel(channel) {}
+
+    void operator()() final
+    {
+        auto* channel = dynamic_cast<TcpChannel*>(m_channel.data());
+        if (channel)
+            channel->onDisconnected();
+    }
+
+private:
+    SafeObjectPointer m_channel;
+};
+
+} // namespace
+
+TcpChannel::TcpChannel(EventLoop& eventLoop, int fd, bool connecting) :
+    m_eventLoop(eventLoop), m_fd(fd), m_state(connecting ? State::Connecting : State::Connected)
+{
+    if (!m_eventLoop.add(m_fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, this))
+        close();
+}
+
+TcpChannel::~TcpChannel()
+{
+    if (m_fd >= 0)
+    {
+        m_eventLoop.remove(m_fd);
+        ::close(m_fd);
+    }
+}
+
+void TcpChannel::sendMessage(std::string_view message)
+{
+    if (!connected() || message.size() > maxMessageSize())
+        return;
+    char header[headerSize];
+    toBigEndian(header, static_cast<uint32_t>(message.size()));
+    if (m_writeBegin < m_writeBuffer.size())
+    {
+        // Сокет еще не принял предыдущие данные: остаток отправится по EPOLLOUT
+        m_writeBuffer.append(header, headerSize);
+        m_writeBuffer.append(message.data(), message.size());
+        return;
+    }
+
+    iovec parts[2] = { { header, headerSize }, { const_cast<char*>(message.data()), message.size() } };
+    msghdr msg {};
+    msg.msg_iov = parts;
+    msg.msg_iovlen = 2;
+    ssize_t sent = 0;
+    do
+        sent = ::sendmsg(m_fd, &msg, MSG_NOSIGNAL);
+    while (sent < 0 && errno == EINTR);
+    if (sent < 0)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return close();
+        sent = 0;
+    }
+    const size_t written = static_cast<size_t>(sent);
+    if (written == headerSize + message.size())
+        return;
+    m_writeBuffer.clear();
+    m_writeBegin = 0;
+    if (written < headerSize)
+        m_writeBuffer.append(header + written, headerSize - written);
+    const size_t messageWritten = written > headerSize ? written - headerSize : 0;
+    m_writeBuffer.append(message.data() + messageWritten, message.size() - messageWritten);
+}
+
+void TcpChannel::disconnect()
+{
+    // Данные, которые сокет не примет сразу, теряются
+    if (connected())
+        flush();
+    close();
+}
+
+void TcpChannel::onDisconnected()
+{
+    // Обработчик может удалить канал
+    if (m_disconnectedHandler)
+        (*m_disconnectedHandler)();
+}
+
+void TcpChannel::operator()(uint32_t events)
+{
+    if (m_state == State::Connecting)
+    {
+        int error = 0;
+        socklen_t size = sizeof(error);
+        if (getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &error, &size) != 0 || error || (events & (EPOLLERR | EPOLLHUP)))
+            return close();
+        if (!(events & EPOLLOUT))
+            return;
+        m_state = State::Connected;
+        if (m_connectedHandler)
+            (*m_connectedHandler)();
+    }
+    if ((events & EPOLLOUT) && connected() && !flush())
+        return;
+    if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && connected())
+        readAvailable();
+}
+
+void TcpChannel::readAvailable()
+{
+    if (m_readBuffer.empty())
+        m_readBuffer.resize(readBufferSize);
+    while (connected())
+    {
+        const ssize_t size = ::read(m_fd, &m_readBuffer[0], m_readBuffer.size());
+        if (size > 0)
+        {
+            if (!processFrames(std::string_view(m_readBuffer.data(), static_cast<size_t>(size))))
+                return;
+        }
+        else if (size == 0)
+            return close();
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return;
+        else if (errno != EINTR)
+            return close();
+    }
+}
+
+bool TcpChannel::processFrames(std::string_view data)
+{
+    while (!data.empty())
+    {
+        const size_t processed = m_frameReader.consume(data, m_messageHandler);
+        if (processed == std::string::npos)
+        {
+            close();
+            return false;
+        }
+        data.remove_prefix(processed);
+        m_frameReader.dispatch(m_messageHandler);
+        if (!connected())
+            return false;
+    }
+    return true;
+}
+
+bool TcpChannel::flush()
+{
+    while (m_writeBegin < m_writeBuffer.size())
+    {
+        const ssize_t size = ::send(m_fd, m_writeBuffer.data() + m_writeBegin, m_writeBuffer.size() - m_writeBegin, MSG_NOSIGNAL);
+        if (size > 0)
+            m_writeBegin += static_cast<size_t>(size);
+        else if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return true;
+        else if (size < 0 && errno == EINTR)
+            continue;
+        else
+        {
+            close();
+            return false;
+        }
+    }
+    m_writeBuffer.clear();
+    m_writeBegin = 0;
+    return true;
+}
+
+void TcpChannel::close()
+{
+    if (m_state == State::Closed)
+        return;
+    m_state = State::Closed;
+    if (m_fd >= 0)
+    {
+        m_eventLoop.remove(m_fd);
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_eventLoop.post(new DisconnectedAction(this));
+}
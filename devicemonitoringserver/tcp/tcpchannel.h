@@ -0,0 +1,115 @@
+#ifndef TCPCHANNEL_H
+#define TCPCHANNEL_H
+
+#include "eventloop.h"
+#include "framereader.h"
+#include <servermock/object.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class AbstractMessageHandler;
+class AbstractAction;
+
+/*!
+ * \brief Канал передачи сообщений по TCP-соединению.
+ *
+ * Сообщения передаются кадрами: длина (uint32_t, big-endian) и данные. Неблокирующий сокет
+ * обслуживается EventLoop в режиме edge-triggered: при каждом событии данные читаются
+ * и отправляются до EAGAIN. Буферы приема и отправки переиспользуются; сообщение пишется
+ * в буфер отправки, только если сокет не принял его сразу. Принятые данные разбираются
+ * FrameReader прямо в буфере приема, в том числе с расшифровкой по мере приема.
+ * Обработчик разрыва соединения вызывается отложенно через EventLoop, как в ConnectionChannel.
+ */
+class TcpChannel final : public Object, private AbstractEventHandler
+{
+    NON_COPYABLE(TcpChannel)
+public:
+    /*!
+     * \brief Наибольший размер сообщения; кадр большего размера разрывает соединение
+     */
+    static constexpr size_t maxMessageSize() { return FrameReader::maxMessageSize(); }
+
+    /*!
+     * \brief Конструктор.
+     * \param fd - неблокирующий сокет; закрывается каналом
+     * \param connecting - соединение еще устанавливается (неблокирующий connect())
+     */
+    TcpChannel(EventLoop& eventLoop, int fd, bool connecting);
+    ~TcpChannel() final;
+
+    /*!
+     * \brief Канал активен.
+     */
+    bool connected() const { return m_state == State::Connected; }
+    /*!
+     * \brief Отправить сообщение.
+     */
+    void sendMessage(std::string_view message);
+    /*!
+     * \brief Отправить оставшиеся данные и закрыть соединение.
+     */
+    void disconnect();
+    /*!
+     * \brief Установить обработчик события установки соединения.
+     * \param handler - невладеющий указатель на обработчик
+     */
+    void setConnectedHandler(AbstractAction* handler) { m_connectedHandler = handler; }
+    /*!
+     * \brief Установить обработчик события получения сообщения.
+     * \param handler - невладеющий указатель на обработчик
+     */
+    void setMessageHandler(AbstractMessageHandler* handler) { m_messageHandler = handler; }
+    /*!
+     * \brief Установить обработчик события разрыва соединения (или неудачного подключения).
+     * \param handler - невладеющий указатель на обработчик
+     */
+    void setDisconnectedHandler(AbstractAction* handler) { m_disconnectedHandler = handler; }
+    /*!
+     * \brief Сообщить о разрыве соединения.
+     */
+    void onDisconnected();
+
+private:
+    enum class State
+    {
+        Connecting,
+        Connected,
+        Closed
+    };
+
+    void operator()(uint32_t events) final;
+    /*!
+     * \brief Прочитать доступные данные и обработать полученные кадры.
+     */
+    void readAvailable();
+    /*!
+     * \brief Разобрать принятые данные \a data и передать принятые целиком кадры обработчику.
+     * \return false, если соединение закрыто
+     */
+    bool processFrames(std::string_view data);
+    /*!
+     * \brief Отправить данные из буфера отправки.
+     * \return false в случае ошибки
+     */
+    bool flush();
+    /*!
+     * \brief Закрыть сокет и запланировать вызов обработчика разрыва соединения.
+     */
+    void close();
+
+private:
+    EventLoop& m_eventLoop;
+    int m_fd = -1;
+    State m_state = State::Connecting;
+    std::string m_readBuffer;  ///< Буфер приема; данные разбираются сразу после чтения
+    FrameReader m_frameReader;
+    std::string m_writeBuffer; ///< Данные, не принятые сокетом: начиная с m_writeBegin
+    size_t m_writeBegin = 0;
+    AbstractAction* m_connectedHandler = nullptr;
+    AbstractMessageHandler* m_messageHandler = nullptr;
+    AbstractAction* m_disconnectedHandler = nullptr;
+};
+
+#endif // TCPCHANNEL_H
@@ -0,0 +1,136 @@
+#include "tcpclientconnection.h"
+#include "../bigendian.h"
+#include "tcpchannel.h"
+#include <handlers/abstractmessagehandler.h>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+TcpClientConnection::TcpClientConnection(EventLoop& eventLoop, std::string host) :
+    m_eventLoop(eventLoop),
+    m_host(std::move(host)),
+    m_channelConnectedHandler(this),
+    m_channelDisconnectedHandler(this)
+{
+}
+
+TcpClientConnection::~TcpClientConnection()
+{
+    delete m_channel;
+    delete m_messageHandler;
+    delete m_connectedHandler;
+    delete m_disconnectedHandler;
+}
+
+bool TcpClientConnection::bind(uint64_t clientId)
+{
+    if (!clientId || clientId == m_clientId || m_channel)
+        return false;
+    m_clientId = clientId;
+    return true;
+}
+
+bool TcpClientConnection::connectToHost(uint64_t serverId)
+{
+    if (!m_clientId || !serverId || serverId > UINT16_MAX || m_channel)
+        return false;
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(serverId));
+    if (inet_pton(AF_INET, m_host.c_str(), &address.sin_addr) != 1)
+        return false;
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    const int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 && errno != EINPROGRESS)
+    {
+        ::close(fd);
+        return false;
+    }
+    m_serverId = serverId;
+    m_wasConnected = false;
+    m_channel = new TcpChannel(m_eventLoop, fd, true);
+    m_channel->setConnectedHandler(&m_channelConnectedHandler);
+    m_channel->setMessageHandler(m_messageHandler);
+    m_channel->setDisconnectedHandler(&m_channelDisconnectedHandler);
+    return true;
+}
+
+void TcpClientConnection::setConnectedHandler(AbstractAction* handler)
+{
+    delete m_connectedHandler;
+    m_connectedHandler = handler;
+}
+
+uint64_t TcpClientConnection::peerId() const
+{
+    return connected() ? m_serverId : 0;
+}
+
+bool TcpClientConnection::connected() const
+{
+    return m_channel && m_channel->connected();
+}
+
+void TcpClientConnection::disconnect()
+{
+    if (m_channel)
+        m_channel->disconnect();
+}
+
+void TcpClientConnection::sendMessage(const std::string& message)
+{
+    if (m_channel)
+        m_channel->sendMessage(message);
+}
+
+void TcpClientConnection::setMessageHandler(AbstractMessageHandler* handler)
+{
+    delete m_messageHandler;
+    m_messageHandler = handler;
+    if (m_channel)
+        m_channel->setMessageHandler(m_messageHandler);
+}
+
+void TcpClientConnection::setDisconnectedHandler(AbstractAction* handler)
+{
+    delete m_disconnectedHandler;
+    m_disconnectedHandler = handler;
+}
+
+void TcpClientConnection::onConnected()
+{
+    m_wasConnected = true;
+    char clientId[sizeof(uint64_t)];
+    toBigEndian(clientId, m_clientId);
+    m_channel->sendMessage(std::string_view(clientId, sizeof(clientId)));
+    if (m_connectedHandler)
+        (*m_connectedHandler)();
+}
+
+void TcpClientConnection::onDisconnected()
+{
+    // Канал удаляется до вызова обработчика, чтобы из него можно было подключиться снова
+    const bool wasConnected = m_wasConnected;
+    delete m_channel;
+    m_channel = nullptr;
+    m_wasConnected = false;
+    if (wasConnected && m_disconnectedHandler)
+        (*m_disconnectedHandler)();
+}
+
+void TcpClientConnection::ConnectedHandler::operator()()
+{
+    m_client->onConnected();
+}
+
+void TcpClientConnection::DisconnectedHandler::operator()()
+{
+    m_client->onDisconnected();
+}
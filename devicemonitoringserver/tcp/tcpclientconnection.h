@@ -0,0 +1,82 @@
+#ifndef TCPCLIENTCONNECTION_H
+#define TCPCLIENTCONNECTION_H
+
+#include "../common.h"
+#include <handlers/abstractaction.h>
+#include <server/abstractclientconnection.h>
+
+#include <string>
+
+class EventLoop;
+class TcpChannel;
+
+/*!
+ * \brief Клиент для подключения к TcpConnectionServer.
+ *
+ * Идентификатор сервера - номер TCP-порта. После установки соединения клиент первым кадром
+ * передает серверу свой идентификатор, затем вызывает обработчик установки соединения.
+ */
+class TcpClientConnection final : public AbstractClientConnection
+{
+    NON_COPYABLE(TcpClientConnection)
+
+    struct ConnectedHandler final : public AbstractAction
+    {
+        ConnectedHandler(TcpClientConnection* client) :
+            m_client(client) {}
+        void operator()() final;
+
+    private:
+        TcpClientConnection* m_client = nullptr;
+    };
+    struct DisconnectedHandler final : public AbstractAction
+    {
+        DisconnectedHandler(TcpClientConnection* client) :
+            m_client(client) {}
+        void operator()() final;
+
+    private:
+        TcpClientConnection* m_client = nullptr;
+    };
+
+public:
+    /*!
+     * \brief Конструктор.
+     * \param host - IPv4-адрес сервера
+     */
+    TcpClientConnection(EventLoop& eventLoop, std::string host = "127.0.0.1");
+    ~TcpClientConnection() final;
+
+    // AbstractClientConnection interface
+    uint64_t bindedId() const final { return m_clientId; }
+    bool bind(uint64_t clientId) final;
+    bool connectToHost(uint64_t serverId) final;
+    void setConnectedHandler(AbstractAction* handler) final;
+
+    // AbstractConnection interface
+    uint64_t peerId() const final;
+    bool connected() const final;
+    void disconnect() final;
+    void sendMessage(const std::string& message) final;
+    void setMessageHandler(AbstractMessageHandler* handler) final;
+    void setDisconnectedHandler(AbstractAction* handler) final;
+
+private:
+    void onConnected();
+    void onDisconnected();
+
+private:
+    EventLoop& m_eventLoop;
+    std::string m_host;
+    uint64_t m_clientId = 0;
+    uint64_t m_serverId = 0;
+    TcpChannel* m_channel = nullptr;
+    bool m_wasConnected = false; ///< Соединение было установлено (а не завершилось ошибкой подключения)
+    ConnectedHandler m_channelConnectedHandler;
+    DisconnectedHandler m_channelDisconnectedHandler;
+    AbstractMessageHandler* m_messageHandler = nullptr;
+    AbstractAction* m_connectedHandler = nullptr;
+    AbstractAction* m_disconnectedHandler = nullptr;
+};
+
+#endif // TCPCLIENTCONNECTION_H
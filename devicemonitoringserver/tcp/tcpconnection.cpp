@@ -0,0 +1,95 @@
+#include "tcpconnection.h"
+#include "../bigendian.h"
+#include "tcpconnectionserver.h"
+
+TcpConnection::TcpConnection(TcpConnectionServer* server, EventLoop& eventLoop, int fd) :
+    m_server(server),
+    m_channelMessageHandler(this),
+    m_channelDisconnectedHandler(this),
+    m_channel(eventLoop, fd, false)
+{
+    m_channel.setMessageHandler(&m_channelMessageHandler);
+    m_channel.setDisconnectedHandler(&m_channelDisconnectedHandler);
+}
+
+TcpConnection::~TcpConnection()
+{
+    delete m_messageHandler;
+    delete m_disconnectedHandler;
+}
+
+bool TcpConnection::connected() const
+{
+    return m_peerId && m_channel.connected();
+}
+
+void TcpConnection::disconnect()
+{
+    m_channel.disconnect();
+}
+
+void TcpConnection::sendMessage(const std::string& message)
+{
+    m_channel.sendMessage(message);
+}
+
+void TcpConnection::setMessageHandler(AbstractMessageHandler* handler)
+{
+    delete m_messageHandler;
+    m_messageHandler = handler;
+}
+
+void TcpConnection::setDisconnectedHandler(AbstractAction* handler)
+{
+    delete m_disconnectedHandler;
+    m_disconnectedHandler = handler;
+}
+
+void TcpConnection::onMessageReceived(const std::string& message)
+{
+    if (m_peerId)
+    {
+        if (m_messageHandler)
+            (*m_messageHandler)(message);
+        return;
+    }
+    // Первый кадр - идентификатор клиента
+    if (message.size() == sizeof(uint64_t))
+        m_peerId = fromBigEndian<uint64_t>(message.data());
+    if (!m_server->onIdentified(this))
+    {
+        m_peerId = 0;
+        m_channel.disconnect();
+    }
+}
+
+void TcpConnection::onDisconnected()
+{
+    if (m_peerId && m_disconnectedHandler)
+        (*m_disconnectedHandler)();
+    m_server->onDisconnected(this); // Удаляет соединение
+}
+
+void TcpConnection::MessageHandler::operator()(const std::string& message)
+{
+    m_conn->onMessageReceived(message);
+}
+
+std::shared_ptr<const BaseEncoderExecutor> TcpConnection::MessageHandler::streamExecutor()
+{
+    // Кадр с идентификатором клиента не шифруется
+    if (!m_conn->m_peerId || !m_conn->m_messageHandler)
+        return nullptr;
+    return m_conn->m_messageHandler->streamExecutor();
+}
+
+void TcpConnection::MessageHandler::onDecoded(const std::string& message)
+{
+    if (m_conn->m_messageHandler)
+        m_conn->m_messageHandler->onDecoded(message);
+}
+
+void TcpConnection::DisconnectedHandler::operator()()
+{
+    m_conn->onDisconnected();
+}
@@ -0,0 +1,71 @@
+#ifndef TCPCONNECTION_H
+#define TCPCONNECTION_H
+
+#include "../common.h"
+#include "tcpchannel.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractmessagehandler.h>
+#include <server/abstractconnection.h>
+
+class EventLoop;
+class TcpConnectionServer;
+
+/*!
+ * \brief Принятое сервером TCP-соединение с клиентом.
+ */
+class TcpConnection final : public AbstractConnection
+{
+    NON_COPYABLE(TcpConnection)
+
+    struct MessageHandler final : public AbstractMessageHandler
+    {
+        MessageHandler(TcpConnection* conn) :
+            m_conn(conn) {}
+        void operator()(const std::string& message) final;
+        std::shared_ptr<const BaseEncoderExecutor> streamExecutor() final;
+        void onDecoded(const std::string& message) final;
+
+    private:
+        TcpConnection* m_conn = nullptr;
+    };
+    struct DisconnectedHandler final : public AbstractAction
+    {
+        DisconnectedHandler(TcpConnection* conn) :
+            m_conn(conn) {}
+        void operator()() final;
+
+    private:
+        TcpConnection* m_conn = nullptr;
+    };
+
+public:
+    /*!
+     * \brief Конструктор.
+     * \param fd - принятый неблокирующий сокет
+     */
+    TcpConnection(TcpConnectionServer* server, EventLoop& eventLoop, int fd);
+    ~TcpConnection() final;
+
+    // AbstractConnection interface
+    uint64_t peerId() const final { return m_peerId; }
+    bool connected() const final;
+    void disconnect() final;
+    void sendMessage(const std::string& message) final;
+    void setMessageHandler(AbstractMessageHandler* handler) final;
+    void setDisconnectedHandler(AbstractAction* handler) final;
+
+private:
+    void onMessageReceived(const std::string& message);
+    void onDisconnected();
+
+private:
+    TcpConnectionServer* m_server = nullptr;
+    uint64_t m_peerId = 0; ///< Идентификатор клиента; 0 - еще не получен
+    MessageHandler m_channelMessageHandler;
+    DisconnectedHandler m_channelDisconnectedHandler;
+    TcpChannel m_channel;
+    AbstractMessageHandler* m_messageHandler = nullptr;
+    AbstractAction* m_disconnectedHandler = nullptr;
+};
+
+#endif // TCPCONNECTION_H
@@ -0,0 +1,159 @@
+#include "tcpconnectionserver.h"
+#include "tcpconnection.h"
+#include <handlers/abstractnewconnectionhandler.h>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+TcpConnectionServer::TcpConnectionServer(EventLoop& eventLoop, std::string host) :
+    m_eventLoop(eventLoop), m_host(std::move(host)), m_acceptHandler(this),
+    m_identificationTimer(eventLoop, new IdentificationTimeoutAction(this))
+{
+}
+
+TcpConnectionServer::~TcpConnectionServer()
+{
+    delete m_newConnectionHandler;
+    for (auto it = m_connections.cbegin(); it != m_connections.cend(); ++it)
+        delete it->second;
+    for (const auto& conn : m_pendingConnections)
+        delete conn.first;
+    if (m_listenFd >= 0)
+    {
+        m_eventLoop.remove(m_listenFd);
+        ::close(m_listenFd);
+    }
+}
+
+bool TcpConnectionServer::listen(uint64_t serverId)
+{
+    if (m_listenFd >= 0 || !serverId || serverId > UINT16_MAX)
+        return false;
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(serverId));
+    if (inet_pton(AF_INET, m_host.c_str(), &address.sin_addr) != 1)
+        return false;
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    const int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if (m_reusePort)
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, SOMAXCONN) != 0
+        || !m_eventLoop.add(fd, EPOLLIN | EPOLLET, &m_acceptHandler))
+    {
+        ::close(fd);
+        return false;
+    }
+    m_listenFd = fd;
+    m_serverId = serverId;
+    m_identificationTimer.start(m_identificationTimeout);
+    return true;
+}
+
+void TcpConnectionServer::setIdentificationTimeout(int timeoutMs)
+{
+    m_identificationTimeout = timeoutMs > 0 ? timeoutMs : 0;
+    if (m_listenFd >= 0)
+        m_identificationTimer.start(m_identificationTimeout);
+}
+
+void TcpConnectionServer::disconnect()
+{
+    for (const auto& conn : m_connections)
+        conn.second->disconnect();
+    for (const auto& conn : m_pendingConnections)
+        conn.first->disconnect();
+    m_identificationTimer.stop();
+    if (m_listenFd >= 0)
+    {
+        m_eventLoop.remove(m_listenFd);
+        ::close(m_listenFd);
+        m_listenFd = -1;
+    }
+    m_serverId = 0;
+}
+
+void TcpConnectionServer::setNewConnectionHandler(AbstractNewConnectionHandler* handler)
+{
+    delete m_newConnectionHandler;
+    m_newConnectionHandler = handler;
+}
+
+AbstractConnection* TcpConnectionServer::connection(uint64_t clientId) const
+{
+    const auto it = m_connections.find(clientId);
+    return it != m_connections.cend() ? it->second : nullptr;
+}
+
+bool TcpConnectionServer::onIdentified(TcpConnection* connection)
+{
+    const uint64_t clientId = connection->peerId();
+    if (!clientId || m_connections.count(clientId) > 0 || !m_pendingConnections.erase(connection))
+        return false;
+    m_connections.insert({ clientId, connection });
+    if (m_newConnectionHandler)
+        (*m_newConnectionHandler)(connection);
+    return true;
+}
+
+void TcpConnectionServer::onDisconnected(TcpConnection* connection)
+{
+    const auto it = m_connections.find(connection->peerId());
+    if (it != m_connections.end() && it->second == connection)
+        m_connections.erase(it);
+    else
+        m_pendingConnections.erase(connection);
+    delete connection;
+}
+
+void TcpConnectionServer::acceptConnections()
+{
+    while (m_listenFd >= 0)
+    {
+        const int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return; // EAGAIN или нехватка ресурсов: остальные подключения ждут следующего события
+        }
+        // Сообщения короткие: отправляем без задержки на накопление
+        if (m_maxPendingConnections && m_pendingConnections.size() >= m_maxPendingConnections)
+        {
+            ::close(fd);
+            continue;
+        }
+        const int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        m_pendingConnections.insert({ new TcpConnection(this, m_eventLoop, fd), false });
+    }
+}
+
+void TcpConnectionServer::closeUnidentifiedConnections()
+{
+    // Разрыв сообщается отложенно, поэтому соединения остаются в списке до конца обхода
+    for (auto& conn : m_pendingConnections)
+    {
+        if (conn.second)
+            conn.first->disconnect();
+        conn.second = true;
+    }
+}
+
+void TcpConnectionServer::AcceptHandler::operator()(uint32_t /*events*/)
+{
+    m_server->acceptConnections();
+}
+
+void TcpConnectionServer::IdentificationTimeoutAction::operator()()
+{
+    m_server->closeUnidentifiedConnections();
+}
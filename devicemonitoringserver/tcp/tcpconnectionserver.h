@@ -0,0 +1,120 @@
+#ifndef TCPCONNECTIONSERVER_H
+#define TCPCONNECTIONSERVER_H
+
+#include "../common.h"
+#include "eventloop.h"
+#include "periodictimer.h"
+#include <handlers/abstractaction.h>
+#include <server/abstractconnectionserver.h>
+
+#include <string>
+#include <unordered_map>
+
+class TcpConnection;
+
+/*!
+ * \brief Сервер для приема TCP-подключений.
+ *
+ * Идентификатор сервера - номер TCP-порта. Клиент (TcpClientConnection) первым кадром передает
+ * свой идентификатор (uint64_t, big-endian); только после этого соединение становится доступно
+ * через connection() и передается обработчику нового подключения. Соединение с нулевым или уже
+ * подключенным идентификатором разрывается, как и соединение, не передавшее идентификатор
+ * за время setIdentificationTimeout(). Подключения сверх setMaxPendingConnections() неидентифицированных
+ * закрываются сразу после приема.
+ */
+class TcpConnectionServer final : public AbstractConnectionServer
+{
+    NON_COPYABLE(TcpConnectionServer)
+
+    struct AcceptHandler final : public AbstractEventHandler
+    {
+        AcceptHandler(TcpConnectionServer* server) :
+            m_server(server) {}
+        void operator()(uint32_t events) final;
+
+    private:
+        TcpConnectionServer* m_server = nullptr;
+    };
+    struct IdentificationTimeoutAction final : public AbstractAction
+    {
+        IdentificationTimeoutAction(TcpConnectionServer* server) :
+            m_server(server) {}
+        void operator()() final;
+
+    private:
+        TcpConnectionServer* m_server = nullptr;
+    };
+
+public:
+    /*!
+     * \brief Время ожидания идентификатора клиента по умолчанию, мс
+     */
+    static constexpr int defaultIdentificationTimeout() { return 10 * 1000; }
+    /*!
+     * \brief Наибольшее количество неидентифицированных соединений по умолчанию
+     */
+    static constexpr size_t defaultMaxPendingConnections() { return 1024; }
+
+    /*!
+     * \brief Конструктор.
+     * \param host - IPv4-адрес для приема подключений
+     */
+    TcpConnectionServer(EventLoop& eventLoop, std::string host = "127.0.0.1");
+    ~TcpConnectionServer() final;
+
+    /*!
+     * \brief Разрешить нескольким серверам принимать подключения на одном порту (SO_REUSEPORT);
+     * ядро распределяет подключения между ними. Действует со следующего listen().
+     */
+    void setReusePort(bool enable) { m_reusePort = enable; }
+    /*!
+     * \brief Разрывать соединения, не передавшие идентификатор за \a timeoutMs мс;
+     * соединение разрывается через [timeoutMs, 2 * timeoutMs) после подключения.
+     * 0 - ждать идентификатор без ограничения.
+     */
+    void setIdentificationTimeout(int timeoutMs);
+    /*!
+     * \brief Ограничить количество соединений, ожидающих идентификатор; 0 - без ограничения.
+     */
+    void setMaxPendingConnections(size_t count) { m_maxPendingConnections = count; }
+    /*!
+     * \brief Обработчик получения идентификатора клиента.
+     * \return false, если идентификатор недопустим
+     */
+    bool onIdentified(TcpConnection* connection);
+    /*!
+     * \brief Обработчик закрытия соединения; удаляет соединение.
+     */
+    void onDisconnected(TcpConnection* connection);
+
+    // AbstractConnectionServer interface
+    uint64_t listenedId() const final { return m_serverId; }
+    bool listen(uint64_t serverId) final;
+    void disconnect() final;
+    void setNewConnectionHandler(AbstractNewConnectionHandler* handler) final;
+    AbstractConnection* connection(uint64_t clientId) const final;
+
+private:
+    void acceptConnections();
+    void closeUnidentifiedConnections();
+
+private:
+    EventLoop& m_eventLoop;
+    std::string m_host;
+    bool m_reusePort = false;
+    uint64_t m_serverId = 0;
+    int m_listenFd = -1;
+    AcceptHandler m_acceptHandler;
+    std::unordered_map<uint64_t, TcpConnection*> m_connections;
+    /*!
+     * \brief Соединения, клиент которых еще не передал идентификатор;
+     * значение - соединение уже пережило срабатывание таймера
+     */
+    std::unordered_map<TcpConnection*, bool> m_pendingConnections;
+    int m_identificationTimeout = defaultIdentificationTimeout();
+    size_t m_maxPendingConnections = defaultMaxPendingConnections();
+    PeriodicTimer m_identificationTimer;
+    AbstractNewConnectionHandler* m_newConnectionHandler = nullptr;
+};
+
+#endif // TCPCONNECTIONSERVER_H
@@ -0,0 +1,681 @@
+#include "tcptests.h"
+#include "../baseencoderexecutor.h"
+#include "../bigendian.h"
+#include "../executorregistry.h"
+#include "test_runner.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractmessagehandler.h>
+#include <handlers/abstractnewconnectionhandler.h>
+#include <tcp/eventloop.h>
+#include <tcp/iouringconnectionserver.h>
+#include <tcp/tcpchannel.h>
+#include <tcp/tcpclientconnection.h>
+#include <tcp/tcpconnectionserver.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+int allocationCounter = 0;
+
+/*!
+ * \brief Время ожидания событий, после которого цикл считается простаивающим, мс
+ */
+constexpr int idleTimeoutMs = 20;
+
+void processEvents(EventLoop& eventLoop)
+{
+    while (eventLoop.processEvents(idleTimeoutMs))
+        ;
+}
+
+class MessageListHandler : public AbstractMessageHandler
+{
+public:
+    MessageListHandler(std::vector<std::string>& messageList) :
+        m_messageList(messageList) { ++allocationCounter; }
+    ~MessageListHandler() { --allocationCounter; }
+
+    void operator()(const std::string& message) final
+    {
+        m_messageList.push_back(message);
+    }
+
+private:
+    std::vector<std::string>& m_messageList;
+};
+
+class DisconnectedHandler : public AbstractAction
+{
+public:
+    DisconnectedHandler(bool& disconnected) :
+        m_disconnected(disconnected) { ++allocationCounter; }
+    ~DisconnectedHandler() { --allocationCounter; }
+
+    void operator()() final
+    {
+        m_disconnected = true;
+    }
+
+private:
+    bool& m_disconnected;
+};
+
+struct EchoMessageHandler : public AbstractMessageHandler
+{
+    EchoMessageHandler(AbstractConnection* conn) :
+        m_conn(conn) { ++allocationCounter; }
+    ~EchoMessageHandler() { --allocationCounter; }
+
+private:
+    void operator()(const std::string& message) final
+    {
+        m_conn->sendMessage(message);
+    }
+
+private:
+    AbstractConnection* m_conn = nullptr;
+};
+
+class EchoNewConnectionHandler : public AbstractNewConnectionHandler
+{
+public:
+    EchoNewConnectionHandler() { ++allocationCounter; }
+    ~EchoNewConnectionHandler() { --allocationCounter; }
+
+private:
+    void operator()(AbstractConnection* conn) final
+    {
+        conn->setMessageHandler(new EchoMessageHandler(conn));
+    }
+};
+
+/*!
+ * \brief Обработчик, получающий сообщения расшифрованными транспортом; алгоритмы чередуются по сообщениям
+ */
+class StreamDecodingHandler : public AbstractMessageHandler
+{
+public:
+    StreamDecodingHandler(std::vector<std::string>& messageList) :
+        m_messageList(messageList) { ++allocationCounter; }
+    ~StreamDecodingHandler() { --allocationCounter; }
+
+    /*!
+     * \brief Алгоритм сообщения с номером \a index
+     */
+    static std::shared_ptr<const BaseEncoderExecutor> executor(size_t index)
+    {
+        return ExecutorRegistry::instance().find(index % 2 ? "Multiply41" : "Mirror");
+    }
+
+private:
+    void operator()(const std::string& message) final
+    {
+        m_messageList.push_back("raw:" + message);
+    }
+    std::shared_ptr<const BaseEncoderExecutor> streamExecutor() final
+    {
+        return executor(m_messageList.size());
+    }
+    void onDecoded(const std::string& message) final
+    {
+        m_messageList.push_back(message);
+    }
+
+private:
+    std::vector<std::string>& m_messageList;
+};
+
+class StreamDecodingNewConnectionHandler : public AbstractNewConnectionHandler
+{
+public:
+    StreamDecodingNewConnectionHandler(std::vector<std::string>& messageList) :
+        m_messageList(messageList) { ++allocationCounter; }
+    ~StreamDecodingNewConnectionHandler() { --allocationCounter; }
+
+private:
+    void operator()(AbstractConnection* conn) final
+    {
+        conn->setMessageHandler(new StreamDecodingHandler(m_messageList));
+    }
+
+private:
+    std::vector<std::string>& m_messageList;
+};
+
+/*!
+ * \brief Кадр с сообщением \a message
+ */
+std::string frame(const std::string& message)
+{
+    std::string result(sizeof(uint32_t), '\0');
+    toBigEndian(&result[0], static_cast<uint32_t>(message.size()));
+    return result + message;
+}
+
+/*!
+ * \brief Подключиться к локальному порту \a port блокирующим сокетом
+ */
+int connectRawSocket(uint64_t port)
+{
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*!
+ * \brief Сервер закрыл соединение сокета \a fd
+ */
+bool rawSocketClosed(int fd)
+{
+    char buffer[64];
+    ssize_t size = 0;
+    while ((size = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0)
+        ;
+    return size == 0;
+}
+
+} // namespace
+
+uint64_t tcpTestPort(size_t attempt)
+{
+    return 20000 + (static_cast<uint64_t>(getpid()) * 7 + attempt) % 30000;
+}
+
+void eventLoopTest()
+{
+    struct CountingAction : public AbstractAction
+    {
+        CountingAction(std::vector<int>& order, int id) :
+            m_order(order), m_id(id) { ++allocationCounter; }
+        ~CountingAction() { --allocationCounter; }
+
+        void operator()() final { m_order.push_back(m_id); }
+
+    private:
+        std::vector<int>& m_order;
+        int m_id = 0;
+    };
+    struct EventFdHandler : public AbstractEventHandler
+    {
+        EventFdHandler(int fd) :
+            m_fd(fd) {}
+
+        void operator()(uint32_t /*events*/) final
+        {
+            uint64_t value = 0;
+            if (read(m_fd, &value, sizeof(value)) == sizeof(value))
+                m_value += value;
+        }
+
+        int m_fd = -1;
+        uint64_t m_value = 0;
+    };
+
+    std::vector<int> order;
+    {
+        EventLoop eventLoop;
+        ASSERT(!eventLoop.processEvents(0));
+
+        eventLoop.post(new CountingAction(order, 1));
+        eventLoop.post(new CountingAction(order, 2));
+        ASSERT_EQUAL(allocationCounter, 2);
+        ASSERT(eventLoop.processEvents(-1)); // Отложенные действия не ждут событий
+        ASSERT_EQUAL(order, std::vector<int>({ 1, 2 }));
+        ASSERT_EQUAL(allocationCounter, 0);
+        ASSERT(!eventLoop.processEvents(0));
+
+        const int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        ASSERT(fd >= 0);
+        EventFdHandler handler(fd);
+        ASSERT(!eventLoop.add(fd, EPOLLIN, nullptr));
+        ASSERT(eventLoop.add(fd, EPOLLIN, &handler));
+        ASSERT(!eventLoop.add(fd, EPOLLIN, &handler));
+        ASSERT(!eventLoop.processEvents(0));
+        const uint64_t increment = 3;
+        ASSERT_EQUAL(write(fd, &increment, sizeof(increment)), static_cast<ssize_t>(sizeof(increment)));
+        ASSERT(eventLoop.processEvents(0));
+        ASSERT_EQUAL(handler.m_value, 3u);
+        ASSERT(!eventLoop.processEvents(0));
+
+        eventLoop.remove(fd);
+        ASSERT_EQUAL(write(fd, &increment, sizeof(increment)), static_cast<ssize_t>(sizeof(increment)));
+        ASSERT(!eventLoop.processEvents(0));
+        ASSERT_EQUAL(handler.m_value, 3u);
+        ::close(fd);
+
+        // Действия, не выполненные до удаления цикла, удаляются вместе с ним
+        eventLoop.post(new CountingAction(order, 3));
+        ASSERT_EQUAL(allocationCounter, 1);
+    }
+    ASSERT_EQUAL(order, std::vector<int>({ 1, 2 }));
+    ASSERT_EQUAL(allocationCounter, 0);
+}
+
+void eventLoopInvokeTest()
+{
+    // Действия удаляются в потоке цикла, поэтому allocationCounter не используется: утечки ловит LeakSanitizer
+    struct IncrementAction : public AbstractAction
+    {
+        IncrementAction(int& counter) :
+            m_counter(counter) {}
+
+        void operator()() final { ++m_counter; }
+
+    private:
+        int& m_counter;
+    };
+    struct QuitAction : public AbstractAction
+    {
+        QuitAction(EventLoop& eventLoop) :
+            m_eventLoop(eventLoop) {}
+
+        void operator()() final { m_eventLoop.quit(); }
+
+    private:
+        EventLoop& m_eventLoop;
+    };
+
+    int counter = 0;
+    {
+        EventLoop eventLoop;
+        std::thread thread([&eventLoop] { eventLoop.run(); });
+        // Действия выполняются в потоке цикла в порядке передачи: к выходу из run() выполнены все
+        for (int i = 0; i < 100; ++i)
+            eventLoop.invoke(new IncrementAction(counter));
+        eventLoop.invoke(new QuitAction(eventLoop));
+        thread.join();
+        ASSERT_EQUAL(counter, 100);
+
+        // quit() до run() не теряется
+        eventLoop.quit();
+        eventLoop.run();
+
+        eventLoop.invoke(new IncrementAction(counter));
+        ASSERT(eventLoop.processEvents(0));
+        ASSERT_EQUAL(counter, 101);
+
+        // Действия, не выполненные до удаления цикла, удаляются вместе с ним
+        eventLoop.invoke(new IncrementAction(counter));
+    }
+    ASSERT_EQUAL(counter, 101);
+}
+
+template <class Server>
+static void runClientServerTest()
+{
+    EventLoop eventLoop;
+
+    AbstractClientConnection* client = new TcpClientConnection(eventLoop);
+    AbstractConnectionServer* server = new Server(eventLoop);
+
+    std::ostringstream ostr;
+    class ClientMessageHandler : public AbstractMessageHandler
+    {
+    public:
+        ClientMessageHandler(std::ostream& out) :
+            m_out(out) { ++allocationCounter; }
+        ~ClientMessageHandler() { --allocationCounter; }
+
+    private:
+        void operator()(const std::string& message) final
+        {
+            m_out << message;
+        }
+
+    private:
+        std::ostream& m_out;
+    };
+    client->setMessageHandler(new ClientMessageHandler(ostr));
+
+    class ConnectedHandler : public AbstractAction
+    {
+    public:
+        ConnectedHandler(AbstractClientConnection* client) :
+            m_client(client) { ++allocationCounter; }
+        ~ConnectedHandler() { --allocationCounter; }
+
+    private:
+        void operator()() final
+        {
+            m_client->sendMessage("connection request");
+        }
+
+    private:
+        AbstractClientConnection* m_client = nullptr;
+    };
+    client->setConnectedHandler(new ConnectedHandler(client));
+
+    bool clientDisconnected = false;
+    client->setDisconnectedHandler(new DisconnectedHandler(clientDisconnected));
+
+    struct ServerMessageHandler : public AbstractMessageHandler
+    {
+        ServerMessageHandler(AbstractConnection* conn) :
+            m_conn(conn) { ++allocationCounter; }
+        ~ServerMessageHandler() { --allocationCounter; }
+
+    private:
+        void operator()(const std::string& message) final
+        {
+            std::ostringstream out;
+            out << "ECHO from " << std::to_string(m_conn->peerId()) << ": " << message;
+            m_conn->sendMessage(out.str());
+        }
+
+    private:
+        AbstractConnection* m_conn = nullptr;
+    };
+
+    class NewConnectionHandler : public AbstractNewConnectionHandler
+    {
+    public:
+        NewConnectionHandler(std::map<uint64_t, bool>& disconnected) :
+            m_disconnected(disconnected) { ++allocationCounter; }
+        ~NewConnectionHandler() { --allocationCounter; }
+
+    private:
+        void operator()(AbstractConnection* conn) final
+        {
+            conn->setMessageHandler(new ServerMessageHandler(conn));
+            conn->setDisconnectedHandler(new DisconnectedHandler(m_disconnected[conn->peerId()]));
+        }
+
+    private:
+        std::map<uint64_t, bool>& m_disconnected;
+    };
+    std::map<uint64_t, bool> serverDisconnected;
+    server->setNewConnectionHandler(new NewConnectionHandler(serverDisconnected));
+
+    const uint64_t clientId = 11;
+    ASSERT(!client->bind(0));
+    ASSERT(client->bind(clientId));
+    ASSERT(!client->bind(clientId));
+    ASSERT(!server->listen(0));
+    ASSERT(!server->listen(UINT16_MAX + 1));
+    const uint64_t serverId = listenOnTcpTestPort(*server);
+    ASSERT(serverId);
+    ASSERT(!server->listen(serverId));
+    ASSERT(!client->connectToHost(0));
+    ASSERT(client->connectToHost(serverId));
+    ASSERT(!client->connectToHost(serverId));
+
+    ASSERT(!client->connected());
+    ASSERT_EQUAL(client->peerId(), 0u);
+    ASSERT(!server->connection(clientId));
+    ASSERT_EQUAL(ostr.str(), "");
+    processEvents(eventLoop);
+    ASSERT(client->connected());
+    ASSERT_EQUAL(client->peerId(), serverId);
+    auto* serverConn = server->connection(clientId);
+    ASSERT(serverConn);
+    ASSERT(serverConn->connected());
+    ASSERT_EQUAL(serverConn->peerId(), clientId);
+    ASSERT_EQUAL(ostr.str(), "ECHO from 11: connection request");
+
+    // Второй клиент с тем же идентификатором отклоняется, первый остается подключенным
+    {
+        TcpClientConnection duplicate(eventLoop);
+        bool duplicateDisconnected = false;
+        duplicate.setDisconnectedHandler(new DisconnectedHandler(duplicateDisconnected));
+        ASSERT(duplicate.bind(clientId));
+        ASSERT(duplicate.connectToHost(serverId));
+        processEvents(eventLoop);
+        ASSERT(duplicateDisconnected);
+        ASSERT(!duplicate.connected());
+        ASSERT_EQUAL(server->connection(clientId), serverConn);
+        ASSERT(!serverDisconnected[clientId]);
+    }
+
+    ASSERT(!clientDisconnected);
+    ASSERT(!serverDisconnected[clientId]);
+    client->disconnect();
+    ASSERT(!clientDisconnected);
+    ASSERT(!serverDisconnected[clientId]);
+    processEvents(eventLoop);
+    ASSERT(clientDisconnected);
+    ASSERT(serverDisconnected[clientId]);
+    ASSERT(!client->connected());
+    ASSERT(!server->connection(clientId));
+
+    // Повторное подключение после разрыва
+    clientDisconnected = serverDisconnected[clientId] = false;
+    ostr.str("");
+    ASSERT(client->connectToHost(serverId));
+    processEvents(eventLoop);
+    ASSERT(client->connected());
+    ASSERT_EQUAL(ostr.str(), "ECHO from 11: connection request");
+    server->disconnect();
+    processEvents(eventLoop);
+    ASSERT(clientDisconnected);
+    ASSERT(serverDisconnected[clientId]);
+    ASSERT(!client->connected());
+
+    // Подключение к порту, который никто не слушает, не вызывает обработчик разрыва
+    clientDisconnected = false;
+    ASSERT(client->connectToHost(serverId));
+    processEvents(eventLoop);
+    ASSERT(!client->connected());
+    ASSERT(!clientDisconnected);
+
+    delete client;
+    delete server;
+    ASSERT_EQUAL(allocationCounter, 0);
+}
+
+template <class Server>
+static void runFramingTest()
+{
+    EventLoop eventLoop;
+    {
+        Server server(eventLoop);
+        server.setNewConnectionHandler(new EchoNewConnectionHandler);
+        const uint64_t serverId = listenOnTcpTestPort(server);
+        ASSERT(serverId);
+
+        TcpClientConnection client(eventLoop);
+        std::vector<std::string> received;
+        client.setMessageHandler(new MessageListHandler(received));
+        ASSERT(client.bind(1));
+        ASSERT(client.connectToHost(serverId));
+        processEvents(eventLoop);
+        ASSERT(client.connected());
+
+        // Сообщения больше буфера сокета отправляются по частям по EPOLLOUT
+        std::vector<std::string> sent = { "", "a", std::string(100000, 'b'), std::string(4u << 20, 'c') };
+        for (size_t i = 0; i < sent[3].size(); i += 4099)
+            sent[3][i] = static_cast<char>(i);
+        for (int i = 0; i < 1000; ++i)
+            sent.push_back(std::to_string(i));
+        sent.push_back(std::string(TcpChannel::maxMessageSize(), 'd'));
+        for (const auto& message : sent)
+            client.sendMessage(message);
+        // Сообщение больше допустимого не отправляется
+        client.sendMessage(std::string(TcpChannel::maxMessageSize() + 1, 'e'));
+        processEvents(eventLoop);
+        ASSERT(client.connected());
+        ASSERT_EQUAL(received.size(), sent.size());
+        ASSERT(received == sent);
+
+        // Соединение без идентификатора, с неверным идентификатором
+        // и с заголовком кадра больше допустимого разрывается сервером
+        char zeroId[sizeof(uint32_t) + sizeof(uint64_t)];
+        toBigEndian(zeroId, static_cast<uint32_t>(sizeof(uint64_t)));
+        toBigEndian(zeroId + sizeof(uint32_t), uint64_t(0));
+        char shortId[sizeof(uint32_t) + 1] = {};
+        toBigEndian(shortId, uint32_t(1));
+        char oversized[sizeof(uint32_t)];
+        toBigEndian(oversized, static_cast<uint32_t>(TcpChannel::maxMessageSize() + 1));
+        const std::vector<std::string> invalidHandshakes = { std::string(zeroId, sizeof(zeroId)),
+                                                             std::string(shortId, sizeof(shortId)),
+                                                             std::string(oversized, sizeof(oversized)) };
+        for (const auto& handshake : invalidHandshakes)
+        {
+            const int fd = connectRawSocket(serverId);
+            ASSERT(fd >= 0);
+            ASSERT_EQUAL(send(fd, handshake.data(), handshake.size(), MSG_NOSIGNAL), static_cast<ssize_t>(handshake.size()));
+            processEvents(eventLoop);
+            ASSERT(rawSocketClosed(fd));
+            ::close(fd);
+        }
+        ASSERT(client.connected());
+        ASSERT(server.connection(1));
+    }
+    processEvents(eventLoop);
+    ASSERT_EQUAL(allocationCounter, 0);
+}
+
+/*!
+ * \brief Кадры, пришедшие частями любого размера, расшифровываются по мере приема алгоритмом,
+ * который обработчик выбирает для каждого сообщения
+ */
+template <class Server>
+static void runStreamDecodingTest()
+{
+    EventLoop eventLoop;
+    {
+        Server server(eventLoop);
+        std::vector<std::string> received;
+        server.setNewConnectionHandler(new StreamDecodingNewConnectionHandler(received));
+        const uint64_t serverId = listenOnTcpTestPort(server);
+        ASSERT(serverId);
+
+        const std::vector<std::string> sent = { "", "a", "stream decoding", std::string(1000, 'x') + "end" };
+        char id[sizeof(uint64_t)];
+        toBigEndian(id, uint64_t(2));
+        std::string stream = frame(std::string(id, sizeof(id)));
+        for (size_t i = 0; i < sent.size(); ++i)
+            stream += frame(StreamDecodingHandler::executor(i)->encode(sent[i]));
+
+        const int fd = connectRawSocket(serverId);
+        ASSERT(fd >= 0);
+        // Части не совпадают ни с кадрами, ни с единицами шифрования
+        for (size_t offset = 0, part = 1; offset < stream.size(); offset += part, part = part % 7 + 1)
+        {
+            const size_t size = std::min(part, stream.size() - offset);
+            ASSERT_EQUAL(send(fd, stream.data() + offset, size, MSG_NOSIGNAL), static_cast<ssize_t>(size));
+            eventLoop.processEvents(idleTimeoutMs);
+        }
+        processEvents(eventLoop);
+        ASSERT(received == sent);
+        ASSERT(server.connection(2));
+        ::close(fd);
+        processEvents(eventLoop);
+    }
+    processEvents(eventLoop);
+    ASSERT_EQUAL(allocationCounter, 0);
+}
+
+/*!
+ * \brief Соединения сверх предела неидентифицированных закрываются сразу,
+ * а не передавшие идентификатор - по истечении времени ожидания
+ */
+template <class Server>
+static void runPendingConnectionsTest()
+{
+    EventLoop eventLoop;
+    {
+        constexpr int timeoutMs = 50;
+        Server server(eventLoop);
+        server.setNewConnectionHandler(new EchoNewConnectionHandler);
+        server.setIdentificationTimeout(timeoutMs);
+        server.setMaxPendingConnections(2);
+        const uint64_t serverId = listenOnTcpTestPort(server);
+        ASSERT(serverId);
+
+        std::vector<int> silent;
+        for (int i = 0; i < 3; ++i)
+        {
+            silent.push_back(connectRawSocket(serverId));
+            ASSERT(silent.back() >= 0);
+            processEvents(eventLoop);
+        }
+        ASSERT(!rawSocketClosed(silent[0]));
+        ASSERT(!rawSocketClosed(silent[1]));
+        ASSERT(rawSocketClosed(silent[2]));
+
+        bool closed = false;
+        for (int waitedMs = 0; waitedMs < 100 * timeoutMs && !closed; waitedMs += idleTimeoutMs)
+        {
+            eventLoop.processEvents(idleTimeoutMs);
+            closed = rawSocketClosed(silent[0]) && rawSocketClosed(silent[1]);
+        }
+        ASSERT(closed);
+
+        // Закрытые соединения освобождают место; идентифицированный клиент не ограничен временем ожидания
+        TcpClientConnection client(eventLoop);
+        ASSERT(client.bind(1));
+        ASSERT(client.connectToHost(serverId));
+        for (int waitedMs = 0; waitedMs < 3 * timeoutMs; waitedMs += idleTimeoutMs)
+            eventLoop.processEvents(idleTimeoutMs);
+        processEvents(eventLoop);
+        ASSERT(client.connected());
+        ASSERT(server.connection(1));
+        for (int fd : silent)
+            ::close(fd);
+    }
+    processEvents(eventLoop);
+    ASSERT_EQUAL(allocationCounter, 0);
+}
+
+void tcpClientServerTest()
+{
+    runClientServerTest<TcpConnectionServer>();
+}
+
+void tcpFramingTest()
+{
+    runFramingTest<TcpConnectionServer>();
+}
+
+void tcpStreamDecodingTest()
+{
+    runStreamDecodingTest<TcpConnectionServer>();
+}
+
+void tcpPendingConnectionsTest()
+{
+    runPendingConnectionsTest<TcpConnectionServer>();
+}
+
+void ioUringClientServerTest()
+{
+    if (!IoUringConnectionServer::isSupported())
+        return; // Сервер на epoll проверен в tcpClientServerTest
+    runClientServerTest<IoUringConnectionServer>();
+}
+
+void ioUringFramingTest()
+{
+    if (!IoUringConnectionServer::isSupported())
+        return;
+    runFramingTest<IoUringConnectionServer>();
+}
+
+void ioUringStreamDecodingTest()
+{
+    if (!IoUringConnectionServer::isSupported())
+        return;
+    runStreamDecodingTest<IoUringConnectionServer>();
+}
+
+void ioUringPendingConnectionsTest()
+{
+    if (!IoUringConnectionServer::isSupported())
+        return;
+    runPendingConnectionsTest<IoUringConnectionServer>();
+}
@@ -0,0 +1,70 @@
+#ifndef TCPTESTS_H
+#define TCPTESTS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*!
+ * \brief Порт для попытки \a attempt начать прием подключений в тестах.
+ *
+ * Порты зависят от идентификатора процесса, чтобы одновременно запущенные тесты не мешали друг другу.
+ */
+uint64_t tcpTestPort(size_t attempt);
+/*!
+ * \brief Начать прием подключений сервером \a server на свободном порту.
+ * \return номер порта; 0, если свободный порт не найден
+ */
+template <class Server>
+uint64_t listenOnTcpTestPort(Server& server)
+{
+    for (size_t attempt = 0; attempt < 100; ++attempt)
+    {
+        const uint64_t port = tcpTestPort(attempt);
+        if (server.listen(port))
+            return port;
+    }
+    return 0;
+}
+
+/*!
+ * \brief Тест цикла обработки событий.
+ */
+void eventLoopTest();
+/*!
+ * \brief Тест выполнения действий, переданных циклу из другого потока.
+ */
+void eventLoopInvokeTest();
+/*!
+ * \brief Тест TCP-клиента и TCP-сервера.
+ */
+void tcpClientServerTest();
+/*!
+ * \brief Тест передачи кадров: пустые, большие и идущие подряд сообщения, нарушения протокола.
+ */
+void tcpFramingTest();
+/*!
+ * \brief Тест расшифровки кадров по мере приема частями произвольного размера.
+ */
+void tcpStreamDecodingTest();
+/*!
+ * \brief Тест ограничения соединений, не передавших идентификатор: по количеству и по времени.
+ */
+void tcpPendingConnectionsTest();
+/*!
+ * \brief Тест TcpClientConnection с IoUringConnectionServer; пропускается, если ядро не поддерживает io_uring.
+ */
+void ioUringClientServerTest();
+/*!
+ * \brief Тест передачи кадров через IoUringConnectionServer.
+ */
+void ioUringFramingTest();
+/*!
+ * \brief Тест расшифровки кадров по мере приема через IoUringConnectionServer.
+ */
+void ioUringStreamDecodingTest();
+/*!
+ * \brief Тест ограничения неидентифицированных соединений IoUringConnectionServer.
+ */
+void ioUringPendingConnectionsTest();
+
+#endif // TCPTESTS_H
@@ -1,21 +1,52 @@
 #include "tests.h"
+#include "aes128ctrencoderexecutor.h"
+#include "bigendian.h"
 #include "commandcenter.h"
+#include "compositeencoderexecutor.h"
+#include "cpufeatures.h"
 #include "devicemock.h"
 #include "devicemonitoringserver.h"
+#include "devicedirectory.h"
 #include "deviceworkschedule.h"
 #include "dummyencoderexecutor.h"
+#include "executorregistry.h"
 #include "message.h"
+#include "messagebatch.h"
 #include "messagecommand.h"
 #include "messageencoder.h"
 #include "messageerror.h"
+#include "messagehandshake.h"
 #include "messagemeterage.h"
+#include "messagemeteragedelta.h"
+#include "messagemulticommand.h"
+#include "messagemultimeterage.h"
+#include "messagepipeline.h"
 #include "messageserializer.h"
+#include "streamdecoder.h"
+#include "messagevariant.h"
+#include "shardeddevicemonitoringserver.h"
 #include "test_runner.h"
+#include "varint.h"
 #include <servermock/clientconnectionmock.h>
 #include <servermock/connectionservermock.h>
 #include <servermock/taskqueue.h>
-
+#include <shm/shmclientconnection.h>
+#include <shm/shmconnectionserver.h>
+#include <tcp/eventloop.h>
+#include <tcp/iouringconnectionserver.h>
+#include <tcp/tcpclientconnection.h>
+#include <tcp/tcpconnectionserver.h>
+#include <tcp/tcptests.h>
+#include <udp/udpclientconnection.h>
+#include <udp/udpconnectionserver.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <limits>
+#include <set>
+#include <thread>
 
 #define COMPARE_VECTORS_OF_SMART_PTRS(a, b) \
     ASSERT_EQUAL(a.size(), b.size());       \
@@ -28,13 +59,30 @@
 
 struct MonitoringServerTest
 {
+    /*!
+     * \brief Транспорт, по которому устройства подключаются к серверу
+     */
+    enum class Transport
+    {
+        Mock,
+        Tcp,
+        IoUring, ///< Сервер на io_uring, устройства - TcpClientConnection
+        Shm,     ///< Разделяемая память между процессами узла
+        Udp      ///< Датаграммы с идентификатором устройства вместо соединений
+    };
+    static Transport transport;
+
     MonitoringServerTest(uint64_t serverId) :
         serverId(serverId),
-        server(new ConnectionServerMock(taskQueue))
+        server(createConnectionServer())
     {
         ASSERT(server.messageEncoder().addExecutor(new DummyEncoderExecutor()));
         ASSERT(server.messageEncoder().selectExecutor("Dummy"));
-        ASSERT(server.listen(serverId));
+        if (transport != Transport::Mock)
+            this->serverId = listenOnTcpTestPort(server); // Идентификатор сервера - номер порта (имя сокета для Shm)
+        else
+            ASSERT(server.listen(serverId));
+        ASSERT(this->serverId);
     }
     ~MonitoringServerTest()
     {
@@ -45,21 +93,61 @@ struct MonitoringServerTest
     }
     void connectDevice(uint64_t deviceId)
     {
-        devices.insert({ deviceId, new DeviceMock(new ClientConnectionMock(taskQueue)) });
+        devices.insert({ deviceId, new DeviceMock(createClientConnection()) });
         ASSERT(devices[deviceId]->messageEncoder().addExecutor(new DummyEncoderExecutor()));
         ASSERT(devices[deviceId]->messageEncoder().selectExecutor("Dummy"));
         ASSERT(devices[deviceId]->bind(deviceId));
         ASSERT(devices[deviceId]->connectToServer(serverId));
-        while (taskQueue.processTask())
-            ;
+        processEvents();
+    }
+    /*!
+     * \brief Обработать события, пока они не закончатся
+     */
+    void processEvents()
+    {
+        if (transport != Transport::Mock)
+        {
+            while (eventLoop.processEvents(20))
+                ;
+        }
+        else
+        {
+            while (taskQueue.processTask())
+                ;
+        }
+    }
+    AbstractConnectionServer* createConnectionServer()
+    {
+        if (transport == Transport::Tcp)
+            return new TcpConnectionServer(eventLoop);
+        if (transport == Transport::IoUring)
+            return new IoUringConnectionServer(eventLoop);
+        if (transport == Transport::Shm)
+            return new ShmConnectionServer(eventLoop);
+        if (transport == Transport::Udp)
+            return new UdpConnectionServer(eventLoop);
+        return new ConnectionServerMock(taskQueue);
+    }
+    AbstractClientConnection* createClientConnection()
+    {
+        if (transport == Transport::Shm)
+            return new ShmClientConnection(eventLoop);
+        if (transport == Transport::Udp)
+            return new UdpClientConnection(eventLoop);
+        if (transport != Transport::Mock)
+            return new TcpClientConnection(eventLoop);
+        return new ClientConnectionMock(taskQueue);
     }
 
     uint64_t serverId;
     TaskQueue taskQueue;
+    EventLoop eventLoop;
     DeviceMonitoringServer server;
     std::map<uint64_t, DeviceMock*> devices;
 };
 
+MonitoringServerTest::Transport MonitoringServerTest::transport = MonitoringServerTest::Transport::Mock;
+
 void monitoringServerTestNoSchedule()
 {
     MonitoringServerTest test(11u);
@@ -68,8 +156,7 @@ void monitoringServerTestNoSchedule()
     std::vector<uint8_t> meterages = { 0u };
     test.devices[deviceId]->setMeterages(meterages);
     test.devices[deviceId]->startMeterageSending();
-    while (test.taskQueue.processTask())
-        ;
+    test.processEvents();
 
     std::vector<std::shared_ptr<Message>> expected = {
         std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoSchedule)),
@@ -88,8 +175,7 @@ void monitoringServerTestNoTimeStamp()
     test.server.setDeviceWorkSchedule(schedule);
     test.devices[deviceId]->setMeterages(meterages);
     test.devices[deviceId]->startMeterageSending();
-    while (test.taskQueue.processTask())
-        ;
+    test.processEvents();
 
     std::vector<std::shared_ptr<Message>> expected = {
         std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoTimestamp)),
@@ -106,13 +192,11 @@ void monitoringServerTestObsolete()
     std::vector<uint8_t> meterages = { 0u };
     test.devices[deviceId]->setMeterages(meterages);
     test.devices[deviceId]->startMeterageSending();
-    while (test.taskQueue.processTask())
-        ;
+    test.processEvents();
 
     test.devices[deviceId]->setMeterages(meterages);
     test.devices[deviceId]->startMeterageSending();
-    while (test.taskQueue.processTask())
-        ;
+    test.processEvents();
 
     std::vector<std::shared_ptr<Message>> expected = {
         std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoSchedule)),
@@ -136,8 +220,7 @@ void monitoringServerTestCommand()
     test.server.setDeviceWorkSchedule(schedule);
     test.devices[deviceId]->setMeterages(meterages);
     test.devices[deviceId]->startMeterageSending();
-    while (test.taskQueue.processTask())
-        ;
+    test.processEvents();
 
     std::vector<std::shared_ptr<Message>> expected = {
         std::shared_ptr<Message>(new MessageCommand(0)),
@@ -168,8 +251,7 @@ void monitoringServerTestTwoDevices()
     test.devices[deviceId2]->setMeterages({ 0u, 0u, 50u, 100u });
     test.devices[deviceId1]->startMeterageSending();
     test.devices[deviceId2]->startMeterageSending();
-    while (test.taskQueue.processTask())
-        ;
+    test.processEvents();
 
     std::vector<std::shared_ptr<Message>> expected1 = {
         std::shared_ptr<Message>(new MessageCommand(0)),
@@ -204,8 +286,7 @@ void monitoringServerCryptoPositiveTest()
     test.server.setDeviceWorkSchedule(schedule);
     test.devices[deviceId]->setMeterages(meterages);
     test.devices[deviceId]->startMeterageSending();
-    while (test.taskQueue.processTask())
-        ;
+    test.processEvents();
 
     std::vector<std::shared_ptr<Message>> expected = {
         std::shared_ptr<Message>(new MessageCommand(0)),
@@ -232,12 +313,470 @@ void monitoringServerCryptoNegativeTest()
     test.server.setDeviceWorkSchedule(schedule);
     test.devices[deviceId]->setMeterages(meterages);
     test.devices[deviceId]->startMeterageSending();
-    while (test.taskQueue.processTask())
-        ;
+    test.processEvents();
 
     ASSERT(test.devices[deviceId]->messages().empty());
 }
 
+void monitoringServerBatchTest()
+{
+    MonitoringServerTest test(11u);
+    uint64_t deviceId = 111u;
+    test.connectDevice(deviceId);
+    DeviceWorkSchedule schedule { deviceId, {
+                                            { 1u, 10u },
+                                            { 3u, 20u },
+                                            } };
+    test.server.setDeviceWorkSchedule(schedule);
+    test.devices[deviceId]->setBatchSize(3);
+    test.devices[deviceId]->setMeterages({ 0u, 1u, 2u, 3u, 4u });
+    test.devices[deviceId]->startMeterageSending();
+    test.processEvents();
+
+    std::vector<std::shared_ptr<Message>> expected = {
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoTimestamp)),
+        std::shared_ptr<Message>(new MessageCommand(9)),
+        std::shared_ptr<Message>(new MessageCommand(8)),
+        std::shared_ptr<Message>(new MessageCommand(17)),
+        std::shared_ptr<Message>(new MessageCommand(16)),
+    };
+    auto& messages = test.devices[deviceId]->messages();
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, messages);
+}
+
+void monitoringServerWireV2Test()
+{
+    MonitoringServerTest test(12u);
+    uint64_t deviceId = 121u;
+    test.connectDevice(deviceId);
+    DeviceWorkSchedule schedule { deviceId, {
+                                            { 1u, 10u },
+                                            { 3u, 20u },
+                                            } };
+    test.server.setDeviceWorkSchedule(schedule);
+    test.devices[deviceId]->sendHandshake(MessageHandshake("Dummy", WireVersion::V2, 1u));
+    test.processEvents();
+    test.devices[deviceId]->setMeterages({ 0u, 1u, 2u, 3u, 4u });
+    test.devices[deviceId]->startMeterageSending();
+    test.processEvents();
+
+    std::vector<std::shared_ptr<Message>> expected = {
+        std::shared_ptr<Message>(new MessageHandshake("Dummy", WireVersion::V2, 1u)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoTimestamp)),
+        std::shared_ptr<Message>(new MessageCommand(9)),
+        std::shared_ptr<Message>(new MessageCommand(8)),
+        std::shared_ptr<Message>(new MessageCommand(17)),
+        std::shared_ptr<Message>(new MessageCommand(16)),
+    };
+    auto& messages = test.devices[deviceId]->messages();
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, messages);
+}
+
+void monitoringServerWireV2BatchTest()
+{
+    MonitoringServerTest test(13u);
+    uint64_t v1DeviceId = 131u;
+    uint64_t v2DeviceId = 132u;
+    test.connectDevice(v1DeviceId);
+    test.connectDevice(v2DeviceId);
+    for (auto deviceId : { v1DeviceId, v2DeviceId })
+    {
+        DeviceWorkSchedule schedule { deviceId, {
+                                                { 1u, 10u },
+                                                { 3u, 20u },
+                                                } };
+        test.server.setDeviceWorkSchedule(schedule);
+        test.devices[deviceId]->setBatchSize(2);
+        test.devices[deviceId]->setMeterages({ 0u, 1u, 2u, 3u, 4u });
+    }
+    test.devices[v2DeviceId]->sendHandshake(MessageHandshake("Dummy", WireVersion::V2, 2u));
+    test.processEvents();
+    test.devices[v1DeviceId]->startMeterageSending();
+    test.devices[v2DeviceId]->startMeterageSending();
+    test.processEvents();
+
+    // Устройства со старым и новым форматом получают одинаковые ответы
+    std::vector<std::shared_ptr<Message>> expected = {
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoTimestamp)),
+        std::shared_ptr<Message>(new MessageCommand(9)),
+        std::shared_ptr<Message>(new MessageCommand(8)),
+        std::shared_ptr<Message>(new MessageCommand(17)),
+        std::shared_ptr<Message>(new MessageCommand(16)),
+    };
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, test.devices[v1DeviceId]->messages());
+    expected.insert(expected.begin(), std::shared_ptr<Message>(new MessageHandshake("Dummy", WireVersion::V2, 2u)));
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, test.devices[v2DeviceId]->messages());
+}
+
+void monitoringServerWireV2NotNegotiatedTest()
+{
+    MonitoringServerTest test(18u);
+    uint64_t deviceId = 181u;
+    test.connectDevice(deviceId);
+    DeviceWorkSchedule schedule { deviceId, {
+                                            { 1u, 10u },
+                                            { 3u, 20u },
+                                            } };
+    test.server.setDeviceWorkSchedule(schedule);
+    // Устройство отправляет измерения WireVersion::V2 без согласования версии
+    test.devices[deviceId]->setWireVersion(WireVersion::V2);
+    test.devices[deviceId]->setMeterages({ 0u, 1u });
+    test.devices[deviceId]->startMeterageSending();
+    test.processEvents();
+    test.devices[deviceId]->setBatchSize(2);
+    test.devices[deviceId]->setMeterages({ 0u, 1u });
+    test.devices[deviceId]->startMeterageSending();
+    test.processEvents();
+
+    std::vector<std::shared_ptr<Message>> expected = {
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NotNegotiated)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NotNegotiated)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NotNegotiated)),
+    };
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, test.devices[deviceId]->messages());
+    ASSERT(test.server.deviationStats(deviceId).empty());
+}
+
+void monitoringServerHandshakeViolationTest()
+{
+    MonitoringServerTest test(19u);
+    test.server.setMaxBatchSize(2);
+    uint64_t v1DeviceId = 191u;
+    uint64_t batchDeviceId = 192u;
+    uint64_t defaultDeviceId = 193u;
+    for (auto deviceId : { v1DeviceId, batchDeviceId, defaultDeviceId })
+    {
+        test.connectDevice(deviceId);
+        DeviceWorkSchedule schedule { deviceId, {
+                                                { 0u, 10u },
+                                                } };
+        test.server.setDeviceWorkSchedule(schedule);
+    }
+    test.devices[v1DeviceId]->sendHandshake(MessageHandshake("Dummy", WireVersion::V1, 2u));
+    test.devices[batchDeviceId]->sendHandshake(MessageHandshake("Dummy", WireVersion::V2, 2u));
+    test.processEvents();
+
+    // Нарушения согласованных параметров: формат WireVersion::V2 после согласования V1
+    // и пакеты больше согласованного (или, без согласования, заданного серверу) размера
+    test.devices[v1DeviceId]->setWireVersion(WireVersion::V2);
+    test.devices[v1DeviceId]->setBatchSize(1);
+    test.devices[v1DeviceId]->setMeterages({ 10u, 10u });
+    test.devices[batchDeviceId]->setBatchSize(3);
+    test.devices[batchDeviceId]->setMeterages({ 10u, 10u, 10u });
+    test.devices[defaultDeviceId]->setBatchSize(3);
+    test.devices[defaultDeviceId]->setMeterages({ 10u, 10u, 10u });
+    for (auto deviceId : { v1DeviceId, batchDeviceId, defaultDeviceId })
+        test.devices[deviceId]->startMeterageSending();
+    test.processEvents();
+
+    std::vector<std::shared_ptr<Message>> expected = {
+        std::shared_ptr<Message>(new MessageHandshake("Dummy", WireVersion::V1, 2u)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NotNegotiated)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NotNegotiated)),
+    };
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, test.devices[v1DeviceId]->messages());
+    expected = {
+        std::shared_ptr<Message>(new MessageHandshake("Dummy", WireVersion::V2, 2u)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NotNegotiated)),
+    };
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, test.devices[batchDeviceId]->messages());
+    expected = {
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NotNegotiated)),
+    };
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, test.devices[defaultDeviceId]->messages());
+    for (auto deviceId : { v1DeviceId, batchDeviceId, defaultDeviceId })
+        ASSERT(test.server.deviationStats(deviceId).empty());
+}
+
+void monitoringServerMultiChannelTest()
+{
+    MonitoringServerTest test(14u);
+    uint64_t deviceId = 141u;
+    test.connectDevice(deviceId);
+    MultiChannelDeviceWorkSchedule schedule { deviceId, {
+                                                        { 1u, { 10u, 20u, 30u } },
+                                                        { 2u, { 40u, 50u, 60u } },
+                                                        } };
+    test.server.setMultiChannelDeviceWorkSchedule(schedule);
+    test.devices[deviceId]->setChannelMeterages({ { 0u, 0u, 0u },
+                                                  { 1u, 2u, 3u },
+                                                  { 40u, 60u, 50u },
+                                                  { 1u, 2u } });
+    test.devices[deviceId]->startMeterageSending();
+    test.processEvents();
+
+    std::vector<std::shared_ptr<Message>> expected = {
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoTimestamp)),
+        std::shared_ptr<Message>(new MessageMultiCommand({ 9, 18, 27 })),
+        std::shared_ptr<Message>(new MessageMultiCommand({ 0, -10, 10 })),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoSchedule)),
+    };
+    auto& messages = test.devices[deviceId]->messages();
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, messages);
+    ASSERT_EQUAL(2u, test.server.multiChannelDeviationStats(deviceId).size());
+}
+
+void monitoringServerHandshakeTest()
+{
+    MonitoringServerTest test(15u);
+    test.server.setMaxBatchSize(2);
+    uint64_t negotiatedDeviceId = 151u;
+    uint64_t defaultDeviceId = 152u;
+    test.connectDevice(negotiatedDeviceId);
+    test.connectDevice(defaultDeviceId);
+    for (auto deviceId : { negotiatedDeviceId, defaultDeviceId })
+    {
+        DeviceWorkSchedule schedule { deviceId, {
+                                                { 1u, 10u },
+                                                { 3u, 20u },
+                                                } };
+        test.server.setDeviceWorkSchedule(schedule);
+        test.devices[deviceId]->setMeterages({ 0u, 1u, 2u, 3u, 4u });
+    }
+
+    // Запрос шифруется алгоритмом по умолчанию, далее соединение использует согласованный
+    test.devices[negotiatedDeviceId]->sendHandshake(MessageHandshake("ROT3", WireVersion::V2, 100u));
+    test.processEvents();
+    test.devices[negotiatedDeviceId]->startMeterageSending();
+    test.devices[defaultDeviceId]->startMeterageSending();
+    test.processEvents();
+
+    std::vector<std::shared_ptr<Message>> expected = {
+        std::shared_ptr<Message>(new MessageHandshake("ROT3", WireVersion::V2, 2u)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoTimestamp)),
+        std::shared_ptr<Message>(new MessageCommand(9)),
+        std::shared_ptr<Message>(new MessageCommand(8)),
+        std::shared_ptr<Message>(new MessageCommand(17)),
+        std::shared_ptr<Message>(new MessageCommand(16)),
+    };
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, test.devices[negotiatedDeviceId]->messages());
+
+    // Устройство без согласования продолжает работать с параметрами по умолчанию
+    expected = {
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoTimestamp)),
+        std::shared_ptr<Message>(new MessageCommand(9)),
+        std::shared_ptr<Message>(new MessageCommand(8)),
+        std::shared_ptr<Message>(new MessageCommand(17)),
+        std::shared_ptr<Message>(new MessageCommand(16)),
+    };
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, test.devices[defaultDeviceId]->messages());
+}
+
+void monitoringServerHandshakeUnsupportedTest()
+{
+    MonitoringServerTest test(16u);
+    uint64_t deviceId = 161u;
+    test.connectDevice(deviceId);
+    DeviceWorkSchedule schedule { deviceId, { { 0u, 5u } } };
+    test.server.setDeviceWorkSchedule(schedule);
+    test.devices[deviceId]->setMeterages({ 1u, 2u });
+
+    // Неизвестные алгоритм, версия формата и сжатие заменяются поддерживаемыми сервером
+    test.devices[deviceId]->sendHandshake(MessageHandshake("Unknown", static_cast<WireVersion>(9), 0u,
+                                                           static_cast<MessageHandshake::Compression>(1)));
+    test.processEvents();
+    test.devices[deviceId]->startMeterageSending();
+    test.processEvents();
+
+    std::vector<std::shared_ptr<Message>> expected = {
+        std::shared_ptr<Message>(new MessageHandshake("Dummy", WireVersion::V2, 1u)),
+        std::shared_ptr<Message>(new MessageCommand(4)),
+        std::shared_ptr<Message>(new MessageCommand(3)),
+    };
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, test.devices[deviceId]->messages());
+}
+
+void monitoringServerAesHandshakeTest()
+{
+    MonitoringServerTest test(17u);
+    uint64_t aesDeviceId = 171u;
+    uint64_t noKeyDeviceId = 172u;
+    const Aes128CtrEncoderExecutor::Key key = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+    test.server.setEncryptionKey(aesDeviceId, key);
+    for (auto deviceId : { aesDeviceId, noKeyDeviceId })
+    {
+        test.connectDevice(deviceId);
+        DeviceWorkSchedule schedule { deviceId, { { 0u, 5u } } };
+        test.server.setDeviceWorkSchedule(schedule);
+        test.devices[deviceId]->setMeterages({ 1u, 2u });
+        test.devices[deviceId]->setEncryptionKey(key);
+        test.devices[deviceId]->sendHandshake(MessageHandshake(Aes128CtrEncoderExecutor::algorithmName(), WireVersion::V1, 1u));
+    }
+    test.processEvents();
+    for (auto deviceId : { aesDeviceId, noKeyDeviceId })
+        test.devices[deviceId]->startMeterageSending();
+    test.processEvents();
+
+    // Без ключа на сервере действующий алгоритм сохраняется
+    std::vector<std::shared_ptr<Message>> expected = {
+        std::shared_ptr<Message>(new MessageHandshake("Dummy", WireVersion::V1, 1u)),
+        std::shared_ptr<Message>(new MessageCommand(4)),
+        std::shared_ptr<Message>(new MessageCommand(3)),
+    };
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, test.devices[noKeyDeviceId]->messages());
+
+    // По датаграммам AES-128-CTR не согласуется даже с ключом: потеря датаграммы сбила бы ключевой поток
+    if (MonitoringServerTest::transport == MonitoringServerTest::Transport::Udp)
+    {
+        COMPARE_VECTORS_OF_SMART_PTRS(expected, test.devices[aesDeviceId]->messages());
+        return;
+    }
+
+    // Сервер отвечает своим случайным nonce, далее соединение шифруется AES-128-CTR
+    auto& messages = test.devices[aesDeviceId]->messages();
+    ASSERT_EQUAL(3u, messages.size());
+    const auto* reply = dynamic_cast<const MessageHandshake*>(messages.front().get());
+    ASSERT(reply != nullptr);
+    ASSERT_EQUAL(std::string(Aes128CtrEncoderExecutor::algorithmName()), reply->encoderName());
+    ASSERT(reply->nonce() != 0);
+    ASSERT_EQUAL(static_cast<const Message&>(MessageCommand(4)), *messages[1]);
+    ASSERT_EQUAL(static_cast<const Message&>(MessageCommand(3)), *messages[2]);
+    ASSERT_EQUAL(std::string(Aes128CtrEncoderExecutor::algorithmName()), test.devices[aesDeviceId]->messageEncoder().currentExecutor()->name());
+}
+
+/*!
+ * \brief Выполнить тесты monitoringServer* через транспорт \a transport
+ */
+static void runMonitoringServerTests(MonitoringServerTest::Transport transport)
+{
+    struct TransportGuard
+    {
+        TransportGuard(MonitoringServerTest::Transport transport) { MonitoringServerTest::transport = transport; }
+        ~TransportGuard() { MonitoringServerTest::transport = MonitoringServerTest::Transport::Mock; }
+    } guard(transport);
+    monitoringServerTestNoSchedule();
+    monitoringServerTestObsolete();
+    monitoringServerTestCommand();
+    monitoringServerTestNoTimeStamp();
+    monitoringServerTestTwoDevices();
+    monitoringServerCryptoPositiveTest();
+    monitoringServerCryptoNegativeTest();
+    monitoringServerBatchTest();
+    monitoringServerWireV2Test();
+    monitoringServerWireV2BatchTest();
+    monitoringServerWireV2NotNegotiatedTest();
+    monitoringServerMultiChannelTest();
+    monitoringServerHandshakeTest();
+    monitoringServerHandshakeViolationTest();
+    monitoringServerHandshakeUnsupportedTest();
+    monitoringServerAesHandshakeTest();
+}
+
+void monitoringServerTcpTest()
+{
+    // Те же сценарии, что и с ConnectionServerMock, через TCP-соединения на localhost
+    runMonitoringServerTests(MonitoringServerTest::Transport::Tcp);
+}
+
+void monitoringServerIoUringTest()
+{
+    if (IoUringConnectionServer::isSupported())
+        runMonitoringServerTests(MonitoringServerTest::Transport::IoUring);
+}
+
+void monitoringServerShmTest()
+{
+    runMonitoringServerTests(MonitoringServerTest::Transport::Shm);
+}
+
+void monitoringServerUdpTest()
+{
+    runMonitoringServerTests(MonitoringServerTest::Transport::Udp);
+}
+
+/*!
+ * \brief Обрабатывать события \a eventLoop, пока не выполнится \a condition, но не дольше 10 секунд
+ */
+template <class Condition>
+static bool processEventsUntil(EventLoop& eventLoop, Condition condition)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!condition() && std::chrono::steady_clock::now() < deadline)
+        eventLoop.processEvents(10);
+    return condition();
+}
+
+void monitoringServerShardedTest()
+{
+    ShardedDeviceMonitoringServer server(2);
+    ASSERT_EQUAL(server.shardCount(), 2u);
+    ASSERT(server.selectExecutor("ROT3"));
+    const uint64_t port = listenOnTcpTestPort(server);
+    ASSERT(port);
+    const std::vector<uint64_t> deviceIds = { 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u };
+    for (const uint64_t deviceId : deviceIds)
+        server.setDeviceWorkSchedule({ deviceId, { { 0u, 10u } } });
+
+    EventLoop eventLoop;
+    // Устройства подключаются к шардам, выбранным ядром, отправляют измерения и остаются подключенными
+    auto connectDevices = [&](std::vector<std::unique_ptr<DeviceMock>>& devices, const std::vector<uint8_t>& meterages) {
+        for (const uint64_t deviceId : deviceIds)
+        {
+            devices.emplace_back(new DeviceMock(new TcpClientConnection(eventLoop)));
+            ASSERT(devices.back()->messageEncoder().selectExecutor("ROT3"));
+            ASSERT(devices.back()->bind(deviceId));
+            ASSERT(devices.back()->connectToServer(port));
+            devices.back()->setMeterages(meterages);
+        }
+        ASSERT(processEventsUntil(eventLoop, [&] {
+            return std::all_of(deviceIds.begin(), deviceIds.end(),
+                               [&](uint64_t deviceId) { return server.deviceShard(deviceId) != DeviceDirectory::noShard; });
+        }));
+        for (auto& device : devices)
+            device->startMeterageSending();
+        ASSERT(processEventsUntil(eventLoop, [&] {
+            return std::all_of(devices.begin(), devices.end(),
+                               [&](const std::unique_ptr<DeviceMock>& device) { return device->messages().size() == meterages.size(); });
+        }));
+    };
+    auto checkDeviations = [&](double expected) {
+        for (const uint64_t deviceId : deviceIds)
+        {
+            const auto deviations = server.deviationStats(deviceId);
+            ASSERT_EQUAL(deviations.size(), 1u);
+            ASSERT_EQUAL(deviations[0].firstTimestamp, 0u);
+            ASSERT_WITH_THRESHOLD(deviations[0].deviation, expected, 1e-9);
+        }
+    };
+
+    {
+        std::vector<std::unique_ptr<DeviceMock>> devices;
+        connectDevices(devices, { 7u, 10u, 13u });
+        std::vector<std::shared_ptr<Message>> expected = {
+            std::shared_ptr<Message>(new MessageCommand(3)),
+            std::shared_ptr<Message>(new MessageCommand(0)),
+            std::shared_ptr<Message>(new MessageCommand(-3)),
+        };
+        for (const auto& device : devices)
+        {
+            COMPARE_VECTORS_OF_SMART_PTRS(expected, device->messages());
+        }
+        // Запрос выполняется в потоке шарда устройства
+        checkDeviations(std::sqrt(6.0));
+    }
+    ASSERT(processEventsUntil(eventLoop, [&] {
+        return std::all_of(deviceIds.begin(), deviceIds.end(),
+                           [&](uint64_t deviceId) { return server.deviceShard(deviceId) == DeviceDirectory::noShard; });
+    }));
+    checkDeviations(std::sqrt(6.0));
+
+    // После переподключения (возможно, к другому шарду) информация об устройстве сохраняется
+    std::vector<std::unique_ptr<DeviceMock>> devices;
+    connectDevices(devices, { 0u, 0u, 0u, 10u, 16u });
+    std::vector<std::shared_ptr<Message>> expected = {
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::Obsolete)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::Obsolete)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::Obsolete)),
+        std::shared_ptr<Message>(new MessageCommand(0)),
+        std::shared_ptr<Message>(new MessageCommand(-6)),
+    };
+    for (const auto& device : devices)
+    {
+        COMPARE_VECTORS_OF_SMART_PTRS(expected, device->messages());
+    }
+    checkDeviations(std::sqrt(54.0 / 5));
+}
+
 void messageSerializationTest()
 {
     std::vector<std::shared_ptr<Message>> messages;
@@ -265,6 +804,7 @@ void messageSerializationTest()
         std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoSchedule)),
         std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoTimestamp)),
         std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::Obsolete)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NotNegotiated)),
     };
 
     for (auto& ptr : expected)
@@ -275,6 +815,414 @@ void messageSerializationTest()
     COMPARE_VECTORS_OF_SMART_PTRS(expected, messages);
 }
 
+void messageValueSerializationTest()
+{
+    ASSERT(!MessageSerializer::deserializeValue(""));
+    ASSERT(!MessageSerializer::deserializeValue("12345"));
+    ASSERT(!MessageSerializer::deserializeValue("e"));
+    ASSERT(!MessageSerializer::deserializeValue("eA"));
+    ASSERT(!MessageSerializer::deserializeValue("m"));
+    ASSERT(!MessageSerializer::deserializeValue("mA"));
+    ASSERT(!MessageSerializer::deserializeValue("c"));
+
+    std::vector<MessageVariant> expected = {
+        MessageCommand(0),
+        MessageCommand(-1),
+        MessageCommand(std::numeric_limits<int8_t>::max()),
+        MessageCommand(std::numeric_limits<int8_t>::min()),
+        MessageMeterage(12345u, 123u),
+        MessageMeterage(std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint8_t>::max()),
+        MessageError(MessageError::ErrorType::NoSchedule),
+        MessageError(MessageError::ErrorType::NoTimestamp),
+        MessageError(MessageError::ErrorType::Obsolete),
+        MessageError(MessageError::ErrorType::NotNegotiated),
+    };
+
+    std::vector<MessageVariant> messages;
+    for (const auto& message : expected)
+    {
+        auto serialized = MessageSerializer::serialize(message);
+        ASSERT_EQUAL(serialized, MessageSerializer::serialize(*toMessagePtr(message)));
+        auto deserialized = MessageSerializer::deserializeValue(serialized);
+        ASSERT(deserialized.has_value());
+        messages.push_back(*deserialized);
+    }
+    ASSERT_EQUAL(expected, messages);
+}
+
+void messageBufferSerializationTest()
+{
+    MessageMeterage meterage(0x0102030405060708u, 0xAAu);
+    ASSERT_EQUAL(10u, MessageSerializer::serializedSize(meterage));
+    ASSERT_EQUAL(2u, MessageSerializer::serializedSize(MessageVariant(MessageCommand(1))));
+    ASSERT_EQUAL(2u, MessageSerializer::serializedSize(MessageVariant(MessageError(MessageError::ErrorType::Obsolete))));
+
+    char buffer[16] = {};
+    ASSERT_EQUAL(0u, MessageSerializer::serialize(meterage, buffer, 9));
+    ASSERT_EQUAL(10u, MessageSerializer::serialize(MessageVariant(meterage), buffer, sizeof(buffer)));
+    ASSERT_EQUAL(MessageSerializer::serialize(meterage), std::string(buffer, 10));
+    std::ostringstream os(std::ios_base::binary);
+    meterage.serialize(os);
+    ASSERT_EQUAL(os.str(), std::string(buffer, 10));
+
+    std::string arena;
+    std::vector<MessageVariant> messages = {
+        meterage,
+        MessageCommand(-5),
+        MessageError(MessageError::ErrorType::NoSchedule),
+    };
+    std::string expected;
+    for (const auto& message : messages)
+    {
+        ASSERT_EQUAL(MessageSerializer::serializedSize(message), MessageSerializer::serialize(message, arena));
+        expected += MessageSerializer::serialize(message);
+    }
+    ASSERT_EQUAL(expected, arena);
+}
+
+void messageViewDeserializationTest()
+{
+    std::vector<std::string> inputs = { "", "m", "mA", "c", "e", "eA", "es", "xs", "12345" };
+    for (const auto& message : std::vector<MessageVariant> {
+             MessageMeterage(0x0102030405060708u, 0xFEu),
+             MessageCommand(-128),
+             MessageError(MessageError::ErrorType::NoTimestamp),
+         })
+    {
+        auto serialized = MessageSerializer::serialize(message);
+        for (size_t len = 0; len <= serialized.size(); ++len)
+            inputs.push_back(serialized.substr(0, len));
+        inputs.push_back(serialized + "tail");
+    }
+
+    for (const auto& input : inputs)
+    {
+        std::istringstream is(input, std::ios_base::binary);
+        auto expected = Message::deserialize(is);
+        auto value = MessageSerializer::deserializeValue(input);
+        auto pointer = MessageSerializer::deserialize(input);
+        ASSERT_EQUAL(expected != nullptr, value.has_value());
+        ASSERT_EQUAL(expected != nullptr, pointer != nullptr);
+        if (expected)
+        {
+            ASSERT_EQUAL(*expected, *toMessagePtr(*value));
+            ASSERT_EQUAL(*expected, *pointer);
+        }
+    }
+}
+
+void messageRegistryTest()
+{
+    for (int signature = 0; signature < 256; ++signature)
+    {
+        const char ch = static_cast<char>(signature);
+        const bool known = ch == MessageMeterage::signature()
+                           || ch == MessageCommand::signature()
+                           || ch == MessageError::signature()
+                           || ch == MessageBatch::signature()
+                           || ch == MessageMeterageDelta::signature()
+                           || ch == MessageMultiMeterage::signature()
+                           || ch == MessageMultiCommand::signature()
+                           || ch == MessageHandshake::signature();
+        ASSERT_EQUAL(known, MessageTypes::contains(ch));
+        if (known)
+            continue;
+        ASSERT(!MessageSerializer::deserializeValue(std::string(1, ch) + "s").has_value());
+        // Неизвестное обозначение типа не извлекается из потока
+        std::istringstream is(std::string(1, ch) + "s", std::ios_base::binary);
+        ASSERT(!Message::deserialize(is));
+        ASSERT_EQUAL(signature, is.peek());
+    }
+
+    struct MessageTest
+    {
+        static constexpr char signature() { return 'z'; }
+        static std::optional<MessageTest> deserializeValue(std::string_view payload)
+        {
+            if (payload.empty())
+                return {};
+            return MessageTest { payload.front() };
+        }
+        static std::unique_ptr<Message> deserialize(std::istream&) { return {}; }
+        char value;
+    };
+    using Registry = MessageRegistry<MessageMeterage, MessageTest, MessageCommand>;
+    auto message = Registry::deserializeValue("z7");
+    ASSERT(message.has_value());
+    ASSERT_EQUAL('7', std::get<MessageTest>(*message).value);
+    ASSERT(!Registry::deserializeValue("z").has_value());
+    ASSERT(!Registry::deserializeValue("e7").has_value());
+    ASSERT(Registry::deserializeValue("c7").has_value());
+}
+
+template <typename T>
+static void checkBulkBigEndian(size_t count)
+{
+    std::vector<T> values(count);
+    for (size_t i = 0; i < count; ++i)
+        values[i] = static_cast<T>(0x0123456789ABCDEFull * (i + 1));
+    std::string expected(count * sizeof(T), '\0');
+    for (size_t i = 0; i < count; ++i)
+        toBigEndian(expected.data() + i * sizeof(T), values[i]);
+
+    std::string buffer(count * sizeof(T), '\0');
+    toBigEndian(buffer.data(), values.data(), count);
+    ASSERT_EQUAL(expected, buffer);
+
+    std::vector<T> decoded(count);
+    fromBigEndian(decoded.data(), buffer.data(), count);
+    ASSERT(values == decoded);
+}
+
+void bigEndianTest()
+{
+    char buffer[8];
+    ASSERT_EQUAL(buffer + 8, toBigEndian(buffer, uint64_t(0x0102030405060708u)));
+    ASSERT_EQUAL(std::string("\x01\x02\x03\x04\x05\x06\x07\x08"), std::string(buffer, 8));
+    ASSERT_EQUAL(0x0102030405060708u, fromBigEndian<uint64_t>(buffer));
+    ASSERT_EQUAL(0x0102, fromBigEndian<int16_t>(buffer));
+    toBigEndian(buffer, int8_t(-2));
+    ASSERT_EQUAL(-2, fromBigEndian<int8_t>(buffer));
+
+    const auto detected = detectedSimdLevel();
+    for (auto level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Ssse3, SimdLevel::Avx2 })
+    {
+        if (level > detected)
+            break;
+        setSimdLevel(level);
+        for (size_t count = 0; count < 70; ++count)
+        {
+            checkBulkBigEndian<uint16_t>(count);
+            checkBulkBigEndian<uint32_t>(count);
+            checkBulkBigEndian<uint64_t>(count);
+        }
+    }
+    setSimdLevel(detected);
+}
+
+void messageBatchSerializationTest()
+{
+    MessageBatch empty;
+    ASSERT_EQUAL(std::string("b\0\0", 3), MessageSerializer::serialize(empty));
+
+    auto created = MessageBatch::create({
+        MessageMeterage(1u, 2u),
+        MessageCommand(-3),
+        MessageError(MessageError::ErrorType::Obsolete),
+    });
+    ASSERT(created.has_value());
+    MessageBatch batch = std::move(*created);
+    ASSERT(batch.append(MessageMeterage(std::numeric_limits<uint64_t>::max(), 4u)));
+    auto serialized = MessageSerializer::serialize(batch);
+    ASSERT_EQUAL(batch.serializedSize(), serialized.size());
+    ASSERT_EQUAL(3u + 11u + 3u + 3u + 11u, serialized.size());
+
+    auto value = MessageSerializer::deserializeValue(serialized);
+    ASSERT(value.has_value());
+    ASSERT_EQUAL(MessageVariant(batch), *value);
+    std::istringstream is(serialized, std::ios_base::binary);
+    auto pointer = Message::deserialize(is);
+    ASSERT(pointer != nullptr);
+    ASSERT_EQUAL(static_cast<const Message&>(batch), *pointer);
+
+    for (size_t len = 0; len < serialized.size(); ++len)
+    {
+        ASSERT(!MessageSerializer::deserializeValue(serialized.substr(0, len)).has_value());
+        std::istringstream truncated(serialized.substr(0, len), std::ios_base::binary);
+        ASSERT(Message::deserialize(truncated) == nullptr);
+    }
+    // Запись неизвестного типа и вложенный пакет недопустимы
+    ASSERT(!MessageSerializer::deserializeValue(std::string("b\0\1\2xs", 6)).has_value());
+    ASSERT(!MessageSerializer::deserializeValue(std::string("b\0\1\3b\0\0", 7)).has_value());
+
+    // Количество записей сверх maxRecords() не помещается в uint16_t заголовка: такой пакет не создается
+    std::vector<MessageBatch::Record> records(MessageBatch::maxRecords(), MessageCommand(1));
+    auto full = MessageBatch::create(records);
+    ASSERT(full.has_value());
+    ASSERT_EQUAL(full->records().size(), MessageBatch::maxRecords());
+    ASSERT(!full->append(MessageCommand(2)));
+    auto fullValue = MessageSerializer::deserializeValue(MessageSerializer::serialize(*full));
+    ASSERT(fullValue.has_value());
+    ASSERT_EQUAL(MessageVariant(*full), *fullValue);
+    records.push_back(MessageCommand(2));
+    ASSERT(!MessageBatch::create(std::move(records)).has_value());
+}
+
+void varintTest()
+{
+    const std::vector<int64_t> values = {
+        0, 1, -1, 63, -64, 64, -65, 8191, 8192,
+        std::numeric_limits<int32_t>::max(),
+        std::numeric_limits<int64_t>::max(),
+        std::numeric_limits<int64_t>::min(),
+    };
+    for (auto value : values)
+        ASSERT_EQUAL(value, zigZagDecode(zigZagEncode(value)));
+    ASSERT_EQUAL(0u, zigZagEncode(0));
+    ASSERT_EQUAL(1u, zigZagEncode(-1));
+    ASSERT_EQUAL(2u, zigZagEncode(1));
+
+    char buffer[maxVarintSize];
+    const std::vector<uint64_t> unsignedValues = { 0u, 1u, 127u, 128u, 300u, 16383u, 16384u, std::numeric_limits<uint64_t>::max() };
+    for (auto value : unsignedValues)
+    {
+        const size_t size = toVarint(buffer, value) - buffer;
+        ASSERT_EQUAL(varintSize(value), size);
+        uint64_t decoded = 0;
+        ASSERT_EQUAL(size, fromVarint(std::string_view(buffer, size), decoded));
+        ASSERT_EQUAL(value, decoded);
+        // Обрезанное число не читается
+        ASSERT_EQUAL(0u, fromVarint(std::string_view(buffer, size - 1), decoded));
+    }
+    ASSERT_EQUAL(1u, varintSize(127u));
+    ASSERT_EQUAL(2u, varintSize(128u));
+    ASSERT_EQUAL(maxVarintSize, varintSize(std::numeric_limits<uint64_t>::max()));
+
+    // Число, не помещающееся в uint64_t
+    uint64_t decoded = 0;
+    ASSERT_EQUAL(0u, fromVarint(std::string(maxVarintSize - 1, '\xFF') + '\x02', decoded));
+    ASSERT_EQUAL(0u, fromVarint(std::string(maxVarintSize + 1, '\x80'), decoded));
+}
+
+void messageMeterageDeltaSerializationTest()
+{
+    // Соседние измерения занимают 3 байта вместо 10
+    MessageMeterageDelta next(MessageMeterage(101u, 7u), 100u);
+    ASSERT_EQUAL(1, next.timeStampDelta());
+    ASSERT_EQUAL(std::string("d\x02\x07", 3), MessageSerializer::serialize(next));
+    ASSERT_EQUAL(3u, next.serializedSize());
+    ASSERT_EQUAL(MessageMeterage(101u, 7u), next.toMeterage(100u));
+
+    const std::vector<MessageMeterageDelta> messages = {
+        MessageMeterageDelta(0, 0u),
+        MessageMeterageDelta(-1, 255u),
+        MessageMeterageDelta(MessageMeterage(std::numeric_limits<uint64_t>::max(), 1u), 0u),
+        MessageMeterageDelta(MessageMeterage(0u, 2u), std::numeric_limits<uint64_t>::max()),
+        MessageMeterageDelta(std::numeric_limits<int64_t>::min(), 3u),
+        MessageMeterageDelta(std::numeric_limits<int64_t>::max(), 4u),
+    };
+    for (const auto& message : messages)
+    {
+        auto serialized = MessageSerializer::serialize(message);
+        ASSERT_EQUAL(message.serializedSize(), serialized.size());
+        ASSERT(serialized.size() <= MessageMeterageDelta::maxSerializedSize());
+
+        auto value = MessageSerializer::deserializeValue(serialized);
+        ASSERT(value.has_value());
+        ASSERT_EQUAL(MessageVariant(message), *value);
+        std::istringstream is(serialized, std::ios_base::binary);
+        auto pointer = Message::deserialize(is);
+        ASSERT(pointer != nullptr);
+        ASSERT_EQUAL(static_cast<const Message&>(message), *pointer);
+
+        for (size_t len = 0; len < serialized.size(); ++len)
+        {
+            ASSERT(!MessageSerializer::deserializeValue(serialized.substr(0, len)).has_value());
+            std::istringstream truncated(serialized.substr(0, len), std::ios_base::binary);
+            ASSERT(Message::deserialize(truncated) == nullptr);
+        }
+    }
+    // Разность восстанавливается по модулю 2^64
+    ASSERT_EQUAL(MessageMeterage(std::numeric_limits<uint64_t>::max(), 1u), messages[2].toMeterage(0u));
+    ASSERT_EQUAL(MessageMeterage(0u, 2u), messages[3].toMeterage(std::numeric_limits<uint64_t>::max()));
+}
+
+void messageMultiChannelSerializationTest()
+{
+    MessageMultiMeterage meterage(0x0102030405060708u, { 1u, 2u, 255u });
+    ASSERT_EQUAL(std::string("M\x01\x02\x03\x04\x05\x06\x07\x08\x03\x01\x02\xFF", 13), MessageSerializer::serialize(meterage));
+    MessageMultiCommand command({ -1, 0, 127 });
+    ASSERT_EQUAL(std::string("C\x03\xFF\x00\x7F", 5), MessageSerializer::serialize(command));
+
+    std::vector<uint8_t> channels(MessageMultiMeterage::maxChannels() + 1);
+    for (size_t i = 0; i < channels.size(); ++i)
+        channels[i] = static_cast<uint8_t>(i);
+    ASSERT_EQUAL(MessageMultiMeterage::maxChannels(), MessageMultiMeterage(0u, channels).meterages().size());
+
+    const std::vector<std::shared_ptr<Message>> messages = {
+        std::shared_ptr<Message>(new MessageMultiMeterage(0u, {})),
+        std::shared_ptr<Message>(new MessageMultiMeterage(12345u, { 1u, 2u, 3u })),
+        std::shared_ptr<Message>(new MessageMultiMeterage(std::numeric_limits<uint64_t>::max(), channels)),
+        std::shared_ptr<Message>(new MessageMultiCommand({})),
+        std::shared_ptr<Message>(new MessageMultiCommand({ -128, 0, 127 })),
+        std::shared_ptr<Message>(new MessageMultiCommand(std::vector<int8_t>(MessageMultiCommand::maxChannels(), -5))),
+    };
+    for (const auto& message : messages)
+    {
+        auto serialized = MessageSerializer::serialize(*message);
+        ASSERT_EQUAL(message->serializedSize(), serialized.size());
+
+        auto value = MessageSerializer::deserializeValue(serialized);
+        ASSERT(value.has_value());
+        ASSERT_EQUAL(*message, *toMessagePtr(*value));
+        std::istringstream is(serialized, std::ios_base::binary);
+        auto pointer = Message::deserialize(is);
+        ASSERT(pointer != nullptr);
+        ASSERT_EQUAL(*message, *pointer);
+
+        for (size_t len = 0; len < serialized.size(); ++len)
+        {
+            ASSERT(!MessageSerializer::deserializeValue(serialized.substr(0, len)).has_value());
+            std::istringstream truncated(serialized.substr(0, len), std::ios_base::binary);
+            ASSERT(Message::deserialize(truncated) == nullptr);
+        }
+    }
+}
+
+void messageHandshakeSerializationTest()
+{
+    MessageHandshake handshake("ROT3", WireVersion::V2, 0x0102u);
+    ASSERT_EQUAL(std::string("h\x02\x01\x02\x00\x04ROT3", 10), MessageSerializer::serialize(handshake));
+    ASSERT_EQUAL(MessageHandshake::maxEncoderNameSize(),
+                 MessageHandshake(std::string(MessageHandshake::maxEncoderNameSize() + 1, 'a'), WireVersion::V1, 1u).encoderName().size());
+
+    const std::vector<MessageHandshake> messages = {
+        handshake,
+        MessageHandshake("", WireVersion::V1, 0u),
+        MessageHandshake(std::string(MessageHandshake::maxEncoderNameSize(), 'x'), static_cast<WireVersion>(255), UINT16_MAX,
+                         static_cast<MessageHandshake::Compression>(7)),
+    };
+    for (const auto& message : messages)
+    {
+        auto serialized = MessageSerializer::serialize(message);
+        ASSERT_EQUAL(message.serializedSize(), serialized.size());
+
+        auto value = MessageSerializer::deserializeValue(serialized);
+        ASSERT(value.has_value());
+        ASSERT_EQUAL(MessageVariant(message), *value);
+        std::istringstream is(serialized, std::ios_base::binary);
+        auto pointer = Message::deserialize(is);
+        ASSERT(pointer != nullptr);
+        ASSERT_EQUAL(static_cast<const Message&>(message), *pointer);
+
+        for (size_t len = 0; len < serialized.size(); ++len)
+        {
+            ASSERT(!MessageSerializer::deserializeValue(serialized.substr(0, len)).has_value());
+            std::istringstream truncated(serialized.substr(0, len), std::ios_base::binary);
+            ASSERT(Message::deserialize(truncated) == nullptr);
+        }
+    }
+
+    // Nonce передается после названия, только если задан
+    MessageHandshake withNonce("AES", WireVersion::V2, 1u, MessageHandshake::Compression::None, 0x0102030405060708u);
+    auto serialized = MessageSerializer::serialize(withNonce);
+    ASSERT_EQUAL(std::string("h\x02\x00\x01\x00\x03" "AES\x01\x02\x03\x04\x05\x06\x07\x08", 17), serialized);
+    ASSERT_EQUAL(withNonce.serializedSize(), serialized.size());
+    ASSERT(serialized.size() <= MessageHandshake::maxSerializedSize());
+    ASSERT_EQUAL(MessageVariant(withNonce), *MessageSerializer::deserializeValue(serialized));
+    std::istringstream is(serialized, std::ios_base::binary);
+    auto pointer = Message::deserialize(is);
+    ASSERT(pointer != nullptr);
+    ASSERT_EQUAL(static_cast<const Message&>(withNonce), *pointer);
+    ASSERT(withNonce != MessageHandshake("AES", WireVersion::V2, 1u));
+    // Без nonce остается сообщение прежнего формата; неполный или нулевой nonce - ошибка
+    ASSERT_EQUAL(MessageVariant(MessageHandshake("AES", WireVersion::V2, 1u)), *MessageSerializer::deserializeValue(serialized.substr(0, 9)));
+    for (size_t len = 10; len < serialized.size(); ++len)
+        ASSERT(!MessageSerializer::deserializeValue(serialized.substr(0, len)).has_value());
+    ASSERT(!MessageSerializer::deserializeValue(serialized + 'x').has_value());
+    ASSERT(!MessageSerializer::deserializeValue(serialized.substr(0, 9) + std::string(8, '\0')).has_value());
+}
+
 void messageEncoderEmptyTest()
 {
     MessageEncoder encoder;
@@ -363,6 +1311,482 @@ void messageEncoderDoubleAddTest()
     ASSERT_EQUAL(std::string("456"), encoder.decode("test"));
 }
 
+void messageEncoderLookupTest()
+{
+    class TestEncoderExecutor : public BaseEncoderExecutor
+    {
+    public:
+        TestEncoderExecutor(const std::string& message) :
+            test_message(message) {}
+        std::string encode(const std::string&) const override final { return test_message; }
+        std::string decode(const std::string&) const override final { return test_message; }
+        std::string name() const override final { return "Test"; }
+
+    private:
+        std::string test_message;
+    };
+    MessageEncoder encoder;
+    ASSERT(encoder.currentExecutor() == nullptr);
+    ASSERT(encoder.executor("Test") == nullptr);
+    ASSERT(encoder.executor("ROT3") != nullptr);
+    ASSERT_EQUAL(std::string("ROT3"), encoder.executor("ROT3")->name());
+
+    ASSERT(encoder.addExecutor(new TestEncoderExecutor("123")));
+    ASSERT(encoder.selectExecutor("Test"));
+    const auto executor = encoder.executor("Test");
+    ASSERT(executor == encoder.currentExecutor());
+    // Замененный алгоритм остается доступным по ранее полученному указателю
+    ASSERT(encoder.addExecutor(new TestEncoderExecutor("456")));
+    ASSERT_EQUAL(std::string("123"), executor->encode("test"));
+    ASSERT_EQUAL(std::string("456"), encoder.executor("Test")->encode("test"));
+    ASSERT(encoder.executor("Test") == encoder.currentExecutor());
+}
+
+void messageEncoderSharedRegistryTest()
+{
+    class CustomRot3EncoderExecutor : public BaseEncoderExecutor
+    {
+    public:
+        std::string encode(const std::string&) const override final { return "custom"; }
+        std::string decode(const std::string&) const override final { return "custom"; }
+        std::string name() const override final { return "ROT3"; }
+    };
+    const auto& registry = ExecutorRegistry::instance();
+    ASSERT_EQUAL(3u, registry.names().size());
+    ASSERT(registry.find("Unknown") == nullptr);
+
+    // Встроенные алгоритмы разделяются всеми объектами MessageEncoder
+    MessageEncoder first;
+    MessageEncoder second;
+    for (const auto& name : registry.names())
+    {
+        const auto executor = registry.find(name);
+        ASSERT(executor != nullptr);
+        ASSERT_EQUAL(name, executor->name());
+        ASSERT(first.executor(name) == executor);
+        ASSERT(second.executor(name) == executor);
+    }
+
+    // Добавленный алгоритм с названием встроенного перекрывает его только в своем объекте
+    ASSERT(first.selectExecutor("ROT3"));
+    ASSERT(first.addExecutor(new CustomRot3EncoderExecutor()));
+    ASSERT(first.currentExecutor() != registry.find("ROT3"));
+    ASSERT_EQUAL(std::string("custom"), first.encode("test"));
+    ASSERT(second.selectExecutor("ROT3"));
+    ASSERT(second.currentExecutor() == registry.find("ROT3"));
+    ASSERT(registry.find("ROT3") == ExecutorRegistry::instance().find("ROT3"));
+}
+
+void messageEncoderHotSwapTest()
+{
+    // Счетчик существующих экземпляров проверяет удаление замененных алгоритмов
+    class ReverseEncoderExecutor : public BaseEncoderExecutor
+    {
+    public:
+        ReverseEncoderExecutor(std::atomic<int>& alive) :
+            m_alive(alive) { ++m_alive; }
+        ~ReverseEncoderExecutor() override { --m_alive; }
+        std::string encode(const std::string& message) const override final { return std::string(message.rbegin(), message.rend()); }
+        std::string decode(const std::string& message) const override final { return encode(message); }
+        std::string name() const override final { return "Reverse"; }
+
+    private:
+        std::atomic<int>& m_alive;
+    };
+    std::atomic<int> alive = 0;
+    auto encoder = std::make_unique<MessageEncoder>();
+    ASSERT(encoder->addExecutor(new ReverseEncoderExecutor(alive)));
+    ASSERT(encoder->selectExecutor("ROT3"));
+
+    std::string message;
+    for (int i = 0; i < 200; ++i)
+        message += static_cast<char>(i * 5);
+    const std::vector<std::string> names = { "ROT3", "Mirror", "Multiply41", "Reverse" };
+    std::vector<std::string> expected;
+    for (const auto& name : names)
+        expected.push_back(encoder->executor(name)->encode(message));
+
+    // Потоки шифруют, пока основной поток переключает и заменяет алгоритмы
+    std::atomic<bool> stop = false;
+    std::atomic<bool> failed = false;
+    std::atomic<size_t> encoded = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&]() {
+            std::string output;
+            while (!stop.load())
+            {
+                if (!encoder->encode(message, output)
+                    || std::find(expected.begin(), expected.end(), output) == expected.end())
+                    failed = true;
+                const auto executor = encoder->currentExecutor();
+                if (executor->decode(executor->encode(message)) != message)
+                    failed = true;
+                ++encoded;
+            }
+        });
+    }
+    for (int i = 0; i < 2000; ++i)
+    {
+        if (i % 10 == 0)
+            encoder->addExecutor(new ReverseEncoderExecutor(alive));
+        encoder->selectExecutor(names[i % names.size()]);
+        if (i % 100 == 0)
+            std::this_thread::yield();
+    }
+    while (encoded.load() < 1000)
+        std::this_thread::yield();
+    stop = true;
+    for (auto& thread : threads)
+        thread.join();
+    ASSERT(!failed.load());
+
+    // Замененные алгоритмы удаляются, как только их отпускает последний пользователь
+    ASSERT_EQUAL(1, alive.load());
+    auto held = encoder->executor("Reverse");
+    ASSERT(encoder->addExecutor(new ReverseEncoderExecutor(alive)));
+    ASSERT_EQUAL(2, alive.load());
+    ASSERT_EQUAL(std::string("cba"), held->encode("abc"));
+    held.reset();
+    ASSERT_EQUAL(1, alive.load());
+    encoder.reset();
+    ASSERT_EQUAL(0, alive.load());
+}
+
+void messageEncoderBufferTest()
+{
+    // Алгоритм только со строковым интерфейсом использует реализации по умолчанию
+    class StringOnlyEncoderExecutor : public BaseEncoderExecutor
+    {
+    public:
+        std::string encode(const std::string& message) const override final { return message + message; }
+        std::string decode(const std::string& message) const override final { return message.substr(0, message.size() / 2); }
+        std::string name() const override final { return "StringOnly"; }
+    };
+    MessageEncoder encoder;
+    ASSERT(encoder.addExecutor(new DummyEncoderExecutor()));
+    ASSERT(encoder.addExecutor(new StringOnlyEncoderExecutor()));
+
+    std::string message;
+    for (int i = 0; i < 300; ++i)
+        message += static_cast<char>(i * 7);
+
+    for (auto name : { "Dummy", "ROT3", "Mirror", "Multiply41", "StringOnly" })
+    {
+        const auto executor = encoder.executor(name);
+        ASSERT(executor != nullptr);
+        const auto expected = executor->encode(message);
+
+        std::string buffer(expected.size() + 5, '\0');
+        auto size = executor->encodeInto(message, &buffer[0], buffer.size());
+        ASSERT(size.has_value());
+        ASSERT_EQUAL(expected, buffer.substr(0, *size));
+        ASSERT(!executor->encodeInto(message, &buffer[0], expected.size() - 1).has_value());
+        if (executor->maxEncodedSize(message.size()) != BaseEncoderExecutor::unknownSize)
+            ASSERT(expected.size() <= executor->maxEncodedSize(message.size()));
+
+        size = executor->decodeInto(expected, &buffer[0], buffer.size());
+        ASSERT(size.has_value());
+        ASSERT_EQUAL(message, buffer.substr(0, *size));
+        if (executor->maxDecodedSize(expected.size()) != BaseEncoderExecutor::unknownSize)
+            ASSERT(message.size() <= executor->maxDecodedSize(expected.size()));
+
+        // Буфер строки переиспользуется, пока его емкости достаточно
+        std::string encoded;
+        ASSERT(executor->encodeTo(message, encoded));
+        ASSERT_EQUAL(expected, encoded);
+        std::string decoded;
+        decoded.reserve(message.size());
+        const char* data = decoded.data();
+        ASSERT(executor->decodeTo(encoded, decoded));
+        ASSERT_EQUAL(message, decoded);
+        if (executor->maxDecodedSize(encoded.size()) != BaseEncoderExecutor::unknownSize)
+            ASSERT(data == decoded.data());
+
+        std::string inPlace = message;
+        ASSERT_EQUAL(executor->lengthPreserving(), executor->encodeInPlace(&inPlace[0], inPlace.size()));
+        if (executor->lengthPreserving())
+        {
+            ASSERT_EQUAL(expected, inPlace);
+            ASSERT(executor->decodeInPlace(&inPlace[0], inPlace.size()));
+            ASSERT_EQUAL(message, inPlace);
+        }
+
+        ASSERT(encoder.selectExecutor(name));
+        std::string viaEncoder;
+        ASSERT(encoder.encode(message, viaEncoder));
+        ASSERT_EQUAL(expected, viaEncoder);
+        ASSERT(encoder.decode(viaEncoder, decoded));
+        ASSERT_EQUAL(message, decoded);
+    }
+
+    MessageEncoder empty;
+    std::string output = "123";
+    ASSERT(!empty.encode(message, output));
+    ASSERT(output.empty());
+    ASSERT(!empty.decode(message, output));
+}
+
+void messageEncoderCompositeTest()
+{
+    // Замена байтов, объявляющая свою таблицу
+    class XorEncoderExecutor : public BaseEncoderExecutor
+    {
+    public:
+        XorEncoderExecutor(std::string name, uint8_t key) :
+            m_name(std::move(name)), m_key(key) {}
+        std::string encode(const std::string& message) const override final
+        {
+            std::string result = message;
+            for (auto& c : result)
+                c = static_cast<char>(c ^ m_key);
+            return result;
+        }
+        std::string decode(const std::string& message) const override final { return encode(message); }
+        std::string name() const override final { return m_name; }
+        bool byteMap(ByteMap& table) const override final
+        {
+            for (size_t c = 0; c < table.size(); ++c)
+                table[c] = static_cast<uint8_t>(c ^ m_key);
+            return m_key != 0xFF; // Таблица с ключом 0xFF объявляется не перестановкой для проверки
+        }
+
+    private:
+        std::string m_name;
+        uint8_t m_key = 0;
+    };
+    MessageEncoder encoder;
+    ASSERT(encoder.addExecutor(new DummyEncoderExecutor()));
+    ASSERT(encoder.addExecutor(new XorEncoderExecutor("Xor", 0x5A)));
+    ASSERT(encoder.addExecutor(new XorEncoderExecutor("Xor0", 0)));
+    ASSERT(encoder.addExecutor(new XorEncoderExecutor("XorFF", 0xFF)));
+
+    std::string message;
+    for (int i = 0; i < 1000; ++i)
+        message += static_cast<char>(i * 11);
+    auto apply = [&encoder](std::string data, std::vector<std::string> names) {
+        for (const auto& name : names)
+            data = encoder.executor(name)->encode(data);
+        return data;
+    };
+
+    ASSERT(!encoder.addComposite("Empty", {}));
+    ASSERT(!encoder.addComposite("Unknown", { "ROT3", "Unknown" }));
+    ASSERT(encoder.executor("Unknown") == nullptr);
+
+    // Подряд идущие замены байтов объединяются в одно звено, работающее на месте
+    ASSERT(encoder.addComposite("Fused", { "ROT3", "Xor", "ROT3" }));
+    const auto* fused = dynamic_cast<const CompositeEncoderExecutor*>(encoder.executor("Fused").get());
+    ASSERT(fused != nullptr);
+    ASSERT_EQUAL(1u, fused->stageCount());
+    ASSERT(fused->lengthPreserving());
+    const auto expected = apply(message, { "ROT3", "Xor", "ROT3" });
+    ASSERT_EQUAL(expected, fused->encode(message));
+    ASSERT_EQUAL(message, fused->decode(expected));
+    std::string inPlace = message;
+    ASSERT(fused->encodeInPlace(&inPlace[0], inPlace.size()));
+    ASSERT_EQUAL(expected, inPlace);
+    ASSERT(fused->decodeInPlace(&inPlace[0], inPlace.size()));
+    ASSERT_EQUAL(message, inPlace);
+    BaseEncoderExecutor::ByteMap table;
+    ASSERT(fused->byteMap(table));
+    ASSERT_EQUAL(static_cast<uint8_t>(((7 + 3) ^ 0x5A) + 3), table[7]);
+
+    // Объединенный сдвиг выполняется векторной реализацией ROT3 на всех уровнях
+    ASSERT(encoder.addComposite("Rotation", { "ROT3", "ROT3", "Dummy", "ROT3" }));
+    ASSERT_EQUAL(1u, dynamic_cast<const CompositeEncoderExecutor*>(encoder.executor("Rotation").get())->stageCount());
+    const auto detected = detectedSimdLevel();
+    for (auto level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 })
+    {
+        setSimdLevel(level);
+        const auto rotated = encoder.executor("Rotation")->encode(message);
+        ASSERT_EQUAL(apply(message, { "ROT3", "ROT3", "ROT3" }), rotated);
+        ASSERT_EQUAL(message, encoder.executor("Rotation")->decode(rotated));
+    }
+    setSimdLevel(detected);
+
+    // Тождественная замена не выполняется; таблица, не являющаяся перестановкой, не объединяется
+    ASSERT(encoder.addComposite("Identity", { "Xor0", "Xor", "Xor" }));
+    ASSERT_EQUAL(0u, dynamic_cast<const CompositeEncoderExecutor*>(encoder.executor("Identity").get())->stageCount());
+    ASSERT_EQUAL(message, encoder.executor("Identity")->encode(message));
+    ASSERT(encoder.addComposite("NotPermutation", { "ROT3", "XorFF" }));
+    ASSERT_EQUAL(2u, dynamic_cast<const CompositeEncoderExecutor*>(encoder.executor("NotPermutation").get())->stageCount());
+    ASSERT_EQUAL(apply(message, { "ROT3", "XorFF" }), encoder.executor("NotPermutation")->encode(message));
+
+    // Звенья, меняющие размер, передают данные через промежуточный буфер
+    const std::vector<std::string> mixedStages = { "ROT3", "Xor", "Mirror", "ROT3", "Multiply41", "Xor" };
+    ASSERT(encoder.addComposite("Mixed", mixedStages));
+    const auto* mixed = dynamic_cast<const CompositeEncoderExecutor*>(encoder.executor("Mixed").get());
+    ASSERT_EQUAL(5u, mixed->stageCount());
+    ASSERT(!mixed->lengthPreserving());
+    ASSERT(!mixed->byteMap(table));
+    ASSERT_EQUAL(message.size() * 6, mixed->maxEncodedSize(message.size()));
+    ASSERT_EQUAL(message.size(), mixed->maxDecodedSize(message.size() * 6));
+    const auto mixedExpected = apply(message, mixedStages);
+    ASSERT_EQUAL(mixedExpected, mixed->encode(message));
+    ASSERT_EQUAL(message, mixed->decode(mixedExpected));
+    std::string encoded;
+    std::string decoded;
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT(mixed->encodeTo(message, encoded));
+        ASSERT_EQUAL(mixedExpected, encoded);
+        ASSERT(mixed->decodeTo(encoded, decoded));
+        ASSERT_EQUAL(message, decoded);
+    }
+    std::string buffer(mixedExpected.size(), '\0');
+    ASSERT_EQUAL(mixedExpected.size(), *mixed->encodeInto(message, &buffer[0], buffer.size()));
+    ASSERT_EQUAL(mixedExpected, buffer);
+    ASSERT(!mixed->encodeInto(message, &buffer[0], buffer.size() - 1).has_value());
+
+    // Вложенная цепочка разворачивается
+    ASSERT(encoder.addComposite("Nested", { "Mixed", "ROT3", "Fused" }));
+    const auto* nested = dynamic_cast<const CompositeEncoderExecutor*>(encoder.executor("Nested").get());
+    ASSERT_EQUAL(5u, nested->stageCount());
+    const auto nestedExpected = apply(mixedExpected, { "ROT3", "Fused" });
+    ASSERT_EQUAL(nestedExpected, nested->encode(message));
+    ASSERT_EQUAL(message, nested->decode(nestedExpected));
+
+    ASSERT(encoder.selectExecutor("Nested"));
+    const MessageVariant variant = MessageMeterage(123456789, 42);
+    ASSERT(MessagePipeline::encode(variant, *encoder.currentExecutor(), encoded, decoded));
+    ASSERT_EQUAL(encoder.encode(MessageSerializer::serialize(variant)), encoded);
+    const auto restored = MessagePipeline::decode(encoded, *encoder.currentExecutor(), decoded);
+    ASSERT(restored.has_value());
+    ASSERT_EQUAL(MessageSerializer::serialize(variant), MessageSerializer::serialize(*restored));
+}
+
+void streamDecoderTest()
+{
+    class StringOnlyEncoderExecutor : public BaseEncoderExecutor
+    {
+    public:
+        std::string encode(const std::string& message) const override final { return message + message; }
+        std::string decode(const std::string& message) const override final { return message.substr(0, message.size() / 2); }
+        std::string name() const override final { return "StringOnly"; }
+    };
+    MessageEncoder encoder;
+    ASSERT(encoder.addExecutor(new DummyEncoderExecutor()));
+    ASSERT(encoder.addExecutor(new StringOnlyEncoderExecutor()));
+    ASSERT(encoder.addComposite("Mixed", { "ROT3", "Mirror", "Multiply41" }));
+    ASSERT_EQUAL(6u, encoder.executor("Mixed")->encodedUnitSize());
+
+    std::string message;
+    for (int i = 0; i < 700; ++i)
+        message += static_cast<char>(i * 13);
+
+    for (auto name : { "Dummy", "ROT3", "Mirror", "Multiply41", "Mixed", "StringOnly" })
+    {
+        const auto executor = encoder.executor(name);
+        const size_t unit = executor->encodedUnitSize();
+        const auto encoded = executor->encode(message);
+        // Части разной длины, в том числе пустые и разрезающие единицы шифрования
+        for (size_t maxChunk : { 1u, 2u, 5u, 7u, 64u, 1000u })
+        {
+            StreamDecoder decoder(*executor);
+            std::string decoded;
+            size_t consumed = 0;
+            for (size_t k = 0; consumed < encoded.size(); ++k)
+            {
+                const size_t chunk = std::min((k * 7919) % (maxChunk + 1), encoded.size() - consumed);
+                const size_t before = decoded.size();
+                const size_t written = decoder.feed(std::string_view(encoded).substr(consumed, chunk), decoded);
+                consumed += chunk;
+                ASSERT_EQUAL(decoded.size() - before, written);
+                // Целые единицы расшифровываются сразу
+                if (unit)
+                {
+                    ASSERT_EQUAL(consumed / unit, decoded.size());
+                    ASSERT_EQUAL(consumed % unit, decoder.pendingSize());
+                }
+            }
+            ASSERT(decoder.finish(decoded) != std::string::npos);
+            ASSERT_EQUAL(message, decoded);
+            ASSERT_EQUAL(0u, decoder.pendingSize());
+        }
+    }
+
+    // Незавершенная единица в конце сообщения отбрасывается, reset() очищает состояние
+    StreamDecoder decoder(*encoder.executor("Mirror"));
+    const auto encoded = encoder.executor("Mirror")->encode("ab");
+    std::string decoded;
+    ASSERT_EQUAL(1u, decoder.feed(std::string_view(encoded).substr(0, 5), decoded));
+    ASSERT_EQUAL(2u, decoder.pendingSize());
+    ASSERT_EQUAL(0u, decoder.finish(decoded));
+    ASSERT_EQUAL(std::string("a"), decoded);
+    ASSERT_EQUAL(0u, decoder.feed(std::string_view(encoded).substr(0, 2), decoded));
+    decoder.reset();
+    ASSERT_EQUAL(2u, decoder.feed(encoded, decoded));
+    ASSERT_EQUAL(std::string("aab"), decoded);
+}
+
+void messagePipelineTest()
+{
+    class StringOnlyEncoderExecutor : public BaseEncoderExecutor
+    {
+    public:
+        std::string encode(const std::string& message) const override final { return message + message; }
+        std::string decode(const std::string& message) const override final { return message.substr(0, message.size() / 2); }
+        std::string name() const override final { return "StringOnly"; }
+    };
+    MessageEncoder encoder;
+    ASSERT(encoder.addExecutor(new StringOnlyEncoderExecutor()));
+
+    // Размеры покрывают векторные блоки всех алгоритмов, включая порог 256-битной реализации
+    std::vector<MessageVariant> messages = { MessageMeterage(1, 2), MessageCommand(-5), MessageError(MessageError::ErrorType::NoSchedule) };
+    for (size_t count : { 1u, 3u, 10u, 500u, 1000u })
+    {
+        std::vector<MessageBatch::Record> records;
+        for (size_t i = 0; i < count; ++i)
+            records.push_back(MessageMeterage(i * 1000003, static_cast<uint8_t>(i * 13)));
+        messages.push_back(*MessageBatch::create(std::move(records)));
+    }
+
+    const auto detected = detectedSimdLevel();
+    for (auto level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Ssse3, SimdLevel::Avx2 })
+    {
+        setSimdLevel(level);
+        for (auto name : { "ROT3", "Mirror", "Multiply41", "StringOnly" })
+        {
+            const auto executor = encoder.executor(name);
+            ASSERT(executor != nullptr);
+            std::string encoded;
+            std::string scratch;
+            std::string decoded;
+            for (const auto& message : messages)
+            {
+                const auto serialized = MessageSerializer::serialize(message);
+                ASSERT(MessagePipeline::encode(message, *executor, encoded, scratch));
+                ASSERT_EQUAL(executor->encode(serialized), encoded);
+
+                const auto restored = MessagePipeline::decode(encoded, *executor, decoded);
+                ASSERT(restored.has_value());
+                ASSERT_EQUAL(serialized, MessageSerializer::serialize(*restored));
+            }
+        }
+
+        // Шифрование из конца буфера на произвольных данных и длинах
+        for (auto name : { "Mirror", "Multiply41" })
+        {
+            const auto executor = encoder.executor(name);
+            for (size_t size : { 0u, 1u, 2u, 9u, 10u, 11u, 17u, 31u, 33u, 64u, 100u, 4096u, 5003u })
+            {
+                std::string message;
+                for (size_t i = 0; i < size; ++i)
+                    message += static_cast<char>(i * 31 + 7);
+                std::string buffer(executor->maxEncodedSize(size), '\0');
+                message.copy(&buffer[buffer.size() - size], size);
+                const auto written = executor->encodeFromTail(&buffer[0], size);
+                ASSERT(written.has_value());
+                ASSERT_EQUAL(executor->encode(message), buffer.substr(0, *written));
+            }
+        }
+    }
+    setSimdLevel(detected);
+    ASSERT(!encoder.executor("StringOnly")->encodeFromTail(nullptr, 0).has_value());
+}
+
 void messageEncoderRot3Test()
 {
     MessageEncoder encoder;
@@ -395,6 +1819,37 @@ void messageEncoderRot3Test()
     ASSERT_EQUAL(message, decoded);
 }
 
+void messageEncoderRot3SimdTest()
+{
+    MessageEncoder encoder;
+    ASSERT(encoder.selectExecutor("ROT3"));
+    // Длины покрывают векторные блоки 16 и 32 байта и скалярный остаток
+    std::vector<size_t> sizes;
+    for (size_t size = 0; size <= 80; ++size)
+        sizes.push_back(size);
+    sizes.push_back(1024u);
+    sizes.push_back(4099u);
+
+    const auto detected = detectedSimdLevel();
+    for (auto size : sizes)
+    {
+        std::string message(size, '\0'), expected(size, '\0');
+        for (size_t i = 0; i < size; ++i)
+        {
+            message[i] = static_cast<char>(i * 131 + 7);
+            expected[i] = static_cast<char>(static_cast<uint8_t>(message[i]) + 3);
+        }
+        for (auto level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Ssse3, SimdLevel::Avx2 })
+        {
+            setSimdLevel(level);
+            auto encoded = encoder.encode(message);
+            ASSERT_EQUAL(expected, encoded);
+            ASSERT_EQUAL(message, encoder.decode(encoded));
+        }
+    }
+    setSimdLevel(detected);
+}
+
 void messageEncoderMirrorTest()
 {
     MessageEncoder encoder;
@@ -456,6 +1911,63 @@ void messageEncoderMirrorTest()
     ASSERT_EQUAL(message, decoded);
 }
 
+void messageEncoderMirrorTableTest()
+{
+    // Эталонная реализация по определению: количество цифр и зеркальное значение
+    auto digits = [](int value) {
+        int digits = 0;
+        for (; value > 0; value /= 10)
+            ++digits;
+        return digits;
+    };
+    auto mirror = [](int value, int digits) {
+        int result = 0;
+        for (int i = 0; i < digits; ++i, value /= 10)
+            result = (result * 10 + value % 10) & 0xFFFF;
+        return result;
+    };
+
+    MessageEncoder encoder;
+    ASSERT(encoder.selectExecutor("Mirror"));
+    const auto detected = detectedSimdLevel();
+    for (size_t size : { 0u, 1u, 7u, 8u, 9u, 10u, 17u, 256u, 1001u })
+    {
+        std::string message(size, '\0'), expected;
+        for (size_t i = 0; i < size; ++i)
+        {
+            message[i] = static_cast<char>(i * 97 + 13);
+            const int c = static_cast<uint8_t>(message[i]);
+            const int value = mirror(c, digits(c));
+            expected += static_cast<char>(digits(c));
+            expected += static_cast<char>(value >> 8);
+            expected += static_cast<char>(value & 0xFF);
+        }
+        for (auto level : { SimdLevel::Scalar, SimdLevel::Avx2 })
+        {
+            setSimdLevel(level);
+            auto encoded = encoder.encode(message);
+            ASSERT_EQUAL(expected, encoded);
+            ASSERT_EQUAL(message, encoder.decode(encoded));
+        }
+    }
+    setSimdLevel(detected);
+
+    // Тройки, не получаемые при кодировании, декодируются так же, как вычислением
+    std::string encoded;
+    std::string expected;
+    for (int digs : { 0, 1, 3, 4, 5, 255 })
+    {
+        for (int value : { 0, 7, 998, 999, 1000, 4321, 65535 })
+        {
+            encoded += static_cast<char>(digs);
+            encoded += static_cast<char>(value >> 8);
+            encoded += static_cast<char>(value & 0xFF);
+            expected += static_cast<char>(mirror(value, digs));
+        }
+    }
+    ASSERT_EQUAL(expected, encoder.decode(encoded + "xy"));
+}
+
 void messageEncoderMultiply41Test()
 {
     MessageEncoder encoder;
@@ -502,6 +2014,124 @@ void messageEncoderMultiply41Test()
     ASSERT_EQUAL(message, decoded);
 }
 
+void messageEncoderMultiply41SimdTest()
+{
+    MessageEncoder encoder;
+    ASSERT(encoder.selectExecutor("Multiply41"));
+    const auto detected = detectedSimdLevel();
+
+    // Все 65536 двухбайтовых значений, включая не получаемые при кодировании, плюс непарный байт
+    std::string all;
+    std::string expectedDecoded;
+    for (uint32_t value = 0; value <= UINT16_MAX; ++value)
+    {
+        all += static_cast<char>(value >> 8);
+        all += static_cast<char>(value & 0xFF);
+        expectedDecoded += static_cast<char>(value / 41);
+    }
+    all += 'x';
+
+    for (auto level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Ssse3, SimdLevel::Avx2 })
+    {
+        setSimdLevel(level);
+        ASSERT_EQUAL(expectedDecoded, encoder.decode(all));
+        std::vector<size_t> sizes;
+        for (size_t size = 0; size <= 100; ++size)
+            sizes.push_back(size);
+        // Длинные сообщения обрабатываются 256-битной реализацией
+        sizes.push_back(4096u);
+        sizes.push_back(5000u);
+        for (auto size : sizes)
+        {
+            std::string message(size, '\0'), expected;
+            for (size_t i = 0; i < size; ++i)
+            {
+                message[i] = static_cast<char>(i * 59 + 201);
+                const uint16_t value = static_cast<uint8_t>(message[i]) * 41;
+                expected += static_cast<char>(value >> 8);
+                expected += static_cast<char>(value & 0xFF);
+            }
+            auto encoded = encoder.encode(message);
+            ASSERT_EQUAL(expected, encoded);
+            ASSERT_EQUAL(message, encoder.decode(encoded));
+            ASSERT_EQUAL(message, encoder.decode(encoded + 'x'));
+        }
+    }
+    setSimdLevel(detected);
+}
+
+void messageEncoderAes128CtrTest()
+{
+    using Aes = Aes128CtrEncoderExecutor;
+    auto fromHex = [](const char* hex) {
+        Aes::Block block;
+        for (size_t i = 0; i < block.size(); ++i)
+            block[i] = static_cast<uint8_t>(std::stoul(std::string(hex + 2 * i, 2), nullptr, 16));
+        return block;
+    };
+    const auto detected = detectedSimdLevel();
+    const Aes::Key key = fromHex("000102030405060708090a0b0c0d0e0f");
+
+    std::string message(1000, '\0');
+    for (size_t i = 0; i < message.size(); ++i)
+        message[i] = static_cast<char>(i * 31 + 7);
+    std::string reference;
+    for (auto level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Ssse3, SimdLevel::Avx2 })
+    {
+        setSimdLevel(level);
+        // FIPS-197, приложение C.1; SP 800-38A, F.5.1 (первый блок ключевого потока)
+        ASSERT(fromHex("69c4e0d86a7b0430d8cdb78070b4c55a") == Aes::encryptBlock(key, fromHex("00112233445566778899aabbccddeeff")));
+        ASSERT(fromHex("ec8cdf7398607cb0f2d21675ea9ea1e4")
+               == Aes::encryptBlock(fromHex("2b7e151628aed2a6abf7158809cf4f3c"), fromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff")));
+
+        // Блок счетчика: nonce и номер блока в big-endian
+        Aes sender(key, 0x0102030405060708u, 42u);
+        const auto keyStream = sender.encode(std::string(40, '\0'));
+        for (uint8_t block = 0; block < 3; ++block)
+        {
+            const auto expected = Aes::encryptBlock(key, { 1, 2, 3, 4, 5, 6, 7, 8, 0, 0, 0, 0, 0, 0, 0, block });
+            ASSERT_EQUAL(std::string(reinterpret_cast<const char*>(expected.data()), std::min<size_t>(16u, 40u - block * 16u)),
+                         keyStream.substr(block * 16u, 16u));
+        }
+
+        // Сообщения занимают последовательные участки ключевого потока
+        Aes whole(key, 1u, 2u);
+        const auto encoded = whole.encode(message);
+        if (reference.empty())
+            reference = encoded;
+        ASSERT_EQUAL(reference, encoded);
+        ASSERT(encoded != message);
+        for (size_t split : { 1u, 3u, 15u, 16u, 17u, 100u, 511u })
+        {
+            Aes parts(key, 1u, 2u);
+            std::string encodedParts = parts.encode(message.substr(0, split));
+            encodedParts += parts.encode(message.substr(split, 200u));
+            std::string tail = message.substr(split + 200u);
+            ASSERT(parts.encodeInPlace(&tail[0], tail.size()));
+            ASSERT_EQUAL(encoded, encodedParts + tail);
+        }
+
+        // Получатель расшифровывает своим nonce входящих сообщений
+        Aes receiver(key, 2u, 1u);
+        std::string decoded(message.size(), '\0');
+        ASSERT_EQUAL(500u, *receiver.decodeInto(encoded.substr(0, 500u), &decoded[0], decoded.size()));
+        ASSERT(!receiver.decodeInto(encoded, &decoded[0], 10u));
+        ASSERT_EQUAL(500u, *receiver.decodeInto(encoded.substr(500u), &decoded[500], decoded.size() - 500u));
+        ASSERT_EQUAL(message, decoded);
+        // Ответ получателя шифруется другим ключевым потоком
+        const auto reply = receiver.encode(message);
+        ASSERT(reply != encoded);
+        ASSERT_EQUAL(message, whole.decode(reply));
+    }
+    setSimdLevel(detected);
+
+    // Nonce берутся из генератора ОС: ненулевые и не повторяются
+    std::set<uint64_t> nonces;
+    for (int i = 0; i < 1000; ++i)
+        ASSERT(nonces.insert(Aes::randomNonce()).second);
+    ASSERT(!nonces.count(0u));
+}
+
 void commandCenterNoScheduleTest()
 {
     CommandCenter center;
@@ -689,6 +2319,48 @@ void commandCenterNewScheduleTest()
     COMPARE_VECTORS_OF_SMART_PTRS(expected, messages);
 }
 
+void commandCenterValueTest()
+{
+    CommandCenter center;
+    uint64_t deviceId = 123u;
+    std::vector<MessageVariant> messages;
+    messages.push_back(center.processMeterageValue(deviceId, MessageMeterage(0u, 100u)));
+    center.setSchedule({ deviceId, { { 2u, 50u } } });
+    messages.push_back(center.processMeterageValue(deviceId, MessageMeterage(1u, 100u)));
+    messages.push_back(center.processMeterageValue(deviceId, MessageMeterage(2u, 100u)));
+    messages.push_back(center.processMeterageValue(deviceId, MessageMeterage(2u, 100u)));
+    std::vector<MessageVariant> expected = {
+        MessageError(MessageError::ErrorType::NoSchedule),
+        MessageError(MessageError::ErrorType::NoTimestamp),
+        MessageCommand(-50),
+        MessageError(MessageError::ErrorType::Obsolete),
+    };
+    ASSERT_EQUAL(expected, messages);
+}
+
+void commandCenterBatchTest()
+{
+    CommandCenter center;
+    uint64_t deviceId = 123u;
+    center.setSchedule({ deviceId, { { 1u, 50u } } });
+    const auto batch = MessageBatch::create({
+        MessageMeterage(0u, 10u),
+        MessageMeterage(1u, 10u),
+        MessageCommand(1),
+        MessageMeterage(1u, 10u),
+        MessageMeterage(2u, 60u),
+    });
+    const auto expected = MessageBatch::create({
+        MessageError(MessageError::ErrorType::NoTimestamp),
+        MessageCommand(40),
+        MessageError(MessageError::ErrorType::Obsolete),
+        MessageCommand(-10),
+    });
+    ASSERT(batch && expected);
+    ASSERT_EQUAL(static_cast<const Message&>(*expected), center.processMeterages(deviceId, *batch));
+    ASSERT(center.processMeterages(deviceId, MessageBatch()).records().empty());
+}
+
 void commandCenterDeviationTest()
 {
     CommandCenter center;
@@ -783,3 +2455,110 @@ void commandCenterForgetTest()
     deviations = center.deviationStats(deviceId);
     ASSERT_EQUAL(0u, deviations.size());
 }
+
+void deviceDirectoryTest()
+{
+    DeviceDirectory directory;
+    CommandCenter shard0, shard1;
+    const uint64_t deviceId = 123u, otherId = 456u;
+    std::vector<std::shared_ptr<Message>> messages;
+
+    // План неподключенного устройства хранится в справочнике
+    ASSERT_EQUAL(directory.accessDetached(deviceId, [&](CommandCenter& center) { center.setSchedule({ deviceId, { { 0u, 10u } } }); }),
+                 DeviceDirectory::noShard);
+    shard1.setSchedule({ otherId, { { 0u, 1u } } });
+
+    ASSERT(directory.attach(deviceId, 0, shard0));
+    ASSERT_EQUAL(directory.shardOf(deviceId), 0u);
+    ASSERT(!directory.attach(deviceId, 1, shard1)); // Второе соединение устройства
+    ASSERT_EQUAL(directory.accessDetached(deviceId, [](CommandCenter&) { ASSERT(false); }), 0u);
+    messages.push_back(shard0.processMeterage(deviceId, MessageMeterage(0u, 7u)));
+    messages.push_back(shard1.processMeterage(deviceId, MessageMeterage(1u, 7u)));
+
+    // Отключение от чужого шарда не действует
+    directory.detach(deviceId, 1, shard1);
+    ASSERT_EQUAL(directory.shardOf(deviceId), 0u);
+    directory.detach(deviceId, 0, shard0);
+    ASSERT_EQUAL(directory.shardOf(deviceId), DeviceDirectory::noShard);
+    ASSERT_EQUAL(shard0.deviationStats(deviceId).size(), 0u);
+    std::vector<DeviationStats> deviations;
+    directory.accessDetached(deviceId, [&](CommandCenter& center) { deviations = center.deviationStats(deviceId); });
+    ASSERT_EQUAL(deviations.size(), 1u);
+    ASSERT_WITH_THRESHOLD(deviations[0].deviation, 3.0, 1e-9);
+
+    // Информация об устройстве переходит к новому шарду вместе с последней меткой времени
+    ASSERT(directory.attach(deviceId, 1, shard1));
+    messages.push_back(shard1.processMeterage(deviceId, MessageMeterage(0u, 7u)));
+    messages.push_back(shard1.processMeterage(deviceId, MessageMeterage(1u, 13u)));
+    deviations = shard1.deviationStats(deviceId);
+    ASSERT_EQUAL(deviations.size(), 1u);
+    ASSERT_EQUAL(deviations[0].firstTimestamp, 0u);
+    ASSERT_WITH_THRESHOLD(deviations[0].deviation, 3.0, 1e-9);
+
+    // Справочник ничего не знает о другом устройстве: у шарда оно забирается
+    ASSERT(directory.attach(otherId, 1, shard1));
+    messages.push_back(shard1.processMeterage(otherId, MessageMeterage(0u, 0u)));
+
+    std::vector<std::shared_ptr<Message>> expected = {
+        std::shared_ptr<Message>(new MessageCommand(3)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoSchedule)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::Obsolete)),
+        std::shared_ptr<Message>(new MessageCommand(-3)),
+        std::shared_ptr<Message>(new MessageError(MessageError::ErrorType::NoSchedule)),
+    };
+    COMPARE_VECTORS_OF_SMART_PTRS(expected, messages);
+}
+
+void commandCenterMultiChannelTest()
+{
+    // Количество каналов не кратно ширине вектора: проверяется и векторная часть, и остаток
+    const size_t channelCount = 37;
+    std::vector<uint8_t> targets(channelCount), meterages(channelCount);
+    std::vector<int8_t> expectedCommands(channelCount);
+    for (size_t i = 0; i < channelCount; ++i)
+    {
+        targets[i] = static_cast<uint8_t>(i * 7);
+        meterages[i] = static_cast<uint8_t>(255 - i * 5);
+        expectedCommands[i] = static_cast<int8_t>(int(targets[i]) - int(meterages[i]));
+    }
+
+    const auto detected = detectedSimdLevel();
+    for (auto level : { SimdLevel::Scalar, SimdLevel::Sse2 })
+    {
+        setSimdLevel(level);
+        CommandCenter center;
+        uint64_t deviceId = 123u;
+        ASSERT_EQUAL(MessageVariant(MessageError(MessageError::ErrorType::NoSchedule)),
+                     center.processMultiMeterage(deviceId, MessageMultiMeterage(0u, meterages)));
+        center.setMultiChannelSchedule({ deviceId, { { 3u, std::vector<uint8_t>(channelCount, 10u) }, { 2u, targets } } });
+        ASSERT_EQUAL(MessageVariant(MessageError(MessageError::ErrorType::NoTimestamp)),
+                     center.processMultiMeterage(deviceId, MessageMultiMeterage(1u, meterages)));
+        ASSERT_EQUAL(MessageVariant(MessageMultiCommand(expectedCommands)),
+                     center.processMultiMeterage(deviceId, MessageMultiMeterage(2u, meterages)));
+        ASSERT_EQUAL(MessageVariant(MessageError(MessageError::ErrorType::Obsolete)),
+                     center.processMultiMeterage(deviceId, MessageMultiMeterage(2u, meterages)));
+        ASSERT_EQUAL(MessageVariant(MessageError(MessageError::ErrorType::NoSchedule)),
+                     center.processMultiMeterage(deviceId, MessageMultiMeterage(3u, { 1u, 2u })));
+        ASSERT_EQUAL(MessageVariant(MessageMultiCommand(std::vector<int8_t>(channelCount, 0))),
+                     center.processMultiMeterage(deviceId, MessageMultiMeterage(4u, std::vector<uint8_t>(channelCount, 10u))));
+        ASSERT_EQUAL(MessageVariant(MessageMultiCommand(std::vector<int8_t>(channelCount, 4))),
+                     center.processMultiMeterage(deviceId, MessageMultiMeterage(5u, std::vector<uint8_t>(channelCount, 6u))));
+
+        const auto stats = center.multiChannelDeviationStats(deviceId);
+        ASSERT_EQUAL(2u, stats.size());
+        ASSERT_EQUAL(2u, stats[0].firstTimestamp);
+        ASSERT_EQUAL(targets, stats[0].phase.values);
+        ASSERT_EQUAL(channelCount, stats[0].deviations.size());
+        for (size_t i = 0; i < channelCount; ++i)
+            ASSERT_WITH_THRESHOLD(std::abs(double(int(targets[i]) - int(meterages[i]))), stats[0].deviations[i], 1e-9);
+        // Разность 0 - 255 не помещается в команду int8_t, но отклонение вычисляется без усечения
+        ASSERT_WITH_THRESHOLD(255.0, stats[0].deviations[0], 1e-9);
+        ASSERT_EQUAL(4u, stats[1].firstTimestamp);
+        for (auto deviation : stats[1].deviations)
+            ASSERT_WITH_THRESHOLD(std::sqrt(8.0), deviation, 1e-9);
+
+        center.forgetDevice(deviceId);
+        ASSERT(center.multiChannelDeviationStats(deviceId).empty());
+    }
+    setSimdLevel(detected);
+}
@@ -8,17 +8,52 @@ void monitoringServerTestNoTimeStamp();
 void monitoringServerTestTwoDevices();
 void monitoringServerCryptoPositiveTest();
 void monitoringServerCryptoNegativeTest();
+void monitoringServerBatchTest();
+void monitoringServerWireV2Test();
+void monitoringServerWireV2BatchTest();
+void monitoringServerWireV2NotNegotiatedTest();
+void monitoringServerMultiChannelTest();
+void monitoringServerHandshakeTest();
+void monitoringServerHandshakeViolationTest();
+void monitoringServerHandshakeUnsupportedTest();
+void monitoringServerAesHandshakeTest();
+void monitoringServerTcpTest();
+void monitoringServerIoUringTest();
+void monitoringServerShmTest();
+void monitoringServerUdpTest();
+void monitoringServerShardedTest();
 
 void messageSerializationTest();
+void messageValueSerializationTest();
+void messageBufferSerializationTest();
+void messageViewDeserializationTest();
+void messageRegistryTest();
+void bigEndianTest();
+void messageBatchSerializationTest();
+void varintTest();
+void messageMeterageDeltaSerializationTest();
+void messageMultiChannelSerializationTest();
+void messageHandshakeSerializationTest();
 
 void messageEncoderEmptyTest();
 void messageEncoderDummyTest();
 void messageEncoderNegativeTest();
 void messageEncoderAddTest();
 void messageEncoderDoubleAddTest();
+void messageEncoderLookupTest();
+void messageEncoderSharedRegistryTest();
+void messageEncoderHotSwapTest();
+void messageEncoderBufferTest();
+void messageEncoderCompositeTest();
+void messagePipelineTest();
+void streamDecoderTest();
 void messageEncoderRot3Test();
+void messageEncoderRot3SimdTest();
 void messageEncoderMirrorTest();
+void messageEncoderMirrorTableTest();
 void messageEncoderMultiply41Test();
+void messageEncoderMultiply41SimdTest();
+void messageEncoderAes128CtrTest();
 
 void commandCenterNoScheduleTest();
 void commandCenterObsoleteTest();
@@ -33,5 +68,9 @@ void commandCenterNewScheduleTest();
 void commandCenterUnsortedScheduleTest();
 void commandCenterDublicateScheduleTest();
 void commandCenterForgetTest();
+void deviceDirectoryTest();
+void commandCenterValueTest();
+void commandCenterBatchTest();
+void commandCenterMultiChannelTest();
 
 #endif // TESTS_H
@@ -0,0 +1,164 @@
+#include "udpbatch.h"
+
+#include <algorithm>
+#include <cerrno>
+
+namespace
+{
+
+/*!
+ * \brief Размер буфера под одну датаграмму: не меньше UdpDatagram::maxSize()
+ */
+constexpr size_t slotSize = 64 * 1024;
+
+bool sameAddress(const sockaddr_in& left, const sockaddr_in& right)
+{
+    return left.sin_addr.s_addr == right.sin_addr.s_addr && left.sin_port == right.sin_port;
+}
+
+} // namespace
+
+UdpReceiveBatch::UdpReceiveBatch(size_t size) :
+    m_parts(std::min(std::max<size_t>(size, 1), UdpDatagram::maxBatchSize())),
+    m_headers(m_parts.size()),
+    m_addresses(m_parts.size())
+{
+    m_buffer = new char[m_parts.size() * slotSize];
+    for (size_t i = 0; i < m_parts.size(); ++i)
+        m_parts[i] = { m_buffer + i * slotSize, slotSize };
+}
+
+UdpReceiveBatch::~UdpReceiveBatch()
+{
+    delete[] m_buffer;
+}
+
+int UdpReceiveBatch::receive(int fd)
+{
+    for (size_t i = 0; i < m_headers.size(); ++i)
+    {
+        msghdr& header = m_headers[i].msg_hdr;
+        header = {};
+        header.msg_name = &m_addresses[i];
+        header.msg_namelen = sizeof(m_addresses[i]);
+        header.msg_iov = &m_parts[i];
+        header.msg_iovlen = 1;
+        m_headers[i].msg_len = 0;
+    }
+    int count = 0;
+    do
+        count = recvmmsg(fd, m_headers.data(), static_cast<unsigned int>(m_headers.size()), 0, nullptr);
+    while (count < 0 && errno == EINTR);
+    if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    return count;
+}
+
+std::string_view UdpReceiveBatch::datagram(size_t index) const
+{
+    if (m_headers[index].msg_hdr.msg_flags & MSG_TRUNC)
+        return {};
+    return std::string_view(static_cast<const char*>(m_parts[index].iov_base), m_headers[index].msg_len);
+}
+
+UdpSendQueue::UdpSendQueue() :
+    m_parts(UdpDatagram::maxBatchSize()),
+    m_headers(UdpDatagram::maxBatchSize())
+{
+}
+
+bool UdpSendQueue::appendMessage(const sockaddr_in& address, uint64_t deviceId, std::string_view message)
+{
+    if (message.size() > UdpDatagram::maxMessageSize())
+        return false;
+    Datagram* datagram = nullptr;
+    const auto it = m_open.find(deviceId);
+    if (it != m_open.end() && it->second >= m_begin && it->second < m_end)
+    {
+        Datagram& open = m_datagrams[it->second];
+        if (sameAddress(open.address, address)
+            && open.data.size() + UdpDatagram::frameHeaderSize() + message.size() <= UdpDatagram::coalesceSize())
+            datagram = &open;
+    }
+    if (!datagram)
+    {
+        datagram = push(address, deviceId, UdpDatagramType::Data);
+        if (!datagram)
+            return false;
+        m_open[deviceId] = m_end - 1;
+    }
+    UdpDatagram::appendMessage(datagram->data, message);
+    return true;
+}
+
+bool UdpSendQueue::appendControl(const sockaddr_in& address, uint64_t deviceId, UdpDatagramType type)
+{
+    // Следующие сообщения не должны попасть в датаграмму, стоящую в очереди раньше этой
+    m_open.erase(deviceId);
+    return push(address, deviceId, type) != nullptr;
+}
+
+bool UdpSendQueue::flush(int fd, bool connected)
+{
+    bool result = true;
+    while (m_begin < m_end)
+    {
+        const size_t count = std::min(m_end - m_begin, m_headers.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            Datagram& datagram = m_datagrams[m_begin + i];
+            m_parts[i] = { &datagram.data[0], datagram.data.size() };
+            msghdr& header = m_headers[i].msg_hdr;
+            header = {};
+            if (!connected)
+            {
+                header.msg_name = &datagram.address;
+                header.msg_namelen = sizeof(datagram.address);
+            }
+            header.msg_iov = &m_parts[i];
+            header.msg_iovlen = 1;
+        }
+        const int sent = sendmmsg(fd, m_headers.data(), static_cast<unsigned int>(count), MSG_NOSIGNAL);
+        if (sent > 0)
+            m_begin += static_cast<size_t>(sent);
+        else if (sent < 0 && errno == EINTR)
+            continue;
+        else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return result; // Остаток отправится по EPOLLOUT
+        else
+        {
+            // Ошибка относится к первой датаграмме пачки (например, ICMP о недоступности получателя)
+            ++m_begin;
+            result = false;
+        }
+    }
+    clear();
+    return result;
+}
+
+void UdpSendQueue::clear()
+{
+    m_begin = m_end = 0;
+    m_open.clear();
+}
+
+UdpSendQueue::Datagram* UdpSendQueue::push(const sockaddr_in& address, uint64_t deviceId, UdpDatagramType type)
+{
+    if (m_end - m_begin >= maxDatagrams())
+        return nullptr;
+    if (m_end == maxDatagrams())
+    {
+        // Начало очереди уже отправлено: ожидающие датаграммы переносятся в начало вместе с буферами
+        std::rotate(m_datagrams.begin(), m_datagrams.begin() + static_cast<std::ptrdiff_t>(m_begin),
+                    m_datagrams.begin() + static_cast<std::ptrdiff_t>(m_end));
+        m_end -= m_begin;
+        m_begin = 0;
+        m_open.clear();
+    }
+    if (m_end == m_datagrams.size())
+        m_datagrams.emplace_back();
+    Datagram& datagram = m_datagrams[m_end++];
+    datagram.address = address;
+    UdpDatagram::writeHeader(datagram.data, deviceId, type);
+    return &datagram;
+}
@@ -0,0 +1,117 @@
+#ifndef UDPBATCH_H
+#define UDPBATCH_H
+
+#include "../common.h"
+#include "udpdatagram.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ * \brief Прием датаграмм пачками через recvmmsg.
+ *
+ * Буферы под датаграммы наибольшего размера выделяются один раз и переиспользуются.
+ */
+class UdpReceiveBatch
+{
+    NON_COPYABLE(UdpReceiveBatch)
+public:
+    /*!
+     * \brief Конструктор.
+     * \param size - число датаграмм, принимаемых за вызов, не больше UdpDatagram::maxBatchSize()
+     */
+    explicit UdpReceiveBatch(size_t size = UdpDatagram::maxBatchSize());
+    ~UdpReceiveBatch();
+
+    size_t size() const { return m_headers.size(); }
+    /*!
+     * \brief Принять до size() датаграмм из неблокирующего сокета \a fd.
+     * \return число принятых датаграмм; 0, если датаграмм нет; -1 в случае ошибки (errno)
+     */
+    int receive(int fd);
+    /*!
+     * \brief Датаграмма \a index из последнего приема; обрезанная датаграмма пуста.
+     */
+    std::string_view datagram(size_t index) const;
+    /*!
+     * \brief Адрес отправителя датаграммы \a index из последнего приема.
+     */
+    const sockaddr_in& address(size_t index) const { return m_addresses[index]; }
+
+private:
+    char* m_buffer = nullptr;
+    std::vector<iovec> m_parts;
+    std::vector<mmsghdr> m_headers;
+    std::vector<sockaddr_in> m_addresses;
+};
+
+/*!
+ * \brief Очередь датаграмм на отправку пачками через sendmmsg.
+ *
+ * Сообщения одному устройству по одному адресу, поставленные в очередь до отправки, объединяются
+ * в одну датаграмму, пока она не превысит UdpDatagram::coalesceSize(). Буферы отправленных
+ * датаграмм переиспользуются.
+ */
+class UdpSendQueue
+{
+    NON_COPYABLE(UdpSendQueue)
+public:
+    /*!
+     * \brief Наибольшее число датаграмм в очереди; сообщения сверх него отбрасываются,
+     * как при переполнении буфера сокета
+     */
+    static constexpr size_t maxDatagrams() { return 4096; }
+
+    UdpSendQueue();
+
+    bool empty() const { return m_begin == m_end; }
+    /*!
+     * \brief Поставить в очередь сообщение \a message устройству \a deviceId по адресу \a address.
+     * \return false, если сообщение больше UdpDatagram::maxMessageSize() или очередь заполнена
+     */
+    bool appendMessage(const sockaddr_in& address, uint64_t deviceId, std::string_view message);
+    /*!
+     * \brief Поставить в очередь датаграмму типа \a type без сообщений.
+     * \return false, если очередь заполнена
+     */
+    bool appendControl(const sockaddr_in& address, uint64_t deviceId, UdpDatagramType type);
+    /*!
+     * \brief Отправить датаграммы через неблокирующий сокет \a fd.
+     * \param connected - сокет подключен через connect(), адрес получателя не указывается
+     * \return false, если отправка какой-либо датаграммы завершилась ошибкой, кроме EAGAIN;
+     * такая датаграмма отбрасывается. Датаграммы, не принятые из-за EAGAIN, остаются в очереди
+     */
+    bool flush(int fd, bool connected);
+    /*!
+     * \brief Отбросить все датаграммы.
+     */
+    void clear();
+
+private:
+    struct Datagram
+    {
+        sockaddr_in address {};
+        std::string data;
+    };
+
+    /*!
+     * \brief Добавить в конец очереди датаграмму с заголовком.
+     * \return nullptr, если очередь заполнена
+     */
+    Datagram* push(const sockaddr_in& address, uint64_t deviceId, UdpDatagramType type);
+
+private:
+    std::vector<Datagram> m_datagrams; ///< Датаграммы [m_begin, m_end) ждут отправки
+    size_t m_begin = 0;
+    size_t m_end = 0;
+    std::unordered_map<uint64_t, size_t> m_open; ///< Датаграммы Data, к которым еще можно добавить сообщения, по устройствам
+    std::vector<iovec> m_parts;
+    std::vector<mmsghdr> m_headers;
+};
+
+#endif // UDPBATCH_H
@@ -0,0 +1,209 @@
+#include "udpclientconnection.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractmessagehandler.h>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace
+{
+
+/*!
+ * \brief Действие с клиентом, которое пропускается, если клиент уже удален
+ */
+template <void (UdpClientConnection::*method)()>
+struct ClientAction final : public AbstractAction
+{
+    ClientAction(UdpClientConnection* client) :
+        m_client(client) {}
+
+    void operator()() final
+    {
+        auto* client = dynamic_cast<UdpClientConnection*>(m_client.data());
+        if (client)
+            (client->*method)();
+    }
+
+private:
+    SafeObjectPointer m_client;
+};
+
+} // namespace
+
+UdpClientConnection::UdpClientConnection(EventLoop& eventLoop, std::string host) :
+    m_eventLoop(eventLoop), m_host(std::move(host)), m_socketHandler(this), m_receiveBatch(receiveBatchSize())
+{
+}
+
+UdpClientConnection::~UdpClientConnection()
+{
+    if (m_fd >= 0)
+    {
+        m_eventLoop.remove(m_fd);
+        ::close(m_fd);
+    }
+    delete m_messageHandler;
+    delete m_connectedHandler;
+    delete m_disconnectedHandler;
+}
+
+bool UdpClientConnection::bind(uint64_t clientId)
+{
+    if (!clientId || clientId == m_clientId || m_state != State::Idle)
+        return false;
+    m_clientId = clientId;
+    return true;
+}
+
+bool UdpClientConnection::connectToHost(uint64_t serverId)
+{
+    if (!m_clientId || !serverId || serverId > UINT16_MAX || m_state != State::Idle)
+        return false;
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(serverId));
+    if (inet_pton(AF_INET, m_host.c_str(), &address.sin_addr) != 1)
+        return false;
+    const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    // Подключенный сокет принимает датаграммы только от сервера и получает ошибки ICMP
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || !m_eventLoop.add(fd, EPOLLIN | EPOLLOUT | EPOLLET, &m_socketHandler))
+    {
+        ::close(fd);
+        return false;
+    }
+    m_fd = fd;
+    m_serverId = serverId;
+    m_serverAddress = address;
+    m_state = State::Connecting;
+    m_wasConnected = false;
+    m_sendQueue.appendControl(m_serverAddress, m_clientId, UdpDatagramType::Connect);
+    scheduleFlush();
+    m_eventLoop.post(new ClientAction<&UdpClientConnection::onConnected>(this));
+    return true;
+}
+
+void UdpClientConnection::setConnectedHandler(AbstractAction* handler)
+{
+    delete m_connectedHandler;
+    m_connectedHandler = handler;
+}
+
+uint64_t UdpClientConnection::peerId() const
+{
+    return connected() ? m_serverId : 0;
+}
+
+void UdpClientConnection::disconnect()
+{
+    if (m_fd < 0)
+        return;
+    m_sendQueue.appendControl(m_serverAddress, m_clientId, UdpDatagramType::Disconnect);
+    m_sendQueue.flush(m_fd, true);
+    close();
+}
+
+void UdpClientConnection::sendMessage(const std::string& message)
+{
+    if (m_fd >= 0 && m_sendQueue.appendMessage(m_serverAddress, m_clientId, message))
+        scheduleFlush();
+}
+
+void UdpClientConnection::setMessageHandler(AbstractMessageHandler* handler)
+{
+    delete m_messageHandler;
+    m_messageHandler = handler;
+}
+
+void UdpClientConnection::setDisconnectedHandler(AbstractAction* handler)
+{
+    delete m_disconnectedHandler;
+    m_disconnectedHandler = handler;
+}
+
+void UdpClientConnection::onConnected()
+{
+    if (m_state != State::Connecting)
+        return;
+    m_state = State::Connected;
+    m_wasConnected = true;
+    if (m_connectedHandler)
+        (*m_connectedHandler)();
+}
+
+void UdpClientConnection::onDisconnected()
+{
+    // Состояние сбрасывается до вызова обработчика, чтобы из него можно было подключиться снова
+    const bool wasConnected = m_wasConnected;
+    m_state = State::Idle;
+    m_wasConnected = false;
+    if (wasConnected && m_disconnectedHandler)
+        (*m_disconnectedHandler)();
+}
+
+void UdpClientConnection::flush()
+{
+    m_flushScheduled = false;
+    if (m_fd >= 0 && !m_sendQueue.flush(m_fd, true))
+        close();
+}
+
+void UdpClientConnection::receiveDatagrams()
+{
+    while (m_fd >= 0)
+    {
+        const int count = m_receiveBatch.receive(m_fd);
+        if (count < 0)
+            return close(); // ECONNREFUSED: порт сервера закрыт
+        for (size_t i = 0; i < static_cast<size_t>(count) && m_fd >= 0; ++i)
+        {
+            const auto datagram = m_receiveBatch.datagram(i);
+            uint64_t deviceId = 0;
+            UdpDatagramType type = UdpDatagramType::Data;
+            if (!UdpDatagram::readHeader(datagram, deviceId, type) || deviceId != m_clientId)
+                continue;
+            if (type == UdpDatagramType::Disconnect)
+                return close();
+            size_t offset = UdpDatagram::headerSize();
+            while (m_fd >= 0 && UdpDatagram::nextMessage(datagram, offset, m_message))
+            {
+                if (m_messageHandler)
+                    (*m_messageHandler)(m_message);
+            }
+        }
+        if (static_cast<size_t>(count) < m_receiveBatch.size())
+            return;
+    }
+}
+
+void UdpClientConnection::scheduleFlush()
+{
+    if (m_flushScheduled)
+        return;
+    m_flushScheduled = true;
+    m_eventLoop.post(new ClientAction<&UdpClientConnection::flush>(this));
+}
+
+void UdpClientConnection::close()
+{
+    if (m_fd < 0)
+        return;
+    m_eventLoop.remove(m_fd);
+    ::close(m_fd);
+    m_fd = -1;
+    m_sendQueue.clear();
+    m_state = State::Closing;
+    m_eventLoop.post(new ClientAction<&UdpClientConnection::onDisconnected>(this));
+}
+
+void UdpClientConnection::SocketHandler::operator()(uint32_t events)
+{
+    if (events & EPOLLOUT)
+        m_client->flush();
+    if (events & (EPOLLIN | EPOLLERR))
+        m_client->receiveDatagrams();
+}
@@ -0,0 +1,111 @@
+#ifndef UDPCLIENTCONNECTION_H
+#define UDPCLIENTCONNECTION_H
+
+#include "../common.h"
+#include "udpbatch.h"
+#include <server/abstractclientconnection.h>
+#include <servermock/object.h>
+#include <tcp/eventloop.h>
+
+#include <string>
+
+/*!
+ * \brief Клиент (устройство) UdpConnectionServer.
+ *
+ * connectToHost() подключает UDP-сокет к адресу сервера и отправляет датаграмму Connect;
+ * подтверждения сервер не присылает, поэтому обработчик установки соединения вызывается
+ * отложенно через EventLoop сразу. Сообщения, отправленные за одну итерацию EventLoop,
+ * объединяются в датаграммы (см. UdpSendQueue). Обработчик разрыва вызывается, если
+ * сервер закрыл сеанс датаграммой Disconnect или ядро сообщило о недоступности сервера.
+ */
+class UdpClientConnection final : public AbstractClientConnection, public Object
+{
+    NON_COPYABLE(UdpClientConnection)
+
+    struct SocketHandler final : public AbstractEventHandler
+    {
+        SocketHandler(UdpClientConnection* client) :
+            m_client(client) {}
+        void operator()(uint32_t events) final;
+
+    private:
+        UdpClientConnection* m_client = nullptr;
+    };
+
+public:
+    /*!
+     * \brief Число датаграмм, принимаемых за один вызов recvmmsg: ответы устройству редки
+     */
+    static constexpr size_t receiveBatchSize() { return 8; }
+
+    /*!
+     * \brief Конструктор.
+     * \param host - IPv4-адрес сервера
+     */
+    UdpClientConnection(EventLoop& eventLoop, std::string host = "127.0.0.1");
+    ~UdpClientConnection() final;
+
+    /*!
+     * \brief Вызвать обработчик установки соединения.
+     */
+    void onConnected();
+    /*!
+     * \brief Вызвать обработчик разрыва соединения.
+     */
+    void onDisconnected();
+    /*!
+     * \brief Отправить датаграммы из очереди.
+     */
+    void flush();
+
+    // AbstractClientConnection interface
+    uint64_t bindedId() const final { return m_clientId; }
+    bool bind(uint64_t clientId) final;
+    bool connectToHost(uint64_t serverId) final;
+    void setConnectedHandler(AbstractAction* handler) final;
+
+    // AbstractConnection interface
+    uint64_t peerId() const final;
+    bool connected() const final { return m_state == State::Connected; }
+    bool reliable() const final { return false; }
+    void disconnect() final;
+    void sendMessage(const std::string& message) final;
+    void setMessageHandler(AbstractMessageHandler* handler) final;
+    void setDisconnectedHandler(AbstractAction* handler) final;
+
+private:
+    enum class State
+    {
+        Idle,
+        Connecting, ///< Обработчик установки соединения еще не вызван
+        Connected,
+        Closing     ///< Сокет закрыт, обработчик разрыва еще не вызван
+    };
+
+    void receiveDatagrams();
+    void scheduleFlush();
+    /*!
+     * \brief Закрыть сокет и запланировать вызов обработчика разрыва соединения.
+     */
+    void close();
+
+private:
+    EventLoop& m_eventLoop;
+    std::string m_host;
+    uint64_t m_clientId = 0;
+    uint64_t m_serverId = 0;
+    sockaddr_in m_serverAddress {};
+    int m_fd = -1;
+    State m_state = State::Idle;
+    bool m_wasConnected = false; ///< Обработчик установки соединения вызван
+    SocketHandler m_socketHandler;
+    UdpReceiveBatch m_receiveBatch;
+    UdpSendQueue m_sendQueue;
+    bool m_flushScheduled = false;
+    std::string m_message; ///< Буфер сообщения, передаваемого обработчику
+    AbstractMessageHandler* m_messageHandler = nullptr;
+    AbstractAction* m_connectedHandler = nullptr;
+    AbstractAction* m_disconnectedHandler = nullptr;
+};
+
+#endif // UDPCLIENTCONNECTION_H
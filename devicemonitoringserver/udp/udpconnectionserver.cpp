@@ -0,0 +1,300 @@
+#include "udpconnectionserver.h"
+#include "udpsession.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractnewconnectionhandler.h>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace
+{
+
+/*!
+ * \brief Запрашиваемый размер буфера приема сокета: пачки датаграмм от многих устройств
+ * не должны теряться между вызовами recvmmsg (ядро ограничивает его net.core.rmem_max)
+ */
+constexpr int receiveBufferSize = 4 << 20;
+
+struct DisconnectedAction final : public AbstractAction
+{
+    DisconnectedAction(UdpConnectionServer* server, UdpSession* session) :
+        m_server(server), m_session(session) {}
+
+    void operator()() final
+    {
+        // Сеанс удаляется вместе с сервером и при повторном подключении устройства
+        auto* session = dynamic_cast<UdpSession*>(m_session.data());
+        if (session)
+            m_server->onDisconnected(session);
+    }
+
+private:
+    UdpConnectionServer* m_server = nullptr;
+    SafeObjectPointer m_session;
+};
+
+struct FlushAction final : public AbstractAction
+{
+    FlushAction(UdpConnectionServer* server) :
+        m_server(server) {}
+
+    void operator()() final
+    {
+        auto* server = dynamic_cast<UdpConnectionServer*>(m_server.data());
+        if (server)
+            server->flush();
+    }
+
+private:
+    SafeObjectPointer m_server;
+};
+
+} // namespace
+
+UdpConnectionServer::UdpConnectionServer(EventLoop& eventLoop, std::string host) :
+    m_eventLoop(eventLoop), m_host(std::move(host)), m_socketHandler(this), m_timerHandler(this)
+{
+}
+
+UdpConnectionServer::~UdpConnectionServer()
+{
+    delete m_newConnectionHandler;
+    for (auto it = m_sessions.cbegin(); it != m_sessions.cend(); ++it)
+        delete it->second;
+    for (int fd : { m_fd, m_timerFd })
+    {
+        if (fd >= 0)
+        {
+            m_eventLoop.remove(fd);
+            ::close(fd);
+        }
+    }
+}
+
+void UdpConnectionServer::setSessionTimeout(int timeoutMs)
+{
+    m_sessionTimeout = timeoutMs > 0 ? timeoutMs : 0;
+    updateTimer();
+}
+
+bool UdpConnectionServer::listen(uint64_t serverId)
+{
+    if (m_fd >= 0 || !serverId || serverId > UINT16_MAX)
+        return false;
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(serverId));
+    if (inet_pton(AF_INET, m_host.c_str(), &address.sin_addr) != 1)
+        return false;
+    const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize));
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || !m_eventLoop.add(fd, EPOLLIN | EPOLLOUT | EPOLLET, &m_socketHandler))
+    {
+        ::close(fd);
+        return false;
+    }
+    m_fd = fd;
+    m_serverId = serverId;
+    updateTimer();
+    return true;
+}
+
+void UdpConnectionServer::disconnect()
+{
+    for (const auto& session : m_sessions)
+        closeSession(session.second, true);
+    if (m_fd >= 0)
+    {
+        // Датаграммы Disconnect отправляются сразу: после закрытия сокета отправить их будет не через что
+        m_sendQueue.flush(m_fd, false);
+        m_eventLoop.remove(m_fd);
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_sendQueue.clear();
+    m_serverId = 0;
+    updateTimer();
+}
+
+void UdpConnectionServer::setNewConnectionHandler(AbstractNewConnectionHandler* handler)
+{
+    delete m_newConnectionHandler;
+    m_newConnectionHandler = handler;
+}
+
+AbstractConnection* UdpConnectionServer::connection(uint64_t clientId) const
+{
+    const auto it = m_sessions.find(clientId);
+    return it != m_sessions.cend() ? it->second : nullptr;
+}
+
+void UdpConnectionServer::sendMessage(UdpSession* session, std::string_view message)
+{
+    if (m_fd < 0 || !m_sendQueue.appendMessage(session->address(), session->peerId(), message))
+        return;
+    if (!m_receiving)
+        scheduleFlush();
+}
+
+void UdpConnectionServer::closeSession(UdpSession* session, bool notifyPeer)
+{
+    if (!session->connected())
+        return;
+    session->close();
+    if (notifyPeer && m_fd >= 0 && m_sendQueue.appendControl(session->address(), session->peerId(), UdpDatagramType::Disconnect))
+        scheduleFlush();
+    m_eventLoop.post(new DisconnectedAction(this, session));
+}
+
+void UdpConnectionServer::onDisconnected(UdpSession* session)
+{
+    session->close();
+    session->onDisconnected();
+    const auto it = m_sessions.find(session->peerId());
+    if (it != m_sessions.end() && it->second == session)
+        m_sessions.erase(it);
+    delete session;
+}
+
+void UdpConnectionServer::flush()
+{
+    m_flushScheduled = false;
+    // Ошибки отправки отдельным устройствам не влияют на остальных
+    if (m_fd >= 0)
+        m_sendQueue.flush(m_fd, false);
+}
+
+void UdpConnectionServer::receiveDatagrams()
+{
+    m_receiving = true;
+    while (m_fd >= 0)
+    {
+        const int count = m_receiveBatch.receive(m_fd);
+        if (count <= 0)
+            break;
+        for (size_t i = 0; i < static_cast<size_t>(count) && m_fd >= 0; ++i)
+            onDatagram(m_receiveBatch.address(i), m_receiveBatch.datagram(i));
+        if (m_fd >= 0)
+            m_sendQueue.flush(m_fd, false);
+        // Неполная пачка: сокет пуст, новая датаграмма вызовет новое событие
+        if (static_cast<size_t>(count) < m_receiveBatch.size())
+            break;
+    }
+    m_receiving = false;
+}
+
+void UdpConnectionServer::onDatagram(const sockaddr_in& address, std::string_view datagram)
+{
+    uint64_t deviceId = 0;
+    UdpDatagramType type = UdpDatagramType::Data;
+    if (!UdpDatagram::readHeader(datagram, deviceId, type) || !deviceId)
+        return;
+    const auto it = m_sessions.find(deviceId);
+    UdpSession* session = it != m_sessions.end() ? it->second : nullptr;
+    // Идентификатор устройства не защищен: пока сеанс открыт, датаграммы с другого адреса
+    // (в том числе Connect и Disconnect) отбрасываются, иначе одна подложная датаграмма
+    // закрыла бы сеанс или перенаправила ответы
+    if (session && session->connected() && !session->hasAddress(address))
+        return;
+    if (session && (type == UdpDatagramType::Connect || !session->connected()))
+    {
+        // Устройство подключилось заново: обработчик разрыва прежнего сеанса вызывается до создания нового
+        onDisconnected(session);
+        session = nullptr;
+    }
+    if (type == UdpDatagramType::Disconnect)
+    {
+        if (session)
+            closeSession(session, false);
+        return;
+    }
+    if (!session)
+    {
+        if (type != UdpDatagramType::Connect)
+        {
+            // Сеанс без Connect (например, после закрытия по таймауту) не знал бы параметров,
+            // согласованных в прежнем: Disconnect заставляет устройство подключиться и согласовать их заново
+            if (m_fd >= 0 && m_sendQueue.appendControl(address, deviceId, UdpDatagramType::Disconnect) && !m_receiving)
+                scheduleFlush();
+            return;
+        }
+        session = new UdpSession(this, deviceId, address);
+        m_sessions.insert({ deviceId, session });
+        if (m_newConnectionHandler)
+            (*m_newConnectionHandler)(session);
+    }
+    session->touch();
+    size_t offset = UdpDatagram::headerSize();
+    while (session->connected() && UdpDatagram::nextMessage(datagram, offset, m_message))
+        session->onMessageReceived(m_message);
+}
+
+void UdpConnectionServer::scheduleFlush()
+{
+    if (m_flushScheduled)
+        return;
+    m_flushScheduled = true;
+    m_eventLoop.post(new FlushAction(this));
+}
+
+void UdpConnectionServer::updateTimer()
+{
+    if (m_fd < 0 || !m_sessionTimeout)
+    {
+        if (m_timerFd >= 0)
+        {
+            m_eventLoop.remove(m_timerFd);
+            ::close(m_timerFd);
+            m_timerFd = -1;
+        }
+        return;
+    }
+    if (m_timerFd < 0)
+    {
+        const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd < 0)
+            return;
+        if (!m_eventLoop.add(fd, EPOLLIN, &m_timerHandler))
+        {
+            ::close(fd);
+            return;
+        }
+        m_timerFd = fd;
+    }
+    itimerspec period {};
+    period.it_interval.tv_sec = m_sessionTimeout / 1000;
+    period.it_interval.tv_nsec = (m_sessionTimeout % 1000) * 1000000L;
+    period.it_value = period.it_interval;
+    timerfd_settime(m_timerFd, 0, &period, nullptr);
+}
+
+void UdpConnectionServer::closeIdleSessions()
+{
+    uint64_t expirations = 0;
+    if (::read(m_timerFd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return;
+    for (const auto& session : m_sessions)
+    {
+        if (session.second->connected() && !session.second->takeActive())
+            closeSession(session.second, true);
+    }
+}
+
+void UdpConnectionServer::SocketHandler::operator()(uint32_t events)
+{
+    if (events & EPOLLOUT)
+        m_server->flush();
+    if (events & (EPOLLIN | EPOLLERR))
+        m_server->receiveDatagrams();
+}
+
+void UdpConnectionServer::TimerHandler::operator()(uint32_t /*events*/)
+{
+    m_server->closeIdleSessions();
+}
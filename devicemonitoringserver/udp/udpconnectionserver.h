@@ -0,0 +1,131 @@
+#ifndef UDPCONNECTIONSERVER_H
+#define UDPCONNECTIONSERVER_H
+
+#include "../common.h"
+#include "udpbatch.h"
+#include <server/abstractconnectionserver.h>
+#include <servermock/object.h>
+#include <tcp/eventloop.h>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+class UdpSession;
+
+/*!
+ * \brief Сервер для приема датаграмм устройств по UDP.
+ *
+ * Идентификатор сервера - номер UDP-порта. Каждая датаграмма помечена идентификатором устройства
+ * (см. UdpDatagram); по нему датаграммы сопоставляются сеансам UdpSession, которые
+ * для логики сервера ведут себя как соединения: датаграмма Connect создает сеанс (закрыв прежний)
+ * и передает его обработчику нового подключения, датаграмма Disconnect или бездействие дольше
+ * setSessionTimeout() его закрывают. На другие датаграммы устройства без открытого сеанса сервер
+ * отвечает датаграммой Disconnect: устройство подключается заново и заново согласует параметры соединения.
+ * Сеанс привязан к адресу датаграммы Connect: пока он открыт, датаграммы устройства с другого
+ * адреса отбрасываются, поэтому устройство, сменившее адрес (перезапуск, переназначение порта NAT),
+ * открывает новый сеанс только после закрытия прежнего по таймауту.
+ *
+ * Датаграммы принимаются через recvmmsg пачками до UdpDatagram::maxBatchSize(); ответы на все
+ * сообщения пачки отправляются одним вызовом sendmmsg после ее обработки. Ответы вне обработки
+ * пачки отправляются в конце итерации EventLoop.
+ */
+class UdpConnectionServer final : public AbstractConnectionServer, public Object
+{
+    NON_COPYABLE(UdpConnectionServer)
+
+    struct SocketHandler final : public AbstractEventHandler
+    {
+        SocketHandler(UdpConnectionServer* server) :
+            m_server(server) {}
+        void operator()(uint32_t events) final;
+
+    private:
+        UdpConnectionServer* m_server = nullptr;
+    };
+    struct TimerHandler final : public AbstractEventHandler
+    {
+        TimerHandler(UdpConnectionServer* server) :
+            m_server(server) {}
+        void operator()(uint32_t events) final;
+
+    private:
+        UdpConnectionServer* m_server = nullptr;
+    };
+
+public:
+    /*!
+     * \brief Время бездействия, после которого сеанс закрывается по умолчанию, мс
+     */
+    static constexpr int defaultSessionTimeout() { return 5 * 60 * 1000; }
+
+    /*!
+     * \brief Конструктор.
+     * \param host - IPv4-адрес для приема датаграмм
+     */
+    UdpConnectionServer(EventLoop& eventLoop, std::string host = "127.0.0.1");
+    ~UdpConnectionServer() final;
+
+    /*!
+     * \brief Закрывать сеансы устройств, не присылавших датаграмм \a timeoutMs мс;
+     * сеанс закрывается через [timeoutMs, 2 * timeoutMs) после последней датаграммы.
+     * 0 - сеансы закрываются только явно.
+     */
+    void setSessionTimeout(int timeoutMs);
+    /*!
+     * \brief Отправить сообщение устройству сеанса \a session.
+     */
+    void sendMessage(UdpSession* session, std::string_view message);
+    /*!
+     * \brief Закрыть сеанс и запланировать вызов обработчика разрыва.
+     * \param notifyPeer - сообщить устройству датаграммой Disconnect
+     */
+    void closeSession(UdpSession* session, bool notifyPeer);
+    /*!
+     * \brief Вызвать обработчик разрыва сеанса и удалить сеанс.
+     */
+    void onDisconnected(UdpSession* session);
+    /*!
+     * \brief Отправить датаграммы из очереди.
+     */
+    void flush();
+
+    // AbstractConnectionServer interface
+    uint64_t listenedId() const final { return m_serverId; }
+    bool listen(uint64_t serverId) final;
+    void disconnect() final;
+    void setNewConnectionHandler(AbstractNewConnectionHandler* handler) final;
+    AbstractConnection* connection(uint64_t clientId) const final;
+
+private:
+    /*!
+     * \brief Принимать пачки датаграмм, пока сокет не опустеет.
+     */
+    void receiveDatagrams();
+    void onDatagram(const sockaddr_in& address, std::string_view datagram);
+    void scheduleFlush();
+    /*!
+     * \brief Создать, перезапустить или удалить таймер закрытия сеансов по текущим настройкам.
+     */
+    void updateTimer();
+    void closeIdleSessions();
+
+private:
+    EventLoop& m_eventLoop;
+    std::string m_host;
+    uint64_t m_serverId = 0;
+    int m_fd = -1;
+    int m_timerFd = -1;
+    int m_sessionTimeout = defaultSessionTimeout();
+    SocketHandler m_socketHandler;
+    TimerHandler m_timerHandler;
+    std::unordered_map<uint64_t, UdpSession*> m_sessions;
+    UdpReceiveBatch m_receiveBatch;
+    UdpSendQueue m_sendQueue;
+    bool m_receiving = false;      ///< Обрабатывается пачка: ответы отправятся после нее
+    bool m_flushScheduled = false;
+    std::string m_message;         ///< Буфер сообщения, передаваемого обработчику
+    AbstractNewConnectionHandler* m_newConnectionHandler = nullptr;
+};
+
+#endif // UDPCONNECTIONSERVER_H
@@ -0,0 +1,52 @@
+#include "udpdatagram.h"
+#include "../bigendian.h"
+
+void UdpDatagram::writeHeader(std::string& datagram, uint64_t deviceId, UdpDatagramType type)
+{
+    char header[headerSize()];
+    toBigEndian(header, deviceId);
+    header[sizeof(uint64_t)] = static_cast<char>(type);
+    datagram.assign(header, headerSize());
+}
+
+void UdpDatagram::appendMessage(std::string& datagram, std::string_view message)
+{
+    char header[frameHeaderSize()];
+    toBigEndian(header, static_cast<uint32_t>(message.size()));
+    datagram.append(header, frameHeaderSize());
+    datagram.append(message.data(), message.size());
+}
+
+bool UdpDatagram::readHeader(std::string_view datagram, uint64_t& deviceId, UdpDatagramType& type)
+{
+    if (datagram.size() < headerSize())
+        return false;
+    const auto rawType = static_cast<uint8_t>(datagram[sizeof(uint64_t)]);
+    if (rawType > static_cast<uint8_t>(UdpDatagramType::Disconnect))
+        return false;
+    // Датаграмма с оборванным кадром отбрасывается целиком, а не после доставки первых сообщений
+    size_t offset = headerSize();
+    while (offset < datagram.size())
+    {
+        if (datagram.size() - offset < frameHeaderSize())
+            return false;
+        const size_t size = fromBigEndian<uint32_t>(datagram.data() + offset);
+        offset += frameHeaderSize();
+        if (datagram.size() - offset < size)
+            return false;
+        offset += size;
+    }
+    deviceId = fromBigEndian<uint64_t>(datagram.data());
+    type = static_cast<UdpDatagramType>(rawType);
+    return true;
+}
+
+bool UdpDatagram::nextMessage(std::string_view datagram, size_t& offset, std::string& message)
+{
+    if (datagram.size() - offset < frameHeaderSize())
+        return false;
+    const size_t size = fromBigEndian<uint32_t>(datagram.data() + offset);
+    message.assign(datagram.data() + offset + frameHeaderSize(), size);
+    offset += frameHeaderSize() + size;
+    return true;
+}
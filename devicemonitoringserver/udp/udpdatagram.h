@@ -0,0 +1,70 @@
+#ifndef UDPDATAGRAM_H
+#define UDPDATAGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*!
+ * \brief Тип датаграммы UDP-транспорта.
+ */
+enum class UdpDatagramType : uint8_t
+{
+    Data = 0,      ///< Сообщения устройства или ответы сервера
+    Connect = 1,   ///< Устройство подключилось заново: прежний сеанс с ним закрывается
+    Disconnect = 2 ///< Отправитель закрыл сеанс
+};
+
+/*!
+ * \brief Формат датаграмм UDP-транспорта.
+ *
+ * Датаграмма начинается с заголовка: идентификатор устройства (uint64_t, big-endian) и тип
+ * (UdpDatagramType, один байт). За заголовком датаграммы Data следуют одно или несколько
+ * сообщений кадрами, как в TcpChannel: длина (uint32_t, big-endian) и данные.
+ */
+class UdpDatagram
+{
+public:
+    static constexpr size_t headerSize() { return sizeof(uint64_t) + sizeof(UdpDatagramType); }
+    static constexpr size_t frameHeaderSize() { return sizeof(uint32_t); }
+    /*!
+     * \brief Наибольший размер датаграммы UDP поверх IPv4
+     */
+    static constexpr size_t maxSize() { return 65507; }
+    /*!
+     * \brief Наибольший размер сообщения: одно сообщение в датаграмме наибольшего размера
+     */
+    static constexpr size_t maxMessageSize() { return maxSize() - headerSize() - frameHeaderSize(); }
+    /*!
+     * \brief Размер, до которого сообщения одному адресату объединяются в датаграмму:
+     * такая датаграмма проходит в одном Ethernet-кадре без фрагментации
+     */
+    static constexpr size_t coalesceSize() { return 1472; }
+    /*!
+     * \brief Наибольшее число датаграмм, принимаемых recvmmsg или отправляемых sendmmsg за один вызов
+     */
+    static constexpr size_t maxBatchSize() { return 64; }
+
+    /*!
+     * \brief Записать в \a datagram заголовок новой датаграммы.
+     */
+    static void writeHeader(std::string& datagram, uint64_t deviceId, UdpDatagramType type);
+    /*!
+     * \brief Добавить к датаграмме \a datagram кадр с сообщением \a message.
+     */
+    static void appendMessage(std::string& datagram, std::string_view message);
+    /*!
+     * \brief Прочитать заголовок датаграммы и проверить, что за ним следуют только целые кадры.
+     * \return false, если датаграмма повреждена или тип неизвестен
+     */
+    static bool readHeader(std::string_view datagram, uint64_t& deviceId, UdpDatagramType& type);
+    /*!
+     * \brief Извлечь из проверенной readHeader() датаграммы сообщение, кадр которого начинается
+     * со смещения \a offset (изначально headerSize()); смещение переносится на следующий кадр.
+     * \return false, если сообщений больше нет
+     */
+    static bool nextMessage(std::string_view datagram, size_t& offset, std::string& message);
+};
+
+#endif // UDPDATAGRAM_H
@@ -0,0 +1,67 @@
+#include "udpsession.h"
+#include "udpconnectionserver.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractmessagehandler.h>
+
+UdpSession::UdpSession(UdpConnectionServer* server, uint64_t deviceId, const sockaddr_in& address) :
+    m_server(server), m_deviceId(deviceId), m_address(address)
+{
+}
+
+UdpSession::~UdpSession()
+{
+    delete m_messageHandler;
+    delete m_disconnectedHandler;
+}
+
+bool UdpSession::hasAddress(const sockaddr_in& address) const
+{
+    return m_address.sin_addr.s_addr == address.sin_addr.s_addr && m_address.sin_port == address.sin_port;
+}
+
+void UdpSession::touch()
+{
+    m_active = true;
+}
+
+bool UdpSession::takeActive()
+{
+    const bool active = m_active;
+    m_active = false;
+    return active;
+}
+
+void UdpSession::onMessageReceived(const std::string& message)
+{
+    if (m_messageHandler)
+        (*m_messageHandler)(message);
+}
+
+void UdpSession::onDisconnected()
+{
+    if (m_disconnectedHandler)
+        (*m_disconnectedHandler)();
+}
+
+void UdpSession::disconnect()
+{
+    m_server->closeSession(this, true);
+}
+
+void UdpSession::sendMessage(const std::string& message)
+{
+    if (m_connected)
+        m_server->sendMessage(this, message);
+}
+
+void UdpSession::setMessageHandler(AbstractMessageHandler* handler)
+{
+    delete m_messageHandler;
+    m_messageHandler = handler;
+}
+
+void UdpSession::setDisconnectedHandler(AbstractAction* handler)
+{
+    delete m_disconnectedHandler;
+    m_disconnectedHandler = handler;
+}
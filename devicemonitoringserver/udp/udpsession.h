@@ -0,0 +1,70 @@
+#ifndef UDPSESSION_H
+#define UDPSESSION_H
+
+#include "../common.h"
+#include <server/abstractconnection.h>
+#include <servermock/object.h>
+
+#include <netinet/in.h>
+
+class UdpConnectionServer;
+
+/*!
+ * \brief Сеанс устройства на UdpConnectionServer.
+ *
+ * Сеанс создается по датаграмме Connect устройства и отвечает по адресу, с которого она пришла;
+ * адрес не меняется до закрытия сеанса. Обработчик разрыва вызывается отложенно через EventLoop, как у TcpConnection.
+ */
+class UdpSession final : public AbstractConnection, public Object
+{
+    NON_COPYABLE(UdpSession)
+public:
+    UdpSession(UdpConnectionServer* server, uint64_t deviceId, const sockaddr_in& address);
+    ~UdpSession() final;
+
+    const sockaddr_in& address() const { return m_address; }
+    /*!
+     * \brief Совпадает ли \a address с адресом устройства сеанса.
+     */
+    bool hasAddress(const sockaddr_in& address) const;
+    /*!
+     * \brief Отметить получение датаграммы.
+     */
+    void touch();
+    /*!
+     * \brief Были ли датаграммы после предыдущего вызова.
+     */
+    bool takeActive();
+    /*!
+     * \brief Пометить сеанс закрытым; сообщения больше не принимаются и не отправляются.
+     */
+    void close() { m_connected = false; }
+    /*!
+     * \brief Передать сообщение обработчику.
+     */
+    void onMessageReceived(const std::string& message);
+    /*!
+     * \brief Вызвать обработчик разрыва соединения.
+     */
+    void onDisconnected();
+
+    // AbstractConnection interface
+    uint64_t peerId() const final { return m_deviceId; }
+    bool connected() const final { return m_connected; }
+    bool reliable() const final { return false; }
+    void disconnect() final;
+    void sendMessage(const std::string& message) final;
+    void setMessageHandler(AbstractMessageHandler* handler) final;
+    void setDisconnectedHandler(AbstractAction* handler) final;
+
+private:
+    UdpConnectionServer* m_server = nullptr;
+    uint64_t m_deviceId = 0;
+    sockaddr_in m_address {};
+    bool m_connected = true;
+    bool m_active = true;
+    AbstractMessageHandler* m_messageHandler = nullptr;
+    AbstractAction* m_disconnectedHandler = nullptr;
+};
+
+#endif // UDPSESSION_H
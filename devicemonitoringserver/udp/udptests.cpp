@@ -0,0 +1,535 @@
+#include "udptests.h"
+#include "test_runner.h"
+#include <handlers/abstractaction.h>
+#include <handlers/abstractmessagehandler.h>
+#include <handlers/abstractnewconnectionhandler.h>
+#include <tcp/eventloop.h>
+#include <tcp/tcptests.h>
+#include <udp/udpbatch.h>
+#include <udp/udpclientconnection.h>
+#include <udp/udpconnectionserver.h>
+#include <udp/udpdatagram.h>
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+int allocationCounter = 0;
+
+void processEvents(EventLoop& eventLoop)
+{
+    while (eventLoop.processEvents(20))
+        ;
+}
+
+/*!
+ * \brief Обрабатывать события, пока не выполнится \a condition, но не дольше 5 секунд
+ */
+template <class Condition>
+bool processEventsUntil(EventLoop& eventLoop, Condition condition)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!condition() && std::chrono::steady_clock::now() < deadline)
+        eventLoop.processEvents(10);
+    return condition();
+}
+
+class MessageListHandler : public AbstractMessageHandler
+{
+public:
+    MessageListHandler(std::vector<std::string>& messageList) :
+        m_messageList(messageList) { ++allocationCounter; }
+    ~MessageListHandler() { --allocationCounter; }
+
+    void operator()(const std::string& message) final
+    {
+        m_messageList.push_back(message);
+    }
+
+private:
+    std::vector<std::string>& m_messageList;
+};
+
+class FlagHandler : public AbstractAction
+{
+public:
+    FlagHandler(bool& flag) :
+        m_flag(flag) { ++allocationCounter; }
+    ~FlagHandler() { --allocationCounter; }
+
+    void operator()() final
+    {
+        m_flag = true;
+    }
+
+private:
+    bool& m_flag;
+};
+
+struct EchoMessageHandler : public AbstractMessageHandler
+{
+    EchoMessageHandler(AbstractConnection* conn) :
+        m_conn(conn) { ++allocationCounter; }
+    ~EchoMessageHandler() { --allocationCounter; }
+
+private:
+    void operator()(const std::string& message) final
+    {
+        m_conn->sendMessage(message);
+    }
+
+private:
+    AbstractConnection* m_conn = nullptr;
+};
+
+class EchoNewConnectionHandler : public AbstractNewConnectionHandler
+{
+public:
+    EchoNewConnectionHandler(std::map<uint64_t, bool>* disconnected = nullptr) :
+        m_disconnected(disconnected) { ++allocationCounter; }
+    ~EchoNewConnectionHandler() { --allocationCounter; }
+
+private:
+    void operator()(AbstractConnection* conn) final
+    {
+        conn->setMessageHandler(new EchoMessageHandler(conn));
+        if (m_disconnected)
+            conn->setDisconnectedHandler(new FlagHandler((*m_disconnected)[conn->peerId()]));
+    }
+
+private:
+    std::map<uint64_t, bool>* m_disconnected = nullptr;
+};
+
+sockaddr_in loopbackAddress(uint64_t port)
+{
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+/*!
+ * \brief UDP-сокет на свободном порту loopback в обход UdpClientConnection
+ */
+int bindRawSocket(sockaddr_in& address)
+{
+    const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    const int bufferSize = 1 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    address = loopbackAddress(0);
+    socklen_t size = sizeof(address);
+    if (fd >= 0
+        && (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+            || getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size) != 0))
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*!
+ * \brief Принять все датаграммы, уже стоящие в очереди сокета \a fd
+ */
+std::vector<std::string> receiveRawDatagrams(int fd)
+{
+    std::vector<std::string> datagrams;
+    std::string buffer(UdpDatagram::maxSize(), '\0');
+    for (;;)
+    {
+        const ssize_t size = recv(fd, &buffer[0], buffer.size(), MSG_DONTWAIT);
+        if (size < 0)
+            return datagrams;
+        datagrams.push_back(buffer.substr(0, static_cast<size_t>(size)));
+    }
+}
+
+/*!
+ * \brief Сообщения датаграммы \a datagram; заголовок должен быть корректным
+ */
+std::vector<std::string> datagramMessages(const std::string& datagram, uint64_t expectedDeviceId, UdpDatagramType expectedType)
+{
+    uint64_t deviceId = 0;
+    UdpDatagramType type = UdpDatagramType::Data;
+    ASSERT(UdpDatagram::readHeader(datagram, deviceId, type));
+    ASSERT_EQUAL(deviceId, expectedDeviceId);
+    ASSERT(type == expectedType);
+    std::vector<std::string> messages;
+    std::string message;
+    size_t offset = UdpDatagram::headerSize();
+    while (UdpDatagram::nextMessage(datagram, offset, message))
+        messages.push_back(message);
+    return messages;
+}
+
+} // namespace
+
+void udpDatagramTest()
+{
+    std::string datagram;
+    UdpDatagram::writeHeader(datagram, 0x0102030405060708, UdpDatagramType::Data);
+    ASSERT_EQUAL(datagram, std::string("\x01\x02\x03\x04\x05\x06\x07\x08\x00", UdpDatagram::headerSize()));
+    const std::vector<std::string> sent = { "", "a", std::string(70000, 'b') };
+    for (const auto& message : sent)
+        UdpDatagram::appendMessage(datagram, message);
+    ASSERT_EQUAL(datagramMessages(datagram, 0x0102030405060708, UdpDatagramType::Data), sent);
+
+    // Короткий заголовок, неизвестный тип и оборванный кадр отбрасывают датаграмму целиком
+    uint64_t deviceId = 0;
+    UdpDatagramType type = UdpDatagramType::Data;
+    ASSERT(!UdpDatagram::readHeader(datagram.substr(0, UdpDatagram::headerSize() - 1), deviceId, type));
+    ASSERT(!UdpDatagram::readHeader(datagram.substr(0, datagram.size() - 1), deviceId, type));
+    ASSERT(!UdpDatagram::readHeader(datagram.substr(0, UdpDatagram::headerSize() + 2), deviceId, type));
+    std::string unknown = datagram;
+    unknown[UdpDatagram::headerSize() - 1] = 3;
+    ASSERT(!UdpDatagram::readHeader(unknown, deviceId, type));
+    ASSERT_EQUAL(deviceId, 0u);
+    UdpDatagram::writeHeader(datagram, 5, UdpDatagramType::Disconnect);
+    ASSERT(UdpDatagram::readHeader(datagram, deviceId, type));
+    ASSERT_EQUAL(deviceId, 5u);
+    ASSERT(type == UdpDatagramType::Disconnect);
+
+    // Очередь объединяет сообщения одному устройству по одному адресу до UdpDatagram::coalesceSize()
+    sockaddr_in receiverAddress {};
+    const int receiver = bindRawSocket(receiverAddress);
+    sockaddr_in otherAddress {};
+    const int other = bindRawSocket(otherAddress);
+    const int sender = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    ASSERT(receiver >= 0 && other >= 0 && sender >= 0);
+    UdpSendQueue queue;
+    ASSERT(queue.empty());
+    ASSERT(queue.flush(sender, false));
+    const std::string medium(700, 'm');
+    ASSERT(queue.appendMessage(receiverAddress, 1, "x"));
+    ASSERT(queue.appendMessage(receiverAddress, 2, "y"));
+    ASSERT(queue.appendMessage(receiverAddress, 1, medium));
+    ASSERT(queue.appendMessage(receiverAddress, 1, medium));
+    ASSERT(queue.appendMessage(receiverAddress, 1, std::string(100, 'z')));
+    ASSERT(queue.appendMessage(otherAddress, 1, "other"));
+    ASSERT(queue.appendMessage(receiverAddress, 1, std::string(UdpDatagram::maxMessageSize(), 'l')));
+    ASSERT(!queue.appendMessage(receiverAddress, 1, std::string(UdpDatagram::maxMessageSize() + 1, 'l')));
+    // Служебная датаграмма не обгоняет сообщения, поставленные после нее
+    ASSERT(queue.appendControl(receiverAddress, 2, UdpDatagramType::Disconnect));
+    ASSERT(queue.appendMessage(receiverAddress, 2, "after"));
+    ASSERT(!queue.empty());
+    ASSERT(queue.flush(sender, false));
+    ASSERT(queue.empty());
+
+    const auto datagrams = receiveRawDatagrams(receiver);
+    ASSERT_EQUAL(datagrams.size(), 6u);
+    ASSERT_EQUAL(datagramMessages(datagrams[0], 1, UdpDatagramType::Data), std::vector<std::string>({ "x", medium, medium }));
+    ASSERT(datagrams[0].size() <= UdpDatagram::coalesceSize());
+    ASSERT_EQUAL(datagramMessages(datagrams[1], 2, UdpDatagramType::Data), std::vector<std::string>({ "y" }));
+    ASSERT_EQUAL(datagramMessages(datagrams[2], 1, UdpDatagramType::Data), std::vector<std::string>({ std::string(100, 'z') }));
+    ASSERT_EQUAL(datagrams[3].size(), UdpDatagram::maxSize());
+    ASSERT(datagramMessages(datagrams[4], 2, UdpDatagramType::Disconnect).empty());
+    ASSERT_EQUAL(datagramMessages(datagrams[5], 2, UdpDatagramType::Data), std::vector<std::string>({ "after" }));
+    const auto otherDatagrams = receiveRawDatagrams(other);
+    ASSERT_EQUAL(otherDatagrams.size(), 1u);
+    ASSERT_EQUAL(datagramMessages(otherDatagrams[0], 1, UdpDatagramType::Data), std::vector<std::string>({ "other" }));
+
+    // Переполненная очередь отбрасывает новые датаграммы; буферы переиспользуются после отправки
+    for (size_t i = 0; i < UdpSendQueue::maxDatagrams(); ++i)
+        ASSERT(queue.appendControl(receiverAddress, 1, UdpDatagramType::Connect));
+    ASSERT(!queue.appendMessage(receiverAddress, 1, "dropped"));
+    queue.clear();
+    ASSERT(queue.appendMessage(receiverAddress, 1, "kept"));
+    ASSERT(queue.flush(sender, false));
+    const auto kept = receiveRawDatagrams(receiver);
+    ASSERT_EQUAL(kept.size(), 1u);
+    ASSERT_EQUAL(datagramMessages(kept[0], 1, UdpDatagramType::Data), std::vector<std::string>({ "kept" }));
+
+    for (int fd : { receiver, other, sender })
+        ::close(fd);
+}
+
+void udpClientServerTest()
+{
+    EventLoop eventLoop;
+    {
+        UdpConnectionServer server(eventLoop);
+        std::map<uint64_t, bool> serverDisconnected;
+        server.setNewConnectionHandler(new EchoNewConnectionHandler(&serverDisconnected));
+
+        UdpClientConnection client(eventLoop);
+        std::vector<std::string> received;
+        client.setMessageHandler(new MessageListHandler(received));
+        bool clientConnected = false;
+        client.setConnectedHandler(new FlagHandler(clientConnected));
+        bool clientDisconnected = false;
+        client.setDisconnectedHandler(new FlagHandler(clientDisconnected));
+
+        const uint64_t clientId = 11;
+        ASSERT(!client.bind(0));
+        ASSERT(client.bind(clientId));
+        ASSERT(!client.connectToHost(0));
+        ASSERT(!client.connectToHost(UINT16_MAX + 1));
+        ASSERT(!server.listen(0));
+        ASSERT(!server.listen(UINT16_MAX + 1));
+        const uint64_t serverId = listenOnTcpTestPort(server);
+        ASSERT(serverId);
+        ASSERT(!server.listen(serverId));
+        ASSERT_EQUAL(server.listenedId(), serverId);
+
+        ASSERT(client.connectToHost(serverId));
+        ASSERT(!client.connectToHost(serverId));
+        ASSERT(!client.bind(clientId + 1));
+        ASSERT(!client.connected());
+        // Сообщения, отправленные до вызова обработчика подключения, уходят вслед за датаграммой Connect
+        client.sendMessage("connection request");
+        processEvents(eventLoop);
+        ASSERT(clientConnected);
+        ASSERT(client.connected());
+        ASSERT_EQUAL(client.peerId(), serverId);
+        auto* serverConn = server.connection(clientId);
+        ASSERT(serverConn);
+        ASSERT(serverConn->connected());
+        ASSERT_EQUAL(serverConn->peerId(), clientId);
+        ASSERT_EQUAL(received, std::vector<std::string>({ "connection request" }));
+
+        received.clear();
+        client.sendMessage("a");
+        client.sendMessage("");
+        client.sendMessage("b");
+        processEvents(eventLoop);
+        ASSERT_EQUAL(received, std::vector<std::string>({ "a", "", "b" }));
+
+        // Датаграммы с идентификатором открытого сеанса, но с другого адреса отбрасываются:
+        // подложные Connect и Disconnect не закрывают сеанс, ответы не перенаправляются
+        {
+            UdpClientConnection forged(eventLoop);
+            std::vector<std::string> forgedReceived;
+            forged.setMessageHandler(new MessageListHandler(forgedReceived));
+            ASSERT(forged.bind(clientId));
+            ASSERT(forged.connectToHost(serverId));
+            forged.sendMessage("forged");
+            processEvents(eventLoop);
+            ASSERT(!serverDisconnected[clientId]);
+            ASSERT(server.connection(clientId) == serverConn);
+            ASSERT(serverConn->connected());
+            forged.disconnect();
+            processEvents(eventLoop);
+            ASSERT(!serverDisconnected[clientId]);
+            ASSERT(server.connection(clientId) == serverConn);
+            ASSERT(forgedReceived.empty());
+        }
+        received.clear();
+        client.sendMessage("still connected");
+        processEvents(eventLoop);
+        ASSERT_EQUAL(received, std::vector<std::string>({ "still connected" }));
+
+        // Разрыв со стороны сервера
+        server.connection(clientId)->disconnect();
+        ASSERT(!clientDisconnected);
+        processEvents(eventLoop);
+        ASSERT(clientDisconnected);
+        ASSERT(serverDisconnected[clientId]);
+        ASSERT(!client.connected());
+        ASSERT_EQUAL(client.peerId(), 0u);
+        ASSERT(!server.connection(clientId));
+
+        // Устройство перезапустилось с другого порта после закрытия сеанса: открывается новый сеанс
+        {
+            UdpClientConnection restarted(eventLoop);
+            std::vector<std::string> restartedReceived;
+            restarted.setMessageHandler(new MessageListHandler(restartedReceived));
+            ASSERT(restarted.bind(clientId));
+            ASSERT(restarted.connectToHost(serverId));
+            restarted.sendMessage("restarted");
+            processEvents(eventLoop);
+            ASSERT(server.connection(clientId));
+            ASSERT_EQUAL(restartedReceived, std::vector<std::string>({ "restarted" }));
+            serverDisconnected[clientId] = false;
+            restarted.disconnect();
+            processEvents(eventLoop);
+            ASSERT(serverDisconnected[clientId]);
+            ASSERT(!server.connection(clientId));
+        }
+
+        // Датаграмма после закрытия сеанса не открывает сеанс без Connect: устройство получает Disconnect
+        // и подключается заново, поэтому параметры соединения согласуются заново
+        {
+            sockaddr_in resumedAddress {};
+            const int resumed = bindRawSocket(resumedAddress);
+            ASSERT(resumed >= 0);
+            const sockaddr_in serverAddress = loopbackAddress(serverId);
+            auto sendDatagram = [&](UdpDatagramType type, const std::string& message) {
+                std::string datagram;
+                UdpDatagram::writeHeader(datagram, clientId, type);
+                if (!message.empty())
+                    UdpDatagram::appendMessage(datagram, message);
+                ASSERT_EQUAL(sendto(resumed, datagram.data(), datagram.size(), 0, reinterpret_cast<const sockaddr*>(&serverAddress),
+                                    sizeof(serverAddress)),
+                             static_cast<ssize_t>(datagram.size()));
+            };
+            serverDisconnected[clientId] = false;
+            sendDatagram(UdpDatagramType::Data, "resumed");
+            processEvents(eventLoop);
+            ASSERT(!server.connection(clientId));
+            auto replies = receiveRawDatagrams(resumed);
+            ASSERT_EQUAL(replies.size(), 1u);
+            ASSERT(datagramMessages(replies[0], clientId, UdpDatagramType::Disconnect).empty());
+            sendDatagram(UdpDatagramType::Connect, "reconnected");
+            processEvents(eventLoop);
+            ASSERT(server.connection(clientId));
+            replies = receiveRawDatagrams(resumed);
+            ASSERT_EQUAL(replies.size(), 1u);
+            ASSERT_EQUAL(datagramMessages(replies[0], clientId, UdpDatagramType::Data), std::vector<std::string>({ "reconnected" }));
+            sendDatagram(UdpDatagramType::Disconnect, std::string());
+            processEvents(eventLoop);
+            ASSERT(serverDisconnected[clientId]);
+            ASSERT(!server.connection(clientId));
+            ::close(resumed);
+        }
+
+        // Разрыв со стороны клиента
+        clientConnected = clientDisconnected = serverDisconnected[clientId] = false;
+        ASSERT(client.connectToHost(serverId));
+        processEvents(eventLoop);
+        ASSERT(clientConnected);
+        ASSERT(server.connection(clientId));
+        client.disconnect();
+        processEvents(eventLoop);
+        ASSERT(clientDisconnected);
+        ASSERT(serverDisconnected[clientId]);
+        ASSERT(!server.connection(clientId));
+
+        // Сеанс без датаграмм закрывается по таймауту
+        clientConnected = clientDisconnected = serverDisconnected[clientId] = false;
+        server.setSessionTimeout(30);
+        ASSERT(client.connectToHost(serverId));
+        processEvents(eventLoop);
+        ASSERT(clientConnected);
+        ASSERT(processEventsUntil(eventLoop, [&] { return clientDisconnected; }));
+        ASSERT(serverDisconnected[clientId]);
+        ASSERT(!server.connection(clientId));
+        server.setSessionTimeout(0);
+
+        // Остановка сервера закрывает сеансы; недоступность порта сервера разрывает соединение клиента
+        clientConnected = clientDisconnected = serverDisconnected[clientId] = false;
+        ASSERT(client.connectToHost(serverId));
+        processEvents(eventLoop);
+        ASSERT(server.connection(clientId));
+        server.disconnect();
+        processEvents(eventLoop);
+        ASSERT(clientDisconnected);
+        ASSERT(serverDisconnected[clientId]);
+        ASSERT_EQUAL(server.listenedId(), 0u);
+        // Порт сервера закрылся без датаграммы Disconnect: ошибка ICMP разрывает соединение клиента
+        sockaddr_in peerAddress {};
+        const int peer = bindRawSocket(peerAddress);
+        ASSERT(peer >= 0);
+        clientConnected = clientDisconnected = false;
+        ASSERT(client.connectToHost(ntohs(peerAddress.sin_port)));
+        processEvents(eventLoop);
+        ASSERT(clientConnected);
+        ASSERT_EQUAL(receiveRawDatagrams(peer).size(), 1u);
+        ::close(peer);
+        client.sendMessage("nobody listens");
+        ASSERT(processEventsUntil(eventLoop, [&] { return clientDisconnected; }));
+        ASSERT(!client.connected());
+    }
+    processEvents(eventLoop);
+    ASSERT_EQUAL(allocationCounter, 0);
+}
+
+void udpBatchTest()
+{
+    EventLoop eventLoop;
+    {
+        UdpConnectionServer server(eventLoop);
+        std::map<uint64_t, bool> serverDisconnected;
+        server.setNewConnectionHandler(new EchoNewConnectionHandler(&serverDisconnected));
+        const uint64_t serverId = listenOnTcpTestPort(server);
+        ASSERT(serverId);
+        const sockaddr_in serverAddress = loopbackAddress(serverId);
+
+        // Устройства за одним адресом (как за NAT) присылают датаграммы Connect с сообщениями раньше,
+        // чем сервер их читает: сервер принимает их несколькими пачками
+        sockaddr_in deviceAddress {};
+        const int fd = bindRawSocket(deviceAddress);
+        ASSERT(fd >= 0);
+        const uint64_t deviceCount = 3 * UdpDatagram::maxBatchSize() / 2;
+        for (uint64_t deviceId = 1; deviceId <= deviceCount; ++deviceId)
+        {
+            std::string datagram;
+            UdpDatagram::writeHeader(datagram, deviceId, UdpDatagramType::Connect);
+            UdpDatagram::appendMessage(datagram, "first " + std::to_string(deviceId));
+            UdpDatagram::appendMessage(datagram, "second " + std::to_string(deviceId));
+            ASSERT_EQUAL(sendto(fd, datagram.data(), datagram.size(), 0, reinterpret_cast<const sockaddr*>(&serverAddress),
+                                sizeof(serverAddress)),
+                         static_cast<ssize_t>(datagram.size()));
+        }
+        // Поврежденные датаграммы и нулевой идентификатор не создают сеансов
+        std::string broken;
+        UdpDatagram::writeHeader(broken, deviceCount + 1, UdpDatagramType::Connect);
+        UdpDatagram::appendMessage(broken, "lost");
+        broken.pop_back();
+        std::string zeroId;
+        UdpDatagram::writeHeader(zeroId, 0, UdpDatagramType::Connect);
+        for (const std::string& datagram : { broken, zeroId, std::string("short") })
+        {
+            ASSERT_EQUAL(sendto(fd, datagram.data(), datagram.size(), 0, reinterpret_cast<const sockaddr*>(&serverAddress),
+                                sizeof(serverAddress)),
+                         static_cast<ssize_t>(datagram.size()));
+        }
+        processEvents(eventLoop);
+        ASSERT(!server.connection(deviceCount + 1));
+        ASSERT(!server.connection(0));
+
+        // Ответы на оба сообщения устройства приходят одной датаграммой
+        const auto replies = receiveRawDatagrams(fd);
+        ASSERT_EQUAL(replies.size(), deviceCount);
+        for (uint64_t deviceId = 1; deviceId <= deviceCount; ++deviceId)
+        {
+            ASSERT(server.connection(deviceId));
+            const auto messages = datagramMessages(replies[deviceId - 1], deviceId, UdpDatagramType::Data);
+            ASSERT_EQUAL(messages, std::vector<std::string>({ "first " + std::to_string(deviceId), "second " + std::to_string(deviceId) }));
+        }
+
+        // Датаграмма Disconnect закрывает только сеанс своего устройства
+        std::string disconnect;
+        UdpDatagram::writeHeader(disconnect, 1, UdpDatagramType::Disconnect);
+        ASSERT_EQUAL(sendto(fd, disconnect.data(), disconnect.size(), 0, reinterpret_cast<const sockaddr*>(&serverAddress),
+                            sizeof(serverAddress)),
+                     static_cast<ssize_t>(disconnect.size()));
+        processEvents(eventLoop);
+        ASSERT(serverDisconnected[1]);
+        ASSERT(!server.connection(1));
+        ASSERT(!serverDisconnected[2]);
+        ASSERT(receiveRawDatagrams(fd).empty());
+        ::close(fd);
+
+        // Сообщения наибольшего размера и серии сообщений через UdpClientConnection
+        UdpClientConnection client(eventLoop);
+        std::vector<std::string> received;
+        client.setMessageHandler(new MessageListHandler(received));
+        ASSERT(client.bind(deviceCount + 2));
+        ASSERT(client.connectToHost(serverId));
+        processEvents(eventLoop);
+        ASSERT(client.connected());
+        const std::string largest(UdpDatagram::maxMessageSize(), 'a');
+        client.sendMessage(largest);
+        // Сообщение больше датаграммы не отправляется
+        client.sendMessage(largest + "e");
+        processEvents(eventLoop);
+        ASSERT_EQUAL(received, std::vector<std::string>({ largest }));
+        received.clear();
+        std::vector<std::string> sent;
+        for (int i = 0; i < 500; ++i)
+            sent.push_back(std::to_string(i) + std::string(i % 100, 'c'));
+        for (const auto& message : sent)
+            client.sendMessage(message);
+        processEvents(eventLoop);
+        ASSERT(client.connected());
+        ASSERT(received == sent);
+    }
+    processEvents(eventLoop);
+    ASSERT_EQUAL(allocationCounter, 0);
+}
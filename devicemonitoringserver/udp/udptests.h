@@ -0,0 +1,17 @@
+#ifndef UDPTESTS_H
+#define UDPTESTS_H
+
+/*!
+ * \brief Тест формата датаграмм и объединения сообщений в очереди отправки.
+ */
+void udpDatagramTest();
+/*!
+ * \brief Тест клиента и сервера UDP: сеансы, повторное подключение, разрыв и закрытие по бездействию.
+ */
+void udpClientServerTest();
+/*!
+ * \brief Тест приема пачек датаграмм от многих устройств и отбрасывания поврежденных датаграмм.
+ */
+void udpBatchTest();
+
+#endif // UDPTESTS_H
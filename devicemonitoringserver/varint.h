@@ -0,0 +1,78 @@
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/*!
+ * \brief Максимальная длина числа uint64_t в формате LEB128
+ */
+constexpr size_t maxVarintSize = 10;
+
+/*!
+ * \brief Отобразить знаковое число в беззнаковое так, что малые по модулю значения дают малые числа (ZigZag)
+ */
+inline uint64_t zigZagEncode(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+/*!
+ * \brief Обратное преобразование ZigZag
+ */
+inline int64_t zigZagDecode(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/*!
+ * \brief Размер числа \a value в формате LEB128 в байтах
+ */
+inline size_t varintSize(uint64_t value)
+{
+    size_t size = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+/*!
+ * \brief Записать число \a value в буфер \a buffer в формате LEB128
+ * \return указатель на байт, следующий за записанными
+ */
+inline char* toVarint(char* buffer, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        *buffer++ = static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    *buffer++ = static_cast<char>(value);
+    return buffer;
+}
+
+/*!
+ * \brief Прочитать число в формате LEB128 из начала буфера \a data
+ * \param value - прочитанное значение
+ * \return количество прочитанных байтов или 0, если число обрезано или не помещается в uint64_t
+ */
+inline size_t fromVarint(std::string_view data, uint64_t& value)
+{
+    value = 0;
+    for (size_t i = 0; i < data.size() && i < maxVarintSize; ++i)
+    {
+        const auto byte = static_cast<unsigned char>(data[i]);
+        if (i == maxVarintSize - 1 && byte > 1)
+            return 0;
+        value |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+        if (!(byte & 0x80))
+            return i + 1;
+    }
+    return 0;
+}
+
+#endif // VARINT_H
@@ -0,0 +1,15 @@
+#ifndef WIREVERSION_H
+#define WIREVERSION_H
+
+#include <cstdint>
+
+/*!
+ * \brief Версия формата передачи измерений
+ */
+enum class WireVersion : uint8_t
+{
+    V1 = 1, ///< Измерение с полной 8-байтной меткой времени (MessageMeterage)
+    V2 = 2  ///< Измерение с разностью меток времени в формате LEB128 (MessageMeterageDelta)
+};
+
+#endif // WIREVERSION_H